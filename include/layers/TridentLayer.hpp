@@ -32,6 +32,7 @@
 #define COUNTHINT_MAX 1
 #define SMALLREL 20
 #define LIMIT_SAMPLE 100
+#define SCAN_BLOCK_SIZE 256
 
 class TridentScan : public DBLayer::Scan {
     private:
@@ -42,13 +43,43 @@ class TridentScan : public DBLayer::Scan {
         DBLayer::Hint *hint;
         size_t countHint;
 
+        //Non-aggregated scans read the pairs in blocks if nothing can move
+        //the iterator forward (hints or hash keys)
+        bool useBlocks;
+        int64_t blockKey;
+        int64_t block1[SCAN_BLOCK_SIZE];
+        int64_t block2[SCAN_BLOCK_SIZE];
+        size_t blockSize, blockPos;
+
+        //Sorted keys of the build side of a hash join (see
+        //DBLayer::Hint::setKeys). The tuples whose columns in hashColumns
+        //are not among them are skipped
+        const std::vector<uint64_t> *hashKeys;
+        int hashColumns;
+        size_t hashPos[3];
+        bool hashSeek, hashAllKeys;
+
+        bool advance();
+
+        void initHashKeys(const bool allKeys);
+
+        bool skipToHashKeys();
+
+        void initBlocks();
+
+        //Releases the iterator of a scan that is opened again
+        void closeItr();
+
     public:
         TridentScan(const int perm, const DBLayer::Aggr_t a,
                 Querier *q, DBLayer::Hint *hint) : a(a), perm(perm),
         itr(NULL),
         q(q),
         hint(hint),
-        countHint(0) {
+        countHint(0),
+        useBlocks(false),
+        blockKey(-1), blockSize(0), blockPos(0),
+        hashKeys(NULL), hashColumns(0), hashSeek(false), hashAllKeys(false) {
         }
 
         uint64_t getValue1();
@@ -72,6 +103,33 @@ class TridentScan : public DBLayer::Scan {
         ~TridentScan();
 };
 
+//Seeks in the second column of a pair iterator if only the key is bound,
+//or in the third one if also the second column is bound
+class TridentValueScan : public DBLayer::ValueScan {
+    private:
+        PairItr *itr;
+        Querier *q;
+        const bool thirdColumn;
+        const int64_t value1;
+        uint64_t value;
+
+    public:
+        TridentValueScan(PairItr *itr, Querier *q, const bool thirdColumn,
+                const int64_t value1) : itr(itr), q(q),
+        thirdColumn(thirdColumn), value1(value1), value(0) {
+        }
+
+        uint64_t getValue() {
+            return value;
+        }
+
+        bool next();
+
+        bool seek(uint64_t v);
+
+        ~TridentValueScan();
+};
+
 class TridentLayer : public DBLayer {
     private:
         KB &kb;
@@ -80,6 +138,8 @@ class TridentLayer : public DBLayer {
         bool bifSampl;
         const int nindices;
 
+        static int getPermutation(const DBLayer::DataOrder order);
+
         //Used to translate IDs back to strings
         std::unique_ptr<char[]> supportBuffer;
 
@@ -119,6 +179,23 @@ class TridentLayer : public DBLayer {
                 std::vector<uint8_t> *posToFilter,
                 std::vector<uint64_t> *valuesToFilter);
 
+        //Uses the characteristic sets for the joins on the subject and
+        //between an object and a subject of two constant predicates.
+        //Returns false if they cannot estimate the join
+        bool charSetsSelectivity(bool valueL1,
+                uint64_t value1CL,
+                bool value2L,
+                uint64_t value2CL,
+                bool value3L,
+                uint64_t value3CL,
+                bool value1R,
+                uint64_t value1CR,
+                bool value2R,
+                uint64_t value2CR,
+                bool value3R,
+                uint64_t value3CR,
+                double &selectivity);
+
         double bifocalSampling(bool valueL1,
                 uint64_t value1CL,
                 bool value2L,
@@ -190,6 +267,12 @@ class TridentLayer : public DBLayer {
                 ::Type::ID& type,
                 unsigned& subType);
 
+        DDLEXPORT void lookupByIds(const std::vector<uint64_t> &ids,
+                std::vector<std::string> &texts,
+                std::vector<::Type::ID> &types,
+                std::vector<unsigned> &subTypes,
+                std::vector<bool> &found);
+
         DDLEXPORT uint64_t getNextId();
 
         DDLEXPORT double getScanCost(DBLayer::DataOrder order,
@@ -237,6 +320,14 @@ class TridentLayer : public DBLayer {
                 const DBLayer::Aggr_t,
                 Hint *hint);
 
+        DDLEXPORT bool hasValueScans(const DBLayer::DataOrder order);
+
+        DDLEXPORT std::unique_ptr<DBLayer::ValueScan> getValueScan(
+                const DBLayer::DataOrder order,
+                const int nbound,
+                const uint64_t value1,
+                const uint64_t value2);
+
         Querier *getQuerier() {
             return q.get();
         }
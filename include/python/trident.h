@@ -31,12 +31,14 @@
 #include <trident/ml/batch.h>
 
 #include <layers/TridentLayer.hpp>
+#include <trident/sparql/plancache.h>
 
 typedef struct {
     PyObject_HEAD
         KB *kb = NULL;
     Querier *q = NULL;
     std::unique_ptr<TridentLayer> db;
+    std::unique_ptr<SPARQLPlanCache> plancache;
     bool rmKbOnDelete = false;
 } trident_Db;
 
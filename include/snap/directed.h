@@ -22,6 +22,8 @@ class Trident_TNGraph {
                 int totalBytes,
                 int64_t (**output)(const char*, const int64_t));
 
+        //The tables of the node stay pinned until releaseNodeInfo is called
+        //with ospPin and sopPin
         static bool getNodeInfo(TermCoordinates &coord,
                 Querier *q,
                 int64_t &indeg,
@@ -29,7 +31,11 @@ class Trident_TNGraph {
                 const char*& osp,
                 const char*& sop,
                 SnapReaders::pReader& ospReader,
-                SnapReaders::pReader& sopReader);
+                SnapReaders::pReader& sopReader,
+                int &ospPin,
+                int &sopPin);
+
+        static void releaseNodeInfo(Querier *q, int &ospPin, int &sopPin);
 
     public:
 
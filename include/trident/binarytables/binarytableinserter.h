@@ -66,6 +66,12 @@ class BinaryTableInserter {
             return 1;
         }
 
+        uint64_t writeBytes(char *bytes, int size) {
+            manager->append(bytes, size);
+            currentPos += size;
+            return size;
+        }
+
         uint64_t writeShort(int64_t t) {
             manager->appendShort(t);
             currentPos += 2;
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#ifndef _FIXEDUNPACK_H
+#define _FIXEDUNPACK_H
+
+#include <kognac/utils.h>
+
+#include <inttypes.h>
+#include <cstddef>
+#include <mutex>
+
+//Decodes runs of fixed-width integers (1-8 bytes) as they are stored in the
+//column tables. The kernel (AVX2, SSE4.1 or scalar) is picked at runtime
+//once, the first time it is used. Single values are always decoded with
+//the scalar decode(), SIMD pays off only on runs.
+class FixedUnpack {
+    public:
+        typedef void (*Kernel)(const char *input,
+                const uint8_t nbytes,
+                const uint8_t stride,
+                const size_t n,
+                int64_t *output);
+
+    private:
+        static Kernel kernel;
+        static std::once_flag selected;
+
+        static void select();
+
+        static void init() {
+            std::call_once(selected, &FixedUnpack::select);
+        }
+
+    public:
+        //Decodes n values of nbytes each. Consecutive values start stride
+        //bytes apart (e.g. bytesFirstBlock for the first column of a
+        //NewColumnTable, or nbytes for the second one)
+        static void unpack(const char *input,
+                const uint8_t nbytes,
+                const uint8_t stride,
+                const size_t n,
+                int64_t *output) {
+            init();
+            kernel(input, nbytes, stride, n, output);
+        }
+
+        static void unpack(const char *input,
+                const uint8_t nbytes,
+                const size_t n,
+                int64_t *output) {
+            init();
+            kernel(input, nbytes, nbytes, n, output);
+        }
+
+        static int64_t decode(const char *input, const uint8_t nbytes) {
+            return Utils::decode_longFixedBytes(input, nbytes);
+        }
+
+        static void unpack_scalar(const char *input,
+                const uint8_t nbytes,
+                const uint8_t stride,
+                const size_t n,
+                int64_t *output);
+
+        static void unpack_sse4(const char *input,
+                const uint8_t nbytes,
+                const uint8_t stride,
+                const size_t n,
+                int64_t *output);
+
+        static void unpack_avx2(const char *input,
+                const uint8_t nbytes,
+                const uint8_t stride,
+                const size_t n,
+                int64_t *output);
+
+        //Returns whether the SIMD kernels can be used on this machine
+        static bool isSSE4Supported();
+
+        static bool isAVX2Supported();
+
+        static const char *getKernelName();
+};
+
+#endif
@@ -0,0 +1,530 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+#ifndef _FORCOLUMNTABLE_H
+#define _FORCOLUMNTABLE_H
+
+#include <trident/binarytables/newtable.h>
+#include <trident/binarytables/intersection.h>
+#include <trident/kb/consts.h>
+#include <kognac/utils.h>
+
+#include <algorithm>
+#include <cstring>
+#include <assert.h>
+
+//Column table where the second column is split in blocks of BLOCKSIZE
+//values. Each value is stored as the difference from the smallest value of
+//its block (frame of reference) with the minimum number of bits. Layout:
+//
+//<header1: bytes first entry | bytes base> <header2: bytes count | bytes
+//starting point> <header3: bytes block offset> <vlong2 n. first terms>
+//<vlong2 n. terms> <first column (as in NewColumnTable)> <one skip header
+//per block: base, n. bits, offset of the packed values> <packed values>
+//<PADDING zero bytes>
+//
+//Since all values of a block have the same width, any row can be read
+//without decoding the previous ones.
+class FORColumnTable: public AbsNewTable {
+    public:
+        static const int BLOCKSIZE = 128;
+        static const int BLOCKSHIFT = 7;
+        //The values are read with 8-byte loads
+        static const int PADDING = 8;
+        static const uint8_t MAXBITS = 56;
+
+        //Bits are stored starting from the least significant one of the
+        //first byte (little-endian). The loaded words are swapped on
+        //big-endian machines
+        static uint64_t load64(const char *p) {
+            uint64_t w;
+            memcpy(&w, p, 8);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            w = __builtin_bswap64(w);
+#endif
+            return w;
+        }
+
+        static uint64_t unpackOne(const char *packed, const uint8_t bits,
+                const int64_t i) {
+            if (bits == 0) {
+                return 0;
+            }
+            const uint64_t bitpos = (uint64_t) i * bits;
+            const uint64_t w = load64(packed + (bitpos >> 3));
+            return (w >> (bitpos & 7)) & ((((uint64_t)1) << bits) - 1);
+        }
+
+        static void unpack(const char *packed, const uint8_t bits,
+                const int64_t base, const int64_t n, int64_t *output) {
+            if (bits == 0) {
+                std::fill(output, output + n, base);
+                return;
+            }
+            const uint64_t mask = (((uint64_t)1) << bits) - 1;
+            uint64_t bitpos = 0;
+            for (int64_t i = 0; i < n; ++i) {
+                const uint64_t w = load64(packed + (bitpos >> 3));
+                output[i] = base + ((w >> (bitpos & 7)) & mask);
+                bitpos += bits;
+            }
+        }
+
+    private:
+        uint8_t bytesPerFirstEntry, bytesPerBase;
+        uint8_t bytesPerCount, bytesPerStartingPoint;
+        uint8_t bytesPerBlockOffset;
+        uint8_t bytesFirstBlock, bytesBlockHeader;
+
+        int64_t currentValue1, currentValue2;
+        uint64_t nTerms, nUniqueFirstTerms;
+        int64_t nRows;
+
+        uint64_t currentCount, scannedCounts;
+
+        const char *start;
+        const char *end;
+        const char *startpos1;
+        const char *endpos1;
+        const char *currentpos1;
+        const char *startheaders;
+        const char *startpacked;
+
+        //Rows of the second column
+        int64_t startrow2;
+        int64_t currentrow2;
+        int64_t endrow2;
+        bool isSecondColumnIgnored;
+
+        //Decoded values of the last block read by next()
+        int64_t currentBlock;
+        int64_t block[BLOCKSIZE];
+
+        // For mark/reset
+        int64_t savedCurrentValue1;
+        const char *savedCurrentpos1;
+        uint64_t savedCurrentCount;
+        uint64_t savedScannedCounts;
+        int64_t savedStartrow2;
+        int64_t savedCurrentValue2;
+        int64_t savedCurrentrow2;
+
+        void readBlockHeader(const int64_t b, int64_t &base, uint8_t &bits,
+                const char *&packed) const {
+            const char *h = startheaders + b * bytesBlockHeader;
+            base = Utils::decode_longFixedBytes(h, bytesPerBase);
+            bits = (uint8_t) h[bytesPerBase];
+            packed = startpacked + Utils::decode_longFixedBytes(
+                    h + bytesPerBase + 1, bytesPerBlockOffset);
+        }
+
+        void loadBlock(const int64_t b) {
+            int64_t base;
+            uint8_t bits;
+            const char *packed;
+            readBlockHeader(b, base, bits, packed);
+            const int64_t n = std::min((int64_t) BLOCKSIZE,
+                    nRows - (b << BLOCKSHIFT));
+            unpack(packed, bits, base, n, block);
+            currentBlock = b;
+        }
+
+        int64_t getRow(const int64_t row) const {
+            const int64_t b = row >> BLOCKSHIFT;
+            if (b == currentBlock) {
+                return block[row & (BLOCKSIZE - 1)];
+            }
+            int64_t base;
+            uint8_t bits;
+            const char *packed;
+            readBlockHeader(b, base, bits, packed);
+            return base + unpackOne(packed, bits, row & (BLOCKSIZE - 1));
+        }
+
+        void readFirstEntry() {
+            currentValue1 = Utils::decode_longFixedBytes(currentpos1,
+                    bytesPerFirstEntry);
+            currentpos1 += bytesPerFirstEntry;
+            currentCount = Utils::decode_longFixedBytes(currentpos1,
+                    bytesPerCount);
+            currentpos1 += bytesPerCount + bytesPerStartingPoint;
+            scannedCounts = 0;
+            startrow2 = currentrow2;
+        }
+
+        int64_t getStartingPoint(const char *entry) const {
+            return Utils::decode_longFixedBytes(entry + bytesPerFirstEntry +
+                    bytesPerCount, bytesPerStartingPoint);
+        }
+
+    public:
+        char getReaderSize1() const {
+            return bytesPerFirstEntry;
+        }
+
+        char getReaderSize2() const {
+            return bytesPerBase;
+        }
+
+        char getReaderCountSize() const {
+            return bytesPerCount;
+        }
+
+        int64_t getValue1() {
+            return currentValue1;
+        }
+
+        int64_t getValue2() {
+            return currentValue2;
+        }
+
+        uint64_t getCardinality() {
+            if (isSecondColumnIgnored) {
+                return nUniqueFirstTerms;
+            } else {
+                return nTerms;
+            }
+        }
+
+        uint64_t estCardinality() {
+            return getCardinality();
+        }
+
+        bool hasNext() {
+            return currentpos1 < endpos1 ||
+                (!isSecondColumnIgnored && currentrow2 < endrow2);
+        }
+
+        void next() {
+            assert(hasNext());
+            if (isSecondColumnIgnored || scannedCounts == currentCount) {
+                readFirstEntry();
+            }
+
+            if (!isSecondColumnIgnored) {
+                const int64_t b = currentrow2 >> BLOCKSHIFT;
+                if (b != currentBlock) {
+                    loadBlock(b);
+                }
+                currentValue2 = block[currentrow2 & (BLOCKSIZE - 1)];
+                currentrow2++;
+                scannedCounts++;
+            }
+        }
+
+        bool next(int64_t &v1, int64_t &v2, int64_t &v3) {
+            next();
+            v2 = currentValue1;
+            v3 = currentValue2;
+            return hasNext();
+        }
+
+        size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                if (scannedCounts == currentCount) {
+                    readFirstEntry();
+                }
+                //Copy the remaining part of the group, one block at a time
+                uint64_t toCopy = currentCount - scannedCounts;
+                if (toCopy > n - i) {
+                    toCopy = n - i;
+                }
+                while (toCopy > 0) {
+                    const int64_t b = currentrow2 >> BLOCKSHIFT;
+                    if (b != currentBlock) {
+                        loadBlock(b);
+                    }
+                    const int64_t offset = currentrow2 & (BLOCKSIZE - 1);
+                    const uint64_t m = std::min(toCopy,
+                            (uint64_t) (BLOCKSIZE - offset));
+                    memcpy(v2 + i, block + offset, m * sizeof(int64_t));
+                    std::fill(v1 + i, v1 + i + m, currentValue1);
+                    i += m;
+                    currentrow2 += m;
+                    scannedCounts += m;
+                    toCopy -= m;
+                }
+            }
+            if (i > 0) {
+                currentValue2 = v2[i - 1];
+            }
+            return i;
+        }
+
+        void moveto(const int64_t c1, const int64_t c2) {
+            if (!hasNext() && (c1 > currentValue1 ||
+                        (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2))) {
+                return;
+            }
+
+            bool searchsecondterm = c1 == currentValue1;
+            if (c1 > currentValue1) {
+                //Galloping search from the current position
+                const char *s = currentpos1;
+                const int64_t n = (endpos1 - s) / bytesFirstBlock;
+                const uint8_t b1 = bytesPerFirstEntry;
+                const uint8_t bb = bytesFirstBlock;
+                const int64_t idx = Intersection::gallop(0, n,
+                        [s, b1, bb, c1](const int64_t i) {
+                        return Utils::decode_longFixedBytes(s + i * bb, b1) < c1;
+                        });
+                s += idx * bytesFirstBlock;
+                if (idx < n && Utils::decode_longFixedBytes(s,
+                            bytesPerFirstEntry) == c1) {
+                    currentpos1 = s;
+                    currentrow2 = startrow2 = getStartingPoint(s);
+                    currentCount = 0;
+                    searchsecondterm = true;
+                } else if (s >= endpos1) {
+                    //No more entries
+                    currentpos1 = endpos1;
+                    currentrow2 = endrow2;
+                } else {
+                    currentpos1 = s;
+                    currentCount = 0;
+                    currentrow2 = startrow2 = getStartingPoint(s);
+                }
+                scannedCounts = 0;
+                currentValue2 = -1;
+            } else if (isSecondColumnIgnored) {
+                //Re-read the current entry
+                currentpos1 -= bytesFirstBlock;
+            }
+
+            if (!isSecondColumnIgnored) {
+                if (searchsecondterm && c2 > currentValue2) {
+                    if (currentValue2 == -1) {
+                        //Read the first term now, otherwise the following
+                        //next() would read it again
+                        readFirstEntry();
+                    }
+                    //The skip headers are not needed: any row can be read
+                    //directly, so the search gallops on the rows
+                    const int64_t endgroup = startrow2 + currentCount;
+                    currentrow2 = Intersection::gallop(currentrow2, endgroup,
+                            [this, c2](const int64_t r) {
+                            return getRow(r) < c2;
+                            });
+                    scannedCounts = currentrow2 - startrow2;
+                    if (currentrow2 == endrow2) {
+                        currentValue2 = 0;
+                    }
+                } else if (currentValue2 != -1) {
+                    //I do a step back so that hasNext() and next() will point to the same value
+                    scannedCounts--;
+                    currentrow2--;
+                    return;
+                }
+            }
+        }
+
+        void clear() {
+        }
+
+        void mark() {
+            savedCurrentValue1 = currentValue1;
+            savedCurrentpos1 = currentpos1;
+            savedCurrentCount = currentCount;
+            savedScannedCounts = scannedCounts;
+            savedStartrow2 = startrow2;
+            savedCurrentValue2 = currentValue2;
+            savedCurrentrow2 = currentrow2;
+        }
+
+        void reset(const char i) {
+            currentValue1 = savedCurrentValue1;
+            currentpos1 = savedCurrentpos1;
+            currentCount = savedCurrentCount;
+            scannedCounts = savedScannedCounts;
+            startrow2 = savedStartrow2;
+            currentValue2 = savedCurrentValue2;
+            currentrow2 = savedCurrentrow2;
+        }
+
+        int64_t getCount() {
+            if (isSecondColumnIgnored)
+                return (int64_t)currentCount;
+            else
+                return 1;
+        }
+
+        void ignoreSecondColumn() {
+            isSecondColumnIgnored = true;
+            if (currentValue1 != -1) {
+                //I must move to the next first element, if any
+                scannedCounts = currentCount;
+            }
+        }
+
+        int getTypeItr() {
+            return FORCOLUMN_ITR;
+        }
+
+        void setup(const char* start, const char *end) {
+            initializeConstraints();
+            this->start = start;
+            this->end = end;
+            currentValue1 = currentValue2 = -1;
+            isSecondColumnIgnored = false;
+
+            //get all column widths
+            uint8_t header1 = (uint8_t) start[0];
+            bytesPerFirstEntry = (header1 >> 3) & 7;
+            bytesPerBase = header1 & 7;
+            uint8_t header2 = (uint8_t) start[1];
+            bytesPerCount = (header2 >> 3) & 7;
+            bytesPerStartingPoint = header2 & 7;
+            bytesPerBlockOffset = ((uint8_t) start[2]) & 7;
+            bytesFirstBlock = bytesPerFirstEntry + bytesPerCount + bytesPerStartingPoint;
+            bytesBlockHeader = bytesPerBase + 1 + bytesPerBlockOffset;
+
+            int offset = 3;
+            nUniqueFirstTerms = Utils::decode_vlong2(start, &offset);
+            nTerms = Utils::decode_vlong2(start, &offset);
+            nRows = nTerms;
+
+            currentpos1 = startpos1 = start + offset;
+            endpos1 = startpos1 + bytesFirstBlock * nUniqueFirstTerms;
+            startheaders = endpos1;
+            const int64_t nblocks = (nRows + BLOCKSIZE - 1) >> BLOCKSHIFT;
+            startpacked = startheaders + nblocks * bytesBlockHeader;
+            startrow2 = currentrow2 = 0;
+            endrow2 = nRows;
+            scannedCounts = currentCount = 0;
+            currentBlock = -1;
+
+            assert(bytesPerFirstEntry > 0);
+            assert(bytesPerBase > 0);
+        }
+
+        void setup(int64_t c1, const char* s, const char *e) {
+            //Search for the right c1. Then sets the limits.
+            setup(s, e);
+            if (hasNext()) {
+                next();
+                moveto(c1, 0);
+                if (hasNext()) {
+                    next();
+                    if (getValue1() == c1) {
+                        //Sets new limits
+                        endrow2 = startrow2 + currentCount;
+                        currentrow2 = startrow2;
+                        endpos1 = currentpos1;
+                        startpos1 = endpos1 - bytesFirstBlock;
+                        currentpos1 = startpos1;
+                        nUniqueFirstTerms = 1;
+                        nTerms = currentCount;
+                    } else {
+                        //Make it fail
+                        currentpos1 = endpos1;
+                        currentrow2 = endrow2;
+                    }
+                } else {
+                    //Make it fail
+                    currentpos1 = endpos1;
+                    currentrow2 = endrow2;
+                }
+            }
+        }
+
+        void setup(int64_t c1, int64_t c2, const char* s, const char *e) {
+            //Search for the right c1. Then sets the limits.
+            setup(s, e);
+            if (hasNext()) {
+                next();
+                moveto(c1, c2);
+                if (hasNext()) {
+                    next();
+                    currentpos1 = endpos1;
+                    if (getValue1() == c1 && getValue2() == c2) {
+                        nUniqueFirstTerms = 1;
+                        nTerms = 1;
+                        endrow2 = currentrow2;
+                        currentrow2--;
+                        scannedCounts--;
+                    } else {
+                        //Make it fail
+                        currentrow2 = endrow2;
+                    }
+                } else {
+                    //Make it fail
+                    currentpos1 = endpos1;
+                    currentrow2 = endrow2;
+                }
+            }
+        }
+
+        int64_t getValue1AtRow(int64_t rowid) {
+            const char *pos = startpos1 + bytesFirstBlock * rowid;
+            return Utils::decode_longFixedBytes(pos, bytesPerFirstEntry);
+        }
+
+        int64_t getValue2AtRow(int64_t rowid) {
+            return getRow(startrow2 + rowid);
+        }
+
+        //Reads the pair at rowId directly from the table in start (used
+        //by the ML batches). sizetable and offset are not needed
+        static void s_getValue12AtRow(const uint64_t sizetable,
+                const uint8_t offset,
+                const char *start,
+                const uint64_t rowId,
+                uint64_t &v1,
+                uint64_t &v2) {
+            const uint8_t header1 = (uint8_t) start[0];
+            const uint8_t header2 = (uint8_t) start[1];
+            const uint8_t b1 = (header1 >> 3) & 7;
+            const uint8_t bBase = header1 & 7;
+            const uint8_t bCount = (header2 >> 3) & 7;
+            const uint8_t bStart = header2 & 7;
+            const uint8_t bOffset = ((uint8_t) start[2]) & 7;
+            const uint8_t bFirst = b1 + bCount + bStart;
+            const uint8_t bHeader = bBase + 1 + bOffset;
+            int pos = 3;
+            const int64_t nfirst = Utils::decode_vlong2(start, &pos);
+            const int64_t nrows = Utils::decode_vlong2(start, &pos);
+            const char *pos1 = start + pos;
+
+            //The first term is the last entry that starts at or before rowId
+            const int64_t idx = Intersection::gallop(0, nfirst,
+                    [pos1, bFirst, b1, bCount, bStart, rowId](const int64_t i) {
+                    return Utils::decode_longFixedBytes(pos1 + i * bFirst +
+                            b1 + bCount, bStart) <= (int64_t) rowId;
+                    }) - 1;
+            v1 = Utils::decode_longFixedBytes(pos1 + idx * bFirst, b1);
+
+            const char *headers = pos1 + nfirst * bFirst;
+            const int64_t nblocks = (nrows + BLOCKSIZE - 1) >> BLOCKSHIFT;
+            const char *h = headers + (rowId >> BLOCKSHIFT) * bHeader;
+            const int64_t base = Utils::decode_longFixedBytes(h, bBase);
+            const uint8_t bits = (uint8_t) h[bBase];
+            const char *packed = headers + nblocks * bHeader +
+                Utils::decode_longFixedBytes(h + bBase + 1, bOffset);
+            v2 = base + unpackOne(packed, bits, rowId & (BLOCKSIZE - 1));
+        }
+};
+
+#endif
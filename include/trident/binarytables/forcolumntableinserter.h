@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+#ifndef _FORCOLUMNTABLEINSERTER_H
+#define _FORCOLUMNTABLEINSERTER_H
+
+#include <trident/binarytables/binarytableinserter.h>
+#include <trident/binarytables/forcolumntable.h>
+
+#include <vector>
+
+//Writes the tables read by FORColumnTable. The blocks of the second column
+//are packed as soon as they are full, so only the compressed values are
+//kept in memory until stopAppend()
+class FORColumnTableInserter: public BinaryTableInserter {
+private:
+    uint64_t largestElement1, largestElement2, largestGroup;
+
+    int64_t prevel1, prevtotalsize2;
+    int64_t nelements2;
+    std::vector<std::pair<uint64_t, uint64_t>> tmpfirstpairs;
+
+    //Values of the block that is being filled
+    int64_t block[FORColumnTable::BLOCKSIZE];
+    int nblock;
+
+    //Skip headers and packed values of the completed blocks
+    std::vector<int64_t> blockBases;
+    std::vector<uint8_t> blockBits;
+    std::vector<uint64_t> blockOffsets;
+    std::vector<char> packed;
+
+    void packBlock();
+
+public:
+    //Returns the number of bits needed to store v
+    static uint8_t numBits(uint64_t v) {
+        uint8_t bits = 0;
+        while (v != 0) {
+            bits++;
+            v >>= 1;
+        }
+        return bits;
+    }
+
+    //Appends the n values to output, each as the difference from base with
+    //the given number of bits
+    static void pack(const int64_t *values, const int64_t n,
+            const int64_t base, const uint8_t bits,
+            std::vector<char> &output);
+
+    int getType() {
+        return FORCOLUMN_ITR;
+    }
+
+    void startAppend();
+
+    void append(int64_t t1, int64_t t2);
+
+    void stopAppend();
+};
+
+#endif
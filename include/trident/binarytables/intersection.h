@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#ifndef _INTERSECTION_H
+#define _INTERSECTION_H
+
+#include <kognac/utils.h>
+
+#include <inttypes.h>
+
+//Intersection of sorted lists of fixed-width values (no duplicates), as they
+//are stored in the binary tables. count() picks galloping when one list is
+//much smaller than the other, a SIMD block comparison when the CPU supports
+//it, or a plain merge otherwise.
+class Intersection {
+    public:
+        //Above this size ratio the smaller list is galloped into the larger
+        static const int64_t GALLOP_RATIO = 32;
+
+        struct PackedList {
+            const char *start;
+            int64_t size;
+            uint8_t nbytes;
+            uint8_t stride;
+
+            PackedList(const char *start, const int64_t size,
+                    const uint8_t nbytes, const uint8_t stride) :
+                start(start), size(size), nbytes(nbytes), stride(stride) {
+            }
+
+            int64_t get(const int64_t idx) const {
+                return Utils::decode_longFixedBytes(start + idx * stride, nbytes);
+            }
+        };
+
+        //Returns the first index in [lo, hi) for which lessThan is false.
+        //It probes lo, lo+1, lo+3, lo+7, ... before the binary search, so
+        //short forward skips are cheap
+        template<typename LessThan>
+            static int64_t gallop(int64_t lo, const int64_t hi,
+                    LessThan lessThan) {
+                if (lo >= hi || !lessThan(lo)) {
+                    return lo;
+                }
+                int64_t step = 1;
+                while (lo + step < hi && lessThan(lo + step)) {
+                    lo += step;
+                    step <<= 1;
+                }
+                int64_t end = lo + step < hi ? lo + step : hi;
+                lo++;
+                while (lo < end) {
+                    const int64_t middle = lo + (end - lo) / 2;
+                    if (lessThan(middle)) {
+                        lo = middle + 1;
+                    } else {
+                        end = middle;
+                    }
+                }
+                return lo;
+            }
+
+        //First index >= from whose value is >= value
+        static int64_t lowerBound(const PackedList &list, const int64_t from,
+                const int64_t value) {
+            return gallop(from, list.size, [&list, value](const int64_t i) {
+                    return list.get(i) < value;
+                    });
+        }
+
+        static int64_t count(const PackedList &l1, const PackedList &l2);
+
+        static int64_t count_merge(const PackedList &l1, const PackedList &l2);
+
+        static int64_t count_gallop(const PackedList &small,
+                const PackedList &large);
+
+        static int64_t count_simd(const PackedList &l1, const PackedList &l2);
+};
+
+#endif
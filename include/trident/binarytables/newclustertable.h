@@ -154,6 +154,36 @@ class NewClusterTable: public AbsNewTable {
             return current < end;
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            size_t i = 0;
+            while (i < n && current < end) {
+                if (count == 0) {
+                    currentValue1 = Reader1::read(current);
+                    current += Reader1::size();
+                    count = countgroup = ReaderCount::read(current);
+                    current += ReaderCount::size();
+                }
+                //Copy the remaining part of the group in one go
+                int64_t toCopy = count;
+                if (toCopy > (int64_t)(n - i)) {
+                    toCopy = n - i;
+                }
+                for (int64_t j = 0; j < toCopy; ++j) {
+                    v1[i] = currentValue1;
+                    v2[i++] = Reader2::read(current);
+                    current += Reader2::size();
+                }
+                count -= toCopy;
+            }
+            if (i > 0) {
+                currentValue2 = v2[i - 1];
+            }
+            return i;
+        }
+
         bool hasNext() {
             return current < end;
         }
@@ -25,6 +25,8 @@
 
 //#include <trident/iterators/pairitr.h>
 #include <trident/binarytables/newtable.h>
+#include <trident/binarytables/fixedunpack.h>
+#include <trident/binarytables/intersection.h>
 #include <trident/kb/consts.h>
 #include <kognac/utils.h>
 
@@ -57,6 +59,14 @@ class NewColumnTable: public AbsNewTable {
         const char *currentpos2;
         bool isSecondColumnIgnored;
         bool limitsSet;
+
+        //Skip index (only in large tables). Rows are counted from the
+        //beginning of the columns, also after the limits are set
+        uint8_t skipShift;
+        const char *skippos1;
+        const char *skippos2;
+        const char *basepos1;
+        const char *basepos2;
 #if DEBUG
         bool movetoAllowed;
         bool hasNextCalled;
@@ -77,6 +87,13 @@ class NewColumnTable: public AbsNewTable {
         bool savedhasNextRetval;
 #endif
 
+        //Merge of two sorted strided columns used by the variants below
+        static void columnNotInStrided(const char *begin1, const char* end1,
+                const uint8_t bEntry1, const uint8_t stride1,
+                const char *begin2, const char *end2,
+                const uint8_t bEntry2, const uint8_t stride2,
+                SequenceWriter *output);
+
         static void columnNotIn11(const char *begin1, const char* end1,
                 const uint8_t bEntry1, const uint8_t bBlock1,
                 const char *begin2, const char *end2,
@@ -101,6 +118,29 @@ class NewColumnTable: public AbsNewTable {
                 const uint8_t bEntry2,
                 SequenceWriter *output);
 
+        //Restricts the rows [lo, hi) where the first value >= value is
+        //searched to the ones between two consecutive entries of the skip
+        //index. The entries are small and contiguous, so the search touches
+        //at most a couple of pages of the column
+        void skipRange(const char *skip, const uint8_t nbytes,
+                const int64_t value, int64_t &lo, int64_t &hi) const {
+            const int64_t first = (lo >> skipShift) +
+                ((lo & ((((int64_t)1) << skipShift) - 1)) != 0);
+            const int64_t last = (hi >> skipShift) +
+                ((hi & ((((int64_t)1) << skipShift) - 1)) != 0);
+            const int64_t j = Intersection::gallop(first, last,
+                    [skip, nbytes, value](const int64_t i) {
+                    return Utils::decode_longFixedBytes(skip + i * nbytes,
+                            nbytes) < value;
+                    });
+            if (j > first) {
+                lo = ((j - 1) << skipShift) + 1;
+            }
+            if (j < last) {
+                hi = j << skipShift;
+            }
+        }
+
     public:
 
         char getReaderSize1() const {
@@ -168,9 +208,9 @@ class NewColumnTable: public AbsNewTable {
             movetoAllowed = true;
 #endif
             if (isSecondColumnIgnored || scannedCounts == currentCount) {
-                currentValue1 = Utils::decode_longFixedBytes(currentpos1, bytesPerFirstEntry);
+                currentValue1 = FixedUnpack::decode(currentpos1, bytesPerFirstEntry);
                 currentpos1 += bytesPerFirstEntry;
-                currentCount = Utils::decode_longFixedBytes(currentpos1, bytesPerCount);
+                currentCount = FixedUnpack::decode(currentpos1, bytesPerCount);
                 currentpos1 += bytesPerCount + bytesPerStartingPoint;
                 scannedCounts = 0;
                 startblock2 = currentpos2;
@@ -178,7 +218,7 @@ class NewColumnTable: public AbsNewTable {
 
             if (!isSecondColumnIgnored) {
                 //Read second term
-                currentValue2 = Utils::decode_longFixedBytes(currentpos2, bytesPerSecondEntry);
+                currentValue2 = FixedUnpack::decode(currentpos2, bytesPerSecondEntry);
                 currentpos2 += bytesPerSecondEntry;
                 scannedCounts++;
             }
@@ -191,6 +231,42 @@ class NewColumnTable: public AbsNewTable {
             return hasNext();
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                if (scannedCounts == currentCount) {
+                    currentValue1 = Utils::decode_longFixedBytes(currentpos1, bytesPerFirstEntry);
+                    currentpos1 += bytesPerFirstEntry;
+                    currentCount = Utils::decode_longFixedBytes(currentpos1, bytesPerCount);
+                    currentpos1 += bytesPerCount + bytesPerStartingPoint;
+                    scannedCounts = 0;
+                    startblock2 = currentpos2;
+                }
+                //Copy the remaining part of the group in one go
+                uint64_t toCopy = currentCount - scannedCounts;
+                if (toCopy > n - i) {
+                    toCopy = n - i;
+                }
+                FixedUnpack::unpack(currentpos2, bytesPerSecondEntry,
+                        toCopy, v2 + i);
+                currentpos2 += toCopy * bytesPerSecondEntry;
+                for (uint64_t j = 0; j < toCopy; ++j) {
+                    v1[i++] = currentValue1;
+                }
+                scannedCounts += toCopy;
+            }
+            if (i > 0) {
+                currentValue2 = v2[i - 1];
+#if DEBUG
+                movetoAllowed = true;
+#endif
+            }
+            return i;
+        }
+
         void first() {
             next();
         }
@@ -218,30 +294,31 @@ class NewColumnTable: public AbsNewTable {
 
             bool searchsecondterm = c1 == currentValue1;
             if (c1 > currentValue1) {
-                //Binary search
-                const char *s = currentpos1;
-                const char *e = startpos2;
+                //Galloping search from the current position
+                int64_t lo = (currentpos1 - basepos1) / bytesFirstBlock;
+                int64_t hi = (startpos2 - basepos1) / bytesFirstBlock;
+                if (skipShift && hi - lo > (((int64_t)1) << skipShift)) {
+                    skipRange(skippos1, bytesPerFirstEntry, c1, lo, hi);
+                }
+                const char *s = basepos1 + lo * bytesFirstBlock;
+                const uint8_t b1 = bytesPerFirstEntry;
+                const uint8_t bb = bytesFirstBlock;
+                const int64_t idx = Intersection::gallop(0, hi - lo,
+                        [s, b1, bb, c1](const int64_t i) {
+                        return Utils::decode_longFixedBytes(s + i * bb, b1) < c1;
+                        });
+                s += idx * bytesFirstBlock;
                 bool found = false;
-                uint64_t middleValue;
-                while (s < e) {
-                    const uint64_t middlePos = (e - s) / bytesFirstBlock / 2;
-                    const char *middle = s + middlePos * bytesFirstBlock;
-                    middleValue  = Utils::decode_longFixedBytes(middle, bytesPerFirstEntry);
-                    if (middleValue < c1) {
-                        s = middle + bytesFirstBlock;
-                    } else if (middleValue > c1) {
-                        e = middle;
-                    } else { //Found
-                        currentpos1 = middle;
-                        const uint64_t idx2 = Utils::decode_longFixedBytes(
-                                middle + bytesPerFirstEntry + bytesPerCount,
-                                bytesPerStartingPoint);
-                        currentpos2 = startpos2 + idx2 * bytesPerSecondEntry;
-                        startblock2 = currentpos2;
-                        currentCount = 0;
-                        found = true;
-                        break;
-                    }
+                if (s < startpos2 && Utils::decode_longFixedBytes(s,
+                            bytesPerFirstEntry) == c1) {
+                    currentpos1 = s;
+                    const uint64_t idx2 = Utils::decode_longFixedBytes(
+                            s + bytesPerFirstEntry + bytesPerCount,
+                            bytesPerStartingPoint);
+                    currentpos2 = startpos2 + idx2 * bytesPerSecondEntry;
+                    startblock2 = currentpos2;
+                    currentCount = 0;
+                    found = true;
                 }
 
                 if (!found) {
@@ -279,25 +356,25 @@ class NewColumnTable: public AbsNewTable {
                         currentpos1 += bytesPerCount + bytesPerStartingPoint;
                     }
 
-                    const char *s = currentpos2;
                     const char *e = startblock2 + currentCount * bytesPerSecondEntry;
+                    int64_t lo = (currentpos2 - basepos2) / bytesPerSecondEntry;
+                    int64_t hi = (e - basepos2) / bytesPerSecondEntry;
+                    if (skipShift && hi - lo > (((int64_t)1) << skipShift)) {
+                        skipRange(skippos2, bytesPerSecondEntry, c2, lo, hi);
+                    }
+                    const char *s = basepos2 + lo * bytesPerSecondEntry;
+                    const uint8_t b2 = bytesPerSecondEntry;
+                    const int64_t idx = Intersection::gallop(0, hi - lo,
+                            [s, b2, c2](const int64_t i) {
+                            return Utils::decode_longFixedBytes(s + i * b2, b2) < c2;
+                            });
+                    s += idx * bytesPerSecondEntry;
                     bool found = false;
-                    while (s < e) {
-                        const uint64_t middlePos = (e - s) / bytesPerSecondEntry / 2;
-                        const char *middle = s + middlePos * bytesPerSecondEntry;
-                        const uint64_t middleValue = Utils::decode_longFixedBytes(
-                                middle,
-                                bytesPerSecondEntry);
-                        if (middleValue < c2) {
-                            s = middle + bytesPerSecondEntry;
-                        } else if (middleValue > c2) {
-                            e = middle;
-                        } else { //Found
-                            found = true;
-                            scannedCounts = (middle - startblock2) / bytesPerSecondEntry;
-                            currentpos2 = middle;
-                            break;
-                        }
+                    if (s < e && Utils::decode_longFixedBytes(s,
+                                bytesPerSecondEntry) == c2) {
+                        found = true;
+                        scannedCounts = (s - startblock2) / bytesPerSecondEntry;
+                        currentpos2 = s;
                     }
                     if (!found) {
                         if (s >= startblock2 + currentCount * bytesPerSecondEntry) {
@@ -400,6 +477,19 @@ class NewColumnTable: public AbsNewTable {
             currentpos2 = startpos2 = startpos1 + (bytesFirstBlock) * nUniqueFirstTerms;
             scannedCounts = currentCount = 0;
 
+            basepos1 = startpos1;
+            basepos2 = startpos2;
+            skipShift = 0;
+            if (header2 & SKIPINDEX_FLAG) {
+                //The skip index follows the second column
+                this->end = startpos2 + bytesPerSecondEntry * nTerms;
+                skipShift = (uint8_t) this->end[0];
+                skippos1 = this->end + 1;
+                const int64_t nskip1 = (nUniqueFirstTerms +
+                        (((int64_t)1) << skipShift) - 1) >> skipShift;
+                skippos2 = skippos1 + nskip1 * bytesPerFirstEntry;
+            }
+
             assert(bytesPerFirstEntry > 0);
             assert(bytesPerSecondEntry > 0);
         }
@@ -465,19 +555,19 @@ class NewColumnTable: public AbsNewTable {
 
         int64_t getValue1AtRow(int64_t rowid) {
             const char *pos = startpos1 + bytesFirstBlock * rowid;
-            return Utils::decode_longFixedBytes(pos, bytesPerFirstEntry);
+            return FixedUnpack::decode(pos, bytesPerFirstEntry);
         }
 
         int64_t getValue2AtRow(int64_t rowid) {
             const char *pos = startblock2 + bytesPerSecondEntry * rowid;
-            return Utils::decode_longFixedBytes(pos, bytesPerSecondEntry);
+            return FixedUnpack::decode(pos, bytesPerSecondEntry);
         }
 
         template<int nbytes, int nskip>
             static int64_t s_getValue1AtRow(const char *start,
                     const int64_t rowId) {
                 const char *currentpos1= start + (nbytes + nskip) * rowId;
-                const int64_t v = Utils::decode_longFixedBytes(currentpos1, nbytes);
+                const int64_t v = FixedUnpack::decode(currentpos1, nbytes);
                 return v;
             }
 
@@ -489,10 +579,10 @@ class NewColumnTable: public AbsNewTable {
                     uint64_t &v1,
                     uint64_t &v2) {
                 const char *currentpos1 = start + (nbytes1 + offset) * rowId;
-                v1 = Utils::decode_longFixedBytes(currentpos1, nbytes1);
+                v1 = FixedUnpack::decode(currentpos1, nbytes1);
                 const char *currentpos2 = start + (nbytes1 + offset) * sizetable +
                     rowId * nbytes2;
-                v2 = Utils::decode_longFixedBytes(currentpos2, nbytes2);
+                v2 = FixedUnpack::decode(currentpos2, nbytes2);
             }
 
 };
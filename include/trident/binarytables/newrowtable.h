@@ -24,6 +24,7 @@
 #define _NEW_ROWTABLE_H
 
 #include <trident/binarytables/newtable.h>
+#include <trident/binarytables/intersection.h>
 #include <trident/kb/consts.h>
 
 #include <iostream>
@@ -147,6 +148,27 @@ class NewRowTable: public AbsNewTable {
             return current < end;
         }
 
+        size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+            if (isSecondColumnIgnored) {
+                return PairItr::nextBlock(v1, v2, n);
+            }
+            const uint8_t rowsize = Reader1::size() + Reader2::size();
+            size_t nrows = (end - current) / rowsize;
+            if (nrows > n) {
+                nrows = n;
+            }
+            for (size_t i = 0; i < nrows; ++i) {
+                v1[i] = Reader1::read(current);
+                v2[i] = Reader2::read(current + Reader1::size());
+                current += rowsize;
+            }
+            if (nrows > 0) {
+                currentValue1 = v1[nrows - 1];
+                currentValue2 = v2[nrows - 1];
+            }
+            return nrows;
+        }
+
         bool hasNext() {
             assert(current <= end);
             return current < end;
@@ -264,23 +286,21 @@ class NewRowTable: public AbsNewTable {
 
             if (c1 > currentValue1 ||
                     (!isSecondColumnIgnored && c1 == currentValue1 && c2 > currentValue2)) {
-                // Read the first entry
-                int64_t currentvalue = -1;
-                while (current != end) {
-                    currentvalue = Reader1::read(current);
-                    if (currentvalue >= c1)
-                        break;
-                    current += Reader1::size() + Reader2::size();
-                }
+                //Gallop to the first row >= (c1, c2)
+                const char *start = current;
+                const int rowSize = Reader1::size() + Reader2::size();
+                const int64_t n = (end - start) / rowSize;
+                const int64_t idx = Intersection::gallop(0, n,
+                        [start, rowSize, c1, c2](const int64_t i) {
+                        const char *row = start + i * rowSize;
+                        const int64_t v1 = Reader1::read(row);
+                        if (v1 != c1) {
+                            return v1 < c1;
+                        }
+                        return c2 > 0 && Reader2::read(row + Reader1::size()) < c2;
+                        });
+                current = start + idx * rowSize;
                 assert(current <= end);
-
-                if (c2 > 0 && current != end && currentvalue == c1) {
-                    int64_t currentC1 = Reader1::read(current);
-                    while (current != end && Reader1::read(current) == currentC1 &&
-                            Reader2::read(current + Reader1::size()) < c2) {
-                        current += Reader1::size() + Reader2::size();
-                    }
-                }
             } else {
                 current -= Reader1::size() + Reader2::size();
             }
@@ -27,8 +27,31 @@
 
 
 
+class TableStorage;
+
 class AbsNewTable : public PairItr {
+    private:
+        //Keeps the file of the table mapped while the iterator reads it
+        TableStorage *pinStorage;
+        int pin;
+
     public:
+        AbsNewTable() : pinStorage(NULL), pin(-1) {
+        }
+
+        void setPin(TableStorage *storage, const int pin) {
+            this->pinStorage = storage;
+            this->pin = pin;
+        }
+
+        TableStorage *getPinStorage() const {
+            return pinStorage;
+        }
+
+        int getPin() const {
+            return pin;
+        }
+
         virtual char getReaderSize1() const = 0;
 
         virtual char getReaderSize2() const = 0;
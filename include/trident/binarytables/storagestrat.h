@@ -30,6 +30,8 @@
 
 #include <trident/binarytables/newcolumntable.h>
 #include <trident/binarytables/newcolumntableinserter.h>
+#include <trident/binarytables/forcolumntable.h>
+#include <trident/binarytables/forcolumntableinserter.h>
 #include <trident/binarytables/newrowtable.h>
 #include <trident/binarytables/binarytablereaders.h>
 #include <trident/binarytables/newrowtableinserter.h>
@@ -49,6 +51,9 @@
  */
 
 #define RATE_LIST 1.05
+//The bit-packed column layout must be this much smaller than the others to
+//compensate for the decoding
+#define RATE_FORCOLUMN 1.2
 
 LIBEXP extern const unsigned FIXEDSTRAT5;
 LIBEXP extern const unsigned FIXEDSTRAT6;
@@ -58,6 +63,7 @@ struct Statistics {
     int64_t nListStrategies;
     int64_t nList2Strategies;
     int64_t nGroupStrategies;
+    int64_t nFORStrategies;
 
     int64_t nFirstCompr1;
     int64_t nFirstCompr2;
@@ -74,6 +80,7 @@ struct Statistics {
 
     Statistics() {
         nList2Strategies = nListStrategies = nGroupStrategies = 0;
+        nFORStrategies = 0;
         nFirstCompr1 = nFirstCompr2 = nSecondCompr1 = nSecondCompr2 = 0;
         exact = approximate = 0;
         diff = nodiff  = 0;
@@ -115,6 +122,13 @@ protected:
                                       int64_t listCounters2Compr1);
 
 private:
+    //Size of the table if it was stored with FORColumnTableInserter
+    static int64_t getFORColumnSize(int64_t *v2, const int size,
+                                    const int64_t ngroups,
+                                    const int64_t maxValue1,
+                                    const int64_t maxValue2,
+                                    const int64_t maxGroupSize);
+
     int64_t static minsum(const int64_t counters1[2][2], const int64_t counters2[2], int &c1, int &c2, int &d);
 
     unsigned static setCompr1(const unsigned signature, unsigned compr) {
@@ -152,6 +166,7 @@ private:
     Factory<NewColumnTable> *f4;
     FactoryNewRowTable *f5;
     FactoryNewClusterTable *f6;
+    Factory<FORColumnTable> *f7;
 
     Factory<RowTableInserter> *f1i;
     Factory<ClusterTableInserter> *f2i;
@@ -159,6 +174,7 @@ private:
     Factory<NewColumnTableInserter> *f4i;
     Factory<NewRowTableInserter> *f5i;
     Factory<NewClusterTableInserter> *f6i;
+    Factory<FORColumnTableInserter> *f7i;
 
 public:
     bool static isAggregated(const char signature) {
@@ -189,6 +205,7 @@ public:
                                   const int64_t nTerms,
                                   const size_t nTermsClusterColumn,
                                   const bool useRowForLargeTables,
+                                  const bool useFORColumn,
                                   Statistics &stats);
 
     static char determineStrategyOld(int64_t *v1, int64_t *v2, const int size,
@@ -207,6 +224,8 @@ public:
         f4 = NULL;
         f5 = NULL;
         f6 = NULL;
+        f7 = NULL;
+        f7i = NULL;
         statsCluster = statsRow = statsColumn = 0;
     }
 
@@ -218,21 +237,25 @@ public:
               Factory<NewColumnTable> *ncFactory,
               FactoryNewRowTable *newRowFactories,
               FactoryNewClusterTable *newClusterFactories,
+              Factory<FORColumnTable> *forFactory,
               Factory<RowTableInserter> *listFactory_i,
               Factory<ClusterTableInserter> *comprFactory_i,
               Factory<ColumnTableInserter> *list2Factory_i,
               Factory<NewColumnTableInserter> *ncFactory_i,
               Factory<NewRowTableInserter> *nrFactory_i,
-              Factory<NewClusterTableInserter> *ncluFactory_i) {
+              Factory<NewClusterTableInserter> *ncluFactory_i,
+              Factory<FORColumnTableInserter> *forFactory_i) {
         this->f4 = ncFactory;
         this->f5 = newRowFactories;
         this->f6 = newClusterFactories;
+        this->f7 = forFactory;
         this->f1i = listFactory_i;
         this->f2i = comprFactory_i;
         this->f3i = list2Factory_i;
         this->f4i = ncFactory_i;
         this->f5i = nrFactory_i;
         this->f6i = ncluFactory_i;
+        this->f7i = forFactory_i;
     }
 
     PairItr *getBinaryTable(const char signature);
@@ -104,6 +104,9 @@ class TableStorage {
         //permutation ID
         int perm;
 
+        //ID of the directory in the AccessLog
+        int accessLogDir;
+
         //*** INSERT ***
         bool indicesWritten;
         BinaryTableInserter* insertHandler;
@@ -120,11 +123,21 @@ class TableStorage {
     public:
         TableStorage(bool readOnly, std::string pathDir, int64_t maxFileSize,
                 int maxNFiles, MemoryManager<FileDescriptor> *bytesTracker,
-                Stats &stats, int perm);
+                Stats &stats, int perm, int64_t asyncBufferSize = 0);
 
         std::string getPath();
 
-        std::pair<const char*, const char*> getTable(short file, int64_t mark);
+        const Stats &getStats() const {
+            return stats;
+        }
+
+        //The table stays mapped until releaseTable() is called with the pin
+        std::pair<const char*, const char*> getTable(short file, int64_t mark,
+                int &pin);
+
+        void releaseTable(int pin) {
+            cache->unpin(pin);
+        }
 
         int64_t startAppend(const int64_t key,
                 const char strat,
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+//Writes the buffers of a file with a background thread. The caller fills a
+//buffer while the previous one is written, so at most two buffers are in
+//memory and the caller waits only if it is faster than the disk. Without MT
+//the buffers are written immediately
+class AsyncWriter {
+    private:
+        const std::string file;
+        std::fstream stream;
+
+        std::vector<char> pending;
+        uint64_t pendingOffset;
+        bool busy;
+        bool stop;
+        bool failed;
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::thread thread;
+
+        void write(const char *data, uint64_t size, uint64_t offset);
+
+        void run();
+
+    public:
+        AsyncWriter(std::string file);
+
+        //Writes buffer at offset. buffer is swapped with the previous
+        //(already written) buffer, so its memory is reused
+        void write(std::vector<char> &buffer, uint64_t offset);
+
+        //Waits until all the buffers are in the file
+        void drain();
+
+        //Writes the bytes synchronously, after the pending buffer
+        void writeAt(const char *data, uint64_t size, uint64_t offset);
+
+        ~AsyncWriter();
+};
+
+#endif
@@ -25,8 +25,10 @@
 
 #include <trident/utils/memorymgr.h>
 #include <trident/utils/memoryfile.h>
+#include <trident/files/asyncwriter.h>
 
 #include <string>
+#include <vector>
 
 //#define SMALLEST_INCR 1*1024*1024
 #define SMALLEST_INCR (uint64_t)16*1024*1024
@@ -54,8 +56,25 @@ private:
     int memoryTrackerId;
     FileDescriptor **parentArray;
 
+    //Used after startAsyncWrites(). The bytes from tailStart are in tail,
+    //the ones before are in the file or in the writer
+    std::unique_ptr<AsyncWriter> writer;
+    std::vector<char> tail;
+    uint64_t tailStart;
+    uint64_t asyncBufferSize;
+
     void mapFile(uint64_t requiredIncrement);
 
+    //Returns where the next n bytes should be written
+    char *reserveAppend(const uint64_t n);
+
+    //Sends the tail to the writer
+    void handOff();
+
+    char *getWrittenBuffer(uint64_t offset, uint64_t length);
+
+    void overwrite(uint64_t pos, const char *bytes, const uint64_t n);
+
 public:
     FileDescriptor(bool readOnly, int id, std::string file, uint64_t fileMaxSize,
                    MemoryManager<FileDescriptor> *tracker, FileDescriptor **parents,
@@ -78,6 +97,14 @@ public:
 
     bool isUsed();
 
+    //From now on the appends are collected in buffers of bufferSize bytes
+    //that are written by a background thread instead of through the
+    //mapping. The file is no longer evicted by the memory tracker
+    void startAsyncWrites(uint64_t bufferSize);
+
+    //Waits until all the appended bytes are in the file
+    void flushAppends();
+
     void shiftFile(uint64_t pos, uint64_t diff);
 
     void append(char *bytes, const uint64_t size);
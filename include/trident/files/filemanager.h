@@ -62,8 +62,14 @@ class FileManager {
 
         Stats* const stats;
 
+        //If not 0, the last file is written asynchronously with buffers of
+        //this size
+        const uint64_t asyncBufferSize;
+
 #ifdef MT
-        std::mutex mutex;
+        //Recursive because the public methods hold it while load_file()
+        //may need to evict other files
+        std::recursive_mutex mutex;
 #endif
 
         bool isFileLoaded(const int id) {
@@ -73,7 +79,7 @@ class FileManager {
         void load_file(const int id) {
             if (!isFileLoaded(id)) {
 #ifdef MT
-                std::unique_lock<std::mutex> lock(mutex);
+                std::unique_lock<std::recursive_mutex> lock(mutex);
                 if (!isFileLoaded(id)) {
 #endif
                     if (nOpenedFiles >= maxFiles) {
@@ -113,15 +119,24 @@ class FileManager {
                             delete openedFiles[idxFileToRemove];
                             openedFiles[idxFileToRemove] = NULL;
                             nOpenedFiles--;
+                            if (stats) {
+                                stats->incrNClosedFiles();
+                            }
                         }
                     }
                     std::stringstream filePath;
                     filePath << cacheDir << DIR_SEP << id;
                     T* f = new T(readOnly, id, filePath.str(), fileMaxSize,
                             bytesTracker, openedFiles, stats);
+                    if (!readOnly && asyncBufferSize > 0 && id == lastFileId) {
+                        f->startAsyncWrites(asyncBufferSize);
+                    }
                     openedFiles[id] = f;
                     trackerOpenedFiles.push_back(id);
                     nOpenedFiles++;
+                    if (stats) {
+                        stats->incrNOpenedFiles();
+                    }
 #ifdef MT
                 }
                 lock.unlock();
@@ -131,10 +146,10 @@ class FileManager {
     public:
         FileManager(std::string path, bool readOnly, int64_t fileMaxSize,
                 int maxNumberFiles, int lastFileId, MemoryManager<K> *bytesTracker,
-                Stats * const stats) :
+                Stats * const stats, uint64_t asyncBufferSize = 0) :
             readOnly(readOnly), cacheDir(path), fileMaxSize(fileMaxSize),
             maxFiles(maxNumberFiles), lastFileId(lastFileId), bytesTracker(bytesTracker),
-            stats(stats) {
+            stats(stats), asyncBufferSize(asyncBufferSize) {
                 for (int i = 0; i < MAX_N_FILES; ++i) {
                     openedFiles[i] = NULL;
                 }
@@ -151,11 +166,57 @@ class FileManager {
         }
 
         char* getBuffer(short id, uint64_t offset, uint64_t *length) {
+#ifdef MT
+            //The file could be evicted by a concurrent reader between
+            //load_file() and the access to it
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
+            if (stats) {
+                stats->incrNAccessedFiles();
+            }
             load_file(id);
             return openedFiles[id]->getBuffer(offset, length);
         }
 
+        //Like getBuffer(), but the file is not evicted until unpin() is
+        //called with the returned pin. The pin is -1 if the file is never
+        //evicted
+        char* pinBuffer(short id, uint64_t offset, uint64_t *length, int &pin) {
+#ifdef MT
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+            //The managers that share the tracker evict its blocks while they
+            //hold its lock
+            std::unique_lock<std::recursive_mutex> lockTracker;
+            if (bytesTracker) {
+                lockTracker = std::unique_lock<std::recursive_mutex>(
+                        bytesTracker->getMutex());
+            }
+#endif
+            if (stats) {
+                stats->incrNAccessedFiles();
+            }
+            load_file(id);
+            char *result = openedFiles[id]->getBuffer(offset, length, pin,
+                    EMPTY_SESSION);
+            if (pin >= 0) {
+                bytesTracker->addLock(pin);
+            }
+            return result;
+        }
+
+        void unpin(int pin) {
+            if (pin >= 0) {
+                bytesTracker->releaseLock(pin);
+            }
+        }
+
         char* getBuffer(short id, uint64_t offset, uint64_t *length, int sessionId) {
+#ifdef MT
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
+            if (stats) {
+                stats->incrNAccessedFiles();
+            }
             load_file(id);
             int memoryBlock;
 
@@ -179,6 +240,9 @@ class FileManager {
         }
 
         int newSession() {
+#ifdef MT
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
             int cnt = 0;
             while (sessions[lastSession] != FREE_SESSION) {
                 lastSession = (lastSession + 1) % MAX_SESSIONS;
@@ -196,6 +260,9 @@ class FileManager {
         }
 
         void closeSession(int idx) {
+#ifdef MT
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
             //Release the lock
             if (sessions[idx] >= 0) {
                 bytesTracker->releaseLock(sessions[idx]);
@@ -205,6 +272,9 @@ class FileManager {
         }
 
         uint64_t sizeFile(const int idx) {
+#ifdef MT
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
             if (isFileLoaded(idx)) {
                 return openedFiles[idx]->getFileLength();
             }
@@ -244,6 +314,13 @@ class FileManager {
         }
 
         short createNewFile() {
+            if (asyncBufferSize > 0 && isFileLoaded(lastFileId)) {
+                //Close the previous file, so that it is reopened with a
+                //mapping and its buffers are released. The entry in
+                //trackerOpenedFiles is removed by load_file()
+                delete openedFiles[lastFileId];
+                openedFiles[lastFileId] = NULL;
+            }
             lastFileId++;
             if (lastFileId == MAX_N_FILES) {
                 LOG(ERRORL) << "Max number of files is reached";
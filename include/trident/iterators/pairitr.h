@@ -25,6 +25,7 @@
 
 
 #include <inttypes.h>
+#include <cstddef>
 
 #define NO_CONSTRAINT -1
 
@@ -62,6 +63,22 @@ class PairItr {
             return hasNext();
         }
 
+        //Copies up to n pairs in v1 and v2, as if next() was called on each
+        //of them, and returns the number of copied pairs (0 if there are no
+        //more). All pairs in one block share the same key, so getKey() can be
+        //called once per block. Afterwards, getValue1()/getValue2() return the
+        //last pair. The content of v2 is undefined if the second column is
+        //ignored. The default implementation copies one pair per call,
+        //because some iterators (e.g. scans) change the key at every step.
+        virtual size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+            if (n == 0 || !hasNext())
+                return 0;
+            next();
+            v1[0] = getValue1();
+            v2[0] = getValue2();
+            return 1;
+        }
+
         virtual void ignoreSecondColumn() = 0;
 
         virtual int64_t getCount() = 0;
@@ -100,6 +100,8 @@ public:
 
     bool next(int64_t &v1, int64_t &v2, int64_t &v3);
 
+    size_t nextBlock(int64_t *v1, int64_t *v2, const size_t n);
+
     void clear();
 
     uint64_t getCardinality();
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+#ifndef _CHARSETS_H
+#define _CHARSETS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <cstdint>
+
+class Querier;
+class PairItr;
+
+//Characteristic sets: the subjects are grouped by the set of their
+//predicates, and every set stores the number of subjects and the number of
+//triples of each predicate. They estimate the joins on the subject without
+//sampling. The joins between the object of a predicate and the subject of
+//another one are counted exactly in a histogram of predicate pairs
+class CharacteristicSets {
+    public:
+        //A triple added (sign 1) or removed (sign -1) by a diff
+        struct Change {
+            int64_t s, p, o;
+            int64_t sign;
+        };
+
+    private:
+        struct Set {
+            int64_t nsubjects;
+            std::vector<int64_t> ntriples;
+        };
+        typedef std::map<std::vector<int64_t>, Set> Sets;
+
+        //The predicates with their counts of the triples with an entity as
+        //subject (out) and as object (in)
+        struct Profile {
+            std::vector<std::pair<int64_t, int64_t>> out, in;
+        };
+
+        Sets sets;
+        //The sets that contain every predicate
+        std::unordered_map<int64_t, std::vector<const Sets::value_type*>> index;
+        std::map<std::pair<int64_t, int64_t>, int64_t> chains;
+        //False if the KB had no OPS index to build the chains
+        bool objects;
+
+        void add(const Profile &profile, const int64_t sign);
+
+        static void readGroup(PairItr *itr, bool &valid, int64_t &key,
+                std::vector<std::pair<int64_t, int64_t>> &predicates);
+
+        static void getProfile(Querier *q, const int64_t entity,
+                const bool objects, Profile &profile);
+
+        static void revert(std::vector<std::pair<int64_t, int64_t>> &counts,
+                const int64_t p, const int64_t sign);
+
+    public:
+        CharacteristicSets() : objects(false) {}
+
+        CharacteristicSets(std::string file);
+
+        static bool exists(std::string file);
+
+        //Scans the SPO index and, if objects is true, the OPS index
+        void build(Querier *q, const bool objects);
+
+        //q must already return the changes
+        void update(Querier *q, std::vector<Change> &changes);
+
+        //Number of results of a star of triple patterns with the same subject
+        //variable, the given predicates and distinct object variables
+        double estimateStar(const std::vector<int64_t> &predicates) const;
+
+        //Number of pairs of triples with the predicates p1 and p2 where the
+        //object of the first is the subject of the second
+        int64_t getChainCount(const int64_t p1, const int64_t p2) const;
+
+        bool hasChains() const {
+            return objects;
+        }
+
+        void store(std::string file) const;
+
+        size_t getNSets() const {
+            return sets.size();
+        }
+};
+
+#endif
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#ifndef _COMPACTOR_H
+#define _COMPACTOR_H
+
+#include <trident/kb/kbconfig.h>
+#include <trident/kb/consts.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+class KB;
+
+//Merges the updates (the diff indices in _diff) into new base tables.
+//Every compaction writes a new "generation" of the KB in <kbdir>/_gen/<n>
+//and then replaces the content of <kbdir>/_current with n. The KB
+//constructor follows this file, so a new generation is visible to every
+//tool as soon as it is committed. Generation 0 is the content of <kbdir>.
+//
+//The compactor can also run in the background: it owns the KB of the
+//current generation and hands it out with getKB(). After a compaction,
+//new callers get the new generation, while the callers that still hold
+//the old one can continue using it. Every KB opened for reading holds a
+//shared lock on its generation (see ReaderLock), also in other processes.
+//An old generation is removed from disk when the last of them closes it.
+class Compactor {
+    public:
+        //Lock on a file, also between processes. If wait is false, the
+        //constructor does not block and isLocked() tells whether the lock
+        //was acquired
+        class FileLock {
+            private:
+#if defined(_WIN32)
+                void *handle;
+#else
+                int fd;
+#endif
+                bool locked;
+
+            public:
+                //If create is false and the file does not exist, no lock
+                //is acquired
+                LIBEXP FileLock(std::string file, bool exclusive, bool wait,
+                        bool create = true);
+
+                FileLock(const FileLock&) = delete;
+
+                FileLock &operator=(const FileLock&) = delete;
+
+                bool isLocked() const {
+                    return locked;
+                }
+
+                LIBEXP ~FileLock();
+        };
+
+        //Exclusive lock on the updates of a KB (the file <kbdir>/_lock).
+        //The updater holds it while it writes a diff index, the compactor
+        //while it checks the diffs and commits a generation, so that no
+        //update is lost by a compaction
+        class UpdateLock : public FileLock {
+            public:
+                LIBEXP UpdateLock(std::string kbdir);
+        };
+
+        //Shared lock of a reader on the current generation (on its
+        //kbstats). The generation is not removed while it is held. When it
+        //is released, the old generations that nobody uses are removed
+        class ReaderLock {
+            private:
+                const std::string kbdir;
+                uint64_t gen;
+                std::unique_ptr<FileLock> lock;
+
+            public:
+                LIBEXP ReaderLock(std::string kbdir);
+
+                ReaderLock(const ReaderLock&) = delete;
+
+                ReaderLock &operator=(const ReaderLock&) = delete;
+
+                std::string getPath() const {
+                    return getGenerationDir(kbdir, gen);
+                }
+
+                LIBEXP ~ReaderLock();
+        };
+
+    private:
+        static const std::vector<std::string> SHARED_ENTRIES;
+
+        const std::string kbdir;
+        KBConfig config;
+        const uint32_t minDiffs;
+        const uint32_t intervalSec;
+        const int nthreads;
+
+        std::shared_ptr<KB> current;
+        std::mutex currentMutex;
+
+        std::thread worker;
+        std::mutex stopMutex;
+        std::condition_variable stopCond;
+        bool stopped;
+
+        //Opens the current generation with all its updates
+        std::shared_ptr<KB> openCurrentGeneration();
+
+        void run();
+
+        static std::string getGenerationDir(std::string kbdir, uint64_t gen);
+
+        static void setGeneration(std::string kbdir, uint64_t gen);
+
+        //Removes the files of a generation that is no longer current
+        static void removeGeneration(std::string kbdir, uint64_t gen);
+
+    public:
+        //minDiffs is the number of diff indices that triggers a compaction.
+        //The background thread checks it every intervalSec seconds
+        LIBEXP Compactor(std::string kbdir, KBConfig &config,
+                uint32_t minDiffs, uint32_t intervalSec, int nthreads);
+
+        //Returns the KB of the current generation. Keep the pointer as long
+        //as the KB (or queriers created from it) are used
+        LIBEXP std::shared_ptr<KB> getKB();
+
+        //Compacts the current generation if it has at least minDiffs diff
+        //indices. Returns true if a new generation was installed
+        LIBEXP bool compactNow();
+
+        LIBEXP void start();
+
+        LIBEXP void stop();
+
+        LIBEXP ~Compactor();
+
+        //Returns the directory that contains the current generation
+        LIBEXP static std::string getGenerationPath(std::string kbdir);
+
+        LIBEXP static uint64_t getGeneration(std::string kbdir);
+
+        //Number of diff indices stored in a generation
+        LIBEXP static size_t countDiffs(std::string genpath);
+
+        //Builds the next generation from kb (the current one) and commits
+        //it. Returns the path of the new generation, or an empty string if
+        //there was nothing to merge, if kb does not contain all the updates,
+        //if new updates arrived meanwhile or if another compaction of the KB
+        //is running (it holds the file <kbdir>/_compact locked)
+        LIBEXP static std::string compact(KB &kb, std::string kbdir,
+                int nthreads);
+
+        //Removes the generations older than the current one that no
+        //reader holds
+        LIBEXP static void removeUnusedGenerations(std::string kbdir);
+};
+
+#endif
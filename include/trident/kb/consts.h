@@ -67,6 +67,11 @@
 #define DIFF1_ITR 17
 #define RM_ITR 18
 #define RMCOMPOSITETERM_ITR 19
+#define FORCOLUMN_ITR 20
+
+//The storage type in the strategy byte has only three bits. The types above
+//are the same as their ITR, the bit-packed column tables use the first free value
+#define FORCOLUMN_STORAGE 6
 
 //Use for dynamic layout
 #define W_DIFFERENCE 0
@@ -91,6 +96,13 @@
 #define N_PARTITIONS 6
 #define THRESHOLD_KEEP_MEMORY 1000*1024
 
+//Column tables with at least these rows store the first value every
+//2^SKIPINDEX_SHIFT rows of both columns after the second column. The flag is
+//set in the second byte of the table
+#define SKIPINDEX_MINROWS 65536
+#define SKIPINDEX_SHIFT 6
+#define SKIPINDEX_FLAG 0x40
+
 #define MAX_N_FILES 4096
 
 //Used in the cache of the tree to serialize the nodes
@@ -25,6 +25,7 @@
 
 #include <trident/kb/consts.h>
 #include <trident/kb/statistics.h>
+#include <trident/kb/termcache.h>
 
 #include <kognac/hashfunctions.h>
 #include <kognac/utils.h>
@@ -33,6 +34,10 @@
 #include <sparsehash/sparse_hash_map>
 #include <sparsehash/dense_hash_map>
 
+#include <memory>
+#include <ostream>
+#include <vector>
+
 class Root;
 class StringBuffer;
 class TreeItr;
@@ -137,6 +142,17 @@ class DictMgmt {
         uint64_t gud_largestID;
         string gudLocation;
 
+        //Decoded terms shared by all the queriers (NULL if disabled)
+        std::unique_ptr<TermCache> termCache;
+
+        int getDictIdx(nTerm key) {
+            int idx = 0;
+            while (idx < beginrange.size() - 1 && key >= beginrange[idx + 1]) {
+                idx++;
+            }
+            return idx;
+        }
+
     public:
 
         DictMgmt(Dict mainDict, string dirToStoreGUD, bool hash, string e2r,
@@ -150,6 +166,11 @@ class DictMgmt {
             return gud_idtext.size();
         }
 
+        //True if the updates added terms that are not in the main dictionary
+        bool hasUpdatedTerms() {
+            return dictionaries.size() > 1 || !gud_idtext.empty();
+        }
+
         uint64_t getNRels() {
             return r2e.size() + r2s.size(); //Either one or the others are populated
         }
@@ -180,6 +201,24 @@ class DictMgmt {
 
         LIBEXP bool getText(nTerm key, char *value, int &size);
 
+        //Decodes many terms at once. The terms that are not cached are
+        //read in the order of their position in the string buffer, so
+        //every compressed block is uncompressed at most once
+        LIBEXP void getTexts(const std::vector<nTerm> &keys,
+                std::vector<std::string> &values,
+                std::vector<bool> &found);
+
+        //Writes all terms (also the ones added by the updates) as
+        //"<id> <length> <text>" lines, the format read by the loader
+        //when the input is already compressed
+        void exportTerms(std::ostream &out);
+
+        void setTermCacheSize(int64_t bytes);
+
+        TermCache *getTermCache() {
+            return termCache.get();
+        }
+
         void getTextFromCoordinates(int64_t coordinates, char *output,
                 int &sizeOutput);
 
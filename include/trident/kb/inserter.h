@@ -59,6 +59,7 @@ class Inserter {
         const char fixedStrategy;
 
         bool useRowForLargeTables;
+        bool useFORColumnStorage;
         size_t thresholdForColumnStorage;
         const size_t thresholdSkipTable;
 
@@ -91,6 +92,7 @@ class Inserter {
         Factory<NewColumnTableInserter> ncFactory[N_PARTITIONS];
         Factory<NewRowTableInserter> nrFactory[N_PARTITIONS];
         Factory<NewClusterTableInserter> ncluFactory[N_PARTITIONS];
+        Factory<FORColumnTableInserter> forFactory[N_PARTITIONS];
         BinaryTableInserter *currentPairHandler[N_PARTITIONS];
 
         //Store the number of virtual tables per partition
@@ -119,6 +121,7 @@ class Inserter {
                 int64_t *ntables, int64_t *nFirstElsNTables) : nTerms(nTerms),
         useFixedStrategy(useFixedStrategy), fixedStrategy(fixedStrategy),
         useRowForLargeTables(false),
+        useFORColumnStorage(false),
         thresholdForColumnStorage(StorageStrat::getBinaryBreakingPoint()),
         thresholdSkipTable(thresholdSkipTable),
         ntables(ntables), nFirstElsNTables(nFirstElsNTables) {
@@ -130,13 +133,14 @@ class Inserter {
                 currentT1[i] = -1;
                 values1[i] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
                 values2[i] = new int64_t[THRESHOLD_KEEP_MEMORY + 1];
-                storageStrategy[i].init(/*NULL, NULL, NULL,*/ NULL, NULL, NULL,
+                storageStrategy[i].init(/*NULL, NULL, NULL,*/ NULL, NULL, NULL, NULL,
                         &listFactory[i],
                         &comprFactory[i],
                         &list2Factory[i],
                         &ncFactory[i],
                         &nrFactory[i],
-                        &ncluFactory[i]);
+                        &ncluFactory[i],
+                        &forFactory[i]);
                 currentPairHandler[i] = NULL;
 
                 lastFirstTerm[i] = -1;
@@ -150,6 +154,12 @@ class Inserter {
 
         void disableColumnStorage() {
             thresholdForColumnStorage = std::numeric_limits<size_t>::max();
+            useFORColumnStorage = false;
+        }
+
+        //The SNAP analytics cannot read the bit-packed tables
+        void enableFORColumnStorage() {
+            useFORColumnStorage = true;
         }
 
         void setUsageRowForLargeTables() {
@@ -29,11 +29,18 @@
 #include <trident/kb/kbconfig.h>
 #include <trident/kb/cacheidx.h>
 #include <trident/kb/diffindex.h>
+#include <trident/kb/searchindex.h>
+#include <trident/kb/membershipfilter.h>
+#include <trident/kb/charsets.h>
+#include <trident/kb/compactor.h>
 #include <trident/utils/memorymgr.h>
 
 #include <kognac/factory.h>
 
 #include <string>
+#ifdef MT
+#include <mutex>
+#endif
 
 class Leaf;
 class Querier;
@@ -50,6 +57,10 @@ typedef enum e_GraphType { DEFAULT, DIRECTED, UNDIRECTED } GraphType;
 
 class KB {
     private:
+        //Keeps the generation opened for reading from being removed. It
+        //is released after all the files of the KB are closed
+        std::unique_ptr<Compactor::ReaderLock> readerLock;
+
         const string path;
 
         const bool readOnly;
@@ -104,6 +115,18 @@ class KB {
         std::unique_ptr<ROMappedFile> ops_f;
         std::unique_ptr<ROMappedFile> osp_f;
 
+        //Opened the first time it is requested
+        std::unique_ptr<SearchIndex> searchIndex;
+#ifdef MT
+        std::mutex searchIndexMutex;
+#endif
+
+        //Loaded only if the KB is read-only, since the inserts do not update it
+        std::unique_ptr<MembershipFilter> membershipFilter;
+
+        //Loaded only if the KB is read-only, like the membership filters
+        std::unique_ptr<CharacteristicSets> characteristicSets;
+
         void loadDict(KBConfig *config);
 
         void createNewDict(std::string dir);
@@ -113,6 +136,11 @@ class KB {
 
         int cmp(PairItr *itr, uint64_t s, uint64_t p, uint64_t o);
 
+        void addDiffToMembershipFilter(DiffIndex *diff, Querier *q);
+
+        void getDiffChanges(DiffIndex *diff, Querier *q,
+                std::vector<CharacteristicSets::Change> &changes);
+
     public:
         DDLEXPORT KB(const char *path, bool readOnly, bool reasoning,
                 bool dictEnabled, KBConfig &config) : KB(path, readOnly, reasoning,
@@ -132,6 +160,26 @@ class KB {
 
         DDLEXPORT void mergeUpdates();
 
+        //Returns NULL if the search index was not built or if the updates
+        //added terms that it does not contain
+        DDLEXPORT SearchIndex *getSearchIndex();
+
+        DDLEXPORT void buildSearchIndex();
+
+        //Returns NULL if the membership filters were not built
+        const MembershipFilter *getMembershipFilter() const {
+            return membershipFilter.get();
+        }
+
+        DDLEXPORT void buildMembershipFilter();
+
+        //Returns NULL if the characteristic sets were not built
+        const CharacteristicSets *getCharacteristicSets() const {
+            return characteristicSets.get();
+        }
+
+        DDLEXPORT void buildCharacteristicSets();
+
         void closeMainDict();
 
         void close();
@@ -140,16 +188,37 @@ class KB {
 
         DDLEXPORT Stats *getStatsDict();
 
+        //Counters of the caches: files opened by the tables, blocks of the
+        //memory trackers, blocks of the dictionary and nodes of the trees
+        struct CacheCounters {
+            uint64_t fileAccesses, fileOpens, fileCloses;
+            uint64_t memEvictions, memBytes;
+            uint64_t dictBlockAccesses, dictBlockReads, dictBlockEvictions;
+            uint64_t dictBytesRead;
+            uint64_t nodeAccesses, nodeLoads;
+        };
+
+        DDLEXPORT CacheCounters getCacheCounters();
+
         string getDictPath(int i);
 
         string getPath() {
             return path;
         }
 
+        //Number of diff indices loaded with the KB
+        size_t getNDiffIndices() const {
+            return diffIndices.size();
+        }
+
         int getNIndices() const {
             return nindices;
         }
 
+        bool areIndicesAggregated() const {
+            return aggrIndices;
+        }
+
         uint64_t getNTerms() const {
             return totalNumberTerms;
         }
@@ -196,7 +265,9 @@ class KB {
 
         std::vector<const char*> openAllFiles(int perm);
 
-        void addDiffIndex(string inputdir, const char **globalbuffers, Querier *q);
+        //The membership filters and the characteristic sets are updated
+        //once all diff indices are loaded
+        void addDiffIndex(string inputdir, const char **globalbuffers);
 
         DDLEXPORT ~KB();
 };
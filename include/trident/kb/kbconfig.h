@@ -90,11 +90,17 @@ typedef enum {
     STORAGE_CACHE_SIZE,
     STORAGE_MAX_FILE_SIZE,
     STORAGE_MAX_N_FILES,
+//Size of the two buffers used to write the tables in the background (0 writes
+//them through the mapping)
+    STORAGE_ASYNC_BUFFER_SIZE,
 
 //Parameters about the string buffer
     SB_COMPRESSDOMAINS,
     SB_PREALLBUFFERS,
-    SB_CACHESIZE
+    SB_CACHESIZE,
+
+//Max size in bytes of the decoded terms cached by the dictionary (0 disables it)
+    DICT_TERMCACHESIZE
 
 } KBParam;
 
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+#ifndef _MEMBERSHIPFILTER_H
+#define _MEMBERSHIPFILTER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+//Blocked Bloom filters over all triples and over the pairs (s,p), (p,o) and
+//(s,o), i.e., the (first,second) pairs of all permutations. Every key sets
+//one bit in each of the eight words of a 512-bit block, so a probe touches a
+//single cache line. A negative answer is exact, a positive one may be wrong
+class MembershipFilter {
+    public:
+        enum Kind { TRIPLES = 0, SP = 1, PO = 2, SO = 3 };
+        static const int NFILTERS = 4;
+        static const int WORDSPERBLOCK = 8;
+        static const int BITSPERKEY = 10;
+
+    private:
+        std::vector<uint64_t> words[NFILTERS];
+        uint64_t nblocks[NFILTERS];
+
+        static uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            h *= 0xc4ceb9fe1a85ec53ULL;
+            h ^= h >> 33;
+            return h;
+        }
+
+        static uint64_t hash(const uint64_t a, const uint64_t b) {
+            return mix(a + mix(b));
+        }
+
+        static uint64_t hash(const uint64_t a, const uint64_t b,
+                const uint64_t c) {
+            return mix(a + mix(b + mix(c)));
+        }
+
+        static uint64_t getMask(const uint64_t h, const int i) {
+            static const uint32_t salts[WORDSPERBLOCK] = {
+                0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U };
+            return (uint64_t) 1 << (((uint32_t) h * salts[i]) >> 26);
+        }
+
+        uint64_t *getBlock(const int f, const uint64_t h) {
+            return words[f].data() +
+                (((h >> 32) * nblocks[f]) >> 32) * WORDSPERBLOCK;
+        }
+
+        void add(const int f, const uint64_t h) {
+            uint64_t *block = getBlock(f, h);
+            for (int i = 0; i < WORDSPERBLOCK; ++i) {
+                block[i] |= getMask(h, i);
+            }
+        }
+
+        bool contains(const int f, const uint64_t h) const {
+            const uint64_t *block = words[f].data() +
+                (((h >> 32) * nblocks[f]) >> 32) * WORDSPERBLOCK;
+            for (int i = 0; i < WORDSPERBLOCK; ++i) {
+                if (!(block[i] & getMask(h, i))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        //nkeys contains the expected number of keys of every filter
+        MembershipFilter(const int64_t nkeys[NFILTERS]);
+
+        MembershipFilter(std::string file);
+
+        static bool exists(std::string file);
+
+        void add(const int64_t s, const int64_t p, const int64_t o) {
+            add(TRIPLES, hash(s, p, o));
+            add(SP, hash(s, p));
+            add(PO, hash(p, o));
+            add(SO, hash(s, o));
+        }
+
+        //Negative values are variables. Returns false only if no triple can
+        //match the pattern
+        bool mayContain(const int64_t s, const int64_t p,
+                const int64_t o) const {
+            if (s >= 0 && p >= 0 && o >= 0) {
+                return contains(TRIPLES, hash(s, p, o));
+            } else if (s >= 0 && p >= 0) {
+                return contains(SP, hash(s, p));
+            } else if (p >= 0 && o >= 0) {
+                return contains(PO, hash(p, o));
+            } else if (s >= 0 && o >= 0) {
+                return contains(SO, hash(s, o));
+            }
+            return true;
+        }
+
+        void store(std::string file) const;
+
+        uint64_t getSize() const;
+};
+
+#endif
@@ -41,6 +41,7 @@
 #include <trident/binarytables/storagestrat.h>
 #include <trident/binarytables/factorytables.h>
 #include <trident/kb/diffindex.h>
+#include <trident/kb/membershipfilter.h>
 
 #include <kognac/factory.h>
 
@@ -73,6 +74,7 @@ class Querier {
 
         std::vector<std::unique_ptr<DiffIndex>> &diffIndices;
         std::unique_ptr<Querier> sampler;
+        const MembershipFilter *filter;
 
         TermCoordinates currentValue;
 
@@ -94,6 +96,7 @@ class Querier {
         Factory<NewColumnTable> ncFactory;
         FactoryNewRowTable nrFactory;
         FactoryNewClusterTable ncluFactory;
+        Factory<FORColumnTable> forFactory;
 
         StorageStrat strat;
 
@@ -109,6 +112,9 @@ class Querier {
                 int64_t v2,
                 const bool setConstraints);
 
+        //Releases the file of a table iterator
+        void unpinTable(AbsNewTable *t);
+
         PairItr *summaryDiff(const int perm, DiffIndex::TypeUpdate tp);
 
     public:
@@ -133,6 +139,16 @@ class Querier {
 
         void initDiffIndex(DiffIndex *diff);
 
+        void setMembershipFilter(const MembershipFilter *filter) {
+            this->filter = filter;
+        }
+
+        //Returns false only if no triple matches the pattern. It does not
+        //access the tree nor the tables
+        bool mayExist(const int64_t s, const int64_t p, const int64_t o) const {
+            return filter == NULL || filter->mayContain(s, p, o);
+        }
+
         TermItr *getKBTermList(const int perm, const bool enforcePerm);
 
         DDLEXPORT PairItr *getTermList(const int perm);
@@ -322,9 +338,13 @@ class Querier {
           const char strategy,
           const int64_t rowId);*/
 
+        //The table stays in memory until releaseTable is called with the pin
         const char *getTable(const int perm,
                 const short fileId,
-                const int64_t markId);
+                const int64_t markId,
+                int &pin);
+
+        void releaseTable(const int perm, const int pin);
 
 };
 
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#ifndef _SEARCHINDEX_H
+#define _SEARCHINDEX_H
+
+#include <trident/utils/memoryfile.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+class DictMgmt;
+
+//On-disk index to search the textual terms of the dictionary. It contains:
+//- prefix.terms/prefix.offsets: all the terms sorted lexicographically,
+//  used for prefix queries;
+//- grams/postings: for every trigram, the sorted list of IDs of the terms
+//  that contain it, used for substring queries.
+//Terms shorter than three bytes have no trigrams. Substring queries find
+//them with exact lookups in the sorted terms.
+class SearchIndex {
+    public:
+        typedef std::pair<int64_t, std::string> Match;
+
+        struct GramEntry {
+            uint32_t gram;
+            uint32_t padding;
+            int64_t offset; //Position of the IDs in the postings file
+            int64_t count;
+        };
+
+    private:
+        std::unique_ptr<MemoryMappedFile> prefixTerms;
+        std::unique_ptr<MemoryMappedFile> prefixOffsets;
+        std::unique_ptr<MemoryMappedFile> grams;
+        std::unique_ptr<MemoryMappedFile> postings;
+        int64_t nTerms;
+        int64_t nGrams;
+
+        void getTerm(const int64_t idx, int64_t &id, const char *&text,
+                int &size) const;
+
+        const GramEntry *getGram(const uint32_t gram) const;
+
+        //Returns the position of the first term >= text
+        int64_t lowerBound(const std::string &text) const;
+
+        bool findExact(const std::string &text, int64_t &id) const;
+
+        void readPostings(const GramEntry *entry, const int64_t limit,
+                std::vector<int64_t> &ids) const;
+
+        static std::unique_ptr<MemoryMappedFile> open(std::string file);
+
+    public:
+        //If the rarest trigram of a substring query has at most this number
+        //of terms, their text is checked directly instead of intersecting
+        //the posting lists
+        static const int64_t VERIFY_THRESHOLD = 1024;
+
+        SearchIndex(std::string dir);
+
+        static bool exists(std::string dir);
+
+        //Builds the index reading all the terms of the main dictionary.
+        //The terms are sorted in runs of at most termsPerRun terms
+        static void build(DictMgmt *dict, std::string dir,
+                int64_t termsPerRun = 4000000);
+
+        int64_t getNTerms() const {
+            return nTerms;
+        }
+
+        void searchPrefix(const std::string &prefix, const int64_t limit,
+                std::vector<Match> &out) const;
+
+        //The posting lists are read while the candidates are checked, so
+        //the search stops after limit matches
+        void searchSubstring(const std::string &text, const int64_t limit,
+                DictMgmt *dict, std::vector<Match> &out) const;
+};
+
+#endif
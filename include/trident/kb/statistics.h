@@ -23,29 +23,101 @@
 #ifndef _STATS_H
 #define _STATS_H
 
+#include <atomic>
+#include <cstdint>
 
+//The counters can be updated by concurrent readers
 class Stats {
 private:
-    int64_t readIndexBlocks;
-    int64_t readIndexBytes;
+    //Blocks of the string buffer
+    std::atomic<int64_t> readIndexBlocks;
+    std::atomic<int64_t> readIndexBytes;
+    std::atomic<int64_t> accessedIndexBlocks;
+    std::atomic<int64_t> evictedIndexBlocks;
+    //Files handled by the file managers
+    std::atomic<int64_t> accessedFiles;
+    std::atomic<int64_t> openedFiles;
+    std::atomic<int64_t> closedFiles;
+
+    void copy(const Stats &other) {
+        readIndexBlocks = other.getNReadIndexBlocks();
+        readIndexBytes = other.getNReadIndexBytes();
+        accessedIndexBlocks = other.getNAccessedIndexBlocks();
+        evictedIndexBlocks = other.getNEvictedIndexBlocks();
+        accessedFiles = other.getNAccessedFiles();
+        openedFiles = other.getNOpenedFiles();
+        closedFiles = other.getNClosedFiles();
+    }
+
 public:
 
-    Stats() : readIndexBlocks(0), readIndexBytes(0) {}
+    Stats() : readIndexBlocks(0), readIndexBytes(0), accessedIndexBlocks(0),
+        evictedIndexBlocks(0), accessedFiles(0), openedFiles(0),
+        closedFiles(0) {}
+
+    Stats(const Stats &other) {
+        copy(other);
+    }
+
+    Stats &operator=(const Stats &other) {
+        copy(other);
+        return *this;
+    }
 
     void incrNReadIndexBlocks() {
-        readIndexBlocks++;
+        readIndexBlocks.fetch_add(1, std::memory_order_relaxed);
     }
 
     void addNReadIndexBytes(const uint64_t bytes) {
-        readIndexBytes += bytes;
+        readIndexBytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    void incrNAccessedIndexBlocks() {
+        accessedIndexBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void incrNEvictedIndexBlocks() {
+        evictedIndexBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void incrNAccessedFiles() {
+        accessedFiles.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void incrNOpenedFiles() {
+        openedFiles.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void incrNClosedFiles() {
+        closedFiles.fetch_add(1, std::memory_order_relaxed);
     }
 
     uint64_t getNReadIndexBlocks() const {
-        return readIndexBlocks;
+        return readIndexBlocks.load(std::memory_order_relaxed);
     }
 
     uint64_t getNReadIndexBytes() const {
-        return readIndexBytes;
+        return readIndexBytes.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNAccessedIndexBlocks() const {
+        return accessedIndexBlocks.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNEvictedIndexBlocks() const {
+        return evictedIndexBlocks.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNAccessedFiles() const {
+        return accessedFiles.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNOpenedFiles() const {
+        return openedFiles.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNClosedFiles() const {
+        return closedFiles.load(std::memory_order_relaxed);
     }
 };
 
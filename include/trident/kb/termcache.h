@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#ifndef _TERMCACHE_H
+#define _TERMCACHE_H
+
+#include <string>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#ifdef MT
+#include <mutex>
+#endif
+
+//Size-bounded cache of decoded dictionary terms. It is split in shards
+//with their own LRU list (and lock, with MT), so that queriers running in
+//different threads can share it.
+class TermCache {
+    private:
+        static const int NSHARDS = 16;
+
+        struct Shard {
+            typedef std::list<std::pair<uint64_t, std::string>> LRUList;
+            LRUList lru; //Most recent at the front
+            std::unordered_map<uint64_t, LRUList::iterator> index;
+            int64_t bytes;
+#ifdef MT
+            std::mutex mutex;
+#endif
+            Shard() : bytes(0) {}
+        };
+
+        const int64_t maxBytesPerShard;
+        Shard shards[NSHARDS];
+
+        Shard &getShard(const uint64_t key) {
+            return shards[(key * UINT64_C(0x9E3779B97F4A7C15)) >> 60];
+        }
+
+        static int64_t entrySize(const std::string &value) {
+            return value.size() + 64; //Rough overhead of the list and map
+        }
+
+    public:
+        TermCache(const int64_t maxBytes) : maxBytesPerShard(maxBytes / NSHARDS) {
+        }
+
+        bool get(const uint64_t key, std::string &value);
+
+        bool get(const uint64_t key, char *value, int &size);
+
+        void put(const uint64_t key, const char *value, const int size);
+
+        int64_t getSizeBytes();
+
+        void clear();
+};
+
+#endif
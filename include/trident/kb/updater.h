@@ -28,9 +28,14 @@
 
 #include <kognac/stringscol.h>
 #include <kognac/hashmap.h>
+#include <kognac/filereader.h>
+#include <kognac/filemerger.h>
+#include <kognac/triple.h>
 
 #include <string>
 #include <cstring>
+#include <vector>
+#include <unordered_map>
 
 class Querier;
 class PairItr;
@@ -38,42 +43,21 @@ class KB;
 class DictMgmt;
 class Updater {
     private:
+        //State shared by the threads that parse the update
+        struct ParseContext;
 
-        struct Triple {
-            uint64_t s;
-            uint64_t p;
-            uint64_t o;
-
-            static bool sorter(const Triple &t1, const Triple &t2) {
-                if (t1.s < t2.s) {
-                    return true;
-                } else if (t1.s == t2.s) {
-                    if (t1.p < t2.p) {
-                        return true;
-                    } else if (t1.p == t2.p) {
-                        return t1.o < t2.o;
-                    }
-                }
-                return false;
-            }
-
-            static bool equal(const Triple &t1, const Triple &t2) {
-                return t1.s == t2.s && t1.p == t2.p && t1.o == t2.o;
-            }
-
-        };
-
-        struct TextualTriple {
-            const char *s;
-            int lens;
-            uint64_t nums;
-            const char *p;
-            uint64_t nump;
-            int lenp;
-            const char *o;
-            uint64_t numo;
-            int leno;
-        };
+        //Splits the files of the update in chunks that can be parsed
+        //independently
+        static std::vector<FileInfo> splitUpdate(std::string update,
+                int nthreads);
+
+        static uint64_t encodeTerm(ParseContext *ctx,
+                std::unordered_map<std::string, uint64_t> &cache,
+                const char *term, int len);
+
+        static void dumpRun(ParseContext *ctx, std::vector<Triple> &triples);
+
+        static void parseUpdate(ParseContext *ctx);
 
         void compressUpdate(DiffIndex::TypeUpdate type,
                 string updatedir,
@@ -83,49 +67,23 @@ class Updater {
                 KB *kb,
                 Querier *q,
                 ByteArrayToNumberMap &tmpdict,
-                StringCollection &tmpdictsupport);
-
-        void parseUpdate(std::string update,
-                StringCollection &support,
-                std::vector<TextualTriple> &output);
+                StringCollection &tmpdictsupport,
+                int nthreads);
 
         static void match(DiffIndex::TypeUpdate type,
                 std::vector<uint64_t> &outputs,
                 std::vector<uint64_t> &outputp,
                 std::vector<uint64_t> &outputo,
                 Querier *q,
-                std::vector<Triple> &input);
-
-        static bool lessThan(const char *s1, int len1, const char *s2, int len2) {
-            int len = len1 < len2 ? len1 : len2;
-            int c = strncmp(s1, s2, len);
-            if (c != 0) {
-                return c < 0;
-            }
-            return len1 < len2;
-        }
-
-        static bool sortByS(const TextualTriple &t1, const TextualTriple &t2) {
-            // return std::string(t1.s, t1.lens) < std::string(t2.s, t2.lens);
-            return lessThan(t1.s, t1.lens, t2.s, t2.lens);
-        }
-
-        static bool sortByP(const TextualTriple &t1, const TextualTriple &t2) {
-            // return std::string(t1.p, t1.lenp) < std::string(t2.p, t2.lenp);
-            return lessThan(t1.p, t1.lenp, t2.p, t2.lenp);
-        }
-
-        static bool sortByO(const TextualTriple &t1, const TextualTriple &t2) {
-            // return std::string(t1.o, t1.leno) < std::string(t2.o, t2.leno);
-            return lessThan(t1.o, t1.leno, t2.o, t2.leno);
-        }
+                FileMerger<Triple> &input);
 
         static int cmp(PairItr *itr, const Triple &t);
 
         static void writeDict(DictMgmt *dictmgmt, string updatedir, ByteArrayToNumberMap &dict);
 
     public:
-        LIBEXP void creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir, std::string updatedir);
+        LIBEXP void creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir, std::string updatedir,
+                int nthreads = 1);
 
         LIBEXP static std::string getPathForUpdate(std::string kbdir);
 };
@@ -37,6 +37,7 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <functional>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -224,6 +225,17 @@ struct ParamInsert {
     bool deletePreviousExt;
 };
 
+//A step of the concurrent construction of the indices. It starts when the
+//task it depends on has finished and its memory fits in the budget
+struct IndexTask {
+    std::function<void()> run;
+    int64_t memory;
+    int dependsOn;
+
+    IndexTask(std::function<void()> run, int64_t memory, int dependsOn) :
+        run(run), memory(memory), dependsOn(dependsOn) {}
+};
+
 class L_Triple {
     public:
         uint64_t first, second, third;
@@ -405,6 +417,11 @@ struct ParamsLoad {
     bool storeDicts;
     bool relsOwnIDs;
     bool flatTree;
+    bool searchIndex;
+    bool membershipFilter;
+    bool characteristicSets;
+    bool forColumns;
+    int concurrentIndices;
 
     ParamsLoad() {
         /**** DEFAULT VALUES ****/
@@ -437,6 +454,11 @@ struct ParamsLoad {
         storeDicts = true;
         relsOwnIDs = false;
         flatTree = false;
+        searchIndex = false;
+        membershipFilter = false;
+        characteristicSets = false;
+        forColumns = false;
+        concurrentIndices = 1;
     }
 
     std::string tostring() {
@@ -470,6 +492,11 @@ struct ParamsLoad {
         output += ";storeDicts=" + to_string(storeDicts);
         output += ";relsOwnIDs=" + to_string(relsOwnIDs);
         output += ";flatTree=" + to_string(flatTree);
+        output += ";searchIndex=" + to_string(searchIndex);
+        output += ";membershipFilter=" + to_string(membershipFilter);
+        output += ";characteristicSets=" + to_string(characteristicSets);
+        output += ";forColumns=" + to_string(forColumns);
+        output += ";concurrentIndices=" + to_string(concurrentIndices);
         return output;
     }
 };
@@ -613,7 +640,33 @@ class Loader {
                 string remoteLocation,
                 int64_t limitSpace,
                 int64_t estimatedSize,
-                int nindices);
+                int nindices,
+                int concurrentIndices);
+
+        //Merges and inserts up to concurrentIndices permutations at the
+        //same time
+        void createIndices_concurrent(
+                int parallelProcesses,
+                int maxReadingThreads,
+                Inserter *ins,
+                const bool aggrIndices,
+                const bool canSkipTables,
+                const bool storePlainList,
+                string *permDirs,
+                string *outputDirs,
+                string aggr1Dir,
+                string aggr2Dir,
+                TreeWriter **treeWriters,
+                SimpleTripleWriter *sampleWriter,
+                double sampleRate,
+                string remoteLocation,
+                int64_t limitSpace,
+                int64_t estimatedSize,
+                int concurrentIndices);
+
+        static void runIndexTasks(std::vector<IndexTask> &tasks,
+                int maxConcurrent,
+                int64_t memoryBudget);
 
         void loadKB_createSamples(string kbDir,
                 string sampleDir,
@@ -638,7 +691,8 @@ class Loader {
                 Inserter *ins,
                 bool relsOwnIDs,
                 string kbDir,
-                bool storeDicts);
+                bool storeDicts,
+                int parallelProcesses);
 
         void loadKB_createTree(KB &kb,
                 string *sTreeWriters,
@@ -684,6 +738,18 @@ class Loader {
                 int maxReadingThreads,
                 int parallelProcesses);
 
+        static void parseSnapFile_seq(DiskReader *reader,
+                std::vector<std::pair<int64_t, int64_t>> *edges,
+                std::vector<int64_t> *nodes);
+
+        static void writeSnapFile_seq(
+                std::vector<std::pair<int64_t, int64_t>> *edges,
+                const std::vector<int64_t> *nodes,
+                string *permDirs,
+                const int *detailPerms,
+                int nperms,
+                int id);
+
         static int64_t parseSnapFile(
                 string inputtriples,
                 string inputdict,
@@ -0,0 +1,98 @@
+#ifndef _SCORE_KERNELS_H
+#define _SCORE_KERNELS_H
+
+#include <cstdint>
+#include <cmath>
+#include <mutex>
+
+//Scores a query vector against a block of n entity embeddings stored one
+//after the other (n * dim values). Lower scores are better. The double
+//versions use AVX2 if the machine supports it (picked at the first call)
+class ScoreKernels {
+    public:
+        typedef void (*Kernel)(const double *query,
+                const double *entities,
+                const uint64_t n,
+                const uint16_t dim,
+                double *out);
+
+    private:
+        static Kernel l1Kernel;
+        static Kernel negDotKernel;
+        static std::once_flag selected;
+
+        static void select();
+
+        static void init() {
+            std::call_once(selected, &ScoreKernels::select);
+        }
+
+    public:
+        //L1 distance (TransE)
+        static void l1(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out) {
+            init();
+            l1Kernel(query, entities, n, dim, out);
+        }
+
+        template<typename K>
+        static void l1(const K *query, const K *entities,
+                const uint64_t n, const uint16_t dim, double *out) {
+            for (uint64_t r = 0; r < n; ++r) {
+                const K *e = entities + r * dim;
+                double res = 0;
+                for (uint16_t i = 0; i < dim; ++i) {
+                    res += std::abs(query[i] - e[i]);
+                }
+                out[r] = res;
+            }
+        }
+
+        //Negated dot product (DistMult)
+        static void negDot(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out) {
+            init();
+            negDotKernel(query, entities, n, dim, out);
+        }
+
+        template<typename K>
+        static void negDot(const K *query, const K *entities,
+                const uint64_t n, const uint16_t dim, double *out) {
+            for (uint64_t r = 0; r < n; ++r) {
+                const K *e = entities + r * dim;
+                double res = 0;
+                for (uint16_t i = 0; i < dim; ++i) {
+                    res += query[i] * e[i];
+                }
+                out[r] = -res;
+            }
+        }
+
+        //Number of scores strictly lower than target
+        static uint64_t countBetter(const double *scores, const uint64_t n,
+                const double target) {
+            uint64_t count = 0;
+            for (uint64_t i = 0; i < n; ++i) {
+                count += scores[i] < target;
+            }
+            return count;
+        }
+
+        static void l1_scalar(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out);
+
+        static void l1_avx2(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out);
+
+        static void negDot_scalar(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out);
+
+        static void negDot_avx2(const double *query, const double *entities,
+                const uint64_t n, const uint16_t dim, double *out);
+
+        static bool isAVX2Supported();
+
+        static const char *getKernelName();
+};
+
+#endif
@@ -2,13 +2,19 @@
 #define _TESTER_H
 
 #include <trident/ml/embeddings.h>
+#include <trident/ml/scorekernels.h>
 #include <trident/kb/kb.h>
+#include <trident/kb/querier.h>
 #include <trident/utils/json.h>
 
 #include <kognac/logs.h>
 
 #include <cstdint>
 #include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -20,19 +26,49 @@ class Tester {
     private:
         std::shared_ptr<Embeddings<K>> E;
         std::shared_ptr<Embeddings<K>> R;
+        //If set, the ranks are also computed in the "filtered" setting
+        KB *kb;
+#ifndef MT
+        //Without MT, the queriers of the same KB cannot be used in parallel
+        std::mutex kbMutex;
+#endif
 
-        static uint64_t getPos(const uint64_t ne, const std::vector<double> &scores,
-                std::vector<size_t> &indices,
-                std::vector<size_t> &indices2,
-                const uint64_t pos) {
-
-            std::sort(indices.begin(), indices.end(), [&](size_t lhs, size_t rhs) {
-                    return scores[lhs] < scores[rhs];
-                    });
-            std::sort(indices2.begin(), indices2.end(), [&](size_t lhs, size_t rhs) {
-                    return indices[lhs] < indices[rhs];
-                    });
-            return indices2[pos];
+        //Test triples are handed out to the threads in groups of this size
+        static const uint64_t TRIPLES_PER_TASK = 16;
+
+        //Returns the position of target (starting from 1) if the entities
+        //are sorted by score. Entities with the same score as target are
+        //not counted. The entities in known (other than target) are skipped
+        static uint64_t getPos(const std::vector<double> &scores,
+                const uint64_t target,
+                const std::vector<uint64_t> *known) {
+            const double score = scores[target];
+            uint64_t pos = ScoreKernels::countBetter(scores.data(),
+                    scores.size(), score);
+            if (known != NULL) {
+                for (const auto e : *known) {
+                    if (e != target && e < scores.size() && scores[e] < score) {
+                        pos--;
+                    }
+                }
+            }
+            return pos + 1;
+        }
+
+        //Collects the third element of all triples with the given first two
+        //elements (e.g. the objects of <s,p,?> with IDX_SPO)
+        void getKnown(Querier *q, const int idx, const uint64_t first,
+                const uint64_t second, std::vector<uint64_t> &out) {
+#ifndef MT
+            std::lock_guard<std::mutex> lock(kbMutex);
+#endif
+            out.clear();
+            PairItr *itr = q->getPermuted(idx, first, second, -1, true);
+            while (itr->hasNext()) {
+                itr->next();
+                out.push_back(itr->getValue2());
+            }
+            q->releaseItr(itr);
         }
 
         struct _OutputTest {
@@ -42,6 +78,13 @@ class Tester {
             uint64_t hit10S = 0;
             uint64_t hit3S = 0;
             uint64_t hit3O = 0;
+            //Filtered setting
+            uint64_t fpositionsO = 0;
+            uint64_t fpositionsS = 0;
+            uint64_t fhit10O = 0;
+            uint64_t fhit10S = 0;
+            uint64_t fhit3S = 0;
+            uint64_t fhit3O = 0;
         };
 
         struct ResSingleQuery {
@@ -50,8 +93,9 @@ class Tester {
             uint64_t s,p,o;
         };
 
-        void test_seq(std::vector<uint64_t> &testset, size_t start,
-                size_t end, _OutputTest *out,
+        void test_seq(std::vector<uint64_t> &testset,
+                std::atomic<uint64_t> *nextTriple,
+                _OutputTest *out,
                 std::vector<ResSingleQuery> &resultsPerQuery) {
 
             //Support variables
@@ -63,81 +107,94 @@ class Tester {
             const uint16_t dime = E->getDim();
             const uint16_t dimr = R->getDim();
             std::vector<K> testArray(dime);
-            double *test = testArray.data();
-            std::vector<std::size_t> indices(ne);
-            std::iota(indices.begin(), indices.end(), 0u);
-            std::vector<std::size_t> indices2(ne);
-            std::iota(indices2.begin(), indices2.end(), 0u);
-
-            //Output statistics
-            uint64_t positionsO = 0;
-            uint64_t positionsS = 0;
-            uint64_t hit10O = 0;
-            uint64_t hit10S = 0;
-            uint64_t hit3S = 0;
-            uint64_t hit3O = 0;
+            K *test = testArray.data();
+            K *entities = pE->get(0);
+
+            std::unique_ptr<Querier> q;
+            std::vector<uint64_t> known;
+            if (kb != NULL) {
+#ifndef MT
+                std::lock_guard<std::mutex> lock(kbMutex);
+#endif
+                q = std::unique_ptr<Querier>(kb->query());
+            }
 
-            int64_t counter = 0;
-            int stepperc = 10;
-            int64_t sizeinput = end - start;
-            while (start != end)  {
-                //Get an input triple to test
-                uint64_t s = testset[start];
-                uint64_t p = testset[start+1];
-                uint64_t o = testset[start+2];
-                start += 3;
-
-                //Test objects
-                predictO(pE->get(s), dime, pR->get(p), dimr, test);
-                for(uint64_t idx = 0; idx < ne; ++idx) {
-                    scores[idx] = closeness(test, pE->get(idx), dime);
+            const uint64_t ntriples = testset.size() / 3;
+            _OutputTest stats;
+            while (true) {
+                uint64_t first = nextTriple->fetch_add(TRIPLES_PER_TASK);
+                if (first >= ntriples) {
+                    break;
                 }
-                const uint64_t posO = getPos(ne, scores, indices, indices2, o) + 1;
-                positionsO += posO;
-                hit10O += posO <= 10;
-                hit3O += posO <= 3;
-
-                //Test subjects
-                predictS(test, pR->get(p), dimr, pE->get(o), dime);
-                for(uint64_t idx = 0; idx < ne; ++idx) {
-                    scores[idx] = closeness(test, pE->get(idx), dime);
+                const uint64_t last = first + TRIPLES_PER_TASK < ntriples ?
+                    first + TRIPLES_PER_TASK : ntriples;
+                for (uint64_t t = first; t < last; ++t) {
+                    //Get an input triple to test
+                    uint64_t s = testset[3 * t];
+                    uint64_t p = testset[3 * t + 1];
+                    uint64_t o = testset[3 * t + 2];
+
+                    //Test objects
+                    predictO(pE->get(s), dime, pR->get(p), dimr, test);
+                    closenessBlock(test, entities, ne, dime, scores.data());
+                    const uint64_t posO = getPos(scores, o, NULL);
+                    stats.positionsO += posO;
+                    stats.hit10O += posO <= 10;
+                    stats.hit3O += posO <= 3;
+                    if (q) {
+                        getKnown(q.get(), IDX_SPO, s, p, known);
+                        const uint64_t fposO = getPos(scores, o, &known);
+                        stats.fpositionsO += fposO;
+                        stats.fhit10O += fposO <= 10;
+                        stats.fhit3O += fposO <= 3;
+                    }
+
+                    //Test subjects
+                    predictS(test, pR->get(p), dimr, pE->get(o), dime);
+                    closenessBlock(test, entities, ne, dime, scores.data());
+                    const uint64_t posS = getPos(scores, s, NULL);
+                    stats.positionsS += posS;
+                    stats.hit10S += posS <= 10;
+                    stats.hit3S += posS <= 3;
+                    if (q) {
+                        getKnown(q.get(), IDX_OPS, o, p, known);
+                        const uint64_t fposS = getPos(scores, s, &known);
+                        stats.fpositionsS += fposS;
+                        stats.fhit10S += fposS <= 10;
+                        stats.fhit3S += fposS <= 3;
+                    }
+
+                    //Store the results per single query
+                    ResSingleQuery &res = resultsPerQuery[t];
+                    res.s = s;
+                    res.p = p;
+                    res.o = o;
+                    res.posO = posO;
+                    res.posS = posS;
                 }
-                const uint64_t posS = getPos(ne, scores, indices, indices2, s) + 1;
-                positionsS += posS;
-                hit10S += posS <= 10;
-                hit3S += posS <= 3;
 
                 //Track progress
-                counter++;
-                float perc = (float)(3*counter) / sizeinput * 100;
-                if (perc > stepperc) {
-                    LOG(DEBUGL) << "***Processed " << perc << "\% testcases***";
-                    stepperc += 10;
+                if (first * 10 / ntriples != last * 10 / ntriples) {
+                    LOG(DEBUGL) << "***Processed " << (last * 100 / ntriples)
+                        << "\% testcases***";
                 }
-
-                //Store the results per single query
-                ResSingleQuery res;
-                res.s = s;
-                res.p = p;
-                res.o = o;
-                res.posO = posO;
-                res.posS = posS;
-                resultsPerQuery.push_back(res);
             }
-
-            out->positionsO = positionsO;
-            out->positionsS = positionsS;
-            out->hit10O = hit10O;
-            out->hit10S = hit10S;
-            out->hit3O = hit3O;
-            out->hit3S = hit3S;
+            if (q) {
+#ifndef MT
+                std::lock_guard<std::mutex> lock(kbMutex);
+#endif
+                q = std::unique_ptr<Querier>();
+            }
+            *out = stats;
         }
 
     public:
         Tester(std::shared_ptr<Embeddings<K>> E,
-                std::shared_ptr<Embeddings<K>> R) {
+                std::shared_ptr<Embeddings<K>> R,
+                KB *kb = NULL) {
             this->E = E;
             this->R = R;
+            this->kb = kb;
         }
 
         struct OutputTest {
@@ -147,6 +204,14 @@ class Tester {
 
         virtual double closeness(K *v1, K *v2, uint16_t dim) = 0;
 
+        //Scores v1 against n vectors stored one after the other in v2
+        virtual void closenessBlock(K *v1, K *v2, const uint64_t n,
+                uint16_t dim, double *out) {
+            for (uint64_t i = 0; i < n; ++i) {
+                out[i] = closeness(v1, v2 + i * dim, dim);
+            }
+        }
+
         virtual void predictO(K *s, uint16_t dims, K *p, uint16_t dimp, K* o) = 0;
 
         virtual void predictS(K *s, K *p, uint16_t dimp, K* o, uint16_t dimo) = 0;
@@ -157,51 +222,46 @@ class Tester {
                 const uint16_t epoch) {
             std::chrono::time_point<std::chrono::system_clock> starttime =std::chrono::system_clock::now();
 
+            uint64_t ntriples = testset.size() / 3;
             std::vector<_OutputTest> outputs;
-            std::vector<std::vector<ResSingleQuery>> resQueries;
-            resQueries.resize(nthreads);
+            std::vector<ResSingleQuery> resQueries(ntriples);
             outputs.resize(nthreads);
             std::vector<std::thread> threads;
             threads.resize(nthreads);
-            uint64_t ntriples = testset.size() / 3;
-            uint64_t triplesPerThread = ntriples / nthreads;
-            uint64_t nelsPerThread = triplesPerThread * 3;
-
-            size_t start = 0;
+            std::atomic<uint64_t> nextTriple(0);
             for(uint16_t i = 0; i < nthreads; ++i) {
-                size_t end = 0;
-                if (i == nthreads - 1) {
-                    end = testset.size();
-                } else {
-                    end = start + nelsPerThread;
-                }
                 threads[i] = std::thread(&Tester::test_seq,
                         this,
                         std::ref(testset),
-                        start,
-                        end,
+                        &nextTriple,
                         &outputs[i],
-                        std::ref(resQueries[i]));
-                start = end;
+                        std::ref(resQueries));
             }
             for(uint16_t i = 0; i < nthreads; ++i) {
                 threads[i].join();
             }
-            uint64_t positionsO = 0;
-            uint64_t positionsS = 0;
-            uint64_t hit10O = 0;
-            uint64_t hit10S = 0;
-            uint64_t hit3S = 0;
-            uint64_t hit3O = 0;
+            _OutputTest tot;
             //Collect the numbers
             for(uint16_t i = 0; i < nthreads; ++i) {
-                positionsO += outputs[i].positionsO;
-                positionsS += outputs[i].positionsS;
-                hit10O += outputs[i].hit10O;
-                hit10S += outputs[i].hit10S;
-                hit3O += outputs[i].hit3O;
-                hit3S += outputs[i].hit3S;
+                tot.positionsO += outputs[i].positionsO;
+                tot.positionsS += outputs[i].positionsS;
+                tot.hit10O += outputs[i].hit10O;
+                tot.hit10S += outputs[i].hit10S;
+                tot.hit3O += outputs[i].hit3O;
+                tot.hit3S += outputs[i].hit3S;
+                tot.fpositionsO += outputs[i].fpositionsO;
+                tot.fpositionsS += outputs[i].fpositionsS;
+                tot.fhit10O += outputs[i].fhit10O;
+                tot.fhit10S += outputs[i].fhit10S;
+                tot.fhit3O += outputs[i].fhit3O;
+                tot.fhit3S += outputs[i].fhit3S;
             }
+            const uint64_t positionsO = tot.positionsO;
+            const uint64_t positionsS = tot.positionsS;
+            const uint64_t hit10O = tot.hit10O;
+            const uint64_t hit10S = tot.hit10S;
+            const uint64_t hit3O = tot.hit3O;
+            const uint64_t hit3S = tot.hit3S;
 
             //return the output statistics
             double avgsubj = (positionsS / (double) ntriples);
@@ -218,6 +278,16 @@ class Tester {
             LOG(INFOL) << "Time: " << elapsed_seconds.count() << " sec. Mean subj pos: " << avgsubj << " Mean obj pos: " << avgobj << " Mean pos: " << totalavg;
             LOG(INFOL) << "Hit@10(s): " << avghit10s << "% Hit@10(o): " << avghit10o << "% Hit@10: " << avghit10 << "%";
             LOG(INFOL) << "Hit@3(s): " << avghit3s << "% Hit@3(o): " << avghit3o << "% Hit@3: " << avghit3 << "%";
+            double favgsubj = 0, favgobj = 0, ftotalavg = 0;
+            double favghit10 = 0, favghit3 = 0;
+            if (kb != NULL) {
+                favgsubj = (tot.fpositionsS / (double) ntriples);
+                favgobj = (tot.fpositionsO / (double) ntriples);
+                ftotalavg = (favgsubj + favgobj) / 2;
+                favghit10 = (tot.fhit10S + tot.fhit10O) / (double) ntriples * 50;
+                favghit3 = (tot.fhit3S + tot.fhit3O) / (double) ntriples * 50;
+                LOG(INFOL) << "Filtered. Mean subj pos: " << favgsubj << " Mean obj pos: " << favgobj << " Mean pos: " << ftotalavg << " Hit@10: " << favghit10 << "% Hit@3: " << favghit3 << "%";
+            }
 
             //Write JSON output
             JSON jsonresults;
@@ -234,16 +304,20 @@ class Tester {
             jsonresults.put("hit3s", avghit3s);
             jsonresults.put("hit3o", avghit3o);
             jsonresults.put("hit3", avghit3);
+            if (kb != NULL) {
+                jsonresults.put("fmeanranks", favgsubj);
+                jsonresults.put("fmeanranko", favgobj);
+                jsonresults.put("fmeanrank", ftotalavg);
+                jsonresults.put("fhit10", favghit10);
+                jsonresults.put("fhit3", favghit3);
+            }
             std::stringstream output;
             jsonresults.write(output, jsonresults);
             LOG(DEBUGL) << "JSON: " << output.str();
 
             std::shared_ptr<OutputTest> results(new OutputTest());
             results->loss = (positionsS + positionsO) / (double)2;
-            //Collect all results
-            for (auto v : resQueries) {
-                std::copy(v.begin(), v.end(), std::back_inserter(results->results));
-            }
+            results->results = std::move(resQueries);
             return results;
         }
 };
@@ -149,7 +149,7 @@ class TrainWorkflow {
                         std::vector<uint64_t> testset;
                         BatchCreator::loadTriples(pathvalid, testset);
                         //Do the test
-                        Tester tester(E, R);
+                        Tester tester(E, R, &kb);
                         LOG(DEBUGL) << "Testing on the valid dataset ...";
                         auto result = tester.test("valid", testset, nthreads, epoch);
                         //Store the results of the detailed queries
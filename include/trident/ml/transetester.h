@@ -7,7 +7,8 @@ template<typename K>
 class TranseTester : public Tester<K> {
     public:
         TranseTester(std::shared_ptr<Embeddings<K>> E,
-               std::shared_ptr<Embeddings<K>> R) : Tester<K>(E, R) {
+               std::shared_ptr<Embeddings<K>> R,
+               KB *kb = NULL) : Tester<K>(E, R, kb) {
         }
 
         double closeness(K *v1, K *v2, uint16_t dim) {
@@ -18,6 +19,11 @@ class TranseTester : public Tester<K> {
             return res;
         }
 
+        void closenessBlock(K *v1, K *v2, const uint64_t n, uint16_t dim,
+                double *out) {
+            ScoreKernels::l1(v1, v2, n, dim, out);
+        }
+
         void predictO(K *s, uint16_t dims, K *p, uint16_t dimp, K* o) {
             for (uint16_t i = 0; i < dims; ++i) {
                 o[i] = s[i] + p[i];
@@ -7,38 +7,96 @@
 #include <trident/utils/httpserver.h>
 
 #include <layers/TridentLayer.hpp>
+#include <trident/kb/compactor.h>
+#include <trident/sparql/plancache.h>
+#include <trident/utils/histogram.h>
 
 #include <cts/infra/QueryGraph.hpp>
 #include <cts/parser/SPARQLParser.hpp>
 #include <rts/runtime/QueryDict.hpp>
 
 #include <map>
+#include <mutex>
+#include <atomic>
 
 using namespace std;
 
 class TridentServer {
     protected:
-        TridentLayer kb;
+        //One layer (and hence one querier) per worker. All of them share
+        //the same read-only KB. If the KB is compacted in the background, a
+        //worker moves to the new generation the next time it is acquired
+        struct Worker {
+            std::shared_ptr<KB> kb;
+            std::unique_ptr<TridentLayer> layer;
+        };
+        std::vector<std::unique_ptr<Worker>> workers;
+        ConcurrentQueue<Worker*> freeWorkers;
+        Compactor *compactor;
+
+        //Shared by all workers. It is reset when the KB generation changes
+        SPARQLPlanCache plancache;
+
+        //Metrics exposed by /metrics. The counters of the queriers are
+        //moved here after every request
+        LatencyHistogram latencyParse, latencyPlan, latencyExecute,
+                         latencyDecode, latencyTotal;
+        std::atomic<uint64_t> nQueries;
+        std::mutex countersMutex;
+        Querier::Counters querierCounters;
 
     private:
         string dirhtmlfiles;
         map<string, string> cachehtml;
+        std::mutex cachehtmlMutex;
         std::thread t;
         string cmdArgs;
 
-        bool isActive;
+        std::atomic<int> activeRequests;
         int webport;
+
+        //Counts a request as active until it goes out of scope, also when
+        //the request throws, so that stop() does not wait forever
+        class ActiveRequest {
+            private:
+                TridentServer &server;
+            public:
+                ActiveRequest(TridentServer &server) : server(server) {
+                    server.setActive();
+                }
+
+                ~ActiveRequest() {
+                    server.setInactive();
+                }
+        };
         std::shared_ptr<HttpServer> server;
         int nthreads;
 
         void startThread(int port);
 
+        void init(std::shared_ptr<KB> kb);
+
+        Worker *acquireWorker();
+
+        void releaseWorker(Worker *worker);
+
+        void handleRequest(std::string req, std::string &resp,
+                TridentLayer &db);
+
         void processRequest(std::string req, std::string &resp);
 
+        void collectCounters(TridentLayer &db);
+
+        string getMetrics(TridentLayer &db);
+
     public:
         //OK
         TridentServer(KB &kb, string htmlfiles, int nthreads = 1);
 
+        //Serves the current generation of the compactor
+        TridentServer(Compactor &compactor, string htmlfiles,
+                int nthreads = 1);
+
         //OK
         void start(int port);
 
@@ -56,12 +114,12 @@ class TridentServer {
 
         //OK
         void setActive() {
-            isActive = true;
+            activeRequests++;
         }
 
         //OK
         void setInactive() {
-            isActive = false;
+            activeRequests--;
         }
 
         //OK
@@ -0,0 +1,91 @@
+#ifndef _PLANCACHE_H
+#define _PLANCACHE_H
+
+#include <cts/parser/SPARQLLexer.hpp>
+#include <cts/parser/SPARQLParser.hpp>
+#include <cts/infra/QueryGraph.hpp>
+#include <cts/plangen/PlanGen.hpp>
+#include <rts/runtime/QueryDict.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+
+class TridentLayer;
+
+//Caches the optimized plans of SPARQL queries, so that a query that was
+//already seen skips the parser, the semantic analysis and the optimizer.
+//The key is the sequence of tokens of the query (whitespaces and comments
+//do not matter) plus the names of the bind parameters. All plans are
+//dropped when the KB changes (e.g., after a compaction).
+//
+//Bind parameters are variables that take a constant (a term as it is stored
+//in the dictionary, e.g. <a> or "b"@en). If only the triple patterns of the
+//main group use the variable, the constant replaces it there. Otherwise the
+//variable is bound like with VALUES, so that filters, optional parts and the
+//output also see the value. The plan is optimized for the first values that
+//are all in the dictionary and then reused for all the others
+class SPARQLPlanCache {
+    public:
+        struct Entry {
+            //The parser and the dictionary must outlive the query graph
+            std::unique_ptr<SPARQLLexer> lexer;
+            std::unique_ptr<SPARQLParser> parser;
+            std::unique_ptr<QueryDict> queryDict;
+            std::unique_ptr<QueryGraph> queryGraph;
+            std::unique_ptr<PlanGen> plangen;
+            //NULL until a query with known values is optimized
+            Plan *plan;
+            std::vector<std::string> vars;
+            //For every parameter, the positions (3 * node + 0/1/2) in the
+            //main group pattern that take its value
+            std::vector<std::vector<unsigned>> slots;
+            //For every parameter, the VALUES node that binds it (-1 if the
+            //value is copied in the nodes instead)
+            std::vector<int> valueSlots;
+            //Protects the constants of the query graph during the codegen
+            std::mutex mutex;
+
+            Entry() : plan(NULL) {}
+        };
+
+    private:
+        const size_t capacity;
+        std::mutex mutex;
+        std::string kbversion;
+        std::list<std::string> lru;
+        std::unordered_map<std::string, std::pair<std::shared_ptr<Entry>,
+            std::list<std::string>::iterator>> entries;
+        uint64_t hits;
+        uint64_t misses;
+
+        static std::string getKBVersion(TridentLayer &db);
+
+        void checkVersion(TridentLayer &db);
+
+    public:
+        SPARQLPlanCache(size_t capacity = 1024);
+
+        static std::string getKey(const std::string &query,
+                const std::map<std::string, std::string> &params);
+
+        //Returns NULL if the query is not in the cache
+        std::shared_ptr<Entry> get(const std::string &key, TridentLayer &db);
+
+        void put(const std::string &key, TridentLayer &db,
+                std::shared_ptr<Entry> entry);
+
+        void clear();
+
+        size_t size();
+
+        uint64_t getHits();
+
+        uint64_t getMisses();
+};
+
+#endif
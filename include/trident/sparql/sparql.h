@@ -2,13 +2,50 @@
 #define _SPARQL_H
 
 #include <trident/utils/json.h>
+#include <trident/sparql/plancache.h>
 
 #include <layers/TridentLayer.hpp>
 #include <cts/infra/QueryGraph.hpp>
 #include <cts/parser/SPARQLParser.hpp>
 #include <rts/runtime/QueryDict.hpp>
 
+#include <map>
+#include <chrono>
+
+class Operator;
+
 class SPARQLUtils {
+    public:
+        //Seconds spent in every phase of a query. Decoding the results is
+        //also part of the execution
+        struct Timings {
+            double parse;
+            double plan;
+            double execute;
+            double decode;
+            Timings() : parse(0), plan(0), execute(0), decode(0) {}
+        };
+
+    private:
+        //Parses the query and binds the parameters. If optimize is set, it
+        //also builds the plan, otherwise the entry has no query graph and
+        //no plan
+        static std::shared_ptr<SPARQLPlanCache::Entry> prepareQuery(
+                string sparqlquery,
+                const std::map<string, string> &params,
+                TridentLayer &db,
+                bool optimize,
+                Timings *timings);
+
+        static void runQuery(Operator *operatorTree,
+                std::chrono::system_clock::time_point start,
+                bool printstdout,
+                bool jsonoutput,
+                std::vector<string> &jsonnamevars,
+                JSON *jsonresults,
+                JSON *jsonstats,
+                Timings *timings);
+
     public:
         static void parseQuery(bool &success,
                 SPARQLParser &parser,
@@ -16,6 +53,13 @@ class SPARQLUtils {
                 QueryDict &queryDict,
                 TridentLayer &db);
 
+        //Semantic analysis of a query that was already parsed
+        static void analyseQuery(bool &success,
+                SPARQLParser &parser,
+                std::unique_ptr<QueryGraph> &queryGraph,
+                QueryDict &queryDict,
+                TridentLayer &db);
+
         static void execSPARQLQuery(string sparqlquery,
                 bool explain,
                 int64_t nterms,
@@ -25,6 +69,20 @@ class SPARQLUtils {
                 JSON *jsonvars,
                 JSON *jsonresults,
                 JSON *jsonstats);
+
+        //Executes a query with the plan stored in the cache (or stores it if
+        //the query was not seen before). The variables in params are bind
+        //parameters, replaced with the terms they map to
+        static void execSPARQLQuery(string sparqlquery,
+                const std::map<string, string> &params,
+                SPARQLPlanCache &cache,
+                TridentLayer &db,
+                bool printstdout,
+                bool jsonoutput,
+                JSON *jsonvars,
+                JSON *jsonresults,
+                JSON *jsonstats,
+                Timings *timings = NULL);
 };
 
 #endif
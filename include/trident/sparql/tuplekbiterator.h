@@ -26,6 +26,9 @@
 #include <trident/iterators/tupleiterators.h>
 #include <trident/iterators/pairitr.h>
 #include <vector>
+#include <assert.h>
+
+#define TUPLEKB_BLOCK_SIZE 256
 
 class Tuple;
 class Querier;
@@ -46,8 +49,17 @@ private:
     bool nextOutcome;
     size_t processedValues;
 
+    //If no field must be checked, the pairs are read in blocks
+    bool useBlocks;
+    int64_t blockKey;
+    int64_t block1[TUPLEKB_BLOCK_SIZE];
+    int64_t block2[TUPLEKB_BLOCK_SIZE];
+    int64_t blockSize, blockPos;
+
     bool checkFields();
 
+    bool fillBlock();
+
 public:
     TupleKBItr();
 
@@ -56,6 +68,9 @@ public:
     }
 
     void ignoreSecondColumn() {
+        //Already buffered pairs cannot be aggregated anymore
+        assert(!useBlocks || blockSize == 0);
+        useBlocks = false;
         physIterator->ignoreSecondColumn();
     }
 
@@ -31,6 +31,7 @@
 #include <list>
 #include <string>
 #include <deque>
+#include <atomic>
 
 class Node;
 class TreeContext;
@@ -51,6 +52,11 @@ private:
     char supportBuffer2[SIZE_SUPPORT_BUFFER];
 
     LeafFactory *factory;
+
+    //Children requested by the intermediate nodes, and those that had to be
+    //read from disk
+    std::atomic<uint64_t> nodeAccesses;
+    std::atomic<uint64_t> nodeLoads;
 public:
 
     Cache(int maxNodesInCache, bool compressedNodes) :
@@ -58,6 +64,8 @@ public:
         context = NULL;
         factory = NULL;
         manager = NULL;
+        nodeAccesses = 0;
+        nodeLoads = 0;
         memset(supportBuffer, 0, SIZE_SUPPORT_BUFFER);
         memset(supportBuffer2, 0, SIZE_SUPPORT_BUFFER);
     }
@@ -70,11 +78,29 @@ public:
 
     void registerNode(Node *node);
 
+    void incrNodeAccesses() {
+        nodeAccesses.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t getNodeAccesses() const {
+        return nodeAccesses.load(std::memory_order_relaxed);
+    }
+
+    uint64_t getNodeLoads() const {
+        return nodeLoads.load(std::memory_order_relaxed);
+    }
+
     Leaf *newLeaf() {
         return factory->get();
     }
 
+    void releasePin(Node *node) {
+        manager->release(node->getPin());
+        node->setPin(-1);
+    }
+
     void releaseLeaf(Node *leaf) {
+        releasePin(leaf);
         factory->release((Leaf*)leaf);
     }
 
@@ -83,6 +83,9 @@ class FlatRoot : public Root {
         static void writeFirstPerm(string sop, Root *root,
                 bool unlabeled, bool undirected, string output);
 
+        //Writes the records of labeled graphs in one pass over the tree
+        static void writeAllPerms(Root *root, string output);
+
         static void writeOtherPerm(string otherperm, string output,
                 int offset,
                 int blocksize,
@@ -80,9 +80,9 @@ public:
 
     int64_t largestNumericKey();
 
-    tTerm *smallestTextualKey(int *size);
+    tTerm *smallestTextualKey(tTerm *key, int *size);
 
-    tTerm *largestTextualKey(int *size);
+    tTerm *largestTextualKey(tTerm *key, int *size);
 
     Node *getChildForKey(int64_t key);
 
@@ -53,6 +53,10 @@ private:
     int consecutiveStep;
     char state;
 
+    //Pin of the file the node was read from. Leaves of read-only trees
+    //point into it
+    int pin;
+
 protected:
     int pos(int64_t key);
 
@@ -64,9 +68,10 @@ protected:
 
     int64_t localLargestNumericKey();
 
-    tTerm *localSmallestTextualKey(int *size);
+    //The keys are copied in a buffer of MAX_TERM_SIZE bytes, which is returned
+    tTerm *localSmallestTextualKey(tTerm *key, int *size);
 
-    tTerm *localLargestTextualKey(int *size);
+    tTerm *localLargestTextualKey(tTerm *key, int *size);
 
     int64_t keyAt(int pos);
 
@@ -91,6 +96,15 @@ public:
 //      wStrings = NULL;
 //      sStrings = 0;
         state = STATE_UNMODIFIED;
+        pin = -1;
+    }
+
+    void setPin(int pin) {
+        this->pin = pin;
+    }
+
+    int getPin() const {
+        return pin;
     }
 
     void setId(int64_t id) {
@@ -171,9 +185,9 @@ public:
 
     virtual int64_t largestNumericKey() = 0;
 
-    virtual tTerm *smallestTextualKey(int *size) = 0;
+    virtual tTerm *smallestTextualKey(tTerm *key, int *size) = 0;
 
-    virtual tTerm *largestTextualKey(int *size) = 0;
+    virtual tTerm *largestTextualKey(tTerm *key, int *size) = 0;
 
     virtual Node *getChildForKey(tTerm *key, int sizeKey) {
         return NULL;
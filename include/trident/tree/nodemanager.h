@@ -82,6 +82,9 @@ private:
     short lastCreatedFile;
     CachedNode *lastNodeInserted;
 
+    //ID of the directory in the AccessLog
+    int accessLogDir;
+
     static void unserializeNodeFrom(CachedNode *node, char *buffer, int pos);
 
     static int serializeTo(CachedNode *node, char *buffer);
@@ -90,7 +93,10 @@ public:
     NodeManager(TreeContext *context, int nodeMinBytes, int fileMaxSize,
                 int maxNFiles, int64_t cacheMaxSize, std::string path);
 
-    char* get(CachedNode *node);
+    //The node stays mapped until release() is called with the pin
+    char* get(CachedNode *node, int &pin);
+
+    void release(int pin);
 
     void put(Node *node, char *buffer, int sizeBuffer);
 
@@ -109,6 +109,9 @@ class Root {
 
         bool get(nTerm key, int64_t &coordinates);
 
+        //Counters of the node cache (zero if the tree has no cache)
+        void getCacheCounters(uint64_t &nodeAccesses, uint64_t &nodeLoads);
+
 };
 
 #endif /* ROOT_H_ */
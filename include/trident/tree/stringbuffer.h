@@ -58,7 +58,6 @@ private:
     std::string dir;
 
     char uncompressSupportBuffer[SB_BLOCK_SIZE * 2];
-    char termSupportBuffer[MAX_TERM_SIZE];
 
     PreallocatedStratArraysFactory<char> factory;
     const bool readOnly;
@@ -101,6 +100,11 @@ private:
     int elementsInCache;
     const int maxElementsInCache;
 
+#ifdef MT
+    //Protects the block cache from concurrent readers
+    std::mutex cacheLock;
+#endif
+
     void addCache(int idx);
     void compressBlocks();
     void compressLastBlock();
@@ -135,10 +139,9 @@ public:
 
     void append(char *string, int size);
 
+    //outputBuffer must hold MAX_TERM_SIZE bytes
     void get(int64_t pos, char* outputBuffer, int &size);
 
-    char* get(int64_t pos, int &size);
-
     int cmp(int64_t pos, char *string, int sizeString);
 
     ~StringBuffer();
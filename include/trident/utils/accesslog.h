@@ -0,0 +1,97 @@
+#ifndef _ACCESSLOG_H
+#define _ACCESSLOG_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdint>
+
+//Records the byte ranges of the tables and of the tree nodes that are read,
+//so that a later run can load them in the page cache before the queries
+//arrive (see replay()). The log is process-wide and disabled by default:
+//then record() only reads an atomic flag.
+//Every range is identified by a directory registered with registerDir(),
+//the number of the file in it and the offset. The same range is stored
+//once, so the log grows with the working set and not with the queries.
+//Every thread records in its own shard, so the threads that read the KB do
+//not wait for each other. The shards are merged when the log is stored.
+class AccessLog {
+    private:
+        static const int NSHARDS = 64;
+
+        //Aligned so that two shards are not in the same cache line
+        struct alignas(64) Shard {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, uint64_t> accesses;
+        };
+
+        static std::atomic<bool> enabled;
+        static std::mutex mutex;
+        static std::vector<std::string> dirs;
+        static Shard shards[NSHARDS];
+        static std::atomic<uint32_t> nextShard;
+
+        static std::string logFile;
+        static uint32_t intervalSec;
+        static std::thread worker;
+        static std::mutex stopMutex;
+        static std::condition_variable stopCond;
+        static bool stopped;
+
+        static void recordAccess(int dir, short file, uint64_t offset,
+                uint64_t len);
+
+        static void store();
+
+        static void run();
+
+        struct Entry {
+            uint32_t dir;
+            short file;
+            uint64_t offset;
+            uint64_t len;
+        };
+
+        struct Range {
+            std::string path;
+            uint64_t begin;
+            uint64_t end;
+        };
+
+        static bool load(std::string file, std::vector<std::string> &logDirs,
+                std::vector<Entry> &entries);
+
+        static uint64_t prefetch(const std::vector<Range> &ranges,
+                size_t begin, size_t end);
+
+    public:
+        static const int MAXDIRS = 256;
+        //Ranges closer than this are read together
+        static const uint64_t MERGEGAP = 1024 * 1024;
+
+        //Returns the ID to pass to record(), or -1 if there are too many
+        //directories
+        static int registerDir(std::string dir);
+
+        static void record(int dir, short file, uint64_t offset, uint64_t len) {
+            if (enabled.load(std::memory_order_relaxed) && dir >= 0) {
+                recordAccess(dir, file, offset, len);
+            }
+        }
+
+        //The ranges already in file are kept. The log is written every
+        //intervalSec seconds and when the recording stops
+        static void startRecording(std::string file, uint32_t intervalSec);
+
+        static void stopRecording();
+
+        //Asks the OS to load all the ranges in the log, sorted by file and
+        //offset. Returns the number of bytes requested
+        static uint64_t replay(std::string file, int nthreads);
+};
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef _HISTOGRAM_H
+#define _HISTOGRAM_H
+
+#include <trident/utils/json.h>
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+//Histogram of latencies. Bucket i counts the durations below 2^i
+//microseconds (the last one also the longer ones). Safe to update from
+//concurrent threads
+class LatencyHistogram {
+    private:
+        static const int NBUCKETS = 28;
+        std::atomic<uint64_t> buckets[NBUCKETS];
+        std::atomic<uint64_t> count;
+        std::atomic<uint64_t> sumMicros;
+
+    public:
+        LatencyHistogram() : count(0), sumMicros(0) {
+            for (int i = 0; i < NBUCKETS; ++i) {
+                buckets[i] = 0;
+            }
+        }
+
+        void add(double seconds) {
+            const uint64_t micros = seconds > 0 ? (uint64_t)(seconds * 1e6) : 0;
+            int b = 0;
+            while (b < NBUCKETS - 1 && (((uint64_t)1) << b) <= micros) {
+                b++;
+            }
+            buckets[b].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            sumMicros.fetch_add(micros, std::memory_order_relaxed);
+        }
+
+        //Only the non-empty buckets are written, with their upper bound (in
+        //microseconds) as key
+        void toJSON(JSON &out) {
+            out.put("count", (unsigned long)count.load());
+            out.put("sum_us", (unsigned long)sumMicros.load());
+            JSON jbuckets;
+            for (int i = 0; i < NBUCKETS; ++i) {
+                const uint64_t n = buckets[i].load(std::memory_order_relaxed);
+                if (n > 0) {
+                    const std::string key = i == NBUCKETS - 1 ? "inf" :
+                        std::to_string(((uint64_t)1) << i);
+                    jbuckets.put(key, (unsigned long)n);
+                }
+            }
+            out.add_child("buckets", jbuckets);
+        }
+};
+
+#endif
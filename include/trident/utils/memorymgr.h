@@ -26,6 +26,7 @@
 #include <trident/kb/consts.h>
 
 #include <iostream>
+#include <mutex>
 #include <assert.h>
 
 using namespace std;
@@ -49,6 +50,13 @@ private:
     int start;
     int end;
     int blocksLeft;
+    uint64_t evictions;
+
+#ifdef MT
+    //Recursive because removing a block triggers the deconstructor of K,
+    //which calls back removeBlockWithoutDeallocation
+    std::recursive_mutex mutex;
+#endif
 
     void removeOneBlock() {
         if (blocksLeft < MAX_N_BLOCKS_IN_CACHE) {
@@ -64,6 +72,7 @@ private:
                 }
             }
             removeBlock(start++);
+            evictions++;
         }
     }
 
@@ -76,15 +85,45 @@ public:
         memset(blocks, 0, sizeof(MemoryBlock<K>*) * MAX_N_BLOCKS_IN_CACHE);
         start = end = 0;
         blocksLeft = MAX_N_BLOCKS_IN_CACHE;
+        evictions = 0;
+    }
+
+#ifdef MT
+    //Held by the callers that must lock a block before another thread can
+    //evict it
+    std::recursive_mutex &getMutex() {
+        return mutex;
+    }
+#endif
+
+    //Number of blocks removed to make space for new ones
+    uint64_t getEvictions() {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
+        return evictions;
+    }
+
+    size_t getBytes() {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
+        return bytes;
     }
 
     void update(int idx, size_t bytes) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         this->bytes -= blocks[idx]->bytes;
         this->bytes += bytes;
         blocks[idx]->bytes = bytes;
     }
 
     void removeBlock(int idx) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         //Delete block. This will trigger the deconstructor of K which should remove the block and update all the datastructures
         bytes -= blocks[idx]->bytes;
         K *elToRemove = blocks[idx]->block;
@@ -96,6 +135,9 @@ public:
     }
 
     void removeBlockWithoutDeallocation(int idx) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         if (blocks[idx] != NULL) {
             bytes -= blocks[idx]->bytes;
             delete blocks[idx];
@@ -105,18 +147,30 @@ public:
     }
 
     void addLock(int idx) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         blocks[idx]->lock++;
     }
 
     bool isUsed(int idx) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         return blocks[idx]->lock > 0;
     }
 
     void releaseLock(int idx) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         blocks[idx]->lock--;
     }
 
     int add(size_t bytes, K *element, int idxInParentArray, K **parentArray) {
+#ifdef MT
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+#endif
         if (this->bytes + bytes > cacheMaxSize) {
             while (this->bytes >= cacheMaxSize || blocksLeft == 0) {
                 removeOneBlock();
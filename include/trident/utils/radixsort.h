@@ -0,0 +1,195 @@
+#ifndef _RADIXSORT_H
+#define _RADIXSORT_H
+
+#include <trident/utils/parallel.h>
+
+#include <array>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <algorithm>
+#include <cstring>
+
+//In-place MSD radix sort (American flag sort) of fixed-width records that
+//are compared byte by byte, like the big-endian triples of the PermSorter.
+//The result is the same as sorting the std::arrays with operator<. Bytes
+//that are equal in a whole range (e.g., the high bytes of the IDs) are
+//skipped. The first distribution is done on the whole array, then the
+//buckets are sorted by parallel workers
+template<size_t SIZE>
+class RadixSort {
+    public:
+        typedef std::array<unsigned char, SIZE> Record;
+
+    private:
+        //Below this size the ranges are sorted with std::sort
+        static const size_t SMALLRANGE = 64;
+        //Below this size the ranges are sorted by a single thread
+        static const size_t PARALLELRANGE = 1 << 16;
+
+        struct Histogram {
+            const Record *records;
+            const size_t byte;
+            size_t *counts;
+            std::mutex *mutex;
+
+            Histogram(const Record *records, size_t byte, size_t *counts,
+                    std::mutex *mutex) : records(records), byte(byte),
+            counts(counts), mutex(mutex) {}
+
+            void operator()(const ParallelRange& r) const {
+                size_t local[256];
+                memset(local, 0, sizeof(local));
+                for (size_t i = r.begin(); i < r.end(); ++i) {
+                    local[records[i][byte]]++;
+                }
+                std::lock_guard<std::mutex> lock(*mutex);
+                for (int b = 0; b < 256; ++b) {
+                    counts[b] += local[b];
+                }
+            }
+        };
+
+        static void histogram(const Record *begin, const Record *end,
+                size_t byte, size_t *counts) {
+            memset(counts, 0, sizeof(size_t) * 256);
+            for (const Record *r = begin; r < end; ++r) {
+                counts[(*r)[byte]]++;
+            }
+        }
+
+        static void histogram_par(const Record *begin, const Record *end,
+                size_t byte, size_t *counts, int nthreads) {
+            memset(counts, 0, sizeof(size_t) * 256);
+            std::mutex mutex;
+            ParallelTasks::parallel_for(0, end - begin, PARALLELRANGE,
+                    Histogram(begin, byte, counts, &mutex), nthreads);
+        }
+
+        //Moves every record in the bucket of its byte. The records are
+        //swapped directly into their final position (cycle leader)
+        static void distribute(Record *begin, size_t byte,
+                const size_t *counts) {
+            size_t heads[256];
+            size_t tails[256];
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b) {
+                heads[b] = offset;
+                offset += counts[b];
+                tails[b] = offset;
+            }
+            for (int b = 0; b < 256; ++b) {
+                while (heads[b] < tails[b]) {
+                    Record &r = begin[heads[b]];
+                    const unsigned char d = r[byte];
+                    if (d == b) {
+                        heads[b]++;
+                    } else {
+                        std::swap(r, begin[heads[d]++]);
+                    }
+                }
+            }
+        }
+
+        //Returns true if all the records have the same byte
+        static bool isConstant(const Record *begin, const Record *end,
+                size_t byte, const size_t *counts) {
+            return counts[(*begin)[byte]] == (size_t)(end - begin);
+        }
+
+        static void sort_seq(Record *begin, Record *end, size_t byte) {
+            size_t counts[256];
+            while (byte < SIZE) {
+                if ((size_t)(end - begin) < SMALLRANGE) {
+                    //The first bytes are equal, so operator< gives the same
+                    //order
+                    std::sort(begin, end);
+                    return;
+                }
+                histogram(begin, end, byte, counts);
+                if (!isConstant(begin, end, byte, counts)) {
+                    break;
+                }
+                byte++;
+            }
+            if (byte == SIZE) {
+                return;
+            }
+            distribute(begin, byte, counts);
+            Record *bucket = begin;
+            for (int b = 0; b < 256; ++b) {
+                if (counts[b] > 1) {
+                    sort_seq(bucket, bucket + counts[b], byte + 1);
+                }
+                bucket += counts[b];
+            }
+        }
+
+        static void sort_par(Record *begin, Record *end, size_t byte,
+                int nthreads) {
+            const size_t n = end - begin;
+            if (nthreads < 2 || n < PARALLELRANGE) {
+                sort_seq(begin, end, byte);
+                return;
+            }
+            size_t counts[256];
+            while (byte < SIZE) {
+                histogram_par(begin, end, byte, counts, nthreads);
+                if (!isConstant(begin, end, byte, counts)) {
+                    break;
+                }
+                byte++;
+            }
+            if (byte == SIZE) {
+                return;
+            }
+            distribute(begin, byte, counts);
+
+            //Buckets larger than the share of a thread are sorted in
+            //parallel one after the other, the others are picked by the
+            //workers starting from the largest ones
+            std::vector<std::pair<size_t, size_t>> buckets;
+            size_t offset = 0;
+            for (int b = 0; b < 256; ++b) {
+                if (counts[b] > n / nthreads) {
+                    sort_par(begin + offset, begin + offset + counts[b],
+                            byte + 1, nthreads);
+                } else if (counts[b] > 1) {
+                    buckets.push_back(std::make_pair(counts[b], offset));
+                }
+                offset += counts[b];
+            }
+            std::sort(buckets.begin(), buckets.end(),
+                    std::greater<std::pair<size_t, size_t>>());
+            std::atomic<size_t> next(0);
+            auto worker = [&]() {
+                size_t i;
+                while ((i = next++) < buckets.size()) {
+                    Record *b = begin + buckets[i].second;
+                    sort_seq(b, b + buckets[i].first, byte + 1);
+                }
+            };
+            std::vector<std::future<void>> threads;
+            for (int i = 1; i < nthreads; ++i) {
+                threads.push_back(std::async(std::launch::async, worker));
+            }
+            worker();
+            for (auto &t : threads) {
+                t.wait();
+            }
+        }
+
+    public:
+        static void sort(Record *begin, Record *end, int nthreads) {
+            if (end - begin > 1) {
+                sort_par(begin, end, 0, nthreads);
+            }
+        }
+
+        static void sort(char *begin, char *end, int nthreads) {
+            sort((Record*) begin, (Record*) end, nthreads);
+        }
+};
+
+#endif
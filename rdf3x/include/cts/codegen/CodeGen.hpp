@@ -33,8 +33,11 @@ class CodeGen
 
         /// Collect all variables contained in a plan
         static void collectVariables(std::set<unsigned>& variables,Plan* plan);
-        /// Translate an execution plan into an operator tree without output generation
-        static Operator* translateIntern(Runtime& runtime, const QueryGraph& query, Plan* plan, std::vector<Register*>& output, const std::map<const QueryGraph::Node*, unsigned> &registers);
+        /// Translate an execution plan into an operator tree without output generation.
+        /// If the output is ordered, only the first topK tuples are produced
+        static Operator* translateIntern(Runtime& runtime, const QueryGraph& query, Plan* plan, std::vector<Register*>& output, const std::map<const QueryGraph::Node*, unsigned> &registers, uint64_t topK=~static_cast<uint64_t>(0));
+        /// Number of sorted tuples needed to produce the result of a query with a limit
+        static uint64_t getTopK(const QueryGraph& query);
         /// Translate an execution plan into an operator tree
         SLIBEXP static Operator* translate(Runtime& runtime,const QueryGraph& query,Plan* plan, bool silent=false);
 };
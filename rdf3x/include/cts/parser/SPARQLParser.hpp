@@ -279,6 +279,15 @@ class SPARQLParser {
         }
         /// Get the name of a variable
         SLIBEXP std::string getVariableName(unsigned id) const;
+        /// Bind a variable to a constant. If only the triple patterns of the
+        /// main group use the variable, the constant replaces it there and
+        /// positions gets the replaced entries (3 * pattern + 0/1/2 for
+        /// s/p/o). Otherwise the variable is bound by a VALUES entry of the
+        /// main group, whose index goes in valuesIdx. Returns false if the
+        /// query has no such variable
+        SLIBEXP bool bindVariable(const std::string& name,
+                const std::string& term, std::vector<unsigned>& positions,
+                int& valuesIdx);
 
         /// Iterator over the projection clause
         typedef std::vector<unsigned>::const_iterator projection_iterator;
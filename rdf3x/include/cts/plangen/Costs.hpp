@@ -46,6 +46,9 @@ class Costs
    // static cost_t hashJoin(double leftCard,double rightCard) { return (leftCard/10)+(rightCard/200); }
    /// Costs for a filter
    static cost_t filter(double card) { return card/(cpuSpeed/3); }
+   /// Costs for the seeks of a worst-case optimal join. Every binding of a level seeks once in every pattern of the next level
+   // A seek in a Trident table costs about as much as reading a few pairs
+   static cost_t leapfrogSeeks(double bindings,unsigned atoms) { return bindings*atoms*4; }
    /// Costs for a table function
    static cost_t tableFunction(double leftCard) { return leftCard*10000.0; }
 };
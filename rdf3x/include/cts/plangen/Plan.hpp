@@ -22,7 +22,7 @@ struct Plan
     enum Op { IndexScan, AggregatedIndexScan, FullyAggregatedIndexScan,
         NestedLoopJoin, MergeJoin, HashJoin, HashGroupify, Filter, Union,
         MergeUnion, TableFunction, Singleton, Subselect, Minus, ValuesScan,
-        CartProd, GroupBy, Having, Aggregates };
+        CartProd, GroupBy, Having, Aggregates, LeapfrogJoin };
     /// The cardinalits type
     typedef double card_t;
     /// The cost type
@@ -74,6 +74,8 @@ class PlanGen {
         Plan* buildFilters(const QueryGraph::SubQuery& query, Plan* plan, uint64_t value1, uint64_t value2, uint64_t value3);
         Plan *attachFiltersToPlan(QueryGraph::Filter *filter, Plan *plan);
         Plan *buildFilterPlan(const QueryGraph::Filter *filter);
+        /// Use a worst-case optimal join for cyclic patterns
+        Plan* buildLeapfrogJoin(const QueryGraph::SubQuery& query, Plan* plans);
 
     public:
         /// Constructor
@@ -54,9 +54,25 @@ class DBLayer {
                 virtual ~Scan() {}
         };
 
+        //The distinct values of one column of a permutation, in ascending
+        //order. The worst-case optimal joins seek in them
+        class ValueScan {
+            public:
+                virtual uint64_t getValue() = 0;
+
+                //Moves to the next value. Returns false at the end
+                virtual bool next() = 0;
+
+                //Moves forward to the first value >= value. Returns false
+                //if there is none
+                virtual bool seek(uint64_t value) = 0;
+
+                virtual ~ValueScan() {}
+        };
+
         class Hint {
             private:
-                std::vector<uint64_t> *hashKeys = NULL; // Keys of a hashjoin. Significant for the right iterator.
+                std::vector<uint64_t> *hashKeys = NULL; // Sorted keys of a hashjoin. The right iterator skips the other values.
                 int varbitset = 0;
 
             public:
@@ -72,6 +88,11 @@ class DBLayer {
                     varbitset = bitset;
                 }
 
+                // False if next() never moves the scan beyond the values it was opened with
+                virtual bool canSkip() {
+                    return true;
+                }
+
                 virtual void next(uint64_t& value1,
                         uint64_t& value2,
                         uint64_t& value3) {
@@ -122,6 +143,27 @@ class DBLayer {
                 ::Type::ID& type,
                 unsigned& subType) = 0;
 
+        //Decodes a batch of IDs. texts[i] is the text that lookupById would
+        //return for ids[i]. Layers that can decode in bulk override it
+        virtual void lookupByIds(const std::vector<uint64_t> &ids,
+                std::vector<std::string> &texts,
+                std::vector<::Type::ID> &types,
+                std::vector<unsigned> &subTypes,
+                std::vector<bool> &found) {
+            texts.resize(ids.size());
+            types.resize(ids.size());
+            subTypes.resize(ids.size());
+            found.resize(ids.size());
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const char *start;
+                const char *stop;
+                found[i] = lookupById(ids[i], start, stop, types[i], subTypes[i]);
+                if (found[i]) {
+                    texts[i].assign(start, stop);
+                }
+            }
+        }
+
         virtual uint64_t getNextId() = 0;
 
         virtual double getScanCost(DBLayer::DataOrder order,
@@ -165,6 +207,22 @@ class DBLayer {
                 const Aggr_t aggr,
                 Hint *hint) = 0;
 
+        //Returns whether getValueScan() can be called with this order
+        virtual bool hasValueScans(const DataOrder order) {
+            return false;
+        }
+
+        //Returns the values of the column after the first nbound (1 or 2)
+        //columns of the order, which are bound to value1 and value2. The
+        //scan is positioned on the first value; NULL if it is empty
+        virtual std::unique_ptr<DBLayer::ValueScan> getValueScan(
+                const DataOrder order,
+                const int nbound,
+                const uint64_t value1,
+                const uint64_t value2) {
+            throw 10;
+        }
+
         virtual ~DBLayer() {
         }
 };
@@ -33,6 +33,15 @@ class HashGroupify : public Operator
    class Rehasher;
    /// Helper
    class Chainer;
+   /// A partition of the hash table
+   struct Partition {
+      /// The hash table
+      std::vector<Group*> hashTable;
+      /// The number of groups and the limit before rehashing
+      uint64_t load,maxLoad;
+   };
+   /// Aggregates a morsel of the input in the partitions
+   class PartitionAggregator;
 
    /// The input registers
    std::vector<Register*> values;
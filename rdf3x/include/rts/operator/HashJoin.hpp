@@ -66,6 +66,9 @@ private:
         void run();
     };
     friend class ProbePeek;
+    /// Inserts a morsel of the left side in the hash tables
+    class PartitionBuilder;
+    friend class PartitionBuilder;
 
     /// The input
     Operator* left, *right;
@@ -75,8 +78,12 @@ private:
     std::vector<Register*> leftTail, rightTail;
     /// The pool of hash entry
     VarPool<Entry> entryPool;
-    /// The hash table
-    std::vector<Entry*> hashTable;
+    /// The hash tables, one per partition of the keys
+    std::vector<std::vector<Entry*> > hashTables;
+    /// The distinct keys of every partition
+    std::vector<std::vector<uint64_t> > partitionKeys;
+    /// Number of bits of the partition IDs
+    unsigned partitionBits;
     /// The current iter
     Entry* hashTableIter;
     /// The tuple count from the right side
@@ -91,15 +98,15 @@ private:
     /// Task priorities
     double hashPriority, probePriority;
 
-    /// Insert into the hash table
-    void insert(Entry* e);
+    /// Insert into a hash table
+    static void insert(std::vector<Entry*>& hashTable, Entry* e);
     /// Lookup an entry
     inline Entry* lookup(uint64_t key);
 
     //Optional?
     bool leftOptional, rightOptional, joinSuccedeed;
     std::set<uint64_t> collectedRightValues;
-    size_t currentIdx;
+    size_t currentIdx, currentPartition;
     std::vector<uint64_t> keys;
 
 public:
@@ -36,6 +36,8 @@ private:
         ~IndexScanHint();
         /// The next hint
         void next(uint64_t& value1, uint64_t& value2, uint64_t& value3);
+        /// Can the hint move the scan forward?
+        bool canSkip();
     };
     friend class IndexScanHint;
 
@@ -0,0 +1,92 @@
+#ifndef H_rts_operator_LeapfrogJoin
+#define H_rts_operator_LeapfrogJoin
+//---------------------------------------------------------------------------
+// RDF-3X
+// (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
+//
+// This work is licensed under the Creative Commons
+// Attribution-Noncommercial-Share Alike 3.0 Unported License. To view a copy
+// of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+// or send a letter to Creative Commons, 171 Second Street, Suite 300,
+// San Francisco, California, 94105, USA.
+//---------------------------------------------------------------------------
+#include "rts/operator/Operator.hpp"
+#include "cts/infra/QueryGraph.hpp"
+
+#include <dblayer.hpp>
+
+#include <memory>
+#include <vector>
+//---------------------------------------------------------------------------
+/// A worst-case optimal join of triple patterns (Leapfrog Triejoin). Every
+/// pattern is read from the permutation that lists its constants first and
+/// then its variables in the variable order. The variables are bound one at
+/// a time by seeking in the patterns that contain them, so no intermediate
+/// result is larger than the final one
+class LeapfrogJoin : public Operator
+{
+   public:
+   /// A triple pattern
+   struct Atom {
+      /// The permutation
+      DBLayer::DataOrder order;
+      /// The number of constants. They are the first columns of the order
+      unsigned constants;
+      /// The values of the constants
+      uint64_t values[2];
+      /// The variables in the order of the columns, as indices in the variable order
+      std::vector<unsigned> variables;
+   };
+
+   private:
+   /// A variable of the variable order
+   struct Level {
+      /// The atoms that contain the variable and the column of the variable among the variables of the atom
+      std::vector<std::pair<unsigned,unsigned> > atoms;
+      /// The scans of the atoms
+      std::vector<std::unique_ptr<DBLayer::ValueScan> > scans;
+      /// The scan that is moved next
+      unsigned current;
+   };
+
+   /// The database
+   DBLayer& db;
+   /// The patterns
+   std::vector<Atom> atoms;
+   /// The variables, in the variable order
+   std::vector<Register*> variables;
+   /// The variable order
+   std::vector<Level> levels;
+
+   /// Open the scans of a level and find the first common value
+   bool open(unsigned level);
+   /// Find the first value common to all scans of a level
+   bool search(unsigned level);
+   /// Move to the next common value of a level
+   bool advance(unsigned level);
+   /// Bind the levels below a level
+   uint64_t produce(unsigned level);
+
+   public:
+   /// Constructor
+   LeapfrogJoin(DBLayer& db,const std::vector<Atom>& atoms,const std::vector<Register*>& variables,double expectedOutputCardinality);
+   /// Destructor
+   ~LeapfrogJoin();
+
+   /// Choose the variable order and the permutations of the patterns. Returns false if a pattern cannot be read in the order
+   static bool buildAtoms(DBLayer& db,const QueryGraph::SubQuery& query,std::vector<unsigned>& variableOrder,std::vector<Atom>& atoms);
+
+   /// Produce the first tuple
+   uint64_t first();
+   /// Produce the next tuple
+   uint64_t next();
+
+   /// Print the operator tree. Debugging only.
+   void print(PlanPrinter& out);
+   /// Add a merge join hint
+   void addMergeHint(Register* reg1,Register* reg2);
+   /// Register parts of the tree that can be executed asynchronous
+   void getAsyncInputCandidates(Scheduler& scheduler);
+};
+//---------------------------------------------------------------------------
+#endif
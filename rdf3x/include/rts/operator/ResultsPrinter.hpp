@@ -84,6 +84,8 @@ class ResultsPrinter : public Operator {
         //Used for set output
         std::unordered_set<uint64_t> *outputset;
         unsigned prjId;
+        //Seconds spent translating the IDs into strings
+        double decodeTime;
 
         void formatJSON(const std::vector<std::string> &columns,
                 std::vector<uint64_t> &results,
@@ -130,6 +132,10 @@ class ResultsPrinter : public Operator {
             return nrows;
         }
 
+        double getDecodeTime() {
+            return decodeTime;
+        }
+
         /// Print the operator tree. Debugging only.
         void print(PlanPrinter& out);
         /// Add a merge join hint
@@ -14,8 +14,12 @@
 #include <infra/util/VarPool.hpp>
 #include <dblayer.hpp>
 #include <vector>
+#include <string>
+#include <unordered_map>
 //---------------------------------------------------------------------------
-/// A sort operator
+/// A sort operator. Every sorted value is decoded once into a sort key, and
+/// with a limit only the first topK tuples are kept in a heap. Then only the
+/// keys of the tuples in the heap are kept
 class Sort : public Operator
 {
    private:
@@ -23,9 +27,24 @@ class Sort : public Operator
    struct Tuple {
       /// The count
       uint64_t count;
-      /// The values
+      /// The values, followed by one sort key (or rank) per order entry
       uint64_t values[];
    };
+   /// A decoded value
+   struct Key {
+      /// The id
+      uint64_t id;
+      /// Was the id found in the dictionary?
+      bool found;
+      /// The type
+      Type::ID type;
+      /// The sub-type
+      unsigned subType;
+      /// The text
+      std::string text;
+      /// Number of references from the tuples
+      uint64_t refs;
+   };
    /// Order specification
    struct Order {
       /// The slot
@@ -49,10 +68,27 @@ class Sort : public Operator
    DBLayer& dict;
    /// Tuples iterator
    std::vector<Tuple*>::const_iterator tuplesIter;
+   /// Maximum number of tuples to produce
+   uint64_t topK;
+   /// The decoded values
+   std::vector<Key> keys;
+   /// Position of every decoded value in keys
+   std::unordered_map<uint64_t, uint64_t> keyPositions;
+   /// Positions in keys that can be reused
+   std::vector<uint64_t> freeKeys;
+
+   /// Returns the position of the key of id, decoding it if necessary. The key is referenced once more
+   uint64_t getKey(uint64_t id);
+   /// Drops the references of a tuple that leaves the heap, and the keys that are no longer used
+   void releaseKeys(Tuple* t);
+   /// Replaces the key positions in the tuples with the ranks of the keys
+   void rankKeys();
+   /// Compare two keys
+   static int compareKeys(const Key& a, const Key& b);
 
    public:
    /// Constructor
-   Sort(DBLayer& db,Operator* input,const std::vector<Register*>& values,const std::vector<std::pair<Register*,bool> >& order,double expectedOutputCardinality);
+   Sort(DBLayer& db,Operator* input,const std::vector<Register*>& values,const std::vector<std::pair<Register*,bool> >& order,double expectedOutputCardinality,uint64_t topK=~static_cast<uint64_t>(0));
    /// Destructor
    ~Sort();
 
@@ -0,0 +1,197 @@
+#ifndef _MORSELS_H
+#define _MORSELS_H
+
+#include <trident/utils/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Helpers for the operators that materialize their input (the build side of
+//the hash joins, the groupings and the sorts). A morsel of tuples is pulled
+//from the input, split in partitions by hash, and the partitions are
+//processed in parallel. Every partition has its own state, so no locks are
+//needed. The scans and the probe sides are still driven by one thread
+namespace Morsels {
+    //Number of tuples pulled from the input at a time
+    const uint64_t MORSELSIZE = 65536;
+    //Smaller morsels are processed by the calling thread
+    const uint64_t MINPARALLEL = 4096;
+
+    //Returns the number of bits of the partition IDs
+    inline unsigned partitionBits() {
+        unsigned bits = 0;
+        while ((1 << bits) < ParallelTasks::getNThreads()) {
+            bits++;
+        }
+        return bits;
+    }
+
+    //Returns the partition of hash. The high bits of the product are used,
+    //so that the partitions do not depend on the low bits that select the
+    //slots of the hash tables
+    inline uint64_t partition(uint64_t hash, unsigned bits) {
+        return bits ? ((hash * UINT64_C(0x9E3779B97F4A7C15)) >> (64 - bits)) : 0;
+    }
+
+    //Threads that the operators of all running queries can start besides
+    //their own. They are shared, so that concurrent queries (e.g., of the
+    //server) do not oversubscribe the machine
+    inline std::atomic<int32_t> &freeThreads() {
+        static std::atomic<int32_t> n(ParallelTasks::getNThreads() - 1);
+        return n;
+    }
+
+    //Takes up to "wanted" free threads, and gives them back when destroyed.
+    //It can get fewer threads, also none
+    class Reservation {
+        private:
+            int32_t n;
+
+        public:
+            Reservation(int32_t wanted) : n(0) {
+                std::atomic<int32_t> &free = freeThreads();
+                int32_t current = free.load();
+                while (wanted > 0 && current > 0) {
+                    const int32_t take = std::min(wanted, current);
+                    if (free.compare_exchange_weak(current, current - take)) {
+                        n = take;
+                        break;
+                    }
+                }
+            }
+
+            Reservation(const Reservation&) = delete;
+
+            Reservation &operator=(const Reservation&) = delete;
+
+            int32_t size() const {
+                return n;
+            }
+
+            ~Reservation() {
+                freeThreads() += n;
+            }
+    };
+
+    //Threads that process the partitions of the morsels of one operator.
+    //They are started with the first large morsel and stay until the
+    //operator has consumed its input, so no thread is started per morsel
+    class Workers {
+        private:
+            std::unique_ptr<Reservation> reservation;
+            std::vector<std::thread> threads;
+            std::mutex mutex;
+            std::condition_variable startCond, doneCond;
+            std::function<void(const ParallelRange&)> task;
+            uint64_t npartitions;
+            std::atomic<uint64_t> nextPartition;
+            //One round per morsel
+            uint64_t round;
+            size_t running;
+            bool stopped;
+
+            void work() {
+                uint64_t p;
+                while ((p = nextPartition++) < npartitions) {
+                    task(ParallelRange(p, p + 1));
+                }
+            }
+
+            void loop() {
+                uint64_t lastRound = 0;
+                std::unique_lock<std::mutex> lock(mutex);
+                while (true) {
+                    startCond.wait(lock, [&] {
+                            return stopped || round != lastRound;
+                            });
+                    if (stopped) {
+                        return;
+                    }
+                    lastRound = round;
+                    lock.unlock();
+                    work();
+                    lock.lock();
+                    if (--running == 0) {
+                        doneCond.notify_one();
+                    }
+                }
+            }
+
+        public:
+            Workers() : npartitions(0), nextPartition(0), round(0),
+            running(0), stopped(false) {
+            }
+
+            Workers(const Workers&) = delete;
+
+            Workers &operator=(const Workers&) = delete;
+
+            //Calls f(range) on the partitions [0, npartitions) of a morsel
+            //of ntuples tuples, and returns when all are processed
+            template<typename F>
+                void process(uint64_t npartitions, uint64_t ntuples, F f) {
+                    if (ntuples < MINPARALLEL || npartitions < 2) {
+                        f(ParallelRange(0, npartitions));
+                        return;
+                    }
+                    if (!reservation) {
+                        reservation = std::unique_ptr<Reservation>(
+                                new Reservation((int32_t) npartitions - 1));
+                        for (int32_t i = 0; i < reservation->size(); ++i) {
+                            threads.push_back(std::thread(&Workers::loop, this));
+                        }
+                    }
+                    if (threads.empty()) {
+                        f(ParallelRange(0, npartitions));
+                        return;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        task = f;
+                        this->npartitions = npartitions;
+                        nextPartition = 0;
+                        running = threads.size();
+                        round++;
+                    }
+                    startCond.notify_all();
+                    work();
+                    std::unique_lock<std::mutex> lock(mutex);
+                    doneCond.wait(lock, [&] {
+                            return running == 0;
+                            });
+                }
+
+            ~Workers() {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    stopped = true;
+                }
+                startCond.notify_all();
+                for (auto &t : threads) {
+                    t.join();
+                }
+            }
+    };
+
+    //Sorts with the calling thread and the free threads
+    template<typename It, typename Cmp>
+        void sort(It begin, It end, const Cmp &cmp) {
+            Reservation threads(ParallelTasks::getNThreads() - 1);
+            ParallelTasks::sort_int(begin, end, cmp, threads.size() + 1);
+        }
+
+    template<typename It>
+        void sort(It begin, It end) {
+            Reservation threads(ParallelTasks::getNThreads() - 1);
+            ParallelTasks::sort_int(begin, end, threads.size() + 1);
+        }
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include <rts/operator/HashJoin.hpp>
 #include <rts/operator/CartProd.hpp>
 #include <rts/operator/IndexScan.hpp>
+#include <rts/operator/LeapfrogJoin.hpp>
 #include <rts/operator/MergeJoin.hpp>
 #include <rts/operator/MergeUnion.hpp>
 #include <rts/operator/NestedLoopFilter.hpp>
@@ -159,6 +160,32 @@ static Operator* translateFullyAggregatedIndexScan(Runtime& runtime, const map<u
             plan->cardinality);
 }
 //---------------------------------------------------------------------------
+static Operator* translateLeapfrogJoin(Runtime& runtime, const map<unsigned, Register*>& context, const set<unsigned>& projection, map<unsigned, Register*>& bindings, const map<const QueryGraph::Node*, unsigned>& registers, Plan* plan)
+    // Translate a worst-case optimal join into an operator tree
+{
+    const QueryGraph::SubQuery& query = *reinterpret_cast<QueryGraph::SubQuery*>(plan->right);
+    vector<unsigned> variableOrder;
+    vector<LeapfrogJoin::Atom> atoms;
+    if (!LeapfrogJoin::buildAtoms(runtime.getDatabase(), query, variableOrder, atoms))
+        return 0;
+
+    // Every variable is bound in the register of its first occurrence
+    vector<Register*> variables;
+    for (vector<unsigned>::const_iterator iter = variableOrder.begin(), limit = variableOrder.end(); iter != limit; ++iter) {
+        Register* reg = 0;
+        for (vector<QueryGraph::Node>::const_iterator iter2 = query.nodes.begin(), limit2 = query.nodes.end(); (iter2 != limit2) && (!reg); ++iter2) {
+            const QueryGraph::Node& node = *iter2;
+            unsigned slot = ((!node.constSubject) && (node.subject == *iter)) ? 0 : (((!node.constPredicate) && (node.predicate == *iter)) ? 1 : (((!node.constObject) && (node.object == *iter)) ? 2 : 3));
+            if (slot < 3)
+                reg = runtime.getRegister((*registers.find(&node)).second + slot);
+        }
+        if (projection.count(*iter))
+            bindings[*iter] = reg;
+        variables.push_back(reg);
+    }
+    return new LeapfrogJoin(runtime.getDatabase(), atoms, variables, plan->cardinality);
+}
+//---------------------------------------------------------------------------
 static void collectVariables(const map<unsigned, Register*>& context, set<unsigned>& variables, Plan* plan)
     // Collect all variables contained in a plan
 {
@@ -197,6 +224,18 @@ static void collectVariables(const map<unsigned, Register*>& context, set<unsign
                                   }
         case Plan::Singleton:
                                   break;
+        case Plan::LeapfrogJoin: {
+                                     const QueryGraph::SubQuery& query = *reinterpret_cast<QueryGraph::SubQuery*>(plan->right);
+                                     for (vector<QueryGraph::Node>::const_iterator iter = query.nodes.begin(), limit = query.nodes.end(); iter != limit; ++iter) {
+                                         if ((!(*iter).constSubject) && (!context.count((*iter).subject)))
+                                             variables.insert((*iter).subject);
+                                         if ((!(*iter).constPredicate) && (!context.count((*iter).predicate)))
+                                             variables.insert((*iter).predicate);
+                                         if ((!(*iter).constObject) && (!context.count((*iter).object)))
+                                             variables.insert((*iter).object);
+                                     }
+                                     break;
+                                 }
         case Plan::Minus:
                                   collectVariables(context, variables, plan->left);
                                   collectVariables(context, variables, plan->right);
@@ -268,8 +307,12 @@ static void getJoinVariables(const map<unsigned, Register*>& context, set<unsign
                 variables.insert(*iter);
     }
     // Here, we figure out, if "right" is a scan, where the join variables are: s, p, or o.
+    // Only the first one is the key of a hash join
     if (bitset != NULL) {
-        findScan(right, variables, bitset);
+        set<unsigned> joinOn;
+        if (!variables.empty())
+            joinOn.insert(*variables.begin());
+        findScan(right, joinOn, bitset);
     }
 }
 
@@ -788,7 +831,7 @@ static Operator* translateSubselect(Runtime& runtime, /*const map<unsigned, Regi
     vector<Register*> outputFromTheSubquery;
     QueryGraph* query = (QueryGraph*)plan->right;
     Operator* tree = CodeGen::translateIntern(runtime, *query, plan->left,
-            outputFromTheSubquery, registers);
+            outputFromTheSubquery, registers, CodeGen::getTopK(*query));
     if (!tree) return 0;
 
     // And add the output generation
@@ -1061,6 +1104,9 @@ static Operator* translatePlan(Runtime& runtime, const map<unsigned, Register*>&
         case Plan::Singleton:
             result = new SingletonScan();
             break;
+        case Plan::LeapfrogJoin:
+            result = translateLeapfrogJoin(runtime, context, projection, bindings, registers, plan);
+            break;
         case Plan::GroupBy:
             result = translateGroupBy(runtime, context, projection, bindings, registers, plan);
             break;
@@ -1158,7 +1204,18 @@ static unsigned allocateRegisters(map<const QueryGraph::Node*, unsigned>& regist
     return id;
 }
 //---------------------------------------------------------------------------
-Operator* CodeGen::translateIntern(Runtime& runtime, const QueryGraph& query, Plan* plan, vector<Register*>& output, const map<const QueryGraph::Node*, unsigned> &registers)
+uint64_t CodeGen::getTopK(const QueryGraph& query)
+    // Number of sorted tuples needed to produce the result of a query with a limit
+{
+    // Every tuple produces at least one row only if the duplicates are kept
+    if (query.getLimit() == ~0u)
+        return ~static_cast<uint64_t>(0);
+    if (query.getDuplicateHandling() != QueryGraph::AllDuplicates && query.getDuplicateHandling() != QueryGraph::CountDuplicates)
+        return ~static_cast<uint64_t>(0);
+    return static_cast<uint64_t>(query.getLimit()) + query.getOffset();
+}
+//---------------------------------------------------------------------------
+Operator* CodeGen::translateIntern(Runtime& runtime, const QueryGraph& query, Plan* plan, vector<Register*>& output, const map<const QueryGraph::Node*, unsigned> &registers, uint64_t topK)
     // Perform a naive translation of a query into an operator tree without output generation
 {
     // Build the operator tree
@@ -1193,7 +1250,7 @@ Operator* CodeGen::translateIntern(Runtime& runtime, const QueryGraph& query, Pl
                     order.push_back(pair<Register*, bool>(bindings[(*iter).id], (*iter).descending));
                 else
                     order.push_back(pair<Register*, bool>(0, (*iter).descending));
-            tree = new Sort(runtime.getDatabase(), tree, regs, order, tree->getExpectedOutputCardinality());
+            tree = new Sort(runtime.getDatabase(), tree, regs, order, tree->getExpectedOutputCardinality(), topK);
         }
 
         // Remember the output registers
@@ -1250,7 +1307,7 @@ Operator* CodeGen::translate(Runtime& runtime, const QueryGraph& query, Plan* pl
 
     // Build the tree itself
     vector<Register*> output;
-    Operator* tree = translateIntern(runtime, query, plan, output, registers);
+    Operator* tree = translateIntern(runtime, query, plan, output, registers, getTopK(query));
     if (!tree) return 0;
 
     // And add the output generation
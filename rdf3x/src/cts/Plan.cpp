@@ -100,6 +100,9 @@ void Plan::print(unsigned indent) const
 	case Aggregates:
             cout << "Aggregates";
 	    break;
+        case LeapfrogJoin:
+            cout << "LeapfrogJoin";
+            break;
     }
     cout << " cardinality=" << cardinality << " costs=" << costs << endl;
     switch (op) {
@@ -109,6 +112,8 @@ void Plan::print(unsigned indent) const
             break;
         case FullyAggregatedIndexScan:
             break;
+        case LeapfrogJoin:
+            break;
         case NestedLoopJoin:
         case MergeJoin:
         case HashJoin:
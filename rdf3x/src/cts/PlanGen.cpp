@@ -1,5 +1,6 @@
 #include <cts/plangen/PlanGen.hpp>
 #include <cts/plangen/Costs.hpp>
+#include <rts/operator/LeapfrogJoin.hpp>
 
 /*#include "cts/codegen/CodeGen.hpp"
 #include "rts/segment/AggregatedFactsSegment.hpp"
@@ -10,6 +11,7 @@
 #include <map>
 #include <set>
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 //---------------------------------------------------------------------------
 // RDF-3X
@@ -859,6 +861,7 @@ static void findFilters(Plan* plan, set<const QueryGraph::Filter*>& filters)
         case Plan::IndexScan:
         case Plan::AggregatedIndexScan:
         case Plan::FullyAggregatedIndexScan:
+        case Plan::LeapfrogJoin:
         case Plan::Singleton:
             // We reached a leaf.
             break;
@@ -892,6 +895,152 @@ static void findFilters(Plan* plan, set<const QueryGraph::Filter*>& filters)
     }
 }
 //---------------------------------------------------------------------------
+static bool isCyclic(const QueryGraph::SubQuery& query)
+    // Check whether the patterns form a cyclic hypergraph (GYO reduction)
+{
+    vector<set<unsigned> > edges;
+    for (vector<QueryGraph::Node>::const_iterator iter = query.nodes.begin(), limit = query.nodes.end(); iter != limit; ++iter) {
+        set<unsigned> vars;
+        if (!(*iter).constSubject) vars.insert((*iter).subject);
+        if (!(*iter).constPredicate) vars.insert((*iter).predicate);
+        if (!(*iter).constObject) vars.insert((*iter).object);
+        edges.push_back(vars);
+    }
+    bool changed = true;
+    while (changed && (edges.size() > 1)) {
+        changed = false;
+        // Remove the variables that occur in a single pattern
+        map<unsigned, unsigned> occurrences;
+        for (vector<set<unsigned> >::const_iterator iter = edges.begin(), limit = edges.end(); iter != limit; ++iter)
+            for (set<unsigned>::const_iterator iter2 = (*iter).begin(), limit2 = (*iter).end(); iter2 != limit2; ++iter2)
+                occurrences[*iter2]++;
+        for (vector<set<unsigned> >::iterator iter = edges.begin(), limit = edges.end(); iter != limit; ++iter)
+            for (set<unsigned>::iterator iter2 = (*iter).begin(); iter2 != (*iter).end();)
+                if (occurrences[*iter2] == 1) {
+                    (*iter).erase(iter2++);
+                    changed = true;
+                } else {
+                    ++iter2;
+                }
+        // Remove the patterns contained in another one
+        for (unsigned index = 0; index < edges.size(); index++)
+            for (unsigned index2 = 0; index2 < edges.size(); index2++)
+                if ((index != index2) && includes(edges[index2].begin(), edges[index2].end(), edges[index].begin(), edges[index].end())) {
+                    edges.erase(edges.begin() + index);
+                    index--;
+                    changed = true;
+                    break;
+                }
+    }
+    return edges.size() > 1;
+}
+//---------------------------------------------------------------------------
+static double boundBindings(const vector<LeapfrogJoin::Atom>& atoms, const vector<double>& cards, unsigned nvars)
+    // Bound the number of bindings of the first nvars variables of the variable order
+{
+    if (!nvars)
+        return 1;
+    // Cover every variable with the smallest pattern that contains it
+    vector<bool> covered(nvars, false);
+    set<unsigned> cover;
+    for (unsigned var = 0; var < nvars; var++) {
+        if (covered[var])
+            continue;
+        unsigned best = ~0u;
+        for (unsigned index = 0; index < atoms.size(); index++)
+            if ((find(atoms[index].variables.begin(), atoms[index].variables.end(), var) != atoms[index].variables.end()) &&
+                    ((!~best) || (cards[index] < cards[best])))
+                best = index;
+        cover.insert(best);
+        for (vector<unsigned>::const_iterator iter = atoms[best].variables.begin(), limit = atoms[best].variables.end(); iter != limit; ++iter)
+            if (*iter < nvars)
+                covered[*iter] = true;
+    }
+    double bound = 1;
+    for (set<unsigned>::const_iterator iter = cover.begin(), limit = cover.end(); iter != limit; ++iter)
+        bound *= cards[*iter];
+
+    // If every variable is in two patterns, half of every pattern is also a
+    // cover (AGM bound, e.g. N^1.5 for a triangle)
+    vector<unsigned> occurrences(nvars, 0);
+    double half = 1;
+    for (unsigned index = 0; index < atoms.size(); index++) {
+        bool touches = false;
+        for (vector<unsigned>::const_iterator iter = atoms[index].variables.begin(), limit = atoms[index].variables.end(); iter != limit; ++iter)
+            if (*iter < nvars) {
+                occurrences[*iter]++;
+                touches = true;
+            }
+        if (touches)
+            half *= sqrt(cards[index]);
+    }
+    if (*min_element(occurrences.begin(), occurrences.end()) >= 2)
+        bound = min(bound, half);
+    return bound;
+}
+//---------------------------------------------------------------------------
+static double estimateLeapfrogCosts(DBLayer& db, const QueryGraph::SubQuery& query, const vector<unsigned>& variableOrder, const vector<LeapfrogJoin::Atom>& atoms)
+    // Estimate the costs of a worst-case optimal join
+{
+    vector<double> cards;
+    for (vector<QueryGraph::Node>::const_iterator iter = query.nodes.begin(), limit = query.nodes.end(); iter != limit; ++iter) {
+        const QueryGraph::Node& node = *iter;
+        cards.push_back(db.getCardinality(node.constSubject ? node.subject : ~0ull, node.constPredicate ? node.predicate : ~0ull, node.constObject ? node.object : ~0ull));
+    }
+
+    // Every binding of a level opens and seeks the patterns of the next
+    // level, and every value found is read once
+    double costs = 0;
+    double bindings = 1;
+    for (unsigned level = 0; level < variableOrder.size(); level++) {
+        unsigned natoms = 0;
+        for (vector<LeapfrogJoin::Atom>::const_iterator iter = atoms.begin(), limit = atoms.end(); iter != limit; ++iter)
+            if (find((*iter).variables.begin(), (*iter).variables.end(), level) != (*iter).variables.end())
+                natoms++;
+        costs += Costs::leapfrogSeeks(bindings, natoms);
+        bindings = boundBindings(atoms, cards, level + 1);
+        costs += bindings;
+    }
+    return costs;
+}
+//---------------------------------------------------------------------------
+Plan* PlanGen::buildLeapfrogJoin(const QueryGraph::SubQuery& query, Plan* plans)
+    // Replace the join trees of a cyclic pattern with a worst-case optimal join if it is cheaper
+{
+    // Only plain basic graph patterns with a cycle. The remaining filters
+    // and minuses are applied on top of the join as usual
+    if ((&query != &fullQuery->getQuery()) || (query.nodes.size() < 3) ||
+            (!query.optional.empty()) || (!query.unions.empty()) ||
+            (!query.subqueries.empty()) || (!query.tableFunctions.empty()) ||
+            (!query.valueNodes.empty()) || (!isCyclic(query)))
+        return plans;
+    vector<unsigned> variableOrder;
+    vector<LeapfrogJoin::Atom> atoms;
+    if (!LeapfrogJoin::buildAtoms(*db, query, variableOrder, atoms))
+        return plans;
+
+    // The cheapest binary plan
+    Plan* best = plans;
+    for (Plan* iter = plans->next; iter; iter = iter->next)
+        if (iter->costs < best->costs)
+            best = iter;
+    double costs = estimateLeapfrogCosts(*db, query, variableOrder, atoms);
+    if (costs >= best->costs)
+        return plans;
+
+    Plan* p = this->plans->alloc();
+    p->op = Plan::LeapfrogJoin;
+    p->opArg = 0;
+    p->left = 0;
+    p->right = reinterpret_cast<Plan*>(const_cast<QueryGraph::SubQuery*>(&query));
+    p->next = 0;
+    // The output is the same as the one of the binary plans
+    p->cardinality = best->cardinality;
+    p->costs = costs;
+    p->ordering = ~0u;
+    return p;
+}
+//---------------------------------------------------------------------------
 Plan* PlanGen::translate_int(const QueryGraph::SubQuery& query,
         const QueryGraph &entirePlan,
         bool completeEstimate)
@@ -1234,7 +1383,7 @@ Plan* PlanGen::translate_int(const QueryGraph::SubQuery& query,
         cerr << "Something went wrong...";
         throw 10;
     }
-    Plan* plan =  dpTable.back()->plans;
+    Plan* plan = buildLeapfrogJoin(query, dpTable.back()->plans);
 
     // Add all remaining filters
     set<const QueryGraph::Filter*> appliedFilters;
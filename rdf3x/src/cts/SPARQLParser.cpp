@@ -1823,6 +1823,122 @@ string SPARQLParser::getVariableName(unsigned id) const
     return "";
 }
 //---------------------------------------------------------------------------
+static bool usesVariable(const SPARQLParser::Element& e, unsigned id)
+// Is the element the variable?
+{
+    return (e.type == SPARQLParser::Element::Variable) && (e.id == id);
+}
+//---------------------------------------------------------------------------
+static bool usesVariable(const SPARQLParser::PatternGroup& group, unsigned id,
+        bool skipPatterns);
+//---------------------------------------------------------------------------
+static bool usesVariable(const SPARQLParser::Filter* f, unsigned id)
+// Does the expression use the variable?
+{
+    if (!f)
+        return false;
+    if ((f->type == SPARQLParser::Filter::Variable) && (f->valueArg == id))
+        return true;
+    // Be conservative with the subqueries
+    if (f->pointerToSubquery)
+        return true;
+    if (f->pointerToSubPattern && usesVariable(*f->pointerToSubPattern, id, false))
+        return true;
+    return usesVariable(f->arg1, id) || usesVariable(f->arg2, id) ||
+        usesVariable(f->arg3, id) || usesVariable(f->arg4, id);
+}
+//---------------------------------------------------------------------------
+static bool usesVariable(const SPARQLParser::PatternGroup& group, unsigned id,
+        bool skipPatterns)
+// Does the group use the variable? If skipPatterns is set, its own triple
+// patterns are not checked
+{
+    if (!skipPatterns) {
+        for (auto& p : group.patterns)
+            if (usesVariable(p.subject, id) || usesVariable(p.predicate, id) ||
+                    usesVariable(p.object, id))
+                return true;
+    }
+    for (auto& a : group.assignments)
+        if (usesVariable(a.outputVar, id) || usesVariable(a.expression.get(), id))
+            return true;
+    for (auto& f : group.filters)
+        if (usesVariable(&f, id))
+            return true;
+    for (auto& g : group.optional)
+        if (usesVariable(g, id, false))
+            return true;
+    for (auto& u : group.unions)
+        for (auto& g : u)
+            if (usesVariable(g, id, false))
+                return true;
+    for (auto& g : group.minuses)
+        if (usesVariable(g, id, false))
+            return true;
+    for (auto& v : group.values)
+        for (auto var : v.variables)
+            if (var == id)
+                return true;
+    // Be conservative with the subqueries
+    return !group.subqueries.empty();
+}
+//---------------------------------------------------------------------------
+bool SPARQLParser::bindVariable(const string& name, const string& term,
+        vector<unsigned>& positions, int& valuesIdx)
+// Bind a variable to a constant
+{
+    positions.clear();
+    valuesIdx = -1;
+    map<string, unsigned>::const_iterator var = namedVariables.find(name);
+    if (var == namedVariables.end())
+        return false;
+    const unsigned id = (*var).second;
+
+    // The term is looked up as it is in the dictionary
+    Element value;
+    value.type = Element::Literal;
+    value.subType = Element::None;
+    value.subTypeValue = "";
+    value.value = term;
+    value.id = 0;
+
+    // Is the variable used outside the triple patterns of the main group?
+    bool usedElsewhere = usesVariable(patterns, id, true);
+    for (auto v : projection)
+        usedElsewhere |= (v == id);
+    for (auto& o : order)
+        usedElsewhere |= (o.id == id) || usesVariable(o.expr, id);
+    for (auto& g : groupBy)
+        usedElsewhere |= (g.id == id) || usesVariable(g.expr, id);
+    for (auto f : having)
+        usedElsewhere |= usesVariable(f, id);
+    for (auto& a : assignments)
+        usedElsewhere |= usesVariable(a.outputVar, id) ||
+            usesVariable(a.expression.get(), id);
+
+    if (usedElsewhere) {
+        // Keep the variable and bind it like VALUES ?var { term }, so that
+        // all the parts of the query (and the output) see the value
+        valuesIdx = patterns.values.size();
+        patterns.values.push_back(PatternGroup::ValueBindings(
+                    vector<unsigned>(1, id), vector<Element>(1, value)));
+        return true;
+    }
+
+    // Otherwise the constant makes the patterns more selective
+    for (size_t i = 0; i < patterns.patterns.size(); ++i) {
+        Element* elements[3] = { &patterns.patterns[i].subject,
+            &patterns.patterns[i].predicate, &patterns.patterns[i].object };
+        for (unsigned j = 0; j < 3; ++j) {
+            if (usesVariable(*elements[j], id)) {
+                *elements[j] = value;
+                positions.push_back(3 * i + j);
+            }
+        }
+    }
+    return true;
+}
+//---------------------------------------------------------------------------
 unsigned SPARQLParser::getVarCount() const {
     return variableCount;
 }
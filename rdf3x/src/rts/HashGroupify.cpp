@@ -1,6 +1,7 @@
 #include "rts/operator/HashGroupify.hpp"
 #include "rts/operator/PlanPrinter.hpp"
 #include "rts/runtime/Runtime.hpp"
+#include "rts/runtime/Morsels.hpp"
 //---------------------------------------------------------------------------
 // RDF-3X
 // (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
@@ -52,6 +53,69 @@ class HashGroupify::Chainer {
    }
 };
 //---------------------------------------------------------------------------
+/// Aggregates a morsel of the input in the partitions
+class HashGroupify::PartitionAggregator {
+   private:
+   /// The partitions
+   std::vector<Partition>& partitions;
+   /// The groups of the morsel, by partition
+   std::vector<std::vector<Group*> >& morsel;
+   /// The number of values
+   uint64_t width;
+
+   public:
+   /// Constructor
+   PartitionAggregator(std::vector<Partition>& partitions,std::vector<std::vector<Group*> >& morsel,uint64_t width) : partitions(partitions),morsel(morsel),width(width) {}
+
+   /// Aggregate the groups of the partitions in the range
+   void operator()(const ParallelRange& range) const;
+};
+//---------------------------------------------------------------------------
+void HashGroupify::PartitionAggregator::operator()(const ParallelRange& range) const
+   // Aggregate the groups of the partitions in the range
+{
+   for (size_t partition=range.begin();partition<range.end();partition++) {
+      Partition& p=partitions[partition];
+      for (std::vector<Group*>::const_iterator iter2=morsel[partition].begin(),limit2=morsel[partition].end();iter2!=limit2;++iter2) {
+         Group* g=*iter2;
+
+         // Scan the hash table for existing values
+         Group*& slot=p.hashTable[g->hash&(p.hashTable.size()-1)];
+         bool match=false;
+         for (Group* iter=slot;iter;iter=iter->next) {
+            match=true;
+            for (uint64_t index=0;index<width;index++)
+               if (iter->values[index]!=g->values[index])
+                  { match=false; break; }
+            if (match) {
+               // The group is released by the caller
+               iter->count+=g->count;
+               g->count=0;
+               break;
+            }
+         }
+         if (match) continue;
+
+         // Add the new group
+         g->next=slot;
+         slot=g;
+
+         // Rehash if necessary
+         if ((++p.load)>=p.maxLoad) {
+            std::vector<Group*> oldTable(p.hashTable.size()*2);
+            oldTable.swap(p.hashTable);
+            p.maxLoad=static_cast<uint64_t>(0.8*p.hashTable.size());
+            Rehasher rehasher(p.hashTable);
+            for (std::vector<Group*>::const_iterator iter=oldTable.begin(),limit=oldTable.end();iter!=limit;++iter)
+               for (Group* g2=*iter,*next;g2;g2=next) {
+                  next=g2->next;
+                  rehasher(g2);
+               }
+         }
+      }
+   }
+}
+//---------------------------------------------------------------------------
 HashGroupify::HashGroupify(Operator* input,const std::vector<Register*>& values,double expectedOutputCardinality)
    : Operator(expectedOutputCardinality),values(values),input(input),groups(0),groupsPool(values.size()*sizeof(uint64_t))
    // Constructor
@@ -69,56 +133,60 @@ uint64_t HashGroupify::first()
 {
    observedOutputCardinality=0;
 
-   // Aggregate the input
-   std::vector<Group*> hashTable;
-   uint64_t hashTableSize=64,load=0,maxLoad=static_cast<uint64_t>(0.8*hashTableSize);
-   hashTable.resize(hashTableSize);
+   // Aggregate the input. The input is read in morsels, and the partitions
+   // of every morsel are aggregated in parallel
+   unsigned partitionBits=Morsels::partitionBits();
+   uint64_t npartitions=static_cast<uint64_t>(1)<<partitionBits;
+   std::vector<Partition> partitions(npartitions);
+   for (std::vector<Partition>::iterator iter=partitions.begin(),limit=partitions.end();iter!=limit;++iter) {
+      (*iter).hashTable.resize(64);
+      (*iter).load=0;
+      (*iter).maxLoad=static_cast<uint64_t>(0.8*64);
+   }
    groupsPool.freeAll();
 
-   for (uint64_t count=input->first();count;count=input->next()) {
-      // Hash the aggregation values
-      uint64_t hash=0;
-      for (std::vector<Register*>::const_iterator iter=values.begin(),limit=values.end();iter!=limit;++iter)
-         hash=((hash<<15)|(hash>>(8*sizeof(uint64_t)-15)))^((*iter)->value);
-
-      // Scan the hash table for existing values
-      Group*& slot=hashTable[hash&(hashTableSize-1)];
-      bool match=false;
-      for (Group* iter=slot;iter;iter=iter->next) {
-         match=true;
+   std::vector<std::vector<Group*> > morsel(npartitions);
+   uint64_t morselSize=0;
+   Morsels::Workers workers;
+   for (uint64_t count=input->first();;count=input->next()) {
+      if (count) {
+         // Hash the aggregation values
+         uint64_t hash=0;
+         for (std::vector<Register*>::const_iterator iter=values.begin(),limit=values.end();iter!=limit;++iter)
+            hash=((hash<<15)|(hash>>(8*sizeof(uint64_t)-15)))^((*iter)->value);
+
+         // Copy the tuple
+         Group* g=groupsPool.alloc();
+         g->hash=hash;
+         g->count=count;
          for (uint64_t index=0,limit=values.size();index<limit;index++)
-            if (iter->values[index]!=values[index]->value)
-               { match=false; break; }
-         if (match) {
-            iter->count+=count;
-            break;
-         }
+            g->values[index]=values[index]->value;
+         morsel[Morsels::partition(hash,partitionBits)].push_back(g);
+         if ((++morselSize)<Morsels::MORSELSIZE)
+            continue;
       }
-      if (match) continue;
-
-      // Create a new group
-      Group* g=groupsPool.alloc();
-      g->next=slot;
-      g->hash=hash;
-      g->count=count;
-      for (uint64_t index=0,limit=values.size();index<limit;index++)
-         g->values[index]=values[index]->value;
-      slot=g;
 
-      // Rehash if necessary
-      if ((++load)>=maxLoad) {
-         hashTable.clear();
-         hashTableSize*=2;
-         maxLoad=static_cast<uint64_t>(0.8*hashTableSize);
-         hashTable.resize(hashTableSize);
-         Rehasher rehasher(hashTable);
-         groupsPool.enumAll(rehasher);
+      // Aggregate the morsel
+      workers.process(npartitions,morselSize,PartitionAggregator(partitions,morsel,values.size()));
+      for (std::vector<std::vector<Group*> >::iterator iter=morsel.begin(),limit=morsel.end();iter!=limit;++iter) {
+         for (std::vector<Group*>::const_iterator iter2=(*iter).begin(),limit2=(*iter).end();iter2!=limit2;++iter2)
+            if (!(*iter2)->count)
+               groupsPool.free(*iter2);
+         (*iter).clear();
       }
+      morselSize=0;
+      if (!count)
+         break;
    }
 
    // Form a chain out of the groups
    Chainer chainer;
-   groupsPool.enumAll(chainer);
+   for (std::vector<Partition>::const_iterator iter=partitions.begin(),limit=partitions.end();iter!=limit;++iter)
+      for (std::vector<Group*>::const_iterator iter2=(*iter).hashTable.begin(),limit2=(*iter).hashTable.end();iter2!=limit2;++iter2)
+         for (Group* g=*iter2,*next;g;g=next) {
+            next=g->next;
+            chainer(g);
+         }
 
    groups=chainer.getHead();
    groupsIter=groups;
@@ -1,6 +1,7 @@
 #include "rts/operator/HashJoin.hpp"
 #include "rts/operator/PlanPrinter.hpp"
 #include "rts/runtime/Runtime.hpp"
+#include "rts/runtime/Morsels.hpp"
 
 #include <kognac/logs.h>
 
@@ -24,7 +25,75 @@ static inline uint64_t hash2(uint64_t key, uint64_t hashTableSize) {
     return hashTableSize + ((key ^ (key >> 3)) & (hashTableSize - 1));
 }
 //---------------------------------------------------------------------------
-//
+/// Inserts a morsel of the left side in the hash tables
+class HashJoin::PartitionBuilder {
+    private:
+        /// The operator
+        HashJoin& join;
+        /// The entries of the morsel, by partition
+        vector<vector<Entry*> >& morsel;
+
+    public:
+        /// Constructor
+        PartitionBuilder(HashJoin& join, vector<vector<Entry*> >& morsel) : join(join), morsel(morsel) {}
+
+        /// Insert the entries of the partitions in the range
+        void operator()(const ParallelRange& range) const;
+};
+//---------------------------------------------------------------------------
+void HashJoin::PartitionBuilder::operator()(const ParallelRange& range) const
+    // Insert the entries of the partitions in the range
+{
+    uint64_t tailLength = join.leftTail.size();
+    for (size_t partition = range.begin(); partition < range.end(); partition++) {
+        vector<Entry*>& hashTable = join.hashTables[partition];
+        vector<uint64_t>& keys = join.partitionKeys[partition];
+        for (vector<Entry*>::const_iterator iter2 = morsel[partition].begin(), limit2 = morsel[partition].end(); iter2 != limit2; ++iter2) {
+            Entry* newEntry = *iter2;
+            uint64_t leftKey = newEntry->key;
+            uint64_t hashTableSize = hashTable.size() / 2;
+            uint64_t slot1 = hash1(leftKey, hashTableSize), slot2 = hash2(leftKey, hashTableSize);
+
+            // Scan if the entry already exists
+            Entry* e = hashTable[slot1];
+            if ((!e) || (e->key != leftKey))
+                e = hashTable[slot2];
+            if (e && (e->key == leftKey)) {
+                uint64_t ofs = (e == hashTable[slot1]) ? slot1 : slot2;
+                bool match = false;
+                for (Entry* iter = e; iter; iter = iter->next)
+                    if (leftKey == iter->key) {
+                        // Tuple already in the table?
+                        match = true;
+                        for (uint64_t index2 = 0; index2 < tailLength; index2++)
+                            if (newEntry->values[index2] != iter->values[index2]) {
+                                match = false;
+                                break;
+                            }
+                        // Then aggregate, the new entry is released by the caller
+                        if (match) {
+                            iter->count += newEntry->count;
+                            newEntry->count = 0;
+                            break;
+                        }
+                    }
+                if (match)
+                    continue;
+
+                // Append to the current bucket
+                newEntry->next = hashTable[ofs];
+                hashTable[ofs] = newEntry;
+                continue;
+            }
+
+            // Insert a new key
+            keys.push_back(leftKey);
+            newEntry->next = 0;
+            insert(hashTable, newEntry);
+        }
+    }
+}
+//---------------------------------------------------------------------------
 void HashJoin::BuildHashTable::run()
     // Build the hash table
 {
@@ -42,82 +111,70 @@ void HashJoin::BuildHashTable::run()
     vector<ObservedDomainDescription> observedDomains;
     observedDomains.resize(domainRegs.size());
 
-    // Build the hash table from the left side
-    uint64_t hashTableSize = 1024;
+    // Build the hash tables from the left side. The input is read in morsels,
+    // and the partitions of every morsel are inserted in parallel
     uint64_t tailLength = join.leftTail.size();
-    join.hashTable.clear();
-    join.hashTable.resize(2 * hashTableSize);
-    for (uint64_t leftCount = join.left->first(); leftCount; leftCount = join.left->next()) {
-        // Check the domain first
-        bool joinCandidate = true;
-        for (uint64_t index = 0, limit = domainRegs.size(); index < limit; ++index) {
-            if (!domainRegs[index]->domain->couldQualify(domainRegs[index]->value)) {
-                joinCandidate = false;
-                break;
-            }
-            observedDomains[index].add(domainRegs[index]->value);
-        }
-        if (!joinCandidate)
-            continue;
-        // Compute the slots
-        uint64_t leftKey = leftValue->value;
-        uint64_t slot1 = hash1(leftKey, hashTableSize), slot2 = hash2(leftKey, hashTableSize);
-        // LOG(DEBUGL) << "leftKey = " << leftKey;
-
-        // Scan if the entry already exists
-        Entry* e = join.hashTable[slot1];
-        if ((!e) || (e->key != leftKey))
-            e = join.hashTable[slot2];
-        if (e && (e->key == leftKey)) {
-            uint64_t ofs = (e == join.hashTable[slot1]) ? slot1 : slot2;
-            bool match = false;
-            for (Entry* iter = e; iter; iter = iter->next)
-                if (leftKey == iter->key) {
-                    // Tuple already in the table?
-                    match = true;
-                    for (uint64_t index2 = 0; index2 < tailLength; index2++)
-                        if (join.leftTail[index2]->value != iter->values[index2]) {
-                            match = false;
-                            break;
-                        }
-                    // Then aggregate
-                    if (match) {
-                        iter->count += leftCount;
-                        break;
-                    }
+    join.partitionBits = Morsels::partitionBits();
+    uint64_t npartitions = static_cast<uint64_t>(1) << join.partitionBits;
+    join.hashTables.clear();
+    join.hashTables.resize(npartitions);
+    join.partitionKeys.clear();
+    join.partitionKeys.resize(npartitions);
+    for (uint64_t partition = 0; partition < npartitions; partition++)
+        join.hashTables[partition].resize(2 * 1024);
+    vector<vector<Entry*> > morsel(npartitions);
+    uint64_t morselSize = 0;
+    Morsels::Workers workers;
+    for (uint64_t leftCount = join.left->first(); ; leftCount = join.left->next()) {
+        if (leftCount) {
+            // Check the domain first
+            bool joinCandidate = true;
+            for (uint64_t index = 0, limit = domainRegs.size(); index < limit; ++index) {
+                if (!domainRegs[index]->domain->couldQualify(domainRegs[index]->value)) {
+                    joinCandidate = false;
+                    break;
                 }
-            if (match)
+                observedDomains[index].add(domainRegs[index]->value);
+            }
+            if (!joinCandidate)
                 continue;
 
-            // Append to the current bucket
-            e = join.entryPool.alloc();
-            e->next = join.hashTable[ofs];
-            join.hashTable[ofs] = e;
-            e->key = leftKey;
+            // Copy the tuple
+            Entry* e = join.entryPool.alloc();
+            e->next = 0;
+            e->key = leftValue->value;
             e->count = leftCount;
             for (uint64_t index2 = 0; index2 < tailLength; index2++)
                 e->values[index2] = join.leftTail[index2]->value;
-            continue;
+            morsel[Morsels::partition(e->key, join.partitionBits)].push_back(e);
+            if ((++morselSize) < Morsels::MORSELSIZE)
+                continue;
         }
 
-        // Create a new tuple
-        join.keys.push_back(leftKey);
-        e = join.entryPool.alloc();
-        e->next = 0;
-        e->key = leftKey;
-        e->count = leftCount;
-        for (uint64_t index2 = 0; index2 < tailLength; index2++)
-            e->values[index2] = join.leftTail[index2]->value;
-
-        // And insert it
-        join.insert(e);
-        hashTableSize = join.hashTable.size() / 2;
+        // Insert the morsel
+        workers.process(npartitions, morselSize, PartitionBuilder(join, morsel));
+        for (vector<vector<Entry*> >::iterator iter = morsel.begin(), limit = morsel.end(); iter != limit; ++iter) {
+            for (vector<Entry*>::const_iterator iter2 = (*iter).begin(), limit2 = (*iter).end(); iter2 != limit2; ++iter2)
+                if (!(*iter2)->count)
+                    join.entryPool.free(*iter2);
+            (*iter).clear();
+        }
+        morselSize = 0;
+        if (!leftCount)
+            break;
     }
+    for (vector<vector<uint64_t> >::iterator iter = join.partitionKeys.begin(), limit = join.partitionKeys.end(); iter != limit; ++iter) {
+        join.keys.insert(join.keys.end(), (*iter).begin(), (*iter).end());
+        vector<uint64_t>().swap(*iter);
+    }
+    // The scans of the probe side seek in the sorted keys
+    Morsels::sort(join.keys.begin(), join.keys.end());
 
     // Update the domains
     for (uint64_t index = 0, limit = domainRegs.size(); index < limit; ++index)
         domainRegs[index]->domain->restrictTo(observedDomains[index]);
-    if (join.bitset != 0) {
+    // Pass the keys to the probe side, unless its tuples without a match are kept
+    if ((join.bitset != 0) && (!join.leftOptional)) {
         join.right->setHashKeys(&join.keys, join.bitset);
     }
 
@@ -138,7 +195,7 @@ HashJoin::HashJoin(Operator* left, Register* leftValue, const vector<Register*>&
         double probePriority, double expectedOutputCardinality, bool leftOptional, bool rightOptional, int bitset)
     : Operator(expectedOutputCardinality), left(left), right(right), leftValue(leftValue), rightValue(rightValue),
     leftTail(leftTail), rightTail(rightTail), entryPool(leftTail.size() * sizeof(uint64_t)),
-    bitset(bitset), buildHashTableTask(*this), probePeekTask(*this), hashPriority(hashPriority), probePriority(probePriority),
+    partitionBits(0), bitset(bitset), buildHashTableTask(*this), probePeekTask(*this), hashPriority(hashPriority), probePriority(probePriority),
     leftOptional(leftOptional), rightOptional(rightOptional)
       // Constructor
 {
@@ -151,8 +208,8 @@ HashJoin::~HashJoin()
     delete right;
 }
 //---------------------------------------------------------------------------
-void HashJoin::insert(Entry* e)
-    // Insert into the hash table
+void HashJoin::insert(vector<Entry*>& hashTable, Entry* e)
+    // Insert into a hash table
 {
     uint64_t hashTableSize = hashTable.size() / 2;
     // Try to insert
@@ -171,13 +228,14 @@ void HashJoin::insert(Entry* e)
     swap(hashTable, oldTable);
     for (vector<Entry*>::const_iterator iter = oldTable.begin(), limit = oldTable.end(); iter != limit; ++iter)
         if (*iter)
-            insert(*iter);
-    insert(e);
+            insert(hashTable, *iter);
+    insert(hashTable, e);
 }
 //---------------------------------------------------------------------------
 HashJoin::Entry* HashJoin::lookup(uint64_t key)
     // Search an entry in the hash table
 {
+    const vector<Entry*>& hashTable = hashTables[Morsels::partition(key, partitionBits)];
     uint64_t hashTableSize = hashTable.size() / 2;
     Entry* e = hashTable[hash1(key, hashTableSize)];
     if (e && (e->key == key))
@@ -221,13 +279,16 @@ uint64_t HashJoin::next()
 {
     if (currentIdx != (size_t) -1) {
         Entry *e;
-        while (currentIdx < hashTable.size()) {
-            if ((e = hashTable[currentIdx++])
-                    && !collectedRightValues.count(e->key)) {
-                for (uint64_t index = 0, limit = leftTail.size();
-                        index < limit; ++index)
-                    leftTail[index]->value = e->values[index];
-                return e->count;
+        for (; currentPartition < hashTables.size(); currentPartition++, currentIdx = 0) {
+            const vector<Entry*>& hashTable = hashTables[currentPartition];
+            while (currentIdx < hashTable.size()) {
+                if ((e = hashTable[currentIdx++])
+                        && !collectedRightValues.count(e->key)) {
+                    for (uint64_t index = 0, limit = leftTail.size();
+                            index < limit; ++index)
+                        leftTail[index]->value = e->values[index];
+                    return e->count;
+                }
             }
         }
         return false;
@@ -271,6 +332,7 @@ uint64_t HashJoin::next()
             } else {
                 //Scan the all left table. return a NULL for each entry not joined
                 currentIdx = 0;
+                currentPartition = 0;
                 for (uint64_t index = 0, limit = rightTail.size();
                         index < limit; ++index)
                     rightTail[index]->value = ~0u;
@@ -221,6 +221,17 @@ void IndexScan::IndexScanHint::next(uint64_t& value1, uint64_t& value2, uint64_t
     }
 }
 //---------------------------------------------------------------------------
+bool IndexScan::IndexScanHint::canSkip()
+// Can the hint move the scan forward?
+{
+    // The bound prefix is already a constraint of the scan
+    if ((scan.bound2 && !scan.bound1) || (scan.bound3 && !(scan.bound1 && scan.bound2)))
+        return true;
+    if ((!scan.merge1.empty()) || (!scan.merge2.empty()) || (!scan.merge3.empty()))
+        return true;
+    return scan.value1->domain || scan.value2->domain || scan.value3->domain;
+}
+//---------------------------------------------------------------------------
 IndexScan::IndexScan(DBLayer& db, DBLayer::DataOrder order, Register* value1, bool bound1, Register* value2, bool bound2, Register* value3, bool bound3, double expectedOutputCardinality)
     : Operator(expectedOutputCardinality), value1(value1), value2(value2), value3(value3), bound1(bound1), bound2(bound2), bound3(bound3)/*,facts(db.getFacts(order))*/, order(order),
       hint(*this), scan(db.getScan(order, DBLayer::AGGR_NO, &hint))
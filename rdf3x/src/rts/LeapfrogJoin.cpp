@@ -0,0 +1,272 @@
+#include "rts/operator/LeapfrogJoin.hpp"
+#include "rts/operator/PlanPrinter.hpp"
+#include "rts/runtime/Runtime.hpp"
+
+#include <algorithm>
+#include <map>
+#include <set>
+//---------------------------------------------------------------------------
+// RDF-3X
+// (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
+//
+// This work is licensed under the Creative Commons
+// Attribution-Noncommercial-Share Alike 3.0 Unported License. To view a copy
+// of this license, visit http://creativecommons.org/licenses/by-nc-sa/3.0/
+// or send a letter to Creative Commons, 171 Second Street, Suite 300,
+// San Francisco, California, 94105, USA.
+//---------------------------------------------------------------------------
+using namespace std;
+//---------------------------------------------------------------------------
+namespace {
+//---------------------------------------------------------------------------
+/// Sort the scans by their current value
+struct ScanSorter {
+   bool operator()(const unique_ptr<DBLayer::ValueScan>& a,const unique_ptr<DBLayer::ValueScan>& b) const { return a->getValue()<b->getValue(); }
+};
+//---------------------------------------------------------------------------
+DBLayer::DataOrder getOrder(unsigned slot1,unsigned slot2)
+   // The order that starts with the two slots (0=subject, 1=predicate, 2=object)
+{
+   switch (slot1) {
+      case 0: return (slot2==1)?DBLayer::Order_Subject_Predicate_Object:DBLayer::Order_Subject_Object_Predicate;
+      case 1: return (slot2==0)?DBLayer::Order_Predicate_Subject_Object:DBLayer::Order_Predicate_Object_Subject;
+      default: return (slot2==0)?DBLayer::Order_Object_Subject_Predicate:DBLayer::Order_Object_Predicate_Subject;
+   }
+}
+//---------------------------------------------------------------------------
+}
+//---------------------------------------------------------------------------
+LeapfrogJoin::LeapfrogJoin(DBLayer& db,const vector<Atom>& atoms,const vector<Register*>& variables,double expectedOutputCardinality)
+   : Operator(expectedOutputCardinality),db(db),atoms(atoms),variables(variables),levels(variables.size())
+   // Constructor
+{
+   for (unsigned index=0;index<atoms.size();index++)
+      for (unsigned index2=0;index2<atoms[index].variables.size();index2++)
+         levels[atoms[index].variables[index2]].atoms.push_back(pair<unsigned,unsigned>(index,index2));
+}
+//---------------------------------------------------------------------------
+LeapfrogJoin::~LeapfrogJoin()
+   // Destructor
+{
+}
+//---------------------------------------------------------------------------
+bool LeapfrogJoin::buildAtoms(DBLayer& db,const QueryGraph::SubQuery& query,vector<unsigned>& variableOrder,vector<Atom>& atoms)
+   // Choose the variable order and the permutations of the patterns
+{
+   // Collect the variables of the patterns and their selectivity
+   map<unsigned,unsigned> occurrences;
+   map<unsigned,uint64_t> cardinalities;
+   vector<vector<unsigned> > nodeVariables;
+   for (vector<QueryGraph::Node>::const_iterator iter=query.nodes.begin(),limit=query.nodes.end();iter!=limit;++iter) {
+      const QueryGraph::Node& node=*iter;
+      if (node.constSubject&&node.constPredicate&&node.constObject)
+         return false;
+      if ((!node.constSubject)&&(!node.constPredicate)&&(!node.constObject))
+         return false;
+      vector<unsigned> vars;
+      if (!node.constSubject) vars.push_back(node.subject);
+      if (!node.constPredicate) vars.push_back(node.predicate);
+      if (!node.constObject) vars.push_back(node.object);
+      if ((vars.size()==2)&&(vars[0]==vars[1]))
+         return false;
+      uint64_t card=db.getCardinality(node.constSubject?node.subject:~0ull,node.constPredicate?node.predicate:~0ull,node.constObject?node.object:~0ull);
+      for (vector<unsigned>::const_iterator iter2=vars.begin(),limit2=vars.end();iter2!=limit2;++iter2) {
+         occurrences[*iter2]++;
+         if ((!cardinalities.count(*iter2))||(cardinalities[*iter2]>card))
+            cardinalities[*iter2]=card;
+      }
+      nodeVariables.push_back(vars);
+   }
+
+   // Bind first the variables that are shared by most patterns, then the
+   // most selective ones. Prefer variables connected to the bound ones
+   variableOrder.clear();
+   set<unsigned> connected;
+   while (variableOrder.size()<occurrences.size()) {
+      unsigned best=~0u;
+      for (map<unsigned,unsigned>::const_iterator iter=occurrences.begin(),limit=occurrences.end();iter!=limit;++iter) {
+         unsigned var=(*iter).first;
+         if (find(variableOrder.begin(),variableOrder.end(),var)!=variableOrder.end())
+            continue;
+         if (!~best) { best=var; continue; }
+         bool c1=connected.count(var),c2=connected.count(best);
+         if (c1!=c2) {
+            if (c1) best=var;
+            continue;
+         }
+         if (occurrences[var]!=occurrences[best]) {
+            if (occurrences[var]>occurrences[best]) best=var;
+            continue;
+         }
+         if (cardinalities[var]<cardinalities[best])
+            best=var;
+      }
+      variableOrder.push_back(best);
+      for (vector<vector<unsigned> >::const_iterator iter=nodeVariables.begin(),limit=nodeVariables.end();iter!=limit;++iter)
+         if (find((*iter).begin(),(*iter).end(),best)!=(*iter).end())
+            connected.insert((*iter).begin(),(*iter).end());
+   }
+   map<unsigned,unsigned> positions;
+   for (unsigned index=0;index<variableOrder.size();index++)
+      positions[variableOrder[index]]=index;
+
+   // Read every pattern from the permutation with the constants first and
+   // the variables in the variable order
+   atoms.clear();
+   for (vector<QueryGraph::Node>::const_iterator iter=query.nodes.begin(),limit=query.nodes.end();iter!=limit;++iter) {
+      const QueryGraph::Node& node=*iter;
+      uint64_t values[3]={node.subject,node.predicate,node.object};
+      bool constants[3]={node.constSubject,node.constPredicate,node.constObject};
+      vector<unsigned> constSlots,varSlots;
+      for (unsigned slot=0;slot<3;slot++)
+         if (constants[slot])
+            constSlots.push_back(slot); else
+            varSlots.push_back(slot);
+      if ((varSlots.size()==2)&&(positions[values[varSlots[0]]]>positions[values[varSlots[1]]]))
+         swap(varSlots[0],varSlots[1]);
+
+      Atom atom;
+      atom.constants=constSlots.size();
+      atom.values[0]=atom.values[1]=0;
+      if (constSlots.size()==1) {
+         atom.order=getOrder(constSlots[0],varSlots[0]);
+      } else {
+         // Any order of the constants will do
+         atom.order=getOrder(constSlots[0],constSlots[1]);
+         if (!db.hasValueScans(atom.order))
+            swap(constSlots[0],constSlots[1]);
+         atom.order=getOrder(constSlots[0],constSlots[1]);
+      }
+      if (!db.hasValueScans(atom.order))
+         return false;
+      for (unsigned index=0;index<constSlots.size();index++)
+         atom.values[index]=values[constSlots[index]];
+      for (vector<unsigned>::const_iterator iter2=varSlots.begin(),limit2=varSlots.end();iter2!=limit2;++iter2)
+         atom.variables.push_back(positions[values[*iter2]]);
+      atoms.push_back(atom);
+   }
+   return true;
+}
+//---------------------------------------------------------------------------
+bool LeapfrogJoin::open(unsigned level)
+   // Open the scans of a level and find the first common value
+{
+   Level& l=levels[level];
+   l.scans.clear();
+   for (vector<pair<unsigned,unsigned> >::const_iterator iter=l.atoms.begin(),limit=l.atoms.end();iter!=limit;++iter) {
+      const Atom& atom=atoms[(*iter).first];
+      // The constants and the variables before this one are bound
+      uint64_t values[2]={atom.values[0],atom.values[1]};
+      unsigned bound=atom.constants;
+      for (unsigned index=0;index<(*iter).second;index++)
+         values[bound++]=variables[atom.variables[index]]->value;
+      unique_ptr<DBLayer::ValueScan> scan=db.getValueScan(atom.order,bound,values[0],values[1]);
+      if (!scan) {
+         l.scans.clear();
+         return false;
+      }
+      l.scans.push_back(move(scan));
+   }
+   sort(l.scans.begin(),l.scans.end(),ScanSorter());
+   l.current=0;
+   return search(level);
+}
+//---------------------------------------------------------------------------
+bool LeapfrogJoin::search(unsigned level)
+   // Find the first value common to all scans of a level
+{
+   Level& l=levels[level];
+   unsigned count=l.scans.size();
+   uint64_t max=l.scans[(l.current+count-1)%count]->getValue();
+   while (true) {
+      DBLayer::ValueScan& scan=*l.scans[l.current];
+      if (scan.getValue()==max) {
+         variables[level]->value=max;
+         return true;
+      }
+      if (!scan.seek(max))
+         return false;
+      max=scan.getValue();
+      l.current=(l.current+1)%count;
+   }
+}
+//---------------------------------------------------------------------------
+bool LeapfrogJoin::advance(unsigned level)
+   // Move to the next common value of a level
+{
+   Level& l=levels[level];
+   if (!l.scans[l.current]->next())
+      return false;
+   l.current=(l.current+1)%l.scans.size();
+   return search(level);
+}
+//---------------------------------------------------------------------------
+uint64_t LeapfrogJoin::produce(unsigned level)
+   // Bind the levels below a level
+{
+   unsigned last=levels.size()-1;
+   while (true) {
+      if (level==last) {
+         observedOutputCardinality++;
+         return 1;
+      }
+      if (open(level+1)) {
+         level++;
+         continue;
+      }
+      // No binding below, try the next value
+      while (!advance(level)) {
+         if (!level)
+            return false;
+         level--;
+      }
+   }
+}
+//---------------------------------------------------------------------------
+uint64_t LeapfrogJoin::first()
+   // Produce the first tuple
+{
+   observedOutputCardinality=0;
+   if (levels.empty()||(!open(0)))
+      return false;
+   return produce(0);
+}
+//---------------------------------------------------------------------------
+uint64_t LeapfrogJoin::next()
+   // Produce the next tuple
+{
+   unsigned level=levels.size()-1;
+   while (!advance(level)) {
+      if (!level)
+         return false;
+      level--;
+   }
+   return produce(level);
+}
+//---------------------------------------------------------------------------
+void LeapfrogJoin::print(PlanPrinter& out)
+   // Print the operator tree. Debugging only.
+{
+   out.beginOperator("LeapfrogJoin",expectedOutputCardinality,observedOutputCardinality);
+   out.addMaterializationAnnotation(variables);
+   for (vector<Atom>::const_iterator iter=atoms.begin(),limit=atoms.end();iter!=limit;++iter) {
+      string atom="order "+to_string(static_cast<unsigned>((*iter).order));
+      for (unsigned index=0;index<(*iter).constants;index++)
+         atom+=" "+to_string((*iter).values[index]);
+      for (vector<unsigned>::const_iterator iter2=(*iter).variables.begin(),limit2=(*iter).variables.end();iter2!=limit2;++iter2)
+         atom+=" ?"+to_string(*iter2);
+      out.addGenericAnnotation(atom);
+   }
+   out.endOperator();
+}
+//---------------------------------------------------------------------------
+void LeapfrogJoin::addMergeHint(Register* /*reg1*/,Register* /*reg2*/)
+   // Add a merge join hint
+{
+}
+//---------------------------------------------------------------------------
+void LeapfrogJoin::getAsyncInputCandidates(Scheduler& /*scheduler*/)
+   // Register parts of the tree that can be executed asynchronous
+{
+}
+//---------------------------------------------------------------------------
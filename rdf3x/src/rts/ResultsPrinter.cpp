@@ -12,6 +12,7 @@
 #include <set>
 #include <cstring>
 #include <sstream>
+#include <chrono>
 //---------------------------------------------------------------------------
 // RDF-3X
 // (c) 2008 Thomas Neumann. Web site: http://www.mpi-inf.mpg.de/~neumann/rdf3x
@@ -25,7 +26,7 @@
 using namespace std;
 //---------------------------------------------------------------------------
 ResultsPrinter::ResultsPrinter(Runtime& runtime, Operator* input, const vector<Register*>& output, DuplicateHandling duplicateHandling, uint64_t limit, uint64_t offset, bool silent)
-    : Operator(1), output(output), input(input), runtime(runtime), dictionary(runtime.getDatabase()), duplicateHandling(duplicateHandling), outputMode(DefaultOutput), limit(limit), offset(offset), silent(silent), nrows(0), jsonoutput(NULL), outputset(NULL)
+    : Operator(1), output(output), input(input), runtime(runtime), dictionary(runtime.getDatabase()), duplicateHandling(duplicateHandling), outputMode(DefaultOutput), limit(limit), offset(offset), silent(silent), nrows(0), jsonoutput(NULL), outputset(NULL), decodeTime(0)
       // Constructor
 {
 }
@@ -364,12 +365,32 @@ uint64_t ResultsPrinter::first()
         if ((++entryCount) >= this->limit) break;
     } while ((count = input->next()) != 0);
 
+    const std::chrono::steady_clock::time_point startDecode =
+        std::chrono::steady_clock::now();
+
     //Data structures to maintain a permanent copy of the strings
     std::vector<std::unique_ptr<char[]>> buf_all;
     const size_t buf_max = 10 * 1024 * 1024;
     std::unique_ptr<char[]> buf_current(new char[buf_max]);
     size_t buf_size = 0;
 
+    // Without a temporary dictionary, decode all the strings in one batch
+    vector<uint64_t> batchIds;
+    vector<string> batchTexts;
+    vector<Type::ID> batchTypes;
+    vector<unsigned> batchSubTypes;
+    vector<bool> batchFound;
+    if (!tempDict) {
+        for (map<uint64_t, CacheEntry>::iterator iter = stringCache.begin(),
+                limit = stringCache.end(); iter != limit; ++iter) {
+            if (!(dictQuery && dictQuery->hasID(iter->first)))
+                batchIds.push_back(iter->first);
+        }
+        dictionary.lookupByIds(batchIds, batchTexts, batchTypes,
+                batchSubTypes, batchFound);
+    }
+    size_t batchIdx = 0;
+
     // Lookup the strings
     set<unsigned> subTypes;
     for (map<uint64_t, CacheEntry>::iterator iter = stringCache.begin(),
@@ -383,10 +404,17 @@ uint64_t ResultsPrinter::first()
             c.stop = pair.second;
             c.type = Type::Literal;
         } else {
-            if (tempDict)
+            if (tempDict) {
                 tempDict->lookupById((*iter).first, c.start, c.stop, c.type, c.subType);
-            else
-                dictionary.lookupById((*iter).first, c.start, c.stop, c.type, c.subType);
+            } else {
+                //The batch follows the order of stringCache
+                const string &text = batchTexts[batchIdx];
+                c.start = text.c_str();
+                c.stop = c.start + text.size();
+                c.type = batchTypes[batchIdx];
+                c.subType = batchSubTypes[batchIdx];
+                batchIdx++;
+            }
 
             //Copy the text in a permanent data structure
             const size_t len = c.stop - c.start;
@@ -432,6 +460,9 @@ uint64_t ResultsPrinter::first()
         formatJSON(this->jsonvars, results, stringCache, duplicateHandling,
                 jsonoutput);
     }
+    const std::chrono::duration<double> durationDecode =
+        std::chrono::steady_clock::now() - startDecode;
+    decodeTime = durationDecode.count();
 
     // Skip printing the results?
     if (silent) {
@@ -2,9 +2,9 @@
 #include "infra/util/Type.hpp"
 #include "rts/operator/PlanPrinter.hpp"
 #include "rts/runtime/Runtime.hpp"
+#include "rts/runtime/Morsels.hpp"
 #include "trident/kb/dictmgmt.h"
 
-#include <kognac/consts.h>
 #include <algorithm>
 //---------------------------------------------------------------------------
 // RDF-3X
@@ -21,84 +21,46 @@ using namespace std;
 /// Comparator
 class Sort::Sorter {
     private:
-        /// The dictionary
-        DBLayer& dict;
         /// The sort order
         const vector<Order>& order;
-        std::shared_ptr<char> buffer1;
-        std::shared_ptr<char> buffer2;
+        /// Position of the first key in the tuples
+        uint64_t keysStart;
+        /// The decoded keys. If NULL the tuples contain the ranks
+        const vector<Key>* keys;
 
     public:
         /// Constructor
-        Sorter(DBLayer& dict, const vector<Order>& order) : dict(dict), order(order),
-        buffer1(new char[MAX_TERM_SIZE]), buffer2(new char[MAX_TERM_SIZE]) {}
+        Sorter(const vector<Order>& order, uint64_t keysStart, const vector<Key>* keys) : order(order),
+        keysStart(keysStart), keys(keys) {}
 
         /// Compare
-        bool operator()(const Tuple* a, const Tuple* b);
+        bool operator()(const Tuple* a, const Tuple* b) const;
 };
 //---------------------------------------------------------------------------
-bool Sort::Sorter::operator()(const Tuple* a, const Tuple* b)
+bool Sort::Sorter::operator()(const Tuple* a, const Tuple* b) const
     // Compare
 {
-    for (vector<Order>::const_iterator iter = order.begin(), limit = order.end(); iter != limit; ++iter) {
-        uint64_t slot = (*iter).slot;
-        if (~slot) {
-            // Access values
-            uint64_t v1, v2;
-            if ((*iter).descending) {
-                v1 = b->values[slot];
-                v2 = a->values[slot];
+    for (uint64_t index = 0, limit = order.size(); index < limit; index++) {
+        const Order& o = order[index];
+        if (~o.slot) {
+            // Access the keys
+            uint64_t k1, k2;
+            if (o.descending) {
+                k1 = b->values[keysStart + index];
+                k2 = a->values[keysStart + index];
             } else {
-                v1 = a->values[slot];
-                v2 = b->values[slot];
-            }
-
-            // Equal?
-            if (v1 == v2) continue;
-
-            // Null values
-            if (!~v1) return true;
-            if (!~v2) return false;
-
-            if (DictMgmt::isnumeric(v1) && DictMgmt::isnumeric(v2)) {
-                int cmp = DictMgmt::compare(DictMgmt::getType(v1), v1, DictMgmt::getType(v2), v2);
-                if (cmp == 0) {
-                    continue;
-                }
-                return cmp < 0;
+                k1 = a->values[keysStart + index];
+                k2 = b->values[keysStart + index];
             }
+            if (k1 == k2) continue;
+            if (!keys) return k1 < k2;
 
-            // Load the strings
-            const char* start1, *stop1, *start2, *stop2;
-            size_t len1, len2;
-            Type::ID type1, type2;
-            unsigned subType1, subType2;
-            if (!dict.lookupById(v1, buffer1.get(), len1, type1, subType1)) continue;
-            if (!dict.lookupById(v2, buffer2.get(), len2, type2, subType2)) continue;
-            start1 = buffer1.get();
-            start2 = buffer2.get();
-            stop1 = start1 + len1;
-            stop2 = start2 + len2;
-
-            // Compare
-            if (type1 < type2) return true;
-            if (type1 > type2) return false;
-            if (Type::hasSubType(type1)) {
-                if (subType1 < subType2) return true;
-                if (subType1 > subType2) return false;
-            }
-            int c = memcmp(start1, start2, min(stop1 - start1, stop2 - start2));
+            int c = compareKeys((*keys)[k1], (*keys)[k2]);
             if (c < 0) return true;
             if (c > 0) return false;
-            if ((stop1 - start1) < (stop2 - start2)) return true;
-            if ((stop1 - start1) > (stop2 - start2)) return false;
-
-            // Tie breaker. Should not be necessary...
-            if (v1 < v2) return true;
-            if (v1 > v2) return false;
         } else {
             // Sort by count
-            if ((*iter).descending) {
+            if (o.descending) {
                 if (a->count > b->count) return true;
                 if (a->count < b->count) return false;
             } else {
@@ -110,8 +72,121 @@ bool Sort::Sorter::operator()(const Tuple* a, const Tuple* b)
     return false;
 }
 //---------------------------------------------------------------------------
-Sort::Sort(DBLayer& db, Operator* input, const vector<Register*>& values, const vector<pair<Register*, bool> >& registerOrder, double expectedOutputCardinality)
-    : Operator(expectedOutputCardinality), values(values), input(input), tuplesPool(values.size() * sizeof(uint64_t)), dict(db)
+int Sort::compareKeys(const Key& a, const Key& b)
+    // Compare two keys
+{
+    uint64_t v1 = a.id, v2 = b.id;
+
+    // Equal?
+    if (v1 == v2) return 0;
+
+    // Null values
+    if (!~v1) return -1;
+    if (!~v2) return 1;
+
+    if (DictMgmt::isnumeric(v1) && DictMgmt::isnumeric(v2)) {
+        int cmp = DictMgmt::compare(DictMgmt::getType(v1), v1, DictMgmt::getType(v2), v2);
+        return (cmp < 0) ? -1 : ((cmp > 0) ? 1 : 0);
+    }
+
+    // Unknown ids are not ordered
+    if ((!a.found) || (!b.found)) return 0;
+
+    // Compare the strings
+    if (a.type < b.type) return -1;
+    if (a.type > b.type) return 1;
+    if (Type::hasSubType(a.type)) {
+        if (a.subType < b.subType) return -1;
+        if (a.subType > b.subType) return 1;
+    }
+    int c = a.text.compare(b.text);
+    if (c < 0) return -1;
+    if (c > 0) return 1;
+
+    // Tie breaker. Should not be necessary...
+    return (v1 < v2) ? -1 : 1;
+}
+//---------------------------------------------------------------------------
+uint64_t Sort::getKey(uint64_t id)
+    // Returns the position of the key of id, decoding it if necessary
+{
+    unordered_map<uint64_t, uint64_t>::const_iterator iter = keyPositions.find(id);
+    if (iter != keyPositions.end()) {
+        keys[(*iter).second].refs++;
+        return (*iter).second;
+    }
+
+    Key k;
+    k.id = id;
+    k.found = false;
+    k.type = Type::URI;
+    k.subType = 0;
+    k.refs = 1;
+    if (~id) {
+        const char* start, *stop;
+        if (dict.lookupById(id, start, stop, k.type, k.subType)) {
+            k.found = true;
+            k.text.assign(start, stop);
+        }
+    }
+    uint64_t pos;
+    if (!freeKeys.empty()) {
+        pos = freeKeys.back();
+        freeKeys.pop_back();
+        keys[pos] = std::move(k);
+    } else {
+        pos = keys.size();
+        keys.push_back(std::move(k));
+    }
+    keyPositions[id] = pos;
+    return pos;
+}
+//---------------------------------------------------------------------------
+void Sort::releaseKeys(Tuple* t)
+    // Drops the references of a tuple that leaves the heap, and the keys that are no longer used
+{
+    const uint64_t keysStart = values.size();
+    for (uint64_t index = 0, limit = order.size(); index < limit; index++) {
+        if (!~order[index].slot)
+            continue;
+        const uint64_t pos = t->values[keysStart + index];
+        Key& k = keys[pos];
+        if (--k.refs == 0) {
+            keyPositions.erase(k.id);
+            string().swap(k.text);
+            freeKeys.push_back(pos);
+        }
+    }
+}
+//---------------------------------------------------------------------------
+void Sort::rankKeys()
+    // Replaces the key positions in the tuples with the ranks of the keys
+{
+    vector<uint64_t> positions(keys.size());
+    for (uint64_t index = 0; index < keys.size(); index++)
+        positions[index] = index;
+    const vector<Key>& k = keys;
+    auto cmp = [&k](uint64_t a, uint64_t b) {
+            return compareKeys(k[a], k[b]) < 0;
+            };
+    Morsels::sort(positions.begin(), positions.end(), cmp);
+    vector<uint64_t> ranks(keys.size());
+    uint64_t rank = 0;
+    for (uint64_t index = 0; index < positions.size(); index++) {
+        if (index && compareKeys(keys[positions[index - 1]], keys[positions[index]]) < 0)
+            rank++;
+        ranks[positions[index]] = rank;
+    }
+
+    const uint64_t keysStart = values.size();
+    for (vector<Tuple*>::const_iterator iter = tuples.begin(), limit = tuples.end(); iter != limit; ++iter)
+        for (uint64_t index = 0; index < order.size(); index++)
+            if (~order[index].slot)
+                (*iter)->values[keysStart + index] = ranks[(*iter)->values[keysStart + index]];
+}
+//---------------------------------------------------------------------------
+Sort::Sort(DBLayer& db, Operator* input, const vector<Register*>& values, const vector<pair<Register*, bool> >& registerOrder, double expectedOutputCardinality, uint64_t topK)
+    : Operator(expectedOutputCardinality), values(values), input(input), tuplesPool((values.size() + registerOrder.size()) * sizeof(uint64_t)), dict(db), topK(topK)
       // Constructor
 {
     for (vector<pair<Register*, bool> >::const_iterator iter = registerOrder.begin(), limit = registerOrder.end(); iter != limit; ++iter) {
@@ -151,17 +226,46 @@ uint64_t Sort::first()
     // Collect the input
     tuples.clear();
     tuplesPool.freeAll();
+    keys.clear();
+    keyPositions.clear();
+    freeKeys.clear();
+    const uint64_t keysStart = values.size();
+    Sorter keySorter(order, keysStart, &keys);
     for (uint64_t count = input->first(); count; count = input->next()) {
         Tuple* t = tuplesPool.alloc();
         t->count = count;
         for (uint64_t index = 0, limit = values.size(); index < limit; index++) {
             t->values[index] = values[index]->value;
         }
-        tuples.push_back(t);
+        for (uint64_t index = 0, limit = order.size(); index < limit; index++) {
+            if (~order[index].slot)
+                t->values[keysStart + index] = getKey(t->values[order[index].slot]);
+        }
+        if (!~topK) {
+            tuples.push_back(t);
+        } else if (tuples.size() < topK) {
+            // The heap has the largest tuple on top
+            tuples.push_back(t);
+            push_heap(tuples.begin(), tuples.end(), keySorter);
+        } else if ((!tuples.empty()) && keySorter(t, tuples.front())) {
+            pop_heap(tuples.begin(), tuples.end(), keySorter);
+            releaseKeys(tuples.back());
+            tuplesPool.free(tuples.back());
+            tuples.back() = t;
+            push_heap(tuples.begin(), tuples.end(), keySorter);
+        } else {
+            releaseKeys(t);
+            tuplesPool.free(t);
+        }
     }
 
     // Sort it
-    sort(tuples.begin(), tuples.end(), Sorter(dict, order));
+    if (!~topK) {
+        rankKeys();
+        Morsels::sort(tuples.begin(), tuples.end(), Sorter(order, keysStart, 0));
+    } else {
+        sort_heap(tuples.begin(), tuples.end(), keySorter);
+    }
 
     // Return the first one
     tuplesIter = tuples.begin();
@@ -201,6 +305,8 @@ void Sort::print(PlanPrinter& out)
             o += " desc";
     }
     o += "]";
+    if (~topK)
+        o += " top " + to_string(topK);
     out.addGenericAnnotation(o);
     out.addMaterializationAnnotation(values);
     input->print(out);
@@ -25,10 +25,12 @@
 #include <trident/kb/statistics.h>
 #include <trident/kb/inserter.h>
 #include <trident/kb/updater.h>
+#include <trident/kb/compactor.h>
 #include <trident/kb/kbconfig.h>
 #include <trident/kb/querier.h>
 #include <trident/mining/miner.h>
 #include <trident/tests/common.h>
+#include <trident/utils/accesslog.h>
 
 #ifdef SERVER
 #include <trident/server/server.h>
@@ -50,6 +52,7 @@
 #include <cstdlib>
 #include <sstream>
 #include <fstream>
+#include <thread>
 
 using namespace std;
 
@@ -167,6 +170,7 @@ void testkb(string kbDir, ProgramArgs &vm) {
         p.dictionaries = vm["ndicts"].as<int>();
         p.nindices = vm["nindices"].as<int>();
         p.createIndicesInBlocks = vm["incrindices"].as<bool>();
+        p.concurrentIndices = vm["concurrentindices"].as<int>();
         p.aggrIndices = vm["aggrIndices"].as<bool>();
         p.canSkipTables = vm["skipTables"].as<bool>();
         p.enableFixedStrat = vm["enableFixedStrat"].as<bool>();
@@ -182,6 +186,10 @@ void testkb(string kbDir, ProgramArgs &vm) {
         p.graphTransformation = vm["gf"].as<string>();
         p.storeDicts = vm["storedicts"].as<bool>();
         p.flatTree = vm["flatTree"].as<bool>();
+        p.searchIndex = vm["searchindex"].as<bool>();
+        p.membershipFilter = vm["membershipfilters"].as<bool>();
+        p.characteristicSets = vm["charsets"].as<bool>();
+        p.forColumns = vm["forcolumns"].as<bool>();
 
         loader.load(p);
     }
@@ -200,8 +208,8 @@ void testkb(string kbDir, ProgramArgs &vm) {
     }
     TestTrident test(&kb);
     //Check whether there is a _diff dir
-    if (Utils::exists(kbDir + DIR_SEP + "_diff")) {
-        std::vector<string> ups = Utils::getSubdirs(kbDir + DIR_SEP + "_diff");
+    if (Utils::exists(kb.getPath() + DIR_SEP + "_diff")) {
+        std::vector<string> ups = Utils::getSubdirs(kb.getPath() + DIR_SEP + "_diff");
         std::vector<string> childrenupdates;
         for (int i = 0; i < ups.size(); ++i) {
             string f = ups[i];
@@ -216,7 +224,7 @@ void testkb(string kbDir, ProgramArgs &vm) {
         sort(childrenupdates.begin(), childrenupdates.end(), _sort_by_number);
         locUpdates = childrenupdates;
     }
-    test.prepare(kbDir + DIR_SEP + string("p0") + DIR_SEP + "raw", locUpdates);
+    test.prepare(kb.getPath() + DIR_SEP + string("p0") + DIR_SEP + "raw", locUpdates);
     test.test_existing(permutations);
     test.test_nonexist(permutations);
     test.test_moveto(permutations);
@@ -250,6 +258,17 @@ void startServer(KB &kb, int port, int nthreads) {
     LOG(INFOL) << "Server is launched at 0.0.0.0:" << to_string(port);
     webint->join();
 }
+
+void startServer(Compactor &compactor, int port, int nthreads) {
+    std::unique_ptr<TridentServer> webint;
+    webint = std::unique_ptr<TridentServer>(
+            new TridentServer(compactor, "./../webinterface", nthreads));
+    compactor.start();
+    webint->start(port);
+    LOG(INFOL) << "Server is launched at 0.0.0.0:" << to_string(port);
+    webint->join();
+    compactor.stop();
+}
 #endif
 
 void printStats(KB &kb, Querier *q) {
@@ -433,6 +452,7 @@ int main(int argc, const char** argv) {
         p.dictionaries = vm["ndicts"].as<int>();
         p.nindices = vm["nindices"].as<int>();
         p.createIndicesInBlocks = vm["incrindices"].as<bool>();
+        p.concurrentIndices = vm["concurrentindices"].as<int>();
         p.aggrIndices = vm["aggrIndices"].as<bool>();
         p.canSkipTables = vm["skipTables"].as<bool>();
         p.enableFixedStrat = vm["enableFixedStrat"].as<bool>();
@@ -449,9 +469,20 @@ int main(int argc, const char** argv) {
         p.storeDicts = vm["storedicts"].as<bool>();
         p.relsOwnIDs = vm["relsOwnIDs"].as<bool>();
         p.flatTree = vm["flatTree"].as<bool>();
+        p.searchIndex = vm["searchindex"].as<bool>();
+        p.membershipFilter = vm["membershipfilters"].as<bool>();
+        p.characteristicSets = vm["charsets"].as<bool>();
+        p.forColumns = vm["forcolumns"].as<bool>();
 
         loader.load(p);
 
+    } else if (cmd == "buildsearch") {
+        KBConfig config;
+        KB kb(kbDir.c_str(), true, false, true, config);
+        kb.buildSearchIndex();
+    } else if (cmd == "warmup") {
+        AccessLog::replay(kbDir + DIR_SEP + "_accesslog",
+                vm["maxThreads"].as<int>());
     } else if (cmd == "info") {
         KBConfig config;
         KB kb(kbDir.c_str(), true, false, true, config);
@@ -459,15 +490,35 @@ int main(int argc, const char** argv) {
     } else if (cmd == "add") {
         string updatedir = vm["update"].as<string>();
         Updater up;
-        up.creatediffupdate(DiffIndex::TypeUpdate::ADDITION_df, kbDir, updatedir);
+        up.creatediffupdate(DiffIndex::TypeUpdate::ADDITION_df, kbDir, updatedir,
+                vm["maxThreads"].as<int>());
     } else if (cmd == "rm") {
         string updatedir = vm["update"].as<string>();
         Updater up;
-        up.creatediffupdate(DiffIndex::TypeUpdate::DELETE_df, kbDir, updatedir);
+        up.creatediffupdate(DiffIndex::TypeUpdate::DELETE_df, kbDir, updatedir,
+                vm["maxThreads"].as<int>());
     } else if (cmd == "merge") {
         KBConfig config;
         KB kb(kbDir.c_str(), true, false, true, config);
         kb.mergeUpdates();
+    } else if (cmd == "compact") {
+        KBConfig config;
+        string newpath;
+        {
+            std::unique_ptr<KB> kb;
+            {
+                //Do not read an update that is being written
+                Compactor::UpdateLock lock(kbDir);
+                kb = std::unique_ptr<KB>(new KB(kbDir.c_str(), true, false,
+                            true, config));
+            }
+            newpath = Compactor::compact(*kb, kbDir, vm["maxThreads"].as<int>());
+            //Closing the KB removes the old generation, unless other
+            //processes still read it. The last of them removes it
+        }
+        if (newpath != "") {
+            LOG(INFOL) << "The KB is now stored in " << newpath;
+        }
     } else if (cmd == "analytics") {
 #ifdef ANALYTICS
         KBConfig config;
@@ -495,8 +546,34 @@ int main(int argc, const char** argv) {
     } else if (cmd == "server") {
 #ifdef SERVER
         KBConfig config;
-        KB kb(kbDir.c_str(), true, false, true, config);
-        startServer(kb, vm["port"].as<int>(), vm["webthreads"].as<int>());
+        //Load the tables used by the previous runs while the server starts
+        const string accessLog = kbDir + DIR_SEP + "_accesslog";
+        std::thread warmer;
+        if (vm["warmup"].as<bool>() && Utils::exists(accessLog)) {
+            const int nthreads = vm["maxThreads"].as<int>();
+            warmer = std::thread([accessLog, nthreads]() {
+                    AccessLog::replay(accessLog, nthreads);
+                    });
+        }
+        if (vm["recordaccesses"].as<int>() > 0) {
+            AccessLog::startRecording(accessLog,
+                    vm["recordaccesses"].as<int>());
+        }
+        int compactdiffs = vm["compactdiffs"].as<int>();
+        if (compactdiffs > 0) {
+            Compactor compactor(kbDir, config, compactdiffs,
+                    vm["compactinterval"].as<int>(),
+                    vm["maxThreads"].as<int>());
+            startServer(compactor, vm["port"].as<int>(),
+                    vm["webthreads"].as<int>());
+        } else {
+            KB kb(kbDir.c_str(), true, false, true, config);
+            startServer(kb, vm["port"].as<int>(), vm["webthreads"].as<int>());
+        }
+        AccessLog::stopRecording();
+        if (warmer.joinable()) {
+            warmer.join();
+        }
 #else
         LOG(ERRORL) << "Trident was not compiled with the webserver. Add -DSERVER=1 to cmake";
         return EXIT_FAILURE;
@@ -35,8 +35,11 @@ void printHelp(const char *programName, string section,
         cout << "load\t\t\t load the KB." << endl;
         cout << "add\t\t\t add triples to an existing KB." << endl;
         cout << "rm\t\t\t rm triples to an existing KB." << endl;
+        cout << "compact\t\t\t merge the updates into a new generation of the KB." << endl;
         cout << "lookup\t\t\t lookup for values in the dictionary." << endl;
+        cout << "buildsearch\t\t build the index for prefix/substring searches on the dictionary." << endl;
         cout << "info\t\t\t print some information about the KB." << endl;
+        cout << "warmup\t\t\t load in the OS cache the tables recorded by the server (see --recordaccesses)." << endl;
         cout << "dump\t\t\t dump the graph on files." << endl;
 
 #ifdef ANALYTICS
@@ -81,10 +84,13 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv,
             && cmd != "add"
             && cmd != "rm"
             && cmd != "merge"
+            && cmd != "compact"
 #ifdef ANALYTICS
             && cmd != "analytics"
 #endif
             && cmd != "mine"
+            && cmd != "buildsearch"
+            && cmd != "warmup"
             && cmd != "server"
             && cmd != "dump"
             && cmd != "learn"
@@ -302,6 +308,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<bool>("","storedicts", p.storeDicts, "Should I also store the dictionaries? (Maybe I don't need it, since I only want to do graph analytics. Default is ENABLED", false);
     load_options.add<int>("","nindices", p.nindices, "Set the number of indices to use. Can be 1,3,4,6. Default is '6'", false);
     load_options.add<bool>("","incrindices", p.createIndicesInBlocks, "Create the indices a few at the time (saves space). Default is 'false'", false);
+    load_options.add<int>("","concurrentindices", p.concurrentIndices, "Max number of indices that are merged and inserted at the same time (ignored with --incrindices). Default is '1'", false);
     load_options.add<bool>("","aggrIndices", p.aggrIndices, "Use aggredated indices. Default is 'false'", false);
     load_options.add<bool>("","enableFixedStrat", p.enableFixedStrat, "Should we store the tables with a fixed layout?. Default is 'false'", false);
     string textStrat = "Fixed strategy to use. Only for advanced users. For for a column-layout " + to_string(FIXEDSTRAT5) + " for row-layout " + to_string(FIXEDSTRAT6) + " for a cluster-layout " + to_string(FIXEDSTRAT7);
@@ -314,7 +321,11 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<int64_t>("","limitSpace", p.limitSpace, "", false);
     load_options.add<string>("","gf", p.graphTransformation, "Possible graph transformations. 'unlabeled' removes the edge labels (but keeps it directed), 'undirected' makes the graph undirected and without edge labels", false);
     load_options.add<bool>("","relsOwnIDs", p.relsOwnIDs, "Should I give independent IDs to the terms that appear as predicates? (Useful for ML learning models). Default is DISABLED", false);
-    load_options.add<bool>("","flatTree", p.flatTree, "Create a flat representation of the nodes' tree. This parameter is forced to tree if the graph is unlabeled. Default is DISABLED", false);
+    load_options.add<bool>("","searchindex", p.searchIndex, "Build also the index for prefix/substring searches on the dictionary. Default is DISABLED", false);
+    load_options.add<bool>("","membershipfilters", p.membershipFilter, "Build also the Bloom filters that answer quickly the existence checks of triples and pairs that are not in the KB. Default is DISABLED", false);
+    load_options.add<bool>("","charsets", p.characteristicSets, "Build also the characteristic sets and the predicate join counts used to estimate the joins of the SPARQL queries without sampling. Default is DISABLED", false);
+    load_options.add<bool>("","forcolumns", p.forColumns, "Store the large tables of the column layout bit-packed (frame of reference), which are smaller and faster to scan. The graph analytics cannot read them. Default is DISABLED", false);
+    load_options.add<bool>("","flatTree", p.flatTree, "Create a flat representation of the nodes' tree, with one fixed-size record per term ID that replaces the lookups in the tree when the KB is read-only. This parameter is forced to true if the graph is unlabeled. Default is DISABLED", false);
 
     /***** LOOKUP *****/
     ProgramArgs::GroupArgs& lookup_options = *vm.newGroup("Options for <lookup>");
@@ -334,7 +345,11 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     /***** SERVER *****/
     ProgramArgs::GroupArgs& server_options = *vm.newGroup("Options for <server>");
     server_options.add<int>("", "port", 8080, "Port to listen to", false);
-    server_options.add<int>("", "webthreads", 1, "N. of threads for the webserver", false);
+    server_options.add<int>("", "webthreads", 1, "N. of threads for the webserver. Each thread has its own querier", false);
+    server_options.add<int>("", "compactdiffs", 0, "Compact the KB in the background once it has this many updates. 0 disables it", false);
+    server_options.add<int>("", "compactinterval", 60, "Seconds between two checks for background compaction", false);
+    server_options.add<int>("", "recordaccesses", 0, "Record the tables and tree nodes that are read in <kb>/_accesslog, and write it every this many seconds. 0 disables it", false);
+    server_options.add<bool>("", "warmup", false, "Load in the background the tables recorded in <kb>/_accesslog when the server starts. Default is DISABLED", false);
 
     /***** LEARN/PREDICT *****/
 #ifdef ML
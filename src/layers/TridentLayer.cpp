@@ -33,6 +33,7 @@
 #include <limits>
 #include <inttypes.h>
 #include <set>
+#include <algorithm>
 
 bool TridentLayer::lookup(const std::string& text,
         ::Type::ID type,
@@ -130,6 +131,26 @@ bool TridentLayer::lookupById(uint64_t id,
     return resp;
 }
 
+void TridentLayer::lookupByIds(const std::vector<uint64_t> &ids,
+        std::vector<std::string> &texts,
+        std::vector<::Type::ID> &types,
+        std::vector<unsigned> &subTypes,
+        std::vector<bool> &found) {
+    std::vector<nTerm> keys(ids.begin(), ids.end());
+    dict->getTexts(keys, texts, found);
+    types.resize(ids.size());
+    //Subtypes are not supported
+    subTypes.assign(ids.size(), 0);
+    for (size_t i = 0; i < ids.size(); ++i) {
+        if (found[i] && !texts[i].empty() && texts[i][0] == '<') {
+            texts[i] = texts[i].substr(1, texts[i].size() - 2);
+            types[i] = ::Type::ID::URI;
+        } else {
+            types[i] = ::Type::ID::Literal;
+        }
+    }
+}
+
 uint64_t TridentLayer::getNextId() {
     return kb.getNextID();
 }
@@ -595,6 +616,69 @@ double TridentLayer::bifocalSampling(bool valueL1,
     return output / (card1 * card2);
 }
 
+bool TridentLayer::charSetsSelectivity(bool valueL1,
+        uint64_t value1CL,
+        bool value2L,
+        uint64_t value2CL,
+        bool value3L,
+        uint64_t value3CL,
+        bool value1R,
+        uint64_t value1CR,
+        bool value2R,
+        uint64_t value2CR,
+        bool value3R,
+        uint64_t value3CR,
+        double &selectivity) {
+    const CharacteristicSets *sets = kb.getCharacteristicSets();
+    if (sets == NULL || !value2L || !value2R) {
+        return false;
+    }
+
+    //The patterns must share only one variable, in the subject or the object
+    const bool constL[3] = { valueL1, value2L, value3L };
+    const uint64_t valuesL[3] = { value1CL, value2CL, value3CL };
+    const bool constR[3] = { value1R, value2R, value3R };
+    const uint64_t valuesR[3] = { value1CR, value2CR, value3CR };
+    int posL = -1, posR = -1, nshared = 0;
+    for (int i = 0; i < 3; i += 2) {
+        for (int j = 0; j < 3; j += 2) {
+            if (!constL[i] && !constR[j] && valuesL[i] == valuesR[j]) {
+                posL = i;
+                posR = j;
+                nshared++;
+            }
+        }
+    }
+    if (nshared != 1) {
+        return false;
+    }
+
+    double joined;
+    if (posL == 0 && posR == 0) {
+        std::vector<int64_t> predicates;
+        predicates.push_back(value2CL);
+        predicates.push_back(value2CR);
+        joined = sets->estimateStar(predicates);
+    } else if (posL == 2 && posR == 0 && sets->hasChains()) {
+        joined = sets->getChainCount(value2CL, value2CR);
+    } else if (posL == 0 && posR == 2 && sets->hasChains()) {
+        joined = sets->getChainCount(value2CR, value2CL);
+    } else {
+        return false;
+    }
+
+    //The other constants select a fraction of the triples of the
+    //predicates, which is assumed independent of the join
+    const int64_t all1 = getCardinality(UINT64_MAX, value2CL, UINT64_MAX);
+    const int64_t all2 = getCardinality(UINT64_MAX, value2CR, UINT64_MAX);
+    if (all1 <= 0 || all2 <= 0) {
+        selectivity = 0;
+    } else {
+        selectivity = joined / ((double) all1 * all2);
+    }
+    return true;
+}
+
 double TridentLayer::getJoinSelectivity(bool valueL1,
         uint64_t value1CL,
         bool value2L,
@@ -625,6 +709,14 @@ double TridentLayer::getJoinSelectivity(bool valueL1,
             !value3R ? UINT64_MAX : value3CR);
     const bool sampleT2 = card2 > SMALLREL;
 
+    double selectivity;
+    if (card1 > 0 && card2 > 0 && charSetsSelectivity(valueL1, value1CL,
+                value2L, value2CL, value3L, value3CL, value1R, value1CR,
+                value2R, value2CR, value3R, value3CR, selectivity)) {
+        LOG(DEBUGL) << "Selectivity from the characteristic sets: " << selectivity;
+        return selectivity;
+    }
+
     if (!bifSampl) {
         //Bifocal sampling is disabled. I perform a simple estimate.
         return card1 * card2;
@@ -733,11 +825,7 @@ uint64_t TridentLayer::getCardinality() {
     return kb.getSize();
 }
 
-std::unique_ptr<DBLayer::Scan> TridentLayer::getScan(
-        const DBLayer::DataOrder order,
-        const DBLayer::Aggr_t a,
-        Hint * hint) {
-
+int TridentLayer::getPermutation(const DBLayer::DataOrder order) {
     //Must convert the DataOrder in a IDX_flag
     int perm = 0;
     switch (order) {
@@ -766,7 +854,47 @@ std::unique_ptr<DBLayer::Scan> TridentLayer::getScan(
             perm = IDX_OSP;
             break;
     }
-    std::unique_ptr<DBLayer::Scan> s(new TridentScan(perm, a, q.get(), hint));
+    return perm;
+}
+
+std::unique_ptr<DBLayer::Scan> TridentLayer::getScan(
+        const DBLayer::DataOrder order,
+        const DBLayer::Aggr_t a,
+        Hint * hint) {
+    std::unique_ptr<DBLayer::Scan> s(new TridentScan(getPermutation(order),
+                a, q.get(), hint));
+    return s;
+}
+
+bool TridentLayer::hasValueScans(const DBLayer::DataOrder order) {
+    //Only the sorted orders. With three indices, the others are sorted at
+    //query time
+    if (order > Order_Predicate_Object_Subject) {
+        return false;
+    }
+    const int perm = getPermutation(order);
+    return nindices > 3 || perm == IDX_SPO || perm == IDX_OPS ||
+        perm == IDX_POS;
+}
+
+std::unique_ptr<DBLayer::ValueScan> TridentLayer::getValueScan(
+        const DBLayer::DataOrder order,
+        const int nbound,
+        const uint64_t value1,
+        const uint64_t value2) {
+    const int perm = getPermutation(order);
+    PairItr *itr;
+    if (nbound == 1) {
+        itr = q->getPermuted(perm, value1, -1, -1, true);
+        itr->ignoreSecondColumn();
+    } else {
+        itr = q->getPermuted(perm, value1, value2, -1, true);
+    }
+    std::unique_ptr<DBLayer::ValueScan> s(new TridentValueScan(itr, q.get(),
+                nbound == 2, nbound == 2 ? value2 : -1));
+    if (!s->next()) {
+        return std::unique_ptr<DBLayer::ValueScan>();
+    }
     return s;
 }
 
@@ -969,17 +1097,158 @@ next_test:
 
 //-----------------------------------------------------------------------------
 
+bool TridentScan::advance() {
+    if (useBlocks) {
+        if (++blockPos < blockSize) {
+            return true;
+        }
+        blockSize = itr->nextBlock(block1, block2, SCAN_BLOCK_SIZE);
+        blockKey = itr->getKey();
+        blockPos = 0;
+        return blockSize > 0;
+    } else if (itr->hasNext()) {
+        itr->next();
+        return true;
+    } else {
+        return false;
+    }
+}
+
+void TridentScan::initHashKeys(const bool allKeys) {
+    hashKeys = NULL;
+    hashColumns = 0;
+    if (hint == NULL) {
+        return;
+    }
+    int bitset = 0;
+    std::vector<uint64_t> *keys = hint->getKeys(&bitset);
+    if (keys == NULL || bitset == 0) {
+        return;
+    }
+    //The bitset refers to the subject, predicate and object. The aggregated
+    //scans do not return the last columns
+    const int ncolumns = a == DBLayer::AGGR_NO ? 3 :
+        (a == DBLayer::AGGR_SKIP_LAST ? 2 : 1);
+    const int *order = q->getInvOrder(perm);
+    for (int i = 0; i < 3; ++i) {
+        if ((bitset & (1 << i)) && order[i] < ncolumns) {
+            hashColumns |= 1 << order[i];
+        }
+    }
+    hashKeys = keys;
+    hashPos[0] = hashPos[1] = hashPos[2] = 0;
+    hashAllKeys = allKeys;
+    //Iterators over all keys can seek only if they read a single index.
+    //The others are tables of a single key
+    hashSeek = !allKeys || itr->getTypeItr() == SCAN_ITR;
+}
+
+void TridentScan::closeItr() {
+    if (itr != NULL) {
+        q->releaseItr(itr);
+        itr = NULL;
+    }
+}
+
+void TridentScan::initBlocks() {
+    useBlocks = a == DBLayer::Aggr_t::AGGR_NO && hashKeys == NULL &&
+        (hint == NULL || !hint->canSkip());
+    //A scan can be opened more than once
+    blockKey = -1;
+    blockSize = 0;
+    blockPos = 0;
+}
+
+bool TridentScan::skipToHashKeys() {
+    const std::vector<uint64_t> &keys = *hashKeys;
+    while (true) {
+        //Find the first column whose value is not a key
+        int column = -1;
+        bool exhausted = false;
+        uint64_t target = 0;
+        for (int i = 0; i < 3 && column == -1; ++i) {
+            if (!(hashColumns & (1 << i))) {
+                continue;
+            }
+            const uint64_t v = i == 0 ? getValue1() :
+                (i == 1 ? getValue2() : getValue3());
+            //The cursor moves forward as long as the column is sorted
+            size_t &pos = hashPos[i];
+            if (pos > 0 && keys[pos - 1] >= v) {
+                pos = 0;
+            }
+            if (pos < keys.size() && keys[pos] < v) {
+                pos = std::lower_bound(keys.begin() + pos, keys.end(), v) -
+                    keys.begin();
+            }
+            if (pos == keys.size() || keys[pos] != v) {
+                column = i;
+                exhausted = pos == keys.size();
+                if (!exhausted) {
+                    target = keys[pos];
+                }
+            }
+        }
+        if (column == -1) {
+            return true;
+        }
+
+        //Jump to the first tuple that can match
+        int64_t nextKey = -1;
+        if (column == 0) {
+            if (exhausted || !hashAllKeys) {
+                return false;
+            }
+            if (hashSeek) {
+                nextKey = target;
+            }
+        } else if (hashSeek) {
+            if (column == 1) {
+                if (!exhausted) {
+                    itr->moveto(target, 0);
+                } else if (!hashAllKeys) {
+                    return false;
+                } else {
+                    nextKey = itr->getKey() + 1;
+                }
+            } else {
+                if (!exhausted) {
+                    itr->moveto(itr->getValue1(), target);
+                } else {
+                    itr->moveto(itr->getValue1() + 1, 0);
+                }
+            }
+        }
+        if (nextKey != -1) {
+            itr->gotoKey(nextKey);
+        }
+        if (!advance()) {
+            return false;
+        }
+        //If there is no larger key, gotoKey stays on the last one
+        if (nextKey != -1 && itr->getKey() < nextKey) {
+            return false;
+        }
+    }
+}
+
 uint64_t TridentScan::getValue1() {
+    if (useBlocks)
+        return blockKey;
     return itr->getKey();
 }
 
 uint64_t TridentScan::getValue2() {
     assert(a != DBLayer::Aggr_t::AGGR_SKIP_2LAST);
+    if (useBlocks)
+        return block1[blockPos];
     return itr->getValue1();
 }
 
 uint64_t TridentScan::getValue3() {
     assert(a == DBLayer::Aggr_t::AGGR_NO);
+    if (useBlocks)
+        return block2[blockPos];
     return itr->getValue2();
 }
 
@@ -989,7 +1258,7 @@ uint64_t TridentScan::getCount() {
 
 bool TridentScan::next() {
 
-    if (hint && countHint == 0) {
+    if (hint && !useBlocks && countHint == 0) {
         uint64_t s = 0, p = 0, o = 0;
         if (a == DBLayer::AGGR_SKIP_LAST) {
             hint->next(s, p);
@@ -1013,8 +1282,7 @@ bool TridentScan::next() {
         countHint = 0;
 
     assert(itr != NULL);
-    if (itr->hasNext()) {
-        itr->next();
+    if (advance() && (!hashKeys || skipToHashKeys())) {
         //cerr <<  "Type=" << itr->getTypeItr() << " " << itr->getKey() << " " << itr->getValue1() << endl;
         return true;
     } else {
@@ -1025,24 +1293,27 @@ bool TridentScan::next() {
 }
 
 bool TridentScan::first() {
+    closeItr();
     if (a == DBLayer::AGGR_SKIP_2LAST) {
         itr = q->getTermList(perm);
+        initHashKeys(true);
+        initBlocks();
         bool resp = itr->hasNext();
         if (resp)
             itr->next();
-        return resp;
+        return resp && (!hashKeys || skipToHashKeys());
     } else {
         itr = q->getPermuted(perm, -1, -1, -1, false);
         if (a == DBLayer::AGGR_SKIP_LAST)
             itr->ignoreSecondColumn();
-        bool resp = itr->hasNext();
-        if (resp)
-            itr->next();
-        return resp;
+        initHashKeys(true);
+        initBlocks();
+        return advance() && (!hashKeys || skipToHashKeys());
     }
 }
 
 bool TridentScan::first(uint64_t el, bool constrained) {
+    closeItr();
     if (a != DBLayer::Aggr_t::AGGR_NO)
         throw 10; //Not supported
 
@@ -1050,9 +1321,10 @@ bool TridentScan::first(uint64_t el, bool constrained) {
         itr = q->getPermuted(perm, el, -1, -1, false);
     else
         itr = q->getPermuted(perm, -1, -1, -1, false);
+    initHashKeys(!constrained);
+    initBlocks();
 
-    if (itr->hasNext()) {
-        itr->next();
+    if (advance() && (!hashKeys || skipToHashKeys())) {
         return true;
     } else {
         q->releaseItr(itr);
@@ -1062,6 +1334,7 @@ bool TridentScan::first(uint64_t el, bool constrained) {
 }
 
 bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2, bool constrained2) {
+    closeItr();
     if (a == DBLayer::Aggr_t::AGGR_SKIP_2LAST)
         throw 10; //Not supported. Should also never occur
 
@@ -1078,8 +1351,9 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2, bool cons
     if (a == DBLayer::Aggr_t::AGGR_SKIP_LAST) {
         itr->ignoreSecondColumn();
     }
-    if (itr->hasNext()) {
-        itr->next();
+    initHashKeys(!constrained1);
+    initBlocks();
+    if (advance() && (!hashKeys || skipToHashKeys())) {
         return true;
     } else {
         q->releaseItr(itr);
@@ -1090,6 +1364,7 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2, bool cons
 
 bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2,
         bool constrained2, uint64_t el3, bool constrained3) {
+    closeItr();
 
     if (a != DBLayer::Aggr_t::AGGR_NO)
         throw 10; //Not supported. Should also never occur
@@ -1108,10 +1383,10 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2,
         itr = q->getPermuted(perm, -1, -1, -1, false);
     }
 
-    bool resp = itr->hasNext();
-    if (resp) {
-        itr->next();
-    } else {
+    initHashKeys(!constrained1);
+    initBlocks();
+    bool resp = advance() && (!hashKeys || skipToHashKeys());
+    if (!resp) {
         q->releaseItr(itr);
         itr = NULL;
     }
@@ -1119,8 +1394,44 @@ bool TridentScan::first(uint64_t el1, bool constrained1, uint64_t el2,
 }
 
 TridentScan::~TridentScan() {
-    if (itr != NULL) {
-        q->releaseItr(itr);
-        itr = NULL;
+    closeItr();
+}
+
+bool TridentValueScan::next() {
+    if (itr->hasNext()) {
+        itr->next();
+        if (thirdColumn) {
+            if (itr->getValue1() == value1) {
+                value = itr->getValue2();
+                return true;
+            }
+        } else {
+            value = itr->getValue1();
+            return true;
+        }
     }
+    return false;
+}
+
+bool TridentValueScan::seek(uint64_t v) {
+    if (value >= v) {
+        return true;
+    }
+    //moveto() positions the iterator so that the following next() returns
+    //the first pair >= the given one
+    if (thirdColumn) {
+        itr->moveto(value1, v);
+    } else {
+        itr->moveto(v, 0);
+    }
+    while (next()) {
+        if (value >= v) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TridentValueScan::~TridentValueScan() {
+    q->releaseItr(itr);
 }
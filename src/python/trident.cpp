@@ -174,6 +174,9 @@ static PyObject *db_exists(PyObject *self, PyObject *args) {
     if (!PyArg_ParseTuple(args, "lll", &s, &p, &o))
         return NULL;
     Querier *q = ((trident_Db*)self)->q;
+    if (!q->mayExist(s, p, o)) {
+        return PyBool_FromLong(0);
+    }
     const int64_t nresults = q->getCardOnIndex(IDX_SPO, s, p, o);
     return PyBool_FromLong(nresults);
 }
@@ -193,6 +196,9 @@ static PyObject *db_existsQuery(PyObject *self, PyObject *args) {
         int64_t p2 = PyLong_AsLong(op2);
         int64_t o2 = PyLong_AsLong(oo2);
         Querier *q = ((trident_Db*)self)->q;
+        if (!q->mayExist(term, p1, -1) || !q->mayExist(-1, p2, o2)) {
+            return PyBool_FromLong(0);
+        }
         auto itr1 = q->getPermuted(IDX_SPO, term, p1, -1, true);
         auto itr2 = q->getPermuted(IDX_OPS, o2, p2, -1, true);
         //Merge join
@@ -737,26 +743,48 @@ static PyObject * db_lookup_relstr(PyObject *self, PyObject *args) {
     }
 }
 
+static PyObject * _matches_to_list(const std::vector<SearchIndex::Match> &matches) {
+    PyObject *obj = PyList_New(0);
+    for (const auto &m : matches) {
+        PyObject *t = PyTuple_New(2);
+        PyTuple_SetItem(t, 0, PyLong_FromLong(m.first));
+        PyTuple_SetItem(t, 1, PyUnicode_FromStringAndSize(m.second.c_str(),
+                    m.second.size()));
+        PyList_Append(obj, t);
+        Py_DECREF(t);
+    }
+    return obj;
+}
+
 static PyObject * db_search_id(PyObject *self, PyObject *args) {
     const char *term;
     if (!PyArg_ParseTuple(args, "s", &term))
         return NULL;
     KB *kb = ((trident_Db*)self)->kb;
     DictMgmt *mgmt = kb->getDictMgmt();
+    SearchIndex *index = kb->getSearchIndex();
+    //Without the index (or if it misses the terms of the updates), all the
+    //terms are scanned
+    if (index != NULL) {
+        std::vector<SearchIndex::Match> matches;
+        index->searchSubstring(string(term), INT64_MAX, mgmt, matches);
+        return _matches_to_list(matches);
+    }
     TreeItr *itr = mgmt->getInvDictIterator();
     StringBuffer *sb = mgmt->getStringBuffer();
     string sTermToSearch(term);
+    std::unique_ptr<char[]> text(new char[MAX_TERM_SIZE]);
     PyObject *obj = PyList_New(0);
     while (itr->hasNext()) {
         int64_t value;
         int64_t key = itr->next(value);
         int size;
-        const char *text = sb->get(value, size);
-        string sTerm(text, size);
+        sb->get(value, text.get(), size);
+        string sTerm(text.get(), size);
         if (sTerm.find(sTermToSearch) != string::npos) {
             PyObject *t = PyTuple_New(2);
             PyTuple_SetItem(t, 0, PyLong_FromLong(key));
-            PyTuple_SetItem(t, 1, PyUnicode_FromStringAndSize(text, size));
+            PyTuple_SetItem(t, 1, PyUnicode_FromStringAndSize(text.get(), size));
             PyList_Append(obj, t);
             Py_DECREF(t);
         }
@@ -765,6 +793,45 @@ static PyObject * db_search_id(PyObject *self, PyObject *args) {
     return obj;
 }
 
+static PyObject * db_search_prefix(PyObject *self, PyObject *args) {
+    const char *term;
+    long limit = 100;
+    if (!PyArg_ParseTuple(args, "s|l", &term, &limit))
+        return NULL;
+    KB *kb = ((trident_Db*)self)->kb;
+    SearchIndex *index = kb->getSearchIndex();
+    if (index == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "The search index was not built or the KB must be compacted");
+        return NULL;
+    }
+    std::vector<SearchIndex::Match> matches;
+    index->searchPrefix(string(term), limit, matches);
+    return _matches_to_list(matches);
+}
+
+static PyObject * db_search_substring(PyObject *self, PyObject *args) {
+    const char *term;
+    long limit = 100;
+    if (!PyArg_ParseTuple(args, "s|l", &term, &limit))
+        return NULL;
+    KB *kb = ((trident_Db*)self)->kb;
+    SearchIndex *index = kb->getSearchIndex();
+    if (index == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "The search index was not built or the KB must be compacted");
+        return NULL;
+    }
+    std::vector<SearchIndex::Match> matches;
+    index->searchSubstring(string(term), limit, kb->getDictMgmt(), matches);
+    return _matches_to_list(matches);
+}
+
+static PyObject * db_build_search_index(PyObject *self, PyObject *args) {
+    KB *kb = ((trident_Db*)self)->kb;
+    kb->buildSearchIndex();
+    Py_INCREF(Py_None);
+    return Py_None;
+}
+
 static PyObject * db_join_e2e(PyObject *self, PyObject *args) {
     long lh_idx, lh_key, lh_firstval;
     long rh_idx, rh_key, rh_firstval;
@@ -813,18 +880,40 @@ static PyObject * db_join_e2e(PyObject *self, PyObject *args) {
 
 static PyObject * db_sparql(PyObject *self, PyObject *args) {
     const char *query = NULL;
-    if (!PyArg_ParseTuple(args, "s", &query))
+    PyObject *bindings_dict = NULL;
+    if (!PyArg_ParseTuple(args, "s|O", &query, &bindings_dict))
         return NULL;
 
-    KB *kb = ((trident_Db*)self)->kb;
+    //Optional bind parameters: {"varname": "<term>"}
+    std::map<std::string, std::string> params;
+    if (bindings_dict != NULL && bindings_dict != Py_None) {
+        if (!PyDict_Check(bindings_dict)) {
+            PyErr_SetString(PyExc_TypeError, "The parameters must be a dict");
+            return NULL;
+        }
+        PyObject *key, *value;
+        Py_ssize_t pos = 0;
+        while (PyDict_Next(bindings_dict, &pos, &key, &value)) {
+            const char *k = PyUnicode_AsUTF8(key);
+            const char *v = PyUnicode_AsUTF8(value);
+            if (k == NULL || v == NULL)
+                return NULL;
+            params[std::string(k)] = std::string(v);
+        }
+    }
+
+    trident_Db *db = (trident_Db*)self;
+    if (!db->plancache) {
+        db->plancache = std::unique_ptr<SPARQLPlanCache>(new SPARQLPlanCache());
+    }
     JSON vars;
     JSON bindings;
     JSON stats;
     SPARQLUtils::execSPARQLQuery(
             std::string(query),
-            false,
-            kb->getNTerms(),
-            *((trident_Db*)self)->db.get(),
+            params,
+            *db->plancache.get(),
+            *db->db.get(),
             false,
             true,
             &vars,
@@ -846,6 +935,7 @@ static PyObject * db_sparql(PyObject *self, PyObject *args) {
 }
 
 static void db_dealloc(trident_Db* self) {
+    self->plancache.reset();
     if (self->q)
         delete self->q;
     if (self->kb) {
@@ -859,7 +949,7 @@ static void db_dealloc(trident_Db* self) {
 }
 
 static PyMethodDef Db_methods[] = {
-    {"sparql", db_sparql, METH_VARARGS, "Execute SPARQL query." },
+    {"sparql", db_sparql, METH_VARARGS, "Execute SPARQL query. The optional dict binds variables to terms. Plans are cached." },
     {"s", db_alls, METH_VARARGS, "Get all subjects given the p and o. Returns a Python list." },
     {"s_itr", db_alls_fast, METH_VARARGS, "Get all subjects given the p and o. Returns an itr." },
     {"s_aggr", db_alls_aggr, METH_VARARGS, "Get all subjects given o" },
@@ -888,7 +978,10 @@ static PyMethodDef Db_methods[] = {
     {"lookup_id", db_lookup_id, METH_VARARGS, "Lookup for the ID of an input term" },
     {"lookup_str", db_lookup_str, METH_VARARGS, "Lookup for the textual version of an entity ID" },
     {"lookup_relstr", db_lookup_relstr, METH_VARARGS, "Lookup for the textual version of a relation ID" },
-    {"search_id", db_search_id, METH_VARARGS, "Search for the IDs of terms" },
+    {"search_id", db_search_id, METH_VARARGS, "Search for the IDs of terms. It uses the search index if it was built" },
+    {"search_prefix", db_search_prefix, METH_VARARGS, "Return (ID, term) for the terms that start with the given prefix. An optional second argument limits the number of results (default 100). Requires the search index" },
+    {"search_substring", db_search_substring, METH_VARARGS, "Return (ID, term) for the terms that contain the given text. An optional second argument limits the number of results (default 100). Requires the search index" },
+    {"build_search_index", db_build_search_index, METH_VARARGS, "Build the index used by search_prefix and search_substring" },
     {"join_e2e", db_join_e2e, METH_VARARGS, "Return the subset of entities of a pattern like <?x p1 o1> is also in another patter <?x p2 o2>. The first three argumenta are the index to use for the first pattern, the key, and second value. Then, the last three arguments refer to the second pattern." },
     {"load", (PyCFunction) db_loadFromFiles, METH_VARARGS | METH_KEYWORDS, "Load a graph from a set of files." },
     {NULL, NULL, 0, NULL}        /* Sentinel */
@@ -19,14 +19,17 @@ bool Trident_TNGraph::getNodeInfo(TermCoordinates &coord,
         const char*& osp,
         const char*& sop,
         SnapReaders::pReader& ospReader,
-        SnapReaders::pReader& sopReader) {
+        SnapReaders::pReader& sopReader,
+        int &ospPin,
+        int &sopPin) {
 
+    ospPin = sopPin = -1;
     bool ok = false;
     if (coord.exists(IDX_OSP)) {
         indeg = coord.getNElements(IDX_OSP);
         const short fileIn = coord.getFileIdx(IDX_OSP);
         const int markIn = coord.getMark(IDX_OSP);
-        osp = q->getTable(IDX_OSP, fileIn, markIn);
+        osp = q->getTable(IDX_OSP, fileIn, markIn, ospPin);
         const char strategy = coord.getStrategy(IDX_OSP);
         const int storageType = StorageStrat::getStorageType(strategy);
         if (storageType == NEWCOLUMN_ITR) {
@@ -46,6 +49,10 @@ bool Trident_TNGraph::getNodeInfo(TermCoordinates &coord,
             const char nbytes1 = (strategy >> 3) & 3;
             const char nbytes2 = (strategy >> 1) & 3;
             FactoryNewRowTable::getReader(nbytes1, nbytes2, &ospReader);
+        } else if (storageType == FORCOLUMN_STORAGE) {
+            releaseNodeInfo(q, ospPin, sopPin);
+            LOG(ERRORL) << "Bit-packed tables are not supported. Load the graph without --forcolumns";
+            throw 10;
         } else {
             const char nbytes1 = (strategy >> 3) & 3;
             const char nbytes2 = (strategy >> 1) & 3;
@@ -61,7 +68,7 @@ bool Trident_TNGraph::getNodeInfo(TermCoordinates &coord,
         outdeg = coord.getNElements(IDX_SOP);
         const short fileOut = coord.getFileIdx(IDX_SOP);
         const int markOut = coord.getMark(IDX_SOP);
-        sop = q->getTable(IDX_SOP, fileOut, markOut);
+        sop = q->getTable(IDX_SOP, fileOut, markOut, sopPin);
         const char strategy = coord.getStrategy(IDX_SOP);
         const int storageType = StorageStrat::getStorageType(strategy);
         if (storageType == NEWCOLUMN_ITR) {
@@ -81,6 +88,10 @@ bool Trident_TNGraph::getNodeInfo(TermCoordinates &coord,
             const char nbytes1 = (strategy >> 3) & 3;
             const char nbytes2 = (strategy >> 1) & 3;
             FactoryNewRowTable::getReader(nbytes1, nbytes2, &sopReader);
+        } else if (storageType == FORCOLUMN_STORAGE) {
+            releaseNodeInfo(q, ospPin, sopPin);
+            LOG(ERRORL) << "Bit-packed tables are not supported. Load the graph without --forcolumns";
+            throw 10;
         } else {
             const char nbytes1 = (strategy >> 3) & 3;
             const char nbytes2 = (strategy >> 1) & 3;
@@ -98,6 +109,12 @@ bool Trident_TNGraph::getNodeInfo(TermCoordinates &coord,
     return ok;
 }
 
+void Trident_TNGraph::releaseNodeInfo(Querier *q, int &ospPin, int &sopPin) {
+    q->releaseTable(IDX_OSP, ospPin);
+    q->releaseTable(IDX_SOP, sopPin);
+    ospPin = sopPin = -1;
+}
+
 void Trident_TNGraph::getNewColumnPointer(int bytesEl,
         int totalBytes,
         int64_t (**output)(const char*, const int64_t)) {
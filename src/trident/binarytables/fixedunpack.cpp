@@ -0,0 +1,219 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#include <trident/binarytables/fixedunpack.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define FIXEDUNPACK_X86
+#include <immintrin.h>
+#endif
+
+//The byte order used by Utils::encode_longNBytes is detected once, so that
+//the shuffle masks produce the same values as the scalar decoder
+static bool isLittleEndian() {
+    static const bool le = [] {
+        const char buf[2] = {1, 0};
+        return Utils::decode_longFixedBytes(buf, 2) == 1;
+    }();
+    return le;
+}
+
+//Fills a shuffle mask that moves "lanes" values of nbytes each (stride bytes
+//apart) into lanes of laneBytes bytes. Unused bytes are zeroed (0x80)
+static void buildMask(uint8_t *mask, const int lanes, const int laneBytes,
+        const int nbytes, const int stride) {
+    const bool le = isLittleEndian();
+    for (int v = 0; v < lanes; ++v) {
+        for (int k = 0; k < laneBytes; ++k) {
+            if (k < nbytes) {
+                mask[v * laneBytes + k] = (uint8_t) (v * stride +
+                        (le ? k : nbytes - 1 - k));
+            } else {
+                mask[v * laneBytes + k] = 0x80;
+            }
+        }
+    }
+}
+
+void FixedUnpack::unpack_scalar(const char *input,
+        const uint8_t nbytes,
+        const uint8_t stride,
+        const size_t n,
+        int64_t *output) {
+    for (size_t i = 0; i < n; ++i) {
+        output[i] = Utils::decode_longFixedBytes(input + i * stride, nbytes);
+    }
+}
+
+#ifdef FIXEDUNPACK_X86
+__attribute__((target("ssse3,sse4.1")))
+void FixedUnpack::unpack_sse4(const char *input,
+        const uint8_t nbytes,
+        const uint8_t stride,
+        const size_t n,
+        int64_t *output) {
+    if (n < 4 || nbytes > 8) {
+        unpack_scalar(input, nbytes, stride, n, output);
+        return;
+    }
+    //Never read past the last byte of the last value
+    const size_t span = (n - 1) * stride + nbytes;
+    size_t i = 0;
+    uint8_t m[16];
+    if (nbytes <= 4 && 3 * stride + nbytes <= 16) {
+        //Four values per load, in 32-bit lanes
+        buildMask(m, 4, 4, nbytes, stride);
+        const __m128i mask = _mm_loadu_si128((const __m128i*) m);
+        for (; i + 4 <= n && i * stride + 16 <= span; i += 4) {
+            const __m128i in = _mm_loadu_si128(
+                    (const __m128i*) (input + i * stride));
+            const __m128i v = _mm_shuffle_epi8(in, mask);
+            _mm_storeu_si128((__m128i*) (output + i), _mm_cvtepu32_epi64(v));
+            _mm_storeu_si128((__m128i*) (output + i + 2),
+                    _mm_cvtepu32_epi64(_mm_srli_si128(v, 8)));
+        }
+    } else if (stride + nbytes <= 16) {
+        //Two values per load, in 64-bit lanes
+        buildMask(m, 2, 8, nbytes, stride);
+        const __m128i mask = _mm_loadu_si128((const __m128i*) m);
+        for (; i + 2 <= n && i * stride + 16 <= span; i += 2) {
+            const __m128i in = _mm_loadu_si128(
+                    (const __m128i*) (input + i * stride));
+            _mm_storeu_si128((__m128i*) (output + i),
+                    _mm_shuffle_epi8(in, mask));
+        }
+    }
+    unpack_scalar(input + i * stride, nbytes, stride, n - i, output + i);
+}
+
+__attribute__((target("avx2")))
+void FixedUnpack::unpack_avx2(const char *input,
+        const uint8_t nbytes,
+        const uint8_t stride,
+        const size_t n,
+        int64_t *output) {
+    if (n < 8 || nbytes > 8) {
+        unpack_scalar(input, nbytes, stride, n, output);
+        return;
+    }
+    const size_t span = (n - 1) * stride + nbytes;
+    size_t i = 0;
+    uint8_t m[32];
+    if (nbytes <= 4 && 3 * stride + nbytes <= 16) {
+        //Eight values per iteration: two 128-bit loads of four values each.
+        //The shuffle works within each 128-bit lane, so both halves share
+        //the same mask
+        buildMask(m, 4, 4, nbytes, stride);
+        buildMask(m + 16, 4, 4, nbytes, stride);
+        const __m256i mask = _mm256_loadu_si256((const __m256i*) m);
+        for (; i + 8 <= n && (i + 4) * stride + 16 <= span; i += 8) {
+            const __m128i lo = _mm_loadu_si128(
+                    (const __m128i*) (input + i * stride));
+            const __m128i hi = _mm_loadu_si128(
+                    (const __m128i*) (input + (i + 4) * stride));
+            const __m256i in = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(lo), hi, 1);
+            const __m256i v = _mm256_shuffle_epi8(in, mask);
+            _mm256_storeu_si256((__m256i*) (output + i),
+                    _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+            _mm256_storeu_si256((__m256i*) (output + i + 4),
+                    _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+        }
+    } else if (stride + nbytes <= 16) {
+        //Four values per iteration, in 64-bit lanes
+        buildMask(m, 2, 8, nbytes, stride);
+        buildMask(m + 16, 2, 8, nbytes, stride);
+        const __m256i mask = _mm256_loadu_si256((const __m256i*) m);
+        for (; i + 4 <= n && (i + 2) * stride + 16 <= span; i += 4) {
+            const __m128i lo = _mm_loadu_si128(
+                    (const __m128i*) (input + i * stride));
+            const __m128i hi = _mm_loadu_si128(
+                    (const __m128i*) (input + (i + 2) * stride));
+            const __m256i in = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(lo), hi, 1);
+            _mm256_storeu_si256((__m256i*) (output + i),
+                    _mm256_shuffle_epi8(in, mask));
+        }
+    }
+    unpack_scalar(input + i * stride, nbytes, stride, n - i, output + i);
+}
+
+bool FixedUnpack::isSSE4Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("ssse3") && __builtin_cpu_supports("sse4.1");
+}
+
+bool FixedUnpack::isAVX2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#else
+void FixedUnpack::unpack_sse4(const char *input,
+        const uint8_t nbytes,
+        const uint8_t stride,
+        const size_t n,
+        int64_t *output) {
+    unpack_scalar(input, nbytes, stride, n, output);
+}
+
+void FixedUnpack::unpack_avx2(const char *input,
+        const uint8_t nbytes,
+        const uint8_t stride,
+        const size_t n,
+        int64_t *output) {
+    unpack_scalar(input, nbytes, stride, n, output);
+}
+
+bool FixedUnpack::isSSE4Supported() {
+    return false;
+}
+
+bool FixedUnpack::isAVX2Supported() {
+    return false;
+}
+#endif
+
+FixedUnpack::Kernel FixedUnpack::kernel = NULL;
+std::once_flag FixedUnpack::selected;
+
+void FixedUnpack::select() {
+    isLittleEndian();
+    if (isAVX2Supported()) {
+        kernel = &FixedUnpack::unpack_avx2;
+    } else if (isSSE4Supported()) {
+        kernel = &FixedUnpack::unpack_sse4;
+    } else {
+        kernel = &FixedUnpack::unpack_scalar;
+    }
+}
+
+const char *FixedUnpack::getKernelName() {
+    init();
+    if (kernel == &FixedUnpack::unpack_avx2) {
+        return "avx2";
+    } else if (kernel == &FixedUnpack::unpack_sse4) {
+        return "sse4.1";
+    } else {
+        return "scalar";
+    }
+}
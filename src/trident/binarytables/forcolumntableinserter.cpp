@@ -0,0 +1,161 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+#include <trident/binarytables/forcolumntableinserter.h>
+#include <kognac/utils.h>
+
+#include <algorithm>
+
+void FORColumnTableInserter::startAppend() {
+    tmpfirstpairs.clear();
+    blockBases.clear();
+    blockBits.clear();
+    blockOffsets.clear();
+    packed.clear();
+    largestGroup = largestElement1 = largestElement2 = 0;
+
+    prevtotalsize2 = 0;
+    prevel1 = -1;
+    nelements2 = 0;
+    nblock = 0;
+}
+
+void FORColumnTableInserter::pack(const int64_t *values, const int64_t n,
+        const int64_t base, const uint8_t bits,
+        std::vector<char> &output) {
+    if (bits == 0) {
+        return;
+    }
+    const size_t start = output.size();
+    output.resize(start + ((uint64_t) n * bits + 7) / 8, 0);
+    uint64_t bitpos = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        uint64_t v = values[i] - base;
+        uint8_t remaining = bits;
+        while (remaining > 0) {
+            const uint8_t shift = bitpos & 7;
+            const uint8_t nbits = std::min((uint8_t) (8 - shift), remaining);
+            output[start + (bitpos >> 3)] |=
+                (char) ((v & ((1u << nbits) - 1)) << shift);
+            v >>= nbits;
+            bitpos += nbits;
+            remaining -= nbits;
+        }
+    }
+}
+
+void FORColumnTableInserter::packBlock() {
+    const int64_t base = *std::min_element(block, block + nblock);
+    const int64_t max = *std::max_element(block, block + nblock);
+    const uint8_t bits = numBits(max - base);
+    if (bits > FORColumnTable::MAXBITS) {
+        LOG(ERRORL) << "The values of the block are too far apart";
+        throw 10;
+    }
+    blockBases.push_back(base);
+    blockBits.push_back(bits);
+    blockOffsets.push_back(packed.size());
+    pack(block, nblock, base, bits, packed);
+    nblock = 0;
+}
+
+void FORColumnTableInserter::append(int64_t t1, int64_t t2) {
+    if (prevel1 != t1) {
+        if (nelements2 - prevtotalsize2 > largestGroup) {
+            largestGroup = nelements2 - prevtotalsize2;
+        }
+        tmpfirstpairs.push_back(std::make_pair(t1, nelements2));
+        prevtotalsize2 = nelements2;
+        prevel1 = t1;
+    }
+    if (t2 >= largestElement2) {
+        largestElement2 = t2;
+    }
+    if (t1 >= largestElement1) {
+        largestElement1 = t1;
+    }
+
+    block[nblock++] = t2;
+    nelements2++;
+    if (nblock == FORColumnTable::BLOCKSIZE) {
+        packBlock();
+    }
+}
+
+void FORColumnTableInserter::stopAppend() {
+    if (nblock > 0) {
+        packBlock();
+    }
+    //Check largest group
+    const int64_t totalsize2 = nelements2;
+    if (totalsize2 - prevtotalsize2 > largestGroup) {
+        largestGroup = totalsize2 - prevtotalsize2;
+    }
+
+    //First determine the size of the fixed-length fields
+    uint8_t bytesPerFirstEntry = Utils::numBytesFixedLength(largestElement1);
+    uint8_t bytesPerBase = Utils::numBytesFixedLength(largestElement2);
+    uint8_t bytesPerCount = Utils::numBytesFixedLength(largestGroup);
+    uint8_t bytesPerOffset = Utils::numBytesFixedLength(totalsize2);
+    uint8_t bytesPerBlockOffset = Utils::numBytesFixedLength(packed.size());
+    if (bytesPerFirstEntry == 0 || bytesPerBase == 0 ||
+            bytesPerCount == 0 || bytesPerOffset == 0 ||
+            bytesPerBlockOffset == 0) {
+        LOG(ERRORL) << "Bytes are incorrect";
+        throw 10;
+    }
+
+    //Write the header
+    uint8_t header1 = (bytesPerFirstEntry << 3) + (bytesPerBase & 7);
+    writeByte(header1);
+    uint8_t header2 = (bytesPerCount << 3) + (bytesPerOffset & 7);
+    writeByte(header2);
+    writeByte(bytesPerBlockOffset);
+    writeVLong2(tmpfirstpairs.size());
+    writeVLong2(totalsize2);
+
+    //Write all first elements
+    for (size_t i = 0; i < tmpfirstpairs.size(); ++i) {
+        std::pair<uint64_t, uint64_t> v = tmpfirstpairs[i];
+        writeLong(bytesPerFirstEntry, v.first);
+        if (i < tmpfirstpairs.size() - 1) {
+            writeLong(bytesPerCount, tmpfirstpairs[i + 1].second - v.second);
+        } else {
+            writeLong(bytesPerCount, totalsize2 - v.second);
+        }
+        writeLong(bytesPerOffset, v.second);
+    }
+
+    //Write the skip headers
+    for (size_t i = 0; i < blockBases.size(); ++i) {
+        writeLong(bytesPerBase, blockBases[i]);
+        writeByte(blockBits[i]);
+        writeLong(bytesPerBlockOffset, blockOffsets[i]);
+    }
+
+    //Write the packed values
+    if (!packed.empty()) {
+        writeBytes(packed.data(), packed.size());
+    }
+    char padding[FORColumnTable::PADDING] = { 0 };
+    writeBytes(padding, FORColumnTable::PADDING);
+}
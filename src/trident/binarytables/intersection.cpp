@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#include <trident/binarytables/intersection.h>
+#include <trident/binarytables/fixedunpack.h>
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define INTERSECTION_X86
+#include <immintrin.h>
+#endif
+
+//Decodes a packed list a chunk at a time. refill() keeps the values that
+//were not consumed yet at the beginning of the buffer
+struct ChunkReader {
+    static const int64_t CHUNK = 256;
+    const Intersection::PackedList &list;
+    int64_t next;
+    int64_t buffer[CHUNK];
+    int64_t pos, size;
+
+    ChunkReader(const Intersection::PackedList &list) : list(list), next(0),
+        pos(0), size(0) {
+    }
+
+    int64_t left() const {
+        return size - pos;
+    }
+
+    void refill() {
+        const int64_t l = size - pos;
+        if (l > 0 && pos > 0) {
+            memmove(buffer, buffer + pos, l * sizeof(int64_t));
+        }
+        pos = 0;
+        size = l;
+        int64_t toDecode = CHUNK - l;
+        if (toDecode > list.size - next) {
+            toDecode = list.size - next;
+        }
+        if (toDecode > 0) {
+            FixedUnpack::unpack(list.start + next * list.stride, list.nbytes,
+                    list.stride, toDecode, buffer + size);
+            next += toDecode;
+            size += toDecode;
+        }
+    }
+};
+
+static int64_t mergeReaders(ChunkReader &r1, ChunkReader &r2) {
+    int64_t count = 0;
+    while (true) {
+        if (r1.left() == 0) {
+            r1.refill();
+        }
+        if (r2.left() == 0) {
+            r2.refill();
+        }
+        if (r1.left() == 0 || r2.left() == 0) {
+            break;
+        }
+        const int64_t *b1 = r1.buffer;
+        const int64_t *b2 = r2.buffer;
+        int64_t p1 = r1.pos, p2 = r2.pos;
+        const int64_t s1 = r1.size, s2 = r2.size;
+        while (p1 < s1 && p2 < s2) {
+            const int64_t v1 = b1[p1];
+            const int64_t v2 = b2[p2];
+            count += v1 == v2;
+            p1 += v1 <= v2;
+            p2 += v2 <= v1;
+        }
+        r1.pos = p1;
+        r2.pos = p2;
+    }
+    return count;
+}
+
+int64_t Intersection::count_merge(const PackedList &l1, const PackedList &l2) {
+    ChunkReader r1(l1);
+    ChunkReader r2(l2);
+    return mergeReaders(r1, r2);
+}
+
+int64_t Intersection::count_gallop(const PackedList &small,
+        const PackedList &large) {
+    int64_t count = 0;
+    int64_t pos = 0;
+    for (int64_t i = 0; i < small.size && pos < large.size; ++i) {
+        const int64_t v = small.get(i);
+        pos = lowerBound(large, pos, v);
+        if (pos < large.size && large.get(pos) == v) {
+            count++;
+            pos++;
+        }
+    }
+    return count;
+}
+
+#ifdef INTERSECTION_X86
+//Compares blocks of four values against each other: every value of the
+//first block is tested against all rotations of the second one
+__attribute__((target("avx2,popcnt")))
+static int64_t count_avx2(ChunkReader &r1, ChunkReader &r2) {
+    int64_t count = 0;
+    while (true) {
+        if (r1.left() < 4) {
+            r1.refill();
+        }
+        if (r2.left() < 4) {
+            r2.refill();
+        }
+        if (r1.left() < 4 || r2.left() < 4) {
+            break;
+        }
+        while (r1.left() >= 4 && r2.left() >= 4) {
+            const int64_t *b1 = r1.buffer + r1.pos;
+            const int64_t *b2 = r2.buffer + r2.pos;
+            const __m256i va = _mm256_loadu_si256((const __m256i*) b1);
+            __m256i vb = _mm256_loadu_si256((const __m256i*) b2);
+            __m256i m = _mm256_cmpeq_epi64(va, vb);
+            vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+            vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+            vb = _mm256_permute4x64_epi64(vb, _MM_SHUFFLE(0, 3, 2, 1));
+            m = _mm256_or_si256(m, _mm256_cmpeq_epi64(va, vb));
+            count += __builtin_popcount(_mm256_movemask_pd(
+                        _mm256_castsi256_pd(m)));
+            const int64_t max1 = b1[3];
+            const int64_t max2 = b2[3];
+            r1.pos += max1 <= max2 ? 4 : 0;
+            r2.pos += max2 <= max1 ? 4 : 0;
+        }
+    }
+    return count + mergeReaders(r1, r2);
+}
+
+static bool isAVX2Supported() {
+    static const bool supported = FixedUnpack::isAVX2Supported();
+    return supported;
+}
+#endif
+
+int64_t Intersection::count_simd(const PackedList &l1, const PackedList &l2) {
+    ChunkReader r1(l1);
+    ChunkReader r2(l2);
+#ifdef INTERSECTION_X86
+    if (isAVX2Supported()) {
+        return count_avx2(r1, r2);
+    }
+#endif
+    return mergeReaders(r1, r2);
+}
+
+int64_t Intersection::count(const PackedList &l1, const PackedList &l2) {
+    if (l1.size == 0 || l2.size == 0) {
+        return 0;
+    }
+    if (l1.size * GALLOP_RATIO < l2.size) {
+        return count_gallop(l1, l2);
+    } else if (l2.size * GALLOP_RATIO < l1.size) {
+        return count_gallop(l2, l1);
+    } else if (l1.size >= 16 && l2.size >= 16) {
+        return count_simd(l1, l2);
+    } else {
+        return count_merge(l1, l2);
+    }
+}
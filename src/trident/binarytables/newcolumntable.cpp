@@ -21,6 +21,7 @@
 
 
 #include <trident/binarytables/newcolumntable.h>
+#include <trident/binarytables/fixedunpack.h>
 
 /*void NewColumnTable::next_pair() {
     if (!has_next()) {
@@ -264,85 +265,80 @@ void NewColumnTable::ignoreSecondColumn() {
     }
 }*/
 
-void NewColumnTable::columnNotIn11(const char *begin1, const char* end1,
-                                   const uint8_t bEntry1, const uint8_t bBlock1,
-                                   const char *begin2, const char *end2,
-                                   const uint8_t bEntry2, const uint8_t bBlock2,
-                                   SequenceWriter *output) {
+//Reads a strided sequence of fixed-width values a chunk at a time
+struct StridedColumnReader {
+    static const size_t CHUNK = 64;
+    const char *pos;
+    const char *end;
+    const uint8_t bEntry;
+    const uint8_t stride;
+    int64_t buffer[CHUNK];
+    size_t idx, size;
+
+    StridedColumnReader(const char *begin, const char *end,
+                        const uint8_t bEntry, const uint8_t stride) :
+        pos(begin), end(end), bEntry(bEntry), stride(stride), idx(0), size(0) {
+        fill();
+    }
 
-    uint64_t tv, ov;
-    tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-    ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-    do {
-        if (tv <= ov) {
-            if (tv < ov)
-                output->add(tv);
-            //move tv forward
-            begin1 += bBlock1;
-            if (begin1 != end1) {
-                tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            } else {
-                break;
-            }
-        } else {
-            begin2 += bBlock2;
-            if (begin2 != end2) {
-                ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-            } else {
-                break;
-            }
-        }
-    } while (true);
+    void fill() {
+        const size_t left = (end - pos) / stride;
+        size = left < CHUNK ? left : CHUNK;
+        FixedUnpack::unpack(pos, bEntry, stride, size, buffer);
+        pos += size * stride;
+        idx = 0;
+    }
+
+    bool hasValue() const {
+        return idx < size;
+    }
 
-    if (begin1 != end1) {
-        output->add(tv);
-        begin1 += bBlock1;
-        while (begin1 != end1) {
-            tv = Utils::decode_longFixedBytes(begin1, bEntry1);
+    int64_t value() const {
+        return buffer[idx];
+    }
+
+    void advance() {
+        if (++idx == size) {
+            fill();
+        }
+    }
+};
+
+void NewColumnTable::columnNotInStrided(const char *begin1, const char* end1,
+                                        const uint8_t bEntry1, const uint8_t stride1,
+                                        const char *begin2, const char *end2,
+                                        const uint8_t bEntry2, const uint8_t stride2,
+                                        SequenceWriter *output) {
+    StridedColumnReader r1(begin1, end1, bEntry1, stride1);
+    StridedColumnReader r2(begin2, end2, bEntry2, stride2);
+    while (r1.hasValue()) {
+        const int64_t tv = r1.value();
+        while (r2.hasValue() && r2.value() < tv) {
+            r2.advance();
+        }
+        if (!r2.hasValue() || r2.value() > tv) {
             output->add(tv);
-            begin1 += bBlock1;
         }
+        r1.advance();
     }
 }
 
+void NewColumnTable::columnNotIn11(const char *begin1, const char* end1,
+                                   const uint8_t bEntry1, const uint8_t bBlock1,
+                                   const char *begin2, const char *end2,
+                                   const uint8_t bEntry2, const uint8_t bBlock2,
+                                   SequenceWriter *output) {
+    columnNotInStrided(begin1, end1, bEntry1, bBlock1,
+                       begin2, end2, bEntry2, bBlock2, output);
+}
+
 void NewColumnTable::columnNotIn12(const char *begin1, const char* end1,
                                    const uint8_t bEntry1, const uint8_t bBlock1,
                                    const char *begin2, const char *end2,
                                    const uint8_t bEntry2,
                                    SequenceWriter * output) {
-    uint64_t tv, ov;
-    tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-    ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-    do {
-        if (tv <= ov) {
-            if (tv < ov)
-                output->add(tv);
-            //move tv forward
-            begin1 += bBlock1;
-            if (begin1 != end1) {
-                tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            } else {
-                break;
-            }
-        } else {
-            begin2 += bEntry2;
-            if (begin2 != end2) {
-                ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-            } else {
-                break;
-            }
-        }
-    } while (true);
-
-    if (begin1 != end1) {
-        output->add(tv);
-        begin1 += bBlock1;
-        while (begin1 != end1) {
-            tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            output->add(tv);
-            begin1 += bBlock1;
-        }
-    }
+    columnNotInStrided(begin1, end1, bEntry1, bBlock1,
+                       begin2, end2, bEntry2, bEntry2, output);
 }
 
 void NewColumnTable::columnNotIn21(const char *begin1, const char* end1,
@@ -350,39 +346,8 @@ void NewColumnTable::columnNotIn21(const char *begin1, const char* end1,
                                    const char *begin2, const char *end2,
                                    const uint8_t bEntry2, const uint8_t bBlock2,
                                    SequenceWriter * output) {
-    uint64_t tv, ov;
-    tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-    ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-    do {
-        if (tv <= ov) {
-            if (tv < ov)
-                output->add(tv);
-            //move tv forward
-            begin1 += bEntry1;
-            if (begin1 != end1) {
-                tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            } else {
-                break;
-            }
-        } else {
-            begin2 += bBlock2;
-            if (begin2 != end2) {
-                ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-            } else {
-                break;
-            }
-        }
-    } while (true);
-
-    if (begin1 != end1) {
-        output->add(tv);
-        begin1 += bEntry1;
-        while (begin1 != end1) {
-            tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            output->add(tv);
-            begin1 += bEntry1;
-        }
-    }
+    columnNotInStrided(begin1, end1, bEntry1, bEntry1,
+                       begin2, end2, bEntry2, bBlock2, output);
 }
 
 void NewColumnTable::columnNotIn22(const char *begin1, const char* end1,
@@ -390,37 +355,6 @@ void NewColumnTable::columnNotIn22(const char *begin1, const char* end1,
                                    const char *begin2, const char *end2,
                                    const uint8_t bEntry2,
                                    SequenceWriter * output) {
-    uint64_t tv, ov;
-    tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-    ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-    do {
-        if (tv <= ov) {
-            if (tv < ov)
-                output->add(tv);
-            //move tv forward
-            begin1 += bEntry1;
-            if (begin1 != end1) {
-                tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            } else {
-                break;
-            }
-        } else {
-            begin2 += bEntry2;
-            if (begin2 != end2) {
-                ov = Utils::decode_longFixedBytes(begin2, bEntry2);
-            } else {
-                break;
-            }
-        }
-    } while (true);
-
-    if (begin1 != end1) {
-        output->add(tv);
-        begin1 += bEntry1;
-        while (begin1 != end1) {
-            tv = Utils::decode_longFixedBytes(begin1, bEntry1);
-            output->add(tv);
-            begin1 += bEntry1;
-        }
-    }
+    columnNotInStrided(begin1, end1, bEntry1, bEntry1,
+                       begin2, end2, bEntry2, bEntry2, output);
 }
@@ -129,10 +129,19 @@ void NewColumnTableInserter::stopAppend() {
         throw 10;
     }
 
+    //Large tables get a skip index, filled while the columns are written
+    const bool skipIndex = totalsize2 >= SKIPINDEX_MINROWS;
+    const int64_t skipMask = (((int64_t)1) << SKIPINDEX_SHIFT) - 1;
+    std::vector<int64_t> skipValues1, skipValues2;
+    int64_t row1 = 0, row2 = 0;
+
     //Write the header
     uint8_t header1 = (bytesPerFirstEntry << 3) + (bytesPerSecondEntry & 7);
     writeByte(header1);
     uint8_t header2 = (bytesPerCount << 3) + (bytesPerOffset & 7);
+    if (skipIndex) {
+        header2 |= SKIPINDEX_FLAG;
+    }
     writeByte(header2);
     writeVLong2(tmpfirstpairs.size() + offloadedElements1);
     writeVLong2(totalsize2);
@@ -153,6 +162,9 @@ void NewColumnTableInserter::stopAppend() {
                 const int64_t v1 = Utils::decode_long(buffer + i);
                 const int64_t v2 = Utils::decode_long(buffer + i + 8);
                 if (prevkey != -1) {
+                    if (skipIndex && (row1++ & skipMask) == 0) {
+                        skipValues1.push_back(prevkey);
+                    }
                     writeLong(bytesPerFirstEntry, prevkey);
                     writeLong(bytesPerCount, v2 - prevsize);
                     writeLong(bytesPerOffset, prevsize);
@@ -164,6 +176,9 @@ void NewColumnTableInserter::stopAppend() {
         }
         //Must write the last element
         assert(prevkey != -1);
+        if (skipIndex && (row1++ & skipMask) == 0) {
+            skipValues1.push_back(prevkey);
+        }
         if (tmpfirstpairs.size() > 0) {
             writeLong(bytesPerFirstEntry, prevkey);
             writeLong(bytesPerCount, tmpfirstpairs.front().second - prevsize);
@@ -183,6 +198,9 @@ void NewColumnTableInserter::stopAppend() {
     //Write all first elements
     for (size_t i = 0; i < tmpfirstpairs.size(); ++i) {
         std::pair<uint64_t, uint64_t> v = tmpfirstpairs[i];
+        if (skipIndex && (row1++ & skipMask) == 0) {
+            skipValues1.push_back(v.first);
+        }
         writeLong(bytesPerFirstEntry, v.first);
         if (i < tmpfirstpairs.size() - 1) {
             writeLong(bytesPerCount, tmpfirstpairs[i + 1].second - v.second);
@@ -203,6 +221,9 @@ void NewColumnTableInserter::stopAppend() {
             offloadfile2_r.read(buffer, maxElsToRead * 8);
             for (int64_t i = 0; i < maxElsToRead * 8; i += 8) {
                 const int64_t value = Utils::decode_long(buffer + i);
+                if (skipIndex && (row2++ & skipMask) == 0) {
+                    skipValues2.push_back(value);
+                }
                 writeLong(bytesPerSecondEntry, value);
             }
             offloadedElements2 -= maxElsToRead;
@@ -214,6 +235,20 @@ void NewColumnTableInserter::stopAppend() {
 
     //Write all second elements
     for (const auto v : tmpsecondpairs) {
+        if (skipIndex && (row2++ & skipMask) == 0) {
+            skipValues2.push_back(v);
+        }
         writeLong(bytesPerSecondEntry, v);
     }
+
+    //Write the skip index
+    if (skipIndex) {
+        writeByte(SKIPINDEX_SHIFT);
+        for (const auto v : skipValues1) {
+            writeLong(bytesPerFirstEntry, v);
+        }
+        for (const auto v : skipValues2) {
+            writeLong(bytesPerSecondEntry, v);
+        }
+    }
 }
@@ -23,6 +23,7 @@
 #include <trident/binarytables/storagestrat.h>
 
 #include <climits>
+#include <algorithm>
 
 unsigned StorageStrat::getStrat5() {
     unsigned output = 0;
@@ -72,6 +73,9 @@ PairItr *StorageStrat::getBinaryTable(const char signature) {
         if (signature & 1)
             ncount = 4;
         return f6->get(nbytes1, nbytes2, ncount);
+    } else if (storageType == FORCOLUMN_STORAGE) {
+        FORColumnTable *ph = f7->get();
+        return ph;
     } else {
         throw 10;
     }
@@ -122,6 +126,9 @@ BinaryTableInserter *StorageStrat::getBinaryTableInserter(const char signature)
         }
         ph->setSizes(nbytes1, nbytes2, ncount);
         return ph;
+    } else if (storageType == FORCOLUMN_STORAGE) {
+        FORColumnTableInserter *ph = f7i->get();
+        return ph;
     } else {
         throw 10;
     }
@@ -328,10 +335,38 @@ bool combinationSorter(const StorageStrat::Combinations &c1, const StorageStrat:
     return c1.sum < c2.sum;
 }
 
+int64_t StorageStrat::getFORColumnSize(int64_t *v2, const int size,
+        const int64_t ngroups,
+        const int64_t maxValue1,
+        const int64_t maxValue2,
+        const int64_t maxGroupSize) {
+    int64_t nblocks = 0;
+    int64_t packedBytes = 0;
+    for (int i = 0; i < size; i += FORColumnTable::BLOCKSIZE) {
+        const int end = std::min(size, i + FORColumnTable::BLOCKSIZE);
+        const int64_t min = *std::min_element(v2 + i, v2 + end);
+        const int64_t max = *std::max_element(v2 + i, v2 + end);
+        const uint8_t bits = FORColumnTableInserter::numBits(max - min);
+        if (bits > FORColumnTable::MAXBITS) {
+            return INT64_MAX;
+        }
+        packedBytes += ((int64_t)(end - i) * bits + 7) / 8;
+        nblocks++;
+    }
+    const int64_t bytesFirstBlock = Utils::numBytesFixedLength(maxValue1) +
+        Utils::numBytesFixedLength(maxGroupSize) +
+        Utils::numBytesFixedLength(size);
+    const int64_t bytesBlockHeader = Utils::numBytesFixedLength(maxValue2) +
+        1 + Utils::numBytesFixedLength(packedBytes);
+    return 3 + ngroups * bytesFirstBlock + nblocks * bytesBlockHeader +
+        packedBytes + FORColumnTable::PADDING;
+}
+
 char StorageStrat::determineStrategy(int64_t *v1, int64_t *v2, const int size,
         const int64_t nTermsInInput,
         const size_t nTermsClusterColumn,
         const bool useRowForLargeTables,
+        const bool useFORColumn,
         Statistics &stats) {
     unsigned strat = 0;
     if (size < THRESHOLD_KEEP_MEMORY) {
@@ -360,10 +395,25 @@ char StorageStrat::determineStrategy(int64_t *v1, int64_t *v2, const int size,
             }
         }
 
+        //The bit-packed layout is used only if it is clearly smaller
+        const double forSize = useFORColumn ? RATE_FORCOLUMN *
+            getFORColumnSize(v2, size, ngroups, maxValue1, maxValue2,
+                    maxGroupSize) : (double) INT64_MAX;
+
         //I have all info I need. Decide between row and cluster
         if (ngroups >= nTermsClusterColumn) {
-            strat = setStorageType(strat, NEWCOLUMN_ITR);
-            stats.nList2Strategies++;
+            const int64_t totalSpaceColumn = ngroups *
+                (Utils::numBytesFixedLength(maxValue1) +
+                 Utils::numBytesFixedLength(maxGroupSize) +
+                 Utils::numBytesFixedLength(size)) +
+                size * Utils::numBytesFixedLength(maxValue2);
+            if (forSize < totalSpaceColumn) {
+                strat = setStorageType(strat, FORCOLUMN_STORAGE);
+                stats.nFORStrategies++;
+            } else {
+                strat = setStorageType(strat, NEWCOLUMN_ITR);
+                stats.nList2Strategies++;
+            }
         } else {
             if (maxGroupSize <= 255) {
                 nbytescount = 1;
@@ -391,7 +441,13 @@ char StorageStrat::determineStrategy(int64_t *v1, int64_t *v2, const int size,
 
             int64_t totalSpaceRow = size * (nbytes1 + nbytes2);
             int64_t totalSpaceCluster = ngroups * (nbytes1 + nbytescount) + nbytes2;
-            if (totalSpaceRow < totalSpaceCluster) {
+            //totalSpaceCluster does not count the whole second column
+            const int64_t totalSpaceAllCluster = ngroups *
+                (nbytes1 + nbytescount) + size * nbytes2;
+            if (forSize < std::min(totalSpaceRow, totalSpaceAllCluster)) {
+                strat = setStorageType(strat, FORCOLUMN_STORAGE);
+                stats.nFORStrategies++;
+            } else if (totalSpaceRow < totalSpaceCluster) {
                 strat = setStorageType(strat, NEWROW_ITR);
                 strat = setBytesField1(strat, flagbytes1);
                 strat = setBytesField2(strat, flagbytes2);
@@ -21,6 +21,7 @@
 
 
 #include <trident/binarytables/tableshandler.h>
+#include <trident/utils/accesslog.h>
 
 #include <kognac/utils.h>
 
@@ -55,11 +56,12 @@ void FileMarks::parse(string path) {
 TableStorage::TableStorage(bool readOnly, string pathDir, int64_t maxFileSize,
         int maxNFiles,
         MemoryManager<FileDescriptor> *bytesTracker,
-        Stats &stats, int perm) :
+        Stats &stats, int perm, int64_t asyncBufferSize) :
     readOnly(readOnly), marks(), marksLoaded(), stats(stats), perm(perm) {
         strcpy(this->pathDir, pathDir.c_str());
         this->sizePathDir = strlen(this->pathDir);
         this->pathDir[sizePathDir++] = CDIR_SEP;
+        accessLogDir = AccessLog::registerDir(pathDir);
 
         //Determine the highest number of a file
         lastCreatedFile = 0;
@@ -74,7 +76,7 @@ TableStorage::TableStorage(bool readOnly, string pathDir, int64_t maxFileSize,
 
             cache = new FileManager<FileDescriptor, FileDescriptor>(pathDir,
                     readOnly, maxFileSize, maxNFiles, lastCreatedFile,
-                    bytesTracker, &stats);
+                    bytesTracker, &stats, asyncBufferSize);
 
             sizeLastCreatedFile = cache->sizeFile(lastCreatedFile);
         } else {
@@ -85,7 +87,7 @@ TableStorage::TableStorage(bool readOnly, string pathDir, int64_t maxFileSize,
 
             cache = new FileManager<FileDescriptor, FileDescriptor>(pathDir,
                     readOnly, maxFileSize, maxNFiles, lastCreatedFile,
-                    bytesTracker, &stats);
+                    bytesTracker, &stats, asyncBufferSize);
         }
         indicesWritten = false;
         insertHandler = NULL;
@@ -131,7 +133,8 @@ std::string TableStorage::getPath() {
     return std::string(pathDir, sizePathDir);
 }
 
-std::pair<const char*, const char*> TableStorage::getTable(short file, int64_t mark) {
+std::pair<const char*, const char*> TableStorage::getTable(short file,
+        int64_t mark, int &pin) {
     //I assume all the table is in one file
     if (!marksLoaded[file]) {
 #ifdef MT
@@ -149,10 +152,11 @@ std::pair<const char*, const char*> TableStorage::getTable(short file, int64_t m
 #endif
     }
     std::pair<uint64_t,uint64_t> coord = marks[file]->getPos(mark);
-    uint64_t realLen = (int) - 1;
-    const char *start = cache->getBuffer(file, coord.first, &realLen);
     const uint64_t len = coord.second - coord.first;
+    uint64_t realLen = len;
+    const char *start = cache->pinBuffer(file, coord.first, &realLen, pin);
     const char *end = start + len;
+    AccessLog::record(accessLogDir, file, coord.first, len);
     return make_pair(start, end);
 }
 
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+#include <trident/files/asyncwriter.h>
+
+#include <kognac/logs.h>
+
+AsyncWriter::AsyncWriter(std::string file) : file(file), pendingOffset(0),
+    busy(false), stop(false), failed(false) {
+        stream.open(file, std::ios_base::in | std::ios_base::out |
+                std::ios_base::binary);
+        if (!stream.good()) {
+            LOG(ERRORL) << "Cannot open " << file << " for writing";
+            throw 10;
+        }
+#ifdef MT
+        thread = std::thread(&AsyncWriter::run, this);
+#endif
+    }
+
+void AsyncWriter::write(const char *data, uint64_t size, uint64_t offset) {
+    stream.seekp(offset);
+    stream.write(data, size);
+    stream.flush();
+    if (!stream.good()) {
+        failed = true;
+    }
+}
+
+void AsyncWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cond.wait(lock, [this] { return busy || stop; });
+        if (busy) {
+            //The buffer is not touched by the caller until busy is false
+            lock.unlock();
+            write(pending.data(), pending.size(), pendingOffset);
+            lock.lock();
+            busy = false;
+            cond.notify_all();
+        } else {
+            break;
+        }
+    }
+}
+
+void AsyncWriter::write(std::vector<char> &buffer, uint64_t offset) {
+#ifndef MT
+    write(buffer.data(), buffer.size(), offset);
+    if (failed) {
+        LOG(ERRORL) << "Failed writing " << file;
+        throw 10;
+    }
+    return;
+#endif
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !busy; });
+    if (failed) {
+        LOG(ERRORL) << "Failed writing " << file;
+        throw 10;
+    }
+    pending.swap(buffer);
+    pendingOffset = offset;
+    busy = true;
+    cond.notify_all();
+}
+
+void AsyncWriter::drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !busy; });
+    if (failed) {
+        LOG(ERRORL) << "Failed writing " << file;
+        throw 10;
+    }
+}
+
+void AsyncWriter::writeAt(const char *data, uint64_t size, uint64_t offset) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return !busy; });
+    write(data, size, offset);
+    if (failed) {
+        LOG(ERRORL) << "Failed writing " << file;
+        throw 10;
+    }
+}
+
+AsyncWriter::~AsyncWriter() {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [this] { return !busy; });
+        stop = true;
+        cond.notify_all();
+    }
+#ifdef MT
+    thread.join();
+#endif
+    stream.close();
+    if (failed) {
+        LOG(ERRORL) << "Failed writing " << file;
+    }
+}
@@ -68,7 +68,8 @@ void FileDescriptor::mapFile(uint64_t requiredIncrement) {
 FileDescriptor::FileDescriptor(bool readOnly, int id, std::string file,
                                uint64_t fileMaxSize, MemoryManager<FileDescriptor> *tracker,
                                FileDescriptor **parents, Stats * const stats) :
-    filePath(file), readOnly(readOnly), id(id), parentArray(parents) {
+    filePath(file), readOnly(readOnly), id(id), parentArray(parents),
+    tailStart(0), asyncBufferSize(0) {
     this->tracker = tracker;
     memoryTrackerId = -1;
 
@@ -91,6 +92,27 @@ char* FileDescriptor::getBuffer(uint64_t offset, uint64_t *length) {
     if (*length > size - offset) {
         *length = size - offset;
     }
+    if (writer) {
+        return getWrittenBuffer(offset, *length);
+    }
+    return buffer + offset;
+}
+
+char *FileDescriptor::getWrittenBuffer(uint64_t offset, uint64_t length) {
+    if (offset >= tailStart) {
+        return tail.data() + (offset - tailStart);
+    }
+    if (offset + length > tailStart) {
+        //The range continues in the tail
+        handOff();
+    }
+    writer->drain();
+    if (mappedFile == NULL || mappedFile->getLength() < offset + length) {
+        mappedFile = NULL;
+        mappedFile = std::unique_ptr<MemoryMappedFile>(
+                new MemoryMappedFile(filePath, true, 0, tailStart));
+        buffer = mappedFile->getData();
+    }
     return buffer + offset;
 }
 
@@ -98,7 +120,73 @@ uint64_t FileDescriptor::getFileLength() {
     return size;
 }
 
+void FileDescriptor::startAsyncWrites(uint64_t bufferSize) {
+    if (readOnly || writer) {
+        return;
+    }
+    if (tracker) {
+        tracker->removeBlockWithoutDeallocation(memoryTrackerId);
+        tracker = NULL;
+        memoryTrackerId = -1;
+    }
+    buffer = NULL;
+    mappedFile = NULL;
+    //Remove the space that was reserved for the mapping
+    Utils::resizeFile(filePath, size);
+
+    tailStart = size;
+    asyncBufferSize = bufferSize;
+    tail.reserve(bufferSize);
+    writer = std::unique_ptr<AsyncWriter>(new AsyncWriter(filePath));
+}
+
+void FileDescriptor::handOff() {
+    if (size > tailStart) {
+        tail.resize(size - tailStart);
+        writer->write(tail, tailStart);
+        tailStart = size;
+    }
+}
+
+void FileDescriptor::flushAppends() {
+    if (writer) {
+        handOff();
+        writer->drain();
+    }
+}
+
+char *FileDescriptor::reserveAppend(const uint64_t n) {
+    if (writer) {
+        if (size - tailStart >= asyncBufferSize) {
+            handOff();
+        }
+        const uint64_t used = size - tailStart;
+        if (used + n > tail.size()) {
+            tail.resize(std::max(used + n, asyncBufferSize));
+        }
+        return tail.data() + used;
+    }
+    if (n + this->size > sizeFile) {
+        uint64_t increment = std::max(SMALLEST_INCR, std::max(n, (uint64_t) sizeFile));
+        mapFile(increment);
+    }
+    return buffer + size;
+}
+
 void FileDescriptor::shiftFile(uint64_t pos, uint64_t diff) {
+    if (writer) {
+        if (pos < tailStart) {
+            LOG(ERRORL) << "Cannot shift bytes that are already written";
+            throw 10;
+        }
+        if (size + diff - tailStart > tail.size()) {
+            tail.resize(size + diff - tailStart);
+        }
+        memmove(tail.data() + (pos + diff - tailStart),
+                tail.data() + (pos - tailStart), size - pos);
+        size += diff;
+        return;
+    }
     if (this->size + diff > sizeFile) {
         uint64_t increment = std::max(SMALLEST_INCR, std::max(diff, (uint64_t) sizeFile));
         mapFile(increment);
@@ -109,11 +197,7 @@ void FileDescriptor::shiftFile(uint64_t pos, uint64_t diff) {
 }
 
 void FileDescriptor::append(char *bytes, const uint64_t size) {
-    if (size + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) size, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    memcpy(buffer + this->size, bytes, size);
+    memcpy(reserveAppend(size), bytes, size);
     this->size += size;
 }
 
@@ -121,84 +205,77 @@ char* FileDescriptor::getBuffer(uint64_t offset, uint64_t *length,
                                 int &memoryBlock, const int sesID) {
     //sedID is used only by the comprfiledescriptor.
     memoryBlock = memoryTrackerId;
-    if (*length > size - offset) {
-        *length = size - offset;
-    }
-    return buffer + offset;
+    return getBuffer(offset, length);
 }
 
 uint64_t FileDescriptor::appendVLong(const int64_t v) {
-    if (8 + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) 8, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    const uint16_t bytesUsed = Utils::encode_vlong(buffer + size, v);
+    const uint16_t bytesUsed = Utils::encode_vlong(reserveAppend(8), v);
     this->size += bytesUsed;
     return this->size;
 }
 
 uint64_t FileDescriptor::appendVLong2(const int64_t v) {
-    if (8 + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) 8, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    const uint16_t nbytes = Utils::encode_vlong2(buffer + size, v);
+    const uint16_t nbytes = Utils::encode_vlong2(reserveAppend(8), v);
     this->size += nbytes;
     return this->size;
 }
 
 void FileDescriptor::appendLong(const int64_t v) {
-    if (8 + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) 8, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    Utils::encode_long(buffer + size, v);
+    Utils::encode_long(reserveAppend(8), v);
     this->size += 8;
 }
 
 void FileDescriptor::appendInt(const int64_t v) {
-    if (4 + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) 4, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    Utils::encode_int(buffer + size, v);
+    Utils::encode_int(reserveAppend(4), v);
     this->size += 4;
 }
 
 void FileDescriptor::appendShort(const int64_t v) {
-    if (2 + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t) 2, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    Utils::encode_short(buffer + size, v);
+    Utils::encode_short(reserveAppend(2), v);
     this->size += 2;
 }
 
 void FileDescriptor::appendLong(const uint8_t nbytes, const uint64_t v) {
-    if (nbytes + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t)nbytes,
-                                      (uint64_t) sizeFile));
-        mapFile(increment);
-    }
-    Utils::encode_longNBytes(buffer + size, nbytes, v);
+    Utils::encode_longNBytes(reserveAppend(nbytes), nbytes, v);
     this->size += nbytes;
 }
 
 
 void FileDescriptor::reserveBytes(const uint8_t n) {
-    if (n + this->size > sizeFile) {
-        uint64_t increment = std::max(SMALLEST_INCR, std::max((uint64_t)n, (uint64_t) sizeFile));
-        mapFile(increment);
-    }
+    //The tail may contain old bytes
+    memset(reserveAppend(n), 0, n);
     this->size += n;
 }
 
+void FileDescriptor::overwrite(uint64_t pos, const char *bytes,
+        const uint64_t n) {
+    //Only the bytes still in the tail can be changed in memory
+    const uint64_t inFile = pos < tailStart ? std::min(n, tailStart - pos) : 0;
+    if (inFile > 0) {
+        writer->writeAt(bytes, inFile, pos);
+    }
+    if (inFile < n) {
+        memcpy(tail.data() + (pos + inFile - tailStart), bytes + inFile,
+                n - inFile);
+    }
+}
+
 void FileDescriptor::overwriteAt(uint64_t pos, char byte) {
-    buffer[pos] = byte;
+    if (writer) {
+        overwrite(pos, &byte, 1);
+    } else {
+        buffer[pos] = byte;
+    }
 }
 
 void FileDescriptor::overwriteVLong2At(uint64_t pos, int64_t number) {
-    Utils::encode_vlong2(buffer + pos, number);
+    if (writer) {
+        char tmp[16];
+        const uint16_t nbytes = Utils::encode_vlong2(tmp, number);
+        overwrite(pos, tmp, nbytes);
+    } else {
+        Utils::encode_vlong2(buffer + pos, number);
+    }
 }
 
 bool FileDescriptor::isUsed() {
@@ -217,6 +294,18 @@ FileDescriptor::~FileDescriptor() {
         tracker->removeBlockWithoutDeallocation(memoryTrackerId);
     }
 
+    if (writer) {
+        try {
+            handOff();
+        } catch (int e) {
+            LOG(ERRORL) << "The last bytes of " << filePath << " are lost";
+        }
+        writer = NULL;
+        //The file has exactly the written bytes
+        mappedFile = NULL;
+        sizeFile = size;
+    }
+
     buffer = NULL;
     if (mappedFile != NULL) {
         mappedFile->flushAll();
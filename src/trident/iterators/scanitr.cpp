@@ -236,6 +236,19 @@ bool ScanItr::next(int64_t &v1, int64_t &v2, int64_t &v3) {
     return hasNext;
 }
 
+size_t ScanItr::nextBlock(int64_t *v1, int64_t *v2, const size_t n) {
+    if (n == 0 || !hasNext()) {
+        return 0;
+    }
+    //next() opens the table of the following key, if necessary. The rest of
+    //the block is read from the same table so that the key does not change
+    next();
+    v1[0] = getValue1();
+    v2[0] = getValue2();
+    PairItr *table = reversedItr ? reversedItr : currentTable;
+    return 1 + table->nextBlock(v1 + 1, v2 + 1, n - 1);
+}
+
 void ScanItr::clear() {
     if (currentTable)
         q->releaseItr(currentTable);
@@ -0,0 +1,355 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+#include <trident/kb/charsets.h>
+#include <trident/kb/querier.h>
+#include <trident/kb/consts.h>
+#include <trident/iterators/pairitr.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <algorithm>
+
+CharacteristicSets::CharacteristicSets(std::string file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.good()) {
+        LOG(ERRORL) << "Cannot open the characteristic sets in " << file;
+        throw 10;
+    }
+    char flag = 0;
+    in.read(&flag, 1);
+    objects = flag != 0;
+    uint64_t nsets = 0;
+    in.read((char*) &nsets, sizeof(uint64_t));
+    for (uint64_t i = 0; i < nsets && in.good(); ++i) {
+        uint64_t npredicates = 0;
+        in.read((char*) &npredicates, sizeof(uint64_t));
+        std::vector<int64_t> predicates(npredicates);
+        Set set;
+        set.ntriples.resize(npredicates);
+        for (uint64_t j = 0; j < npredicates; ++j) {
+            in.read((char*) &predicates[j], sizeof(int64_t));
+            in.read((char*) &set.ntriples[j], sizeof(int64_t));
+        }
+        in.read((char*) &set.nsubjects, sizeof(int64_t));
+        const Sets::value_type &entry = *sets.insert(
+                std::make_pair(predicates, set)).first;
+        for (uint64_t j = 0; j < npredicates; ++j) {
+            index[predicates[j]].push_back(&entry);
+        }
+    }
+    uint64_t nchains = 0;
+    in.read((char*) &nchains, sizeof(uint64_t));
+    for (uint64_t i = 0; i < nchains && in.good(); ++i) {
+        int64_t values[3];
+        in.read((char*) values, sizeof(int64_t) * 3);
+        chains[std::make_pair(values[0], values[1])] = values[2];
+    }
+    if (!in.good()) {
+        LOG(ERRORL) << "The characteristic sets in " << file << " are corrupted";
+        throw 10;
+    }
+}
+
+bool CharacteristicSets::exists(std::string file) {
+    return Utils::exists(file);
+}
+
+void CharacteristicSets::add(const Profile &profile, const int64_t sign) {
+    //Entities that are never subjects are in no set and in no chain
+    if (profile.out.empty()) {
+        return;
+    }
+    std::vector<int64_t> predicates;
+    for (size_t i = 0; i < profile.out.size(); ++i) {
+        predicates.push_back(profile.out[i].first);
+    }
+    Sets::iterator itr = sets.find(predicates);
+    if (itr == sets.end()) {
+        Set set;
+        set.nsubjects = 0;
+        set.ntriples.resize(predicates.size(), 0);
+        itr = sets.insert(std::make_pair(predicates, set)).first;
+        for (size_t i = 0; i < predicates.size(); ++i) {
+            index[predicates[i]].push_back(&(*itr));
+        }
+    }
+    //The empty sets are kept because the index points to them
+    Set &set = itr->second;
+    set.nsubjects += sign;
+    for (size_t i = 0; i < profile.out.size(); ++i) {
+        set.ntriples[i] += sign * profile.out[i].second;
+    }
+
+    for (size_t i = 0; i < profile.in.size(); ++i) {
+        for (size_t j = 0; j < profile.out.size(); ++j) {
+            chains[std::make_pair(profile.in[i].first, profile.out[j].first)] +=
+                sign * profile.in[i].second * profile.out[j].second;
+        }
+    }
+}
+
+void CharacteristicSets::readGroup(PairItr *itr, bool &valid, int64_t &key,
+        std::vector<std::pair<int64_t, int64_t>> &predicates) {
+    //The predicates are the second column of SPO and OPS, so they are sorted
+    predicates.clear();
+    key = itr->getKey();
+    while (valid && itr->getKey() == key) {
+        const int64_t p = itr->getValue1();
+        if (!predicates.empty() && predicates.back().first == p) {
+            predicates.back().second++;
+        } else {
+            predicates.push_back(std::make_pair(p, 1));
+        }
+        valid = itr->hasNext();
+        if (valid) {
+            itr->next();
+        }
+    }
+}
+
+void CharacteristicSets::build(Querier *q, const bool objects) {
+    this->objects = objects;
+    PairItr *spo = q->get(IDX_SPO, -1, -1, -1);
+    PairItr *ops = objects ? q->get(IDX_OPS, -1, -1, -1) : NULL;
+    bool validOut = spo->hasNext();
+    if (validOut) {
+        spo->next();
+    }
+    bool validIn = ops != NULL && ops->hasNext();
+    if (validIn) {
+        ops->next();
+    }
+
+    //Merge the two scans on the entity
+    std::vector<std::pair<int64_t, int64_t>> out, in;
+    int64_t keyOut = -1, keyIn = -1;
+    bool hasOut = false, hasIn = false;
+    Profile profile;
+    while (true) {
+        if (!hasOut && validOut) {
+            readGroup(spo, validOut, keyOut, out);
+            hasOut = true;
+        }
+        if (!hasIn && validIn) {
+            readGroup(ops, validIn, keyIn, in);
+            hasIn = true;
+        }
+        if (!hasOut && !hasIn) {
+            break;
+        }
+        int64_t entity;
+        if (hasOut && hasIn) {
+            entity = std::min(keyOut, keyIn);
+        } else {
+            entity = hasOut ? keyOut : keyIn;
+        }
+        profile.out.clear();
+        profile.in.clear();
+        if (hasOut && keyOut == entity) {
+            profile.out.swap(out);
+            hasOut = false;
+        }
+        if (hasIn && keyIn == entity) {
+            profile.in.swap(in);
+            hasIn = false;
+        }
+        add(profile, 1);
+    }
+    q->releaseItr(spo);
+    if (ops != NULL) {
+        q->releaseItr(ops);
+    }
+}
+
+void CharacteristicSets::getProfile(Querier *q, const int64_t entity,
+        const bool objects, Profile &profile) {
+    profile.out.clear();
+    profile.in.clear();
+    for (int i = 0; i < (objects ? 2 : 1); ++i) {
+        std::vector<std::pair<int64_t, int64_t>> &counts = i == 0 ?
+            profile.out : profile.in;
+        PairItr *itr = i == 0 ? q->get(IDX_SPO, entity, -1, -1) :
+            q->get(IDX_OPS, -1, -1, entity);
+        while (itr->hasNext()) {
+            itr->next();
+            const int64_t p = itr->getValue1();
+            if (!counts.empty() && counts.back().first == p) {
+                counts.back().second++;
+            } else {
+                counts.push_back(std::make_pair(p, 1));
+            }
+        }
+        q->releaseItr(itr);
+    }
+}
+
+void CharacteristicSets::revert(std::vector<std::pair<int64_t, int64_t>> &counts,
+        const int64_t p, const int64_t sign) {
+    std::vector<std::pair<int64_t, int64_t>>::iterator itr =
+        std::lower_bound(counts.begin(), counts.end(),
+                std::make_pair(p, (int64_t) 0));
+    if (itr == counts.end() || itr->first != p) {
+        itr = counts.insert(itr, std::make_pair(p, (int64_t) 0));
+    }
+    itr->second -= sign;
+    if (itr->second == 0) {
+        counts.erase(itr);
+    }
+}
+
+void CharacteristicSets::update(Querier *q, std::vector<Change> &changes) {
+    //Every entity of the changes moves from its profile before them to the
+    //current one. The first is the current one without the changes
+    std::vector<Change> byObject(changes);
+    std::sort(changes.begin(), changes.end(), [](const Change &a,
+                const Change &b) { return a.s < b.s; });
+    std::sort(byObject.begin(), byObject.end(), [](const Change &a,
+                const Change &b) { return a.o < b.o; });
+    std::vector<int64_t> entities;
+    for (size_t i = 0; i < changes.size(); ++i) {
+        entities.push_back(changes[i].s);
+        if (objects) {
+            entities.push_back(changes[i].o);
+        }
+    }
+    std::sort(entities.begin(), entities.end());
+    entities.erase(std::unique(entities.begin(), entities.end()),
+            entities.end());
+
+    Profile after, before;
+    size_t posS = 0, posO = 0;
+    for (size_t i = 0; i < entities.size(); ++i) {
+        const int64_t entity = entities[i];
+        getProfile(q, entity, objects, after);
+        before = after;
+        for (; posS < changes.size() && changes[posS].s <= entity; ++posS) {
+            if (changes[posS].s == entity) {
+                revert(before.out, changes[posS].p, changes[posS].sign);
+            }
+        }
+        if (objects) {
+            for (; posO < byObject.size() && byObject[posO].o <= entity;
+                    ++posO) {
+                if (byObject[posO].o == entity) {
+                    revert(before.in, byObject[posO].p, byObject[posO].sign);
+                }
+            }
+        }
+        add(before, -1);
+        add(after, 1);
+    }
+}
+
+double CharacteristicSets::estimateStar(
+        const std::vector<int64_t> &predicates) const {
+    //Read only the sets of the rarest predicate
+    const std::vector<const Sets::value_type*> *candidates = NULL;
+    for (size_t i = 0; i < predicates.size(); ++i) {
+        auto itr = index.find(predicates[i]);
+        if (itr == index.end()) {
+            return 0;
+        }
+        if (candidates == NULL || itr->second.size() < candidates->size()) {
+            candidates = &itr->second;
+        }
+    }
+    if (candidates == NULL) {
+        return 0;
+    }
+
+    //Every subject of a set has, on average, ntriples / nsubjects triples of
+    //each predicate
+    double output = 0;
+    for (size_t i = 0; i < candidates->size(); ++i) {
+        const std::vector<int64_t> &setPredicates = (*candidates)[i]->first;
+        const Set &set = (*candidates)[i]->second;
+        if (set.nsubjects <= 0) {
+            continue;
+        }
+        double card = set.nsubjects;
+        for (size_t j = 0; j < predicates.size() && card > 0; ++j) {
+            std::vector<int64_t>::const_iterator pos = std::lower_bound(
+                    setPredicates.begin(), setPredicates.end(), predicates[j]);
+            if (pos == setPredicates.end() || *pos != predicates[j]) {
+                card = 0;
+            } else {
+                card *= (double) set.ntriples[pos - setPredicates.begin()] /
+                    set.nsubjects;
+            }
+        }
+        output += card;
+    }
+    return output;
+}
+
+int64_t CharacteristicSets::getChainCount(const int64_t p1,
+        const int64_t p2) const {
+    auto itr = chains.find(std::make_pair(p1, p2));
+    return itr == chains.end() ? 0 : itr->second;
+}
+
+void CharacteristicSets::store(std::string file) const {
+    std::ofstream out(file, std::ios::binary);
+    const char flag = objects ? 1 : 0;
+    out.write(&flag, 1);
+    uint64_t nsets = 0;
+    for (Sets::const_iterator itr = sets.begin(); itr != sets.end(); ++itr) {
+        if (itr->second.nsubjects > 0) {
+            nsets++;
+        }
+    }
+    out.write((const char*) &nsets, sizeof(uint64_t));
+    for (Sets::const_iterator itr = sets.begin(); itr != sets.end(); ++itr) {
+        if (itr->second.nsubjects <= 0) {
+            continue;
+        }
+        const uint64_t npredicates = itr->first.size();
+        out.write((const char*) &npredicates, sizeof(uint64_t));
+        for (uint64_t j = 0; j < npredicates; ++j) {
+            out.write((const char*) &itr->first[j], sizeof(int64_t));
+            out.write((const char*) &itr->second.ntriples[j], sizeof(int64_t));
+        }
+        out.write((const char*) &itr->second.nsubjects, sizeof(int64_t));
+    }
+    uint64_t nchains = 0;
+    for (auto itr = chains.begin(); itr != chains.end(); ++itr) {
+        if (itr->second > 0) {
+            nchains++;
+        }
+    }
+    out.write((const char*) &nchains, sizeof(uint64_t));
+    for (auto itr = chains.begin(); itr != chains.end(); ++itr) {
+        if (itr->second <= 0) {
+            continue;
+        }
+        const int64_t values[3] = { itr->first.first, itr->first.second,
+            itr->second };
+        out.write((const char*) values, sizeof(int64_t) * 3);
+    }
+    if (!out.good()) {
+        LOG(ERRORL) << "Error while writing the characteristic sets in " << file;
+        throw 10;
+    }
+}
@@ -0,0 +1,462 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#include <trident/kb/compactor.h>
+#include <trident/kb/kb.h>
+#include <trident/kb/querier.h>
+#include <trident/kb/dictmgmt.h>
+#include <trident/kb/searchindex.h>
+#include <trident/kb/membershipfilter.h>
+#include <trident/kb/charsets.h>
+#include <trident/iterators/pairitr.h>
+#include <trident/loader.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <algorithm>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#endif
+
+//The entries of <kbdir> that do not belong to generation 0
+const std::vector<std::string> Compactor::SHARED_ENTRIES = { "_gen",
+    "_current", "_current.tmp", "_lock", "_compact" };
+
+static bool isNumber(const std::string &s) {
+    return !s.empty() && std::find_if(s.begin(), s.end(), [](char c) {
+            return !isdigit(c);
+            }) == s.end();
+}
+
+Compactor::FileLock::FileLock(std::string file, bool exclusive, bool wait,
+        bool create) : locked(false) {
+#if defined(_WIN32)
+    //The files of a generation can be removed while they are locked
+    handle = CreateFile(file.c_str(),
+            create ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+            create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) {
+        if (!create) {
+            return;
+        }
+        LOG(ERRORL) << "Failed opening " << file;
+        throw 10;
+    }
+    OVERLAPPED ov = {};
+    DWORD flags = (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0) |
+        (wait ? 0 : LOCKFILE_FAIL_IMMEDIATELY);
+    locked = LockFileEx(handle, flags, 0, 1, 0, &ov);
+#else
+    fd = create ? ::open(file.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR) :
+        ::open(file.c_str(), O_RDONLY);
+    if (fd == -1) {
+        if (!create) {
+            return;
+        }
+        LOG(ERRORL) << "Failed opening " << file;
+        throw 10;
+    }
+    //Every open file has its own lock, so it works also between threads
+    locked = flock(fd, (exclusive ? LOCK_EX : LOCK_SH) |
+            (wait ? 0 : LOCK_NB)) == 0;
+#endif
+    if (!locked && wait) {
+#if defined(_WIN32)
+        CloseHandle(handle);
+#else
+        ::close(fd);
+#endif
+        LOG(ERRORL) << "Failed locking " << file;
+        throw 10;
+    }
+}
+
+Compactor::FileLock::~FileLock() {
+#if defined(_WIN32)
+    if (handle == INVALID_HANDLE_VALUE) {
+        return;
+    }
+    if (locked) {
+        OVERLAPPED ov = {};
+        UnlockFileEx(handle, 0, 1, 0, &ov);
+    }
+    CloseHandle(handle);
+#else
+    if (fd == -1) {
+        return;
+    }
+    if (locked) {
+        flock(fd, LOCK_UN);
+    }
+    ::close(fd);
+#endif
+}
+
+Compactor::UpdateLock::UpdateLock(std::string kbdir) :
+    FileLock(kbdir + DIR_SEP + "_lock", true, true) {
+    }
+
+Compactor::ReaderLock::ReaderLock(std::string kbdir) : kbdir(kbdir) {
+    while (true) {
+        gen = getGeneration(kbdir);
+        lock = std::unique_ptr<FileLock>(new FileLock(getGenerationDir(kbdir,
+                        gen) + DIR_SEP + "kbstats", false, true, false));
+        if (getGeneration(kbdir) == gen) {
+            break;
+        }
+        //A new generation was committed before the lock, so the old one
+        //might be already removed
+    }
+}
+
+Compactor::ReaderLock::~ReaderLock() {
+    lock.reset();
+    if (getGeneration(kbdir) == gen) {
+        return;
+    }
+    try {
+        removeUnusedGenerations(kbdir);
+    } catch (...) {
+        LOG(WARNL) << "Failed removing the old generations of " << kbdir;
+    }
+}
+
+Compactor::Compactor(std::string kbdir, KBConfig &config,
+        uint32_t minDiffs, uint32_t intervalSec, int nthreads) :
+    kbdir(kbdir), config(config), minDiffs(minDiffs),
+    intervalSec(intervalSec), nthreads(nthreads), stopped(true) {
+        current = openCurrentGeneration();
+    }
+
+std::shared_ptr<KB> Compactor::openCurrentGeneration() {
+    const std::string dir = kbdir;
+    //No update is half-written while the KB reads the diffs
+    UpdateLock lock(dir);
+    //The KB constructor opens the current generation. It removes it when
+    //it is closed, if it is no longer current nor used by others
+    return std::shared_ptr<KB>(new KB(dir.c_str(), true, false, true,
+                config));
+}
+
+std::shared_ptr<KB> Compactor::getKB() {
+    std::lock_guard<std::mutex> lock(currentMutex);
+    return current;
+}
+
+bool Compactor::compactNow() {
+    std::shared_ptr<KB> kb = getKB();
+    const size_t ndiffs = countDiffs(kb->getPath());
+    if (ndiffs < std::max((uint32_t) 1, minDiffs)) {
+        return false;
+    }
+    if (kb->getNDiffIndices() != ndiffs ||
+            kb->getPath() != getGenerationPath(kbdir)) {
+        //Other processes changed the KB after it was opened
+        kb = openCurrentGeneration();
+        std::lock_guard<std::mutex> lock(currentMutex);
+        current = kb;
+    }
+    if (compact(*kb.get(), kbdir, nthreads) == "") {
+        return false;
+    }
+    std::shared_ptr<KB> newkb = openCurrentGeneration();
+    {
+        std::lock_guard<std::mutex> lock(currentMutex);
+        current = newkb;
+    }
+    LOG(INFOL) << "Switched to generation " << getGeneration(kbdir) <<
+        ". The previous one is removed when it is no longer used";
+    return true;
+}
+
+void Compactor::run() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopped) {
+        stopCond.wait_for(lock, std::chrono::seconds(intervalSec));
+        if (stopped) {
+            break;
+        }
+        lock.unlock();
+        try {
+            compactNow();
+        } catch (...) {
+            LOG(ERRORL) << "The compaction failed. I will retry later";
+        }
+        lock.lock();
+    }
+}
+
+void Compactor::start() {
+    std::lock_guard<std::mutex> lock(stopMutex);
+    if (!stopped) {
+        return;
+    }
+    stopped = false;
+    worker = std::thread(&Compactor::run, this);
+}
+
+void Compactor::stop() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopped = true;
+    }
+    stopCond.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+Compactor::~Compactor() {
+    stop();
+}
+
+std::string Compactor::getGenerationDir(std::string kbdir, uint64_t gen) {
+    if (gen == 0) {
+        return kbdir;
+    }
+    return kbdir + DIR_SEP + "_gen" + DIR_SEP + to_string(gen);
+}
+
+uint64_t Compactor::getGeneration(std::string kbdir) {
+    std::string file = kbdir + DIR_SEP + "_current";
+    if (!Utils::exists(file)) {
+        return 0;
+    }
+    std::ifstream ifs(file);
+    uint64_t gen = 0;
+    ifs >> gen;
+    return gen;
+}
+
+std::string Compactor::getGenerationPath(std::string kbdir) {
+    return getGenerationDir(kbdir, getGeneration(kbdir));
+}
+
+void Compactor::setGeneration(std::string kbdir, uint64_t gen) {
+    //Write a new file and rename it, so that readers never see a partial one
+    std::string file = kbdir + DIR_SEP + "_current";
+    std::string tmpfile = file + ".tmp";
+    {
+        std::ofstream ofs(tmpfile, std::ios_base::trunc);
+        ofs << gen << std::endl;
+    }
+    if (std::rename(tmpfile.c_str(), file.c_str()) != 0) {
+        LOG(ERRORL) << "Error renaming " << tmpfile;
+        throw 10;
+    }
+}
+
+size_t Compactor::countDiffs(std::string genpath) {
+    std::string diffdir = genpath + DIR_SEP + "_diff";
+    if (!Utils::exists(diffdir)) {
+        return 0;
+    }
+    size_t count = 0;
+    for (auto f : Utils::getSubdirs(diffdir)) {
+        if (isNumber(Utils::filename(f))) {
+            count++;
+        }
+    }
+    return count;
+}
+
+std::string Compactor::compact(KB &kb, std::string kbdir, int nthreads) {
+    //Another compaction (e.g., of the server and of the command line) would
+    //remove the directories of this one as leftovers
+    FileLock compactLock(kbdir + DIR_SEP + "_compact", true, false);
+    if (!compactLock.isLocked()) {
+        LOG(WARNL) << "Another compaction of the KB is running";
+        return "";
+    }
+    const std::string oldpath = kb.getPath();
+    size_t ndiffs;
+    {
+        UpdateLock lock(kbdir);
+        ndiffs = countDiffs(oldpath);
+        if (oldpath != getGenerationPath(kbdir) ||
+                kb.getNDiffIndices() != ndiffs) {
+            LOG(WARNL) << "The KB does not contain the last updates. Open it "
+                "again before the compaction";
+            return "";
+        }
+    }
+    if (ndiffs == 0) {
+        LOG(INFOL) << "There are no updates to compact";
+        return "";
+    }
+    if (kb.getDictMgmt() == NULL || kb.areRelIDsSeparated() ||
+            kb.getGraphType() != GraphType::DEFAULT) {
+        LOG(WARNL) << "The compaction is supported only for RDF KBs with "
+            "one dictionary. Use 'merge' instead";
+        return "";
+    }
+
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    const uint64_t newgen = getGeneration(kbdir) + 1;
+    const std::string newdir = getGenerationDir(kbdir, newgen);
+    const std::string exportdir = newdir + ".export";
+    const std::string tmpdir = newdir + ".tmp";
+    //Leftovers of an interrupted compaction. No other compaction is running
+    for (auto dir : { newdir, exportdir, tmpdir }) {
+        if (Utils::exists(dir)) {
+            Utils::remove_all(dir);
+        }
+    }
+    Utils::create_directories(exportdir);
+
+    try {
+        //Export the current content (base tables plus all diffs) with the
+        //same IDs, so that they can be loaded as an already compressed input
+        LOG(INFOL) << "Compacting " << ndiffs << " updates into generation " << newgen;
+        {
+            std::ofstream out(exportdir + DIR_SEP + "triples");
+            Querier *q = kb.query();
+            PairItr *itr = q->get(IDX_SPO, -1, -1, -1);
+            while (itr->hasNext()) {
+                itr->next();
+                out << itr->getKey() << ' ' << itr->getValue1() << ' ' <<
+                    itr->getValue2() << '\n';
+            }
+            q->releaseItr(itr);
+            delete q;
+        }
+        {
+            std::ofstream out(exportdir + DIR_SEP + "dict");
+            kb.getDictMgmt()->exportTerms(out);
+        }
+
+        ParamsLoad p;
+        p.inputCompressed = true;
+        p.triplesInputDir = exportdir + DIR_SEP + "triples";
+        p.dictDir = exportdir + DIR_SEP + "dict";
+        p.kbDir = newdir;
+        p.tmpDir = tmpdir;
+        p.nindices = kb.getNIndices();
+        p.aggrIndices = kb.areIndicesAggregated();
+        p.parallelThreads = nthreads;
+        p.maxReadingThreads = std::min(nthreads, p.maxReadingThreads);
+        p.sample = Utils::exists(oldpath + DIR_SEP + "_sample");
+        p.searchIndex = SearchIndex::exists(oldpath + DIR_SEP + "_search");
+        p.membershipFilter = MembershipFilter::exists(oldpath + DIR_SEP + "_filter");
+        p.characteristicSets = CharacteristicSets::exists(oldpath + DIR_SEP + "_charsets");
+        p.flatTree = Utils::exists(oldpath + DIR_SEP + "tree" + DIR_SEP + "flat");
+        Loader loader;
+        loader.load(p);
+    } catch (...) {
+        for (auto dir : { newdir, exportdir, tmpdir }) {
+            if (Utils::exists(dir)) {
+                Utils::remove_all(dir);
+            }
+        }
+        throw;
+    }
+    Utils::remove_all(exportdir);
+    if (Utils::exists(tmpdir)) {
+        Utils::remove_all(tmpdir);
+    }
+
+    //Updates that arrived in the meantime are not in the new generation.
+    //The lock makes the check and the commit atomic for the updaters
+    {
+        UpdateLock lock(kbdir);
+        if (countDiffs(oldpath) != ndiffs ||
+                getGenerationPath(kbdir) != oldpath) {
+            LOG(WARNL) << "New updates arrived during the compaction. I "
+                "discard generation " << newgen;
+            if (getGeneration(kbdir) != newgen) {
+                Utils::remove_all(newdir);
+            }
+            return "";
+        }
+        setGeneration(kbdir, newgen);
+    }
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Generation " << newgen << " is ready. Time compaction = " <<
+        sec.count() * 1000 << " ms.";
+    return newdir;
+}
+
+void Compactor::removeGeneration(std::string kbdir, uint64_t gen) {
+    LOG(DEBUGL) << "Removing generation " << gen;
+    if (gen != 0) {
+        Utils::remove_all(getGenerationDir(kbdir, gen));
+        return;
+    }
+    //The first generation shares the directory with the others. Everything
+    //else in the directory belongs to it (tables, dictionaries, diffs and
+    //the optional structures like _sample, _filter or _charsets)
+    std::vector<std::string> entries = Utils::getSubdirs(kbdir);
+    for (auto f : Utils::getFiles(kbdir)) {
+        entries.push_back(f);
+    }
+    for (auto path : entries) {
+        const std::string e = Utils::filename(path);
+        if (std::find(SHARED_ENTRIES.begin(), SHARED_ENTRIES.end(), e) !=
+                SHARED_ENTRIES.end() || !Utils::exists(path)) {
+            continue;
+        }
+        if (Utils::isDirectory(path)) {
+            Utils::remove_all(path);
+        } else {
+            Utils::remove(path);
+        }
+    }
+}
+
+void Compactor::removeUnusedGenerations(std::string kbdir) {
+    const uint64_t current = getGeneration(kbdir);
+    std::vector<uint64_t> gens;
+    if (current > 0 && Utils::exists(kbdir + DIR_SEP + "kbstats")) {
+        gens.push_back(0);
+    }
+    const std::string gendir = kbdir + DIR_SEP + "_gen";
+    if (Utils::exists(gendir)) {
+        for (auto f : Utils::getSubdirs(gendir)) {
+            const std::string fn = Utils::filename(f);
+            //The newer ones are being built by a compaction
+            if (isNumber(fn) && std::stoull(fn) < current) {
+                gens.push_back(std::stoull(fn));
+            }
+        }
+    }
+    for (auto gen : gens) {
+        //The readers hold a shared lock on the kbstats of their generation
+        const std::string stats = getGenerationDir(kbdir, gen) + DIR_SEP +
+            "kbstats";
+        FileLock lock(stats, true, false, false);
+        if (lock.isLocked() || !Utils::exists(stats)) {
+            removeGeneration(kbdir, gen);
+        }
+    }
+}
@@ -32,6 +32,7 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 
 using namespace std;
 
@@ -136,15 +137,27 @@ bool DictMgmt::getTextRel(nTerm key, char *value, int &size) {
     }
 }
 
+void DictMgmt::setTermCacheSize(int64_t bytes) {
+    if (bytes > 0) {
+        termCache = std::unique_ptr<TermCache>(new TermCache(bytes));
+    } else {
+        termCache = std::unique_ptr<TermCache>();
+    }
+}
+
 bool DictMgmt::getText(nTerm key, char *value) {
     int64_t coordinates;
-    int idx = 0;
-    while (idx < beginrange.size() - 1 && key >= beginrange[idx + 1]) {
-        idx++;
+    int size = 0;
+    if (termCache && termCache->get(key, value, size)) {
+        value[size] = '\0';
+        return true;
     }
+    const int idx = getDictIdx(key);
     if (dictionaries[idx].invdict->get(key, coordinates)) {
-        int size = 0;
         dictionaries[idx].sb->get(coordinates, value, size);
+        if (termCache) {
+            termCache->put(key, value, size);
+        }
         value[size] = '\0';
         return true;
     }
@@ -162,14 +175,18 @@ bool DictMgmt::getText(nTerm key, char *value) {
 
 bool DictMgmt::getText(nTerm key, std::string &value) {
     int64_t coordinates;
-    int idx = 0;
-    while (idx < beginrange.size() - 1 && key >= beginrange[idx + 1]) {
-        idx++;
+    if (termCache && termCache->get(key, value)) {
+        return true;
     }
+    const int idx = getDictIdx(key);
     if (dictionaries[idx].invdict->get(key, coordinates)) {
         int size = 0;
-        char *rawvalue = dictionaries[idx].sb->get(coordinates, size);
-        value = std::string(rawvalue, size);
+        value.resize(MAX_TERM_SIZE);
+        dictionaries[idx].sb->get(coordinates, &value[0], size);
+        value.resize(size);
+        if (termCache) {
+            termCache->put(key, value.c_str(), size);
+        }
         return true;
     }
     if (!gud_idtext.empty()) {
@@ -185,12 +202,15 @@ bool DictMgmt::getText(nTerm key, std::string &value) {
 
 bool DictMgmt::getText(nTerm key, char *value, int &size) {
     int64_t coordinates;
-    int idx = 0;
-    while (idx < beginrange.size() - 1 && key >= beginrange[idx + 1]) {
-        idx++;
+    if (termCache && termCache->get(key, value, size)) {
+        return true;
     }
+    const int idx = getDictIdx(key);
     if (dictionaries[idx].invdict->get(key, coordinates)) {
         dictionaries[idx].sb->get(coordinates, value, size);
+        if (termCache) {
+            termCache->put(key, value, size);
+        }
         return true;
     }
     if (!gud_idtext.empty()) {
@@ -204,6 +224,84 @@ bool DictMgmt::getText(nTerm key, char *value, int &size) {
     return false;
 }
 
+void DictMgmt::exportTerms(std::ostream &out) {
+    std::unique_ptr<char[]> buffer(new char[MAX_TERM_SIZE]);
+    for (size_t i = 0; i < dictionaries.size(); ++i) {
+        TreeItr *itr = dictionaries[i].invdict->itr();
+        while (itr->hasNext()) {
+            int64_t coordinates;
+            nTerm key = itr->next(coordinates);
+            int size;
+            dictionaries[i].sb->get(coordinates, buffer.get(), size);
+            out << key << " " << size << " ";
+            out.write(buffer.get(), size);
+            out << '\n';
+        }
+        delete itr;
+    }
+    for (auto it = gud_idtext.begin(); it != gud_idtext.end(); ++it) {
+        out << it->first << " " << it->second.size() << " " << it->second << '\n';
+    }
+}
+
+void DictMgmt::getTexts(const std::vector<nTerm> &keys,
+        std::vector<std::string> &values,
+        std::vector<bool> &found) {
+    values.resize(keys.size());
+    found.assign(keys.size(), false);
+
+    //Look up the coordinates in key order, to visit the tree sequentially
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+            return keys[a] < keys[b];
+            });
+
+    struct TermRequest {
+        int dict;
+        int64_t coordinates;
+        size_t pos;
+    };
+    std::vector<TermRequest> requests;
+    for (auto i : order) {
+        const nTerm key = keys[i];
+        if (termCache && termCache->get(key, values[i])) {
+            found[i] = true;
+            continue;
+        }
+        TermRequest r;
+        r.dict = getDictIdx(key);
+        r.pos = i;
+        if (dictionaries[r.dict].invdict->get(key, r.coordinates)) {
+            requests.push_back(r);
+        } else if (!gud_idtext.empty()) {
+            auto it = gud_idtext.find(key);
+            if (it != gud_idtext.end()) {
+                values[i] = it->second;
+                found[i] = true;
+            }
+        }
+    }
+
+    std::sort(requests.begin(), requests.end(),
+            [](const TermRequest &a, const TermRequest &b) {
+            return a.dict < b.dict || (a.dict == b.dict &&
+                    a.coordinates < b.coordinates);
+            });
+    std::unique_ptr<char[]> buffer(new char[MAX_TERM_SIZE]);
+    for (const auto &r : requests) {
+        int size = 0;
+        dictionaries[r.dict].sb->get(r.coordinates, buffer.get(), size);
+        values[r.pos].assign(buffer.get(), size);
+        found[r.pos] = true;
+        if (termCache) {
+            termCache->put(keys[r.pos], buffer.get(), size);
+        }
+    }
+}
+
 void DictMgmt::getTextFromCoordinates(int64_t coordinates, char *output,
         int &sizeOutput) {
     dictionaries[0].sb->get(coordinates, output, sizeOutput);
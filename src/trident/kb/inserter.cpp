@@ -174,6 +174,9 @@ void Inserter::writeCurrentEntryIntoTree(int permutation,
             case NEWCLUSTER_ITR:
                 ncluFactory[permutation].release((NewClusterTableInserter *) (currentPairHandler[permutation]));
                 break;
+            case FORCOLUMN_ITR:
+                forFactory[permutation].release((FORColumnTableInserter *) (currentPairHandler[permutation]));
+                break;
         }
 
         int64_t nels;
@@ -221,6 +224,7 @@ void Inserter::storeInmemoryValuesIntoFiles(int permutation, int64_t* v1, int64_
             strat = StorageStrat::determineStrategy(v1, v2, n, nTerms,
                     thresholdForColumnStorage,
                     useRowForLargeTables,
+                    useFORColumnStorage,
                     stats[permutation]);
         }
     }
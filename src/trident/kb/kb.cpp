@@ -23,6 +23,7 @@
 #include <trident/kb/memoryopt.h>
 #include <trident/kb/kb.h>
 #include <trident/kb/querier.h>
+#include <trident/kb/compactor.h>
 #include <trident/kb/inserter.h>
 #include <trident/kb/consts.h>
 #include <trident/kb/kbconfig.h>
@@ -52,8 +53,13 @@ KB::KB(const char *path,
         bool dictEnabled,
         KBConfig &config,
         std::vector<string> locationUpdates) :
-    path(path), readOnly(readOnly), isClosed(false), ntables(), nFirstTables(),
+    readerLock(readOnly ? new Compactor::ReaderLock(path) : NULL),
+    path(readerLock ? readerLock->getPath() :
+            Compactor::getGenerationPath(path)), readOnly(readOnly),
+    isClosed(false), ntables(), nFirstTables(),
     dictEnabled(dictEnabled), config(config) {
+        //Open the current generation, if the updates were compacted
+        path = this->path.c_str();
 
         if (readOnly && !Utils::exists(string(path) + DIR_SEP + "tree")) {
             LOG(ERRORL) << "The input path does not seem to be a valid KB";
@@ -176,6 +182,7 @@ KB::KB(const char *path,
                 Utils::get_max_mem() << " MB occupied";
             dictManager = new DictMgmt(*maindict.get(), string(path) + DIR_SEP + "_diff",
                     dictHash, string(path) + DIR_SEP + "e2r", string(path) + DIR_SEP + "e2s");
+            dictManager->setTermCacheSize(config.getParamLong(DICT_TERMCACHESIZE));
         }
 
         //Initialize the memory tracker for the storage partitions
@@ -216,7 +223,8 @@ KB::KB(const char *path,
                 files[i] = new TableStorage(readOnly, is.str(),
                         config.getParamLong(STORAGE_MAX_FILE_SIZE),
                         config.getParamInt(STORAGE_MAX_N_FILES),
-                        bytesTracker[i], stats, i);
+                        bytesTracker[i], stats, i,
+                        config.getParamLong(STORAGE_ASYNC_BUFFER_SIZE));
             }
         }
 
@@ -231,6 +239,15 @@ KB::KB(const char *path,
             sampleRate = 0;
         }
 
+        if (readOnly && MembershipFilter::exists(path + DIR_SEP + "_filter")) {
+            membershipFilter = std::unique_ptr<MembershipFilter>(
+                    new MembershipFilter(path + DIR_SEP + "_filter"));
+        }
+        if (readOnly && CharacteristicSets::exists(path + DIR_SEP + "_charsets")) {
+            characteristicSets = std::unique_ptr<CharacteristicSets>(
+                    new CharacteristicSets(path + DIR_SEP + "_charsets"));
+        }
+
         string defaultDiffDir = path + DIR_SEP + string("_diff");
         if (Utils::exists(defaultDiffDir)) {
             std::vector<string> files = Utils::getSubdirs(defaultDiffDir);
@@ -287,10 +304,28 @@ KB::KB(const char *path,
                 sort(childrenupdates.begin(), childrenupdates.end(), _sort_by_number);
                 for (int i = 0; i < childrenupdates.size(); ++i) {
                     std::chrono::system_clock::time_point startDiff = std::chrono::system_clock::now();
-                    addDiffIndex(childrenupdates[i], &globalbuffers[0], NULL);
+                    addDiffIndex(childrenupdates[i], &globalbuffers[0]);
                     sec = std::chrono::system_clock::now() - startDiff;
                     LOG(DEBUGL) << "Time loading diff index " << sec.count() * 1000 << "ms.";
                 }
+                if (membershipFilter) {
+                    //The triples removed by the diffs can stay in the filters
+                    Querier *q = query();
+                    for (size_t i = 0; i < diffIndices.size(); ++i) {
+                        addDiffToMembershipFilter(diffIndices[i].get(), q);
+                    }
+                    delete q;
+                }
+                if (characteristicSets) {
+                    //The sets were computed on the KB without the diffs
+                    Querier *q = query();
+                    std::vector<CharacteristicSets::Change> changes;
+                    for (size_t i = 0; i < diffIndices.size(); ++i) {
+                        getDiffChanges(diffIndices[i].get(), q, changes);
+                    }
+                    characteristicSets->update(q, changes);
+                    delete q;
+                }
             }
             if (!dictUpdates.empty()) {
                 dictManager->addUpdates(dictUpdates);
@@ -393,10 +428,153 @@ void KB::loadDict(KBConfig *config) {
     maindict->invdict = std::shared_ptr<Root>(new Root(ss2.str(), NULL, readOnly, map));
 }
 
+SearchIndex *KB::getSearchIndex() {
+#ifdef MT
+    std::lock_guard<std::mutex> lock(searchIndexMutex);
+#endif
+    //The index contains only the terms of the main dictionary. The terms
+    //added by the updates are indexed when the KB is compacted
+    if (dictEnabled && dictManager->hasUpdatedTerms()) {
+        if (searchIndex) {
+            LOG(WARNL) << "The search index does not contain the terms of "
+                "the updates. I do not use it until the KB is compacted";
+            searchIndex = std::unique_ptr<SearchIndex>();
+        }
+        return NULL;
+    }
+    if (!searchIndex && dictEnabled &&
+            SearchIndex::exists(path + DIR_SEP + "_search")) {
+        searchIndex = std::unique_ptr<SearchIndex>(
+                new SearchIndex(path + DIR_SEP + "_search"));
+    }
+    return searchIndex.get();
+}
+
+void KB::buildSearchIndex() {
+    if (!dictEnabled) {
+        LOG(ERRORL) << "The search index requires the dictionary";
+        throw 10;
+    }
+#ifdef MT
+    std::lock_guard<std::mutex> lock(searchIndexMutex);
+#endif
+    searchIndex = std::unique_ptr<SearchIndex>();
+    if (dictManager->hasUpdatedTerms()) {
+        LOG(WARNL) << "The search index will not contain the terms of the "
+            "updates and it is not used until the KB is compacted";
+    }
+    SearchIndex::build(dictManager, path + DIR_SEP + "_search");
+}
+
+void KB::buildMembershipFilter() {
+    //The pairs are as many as the first tables of the permutations
+    int64_t nkeys[MembershipFilter::NFILTERS];
+    nkeys[MembershipFilter::TRIPLES] = totalNumberTriples;
+    nkeys[MembershipFilter::SP] = nindices > IDX_SPO ? nFirstTables[IDX_SPO] : 0;
+    nkeys[MembershipFilter::PO] = nindices > IDX_POS ? nFirstTables[IDX_POS] : 0;
+    nkeys[MembershipFilter::SO] = nindices > IDX_SOP ? nFirstTables[IDX_SOP] : 0;
+    for (int f = 1; f < MembershipFilter::NFILTERS; ++f) {
+        if (nkeys[f] <= 0) {
+            nkeys[f] = totalNumberTriples;
+        }
+    }
+
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::unique_ptr<MembershipFilter> filter(new MembershipFilter(nkeys));
+    Querier *q = query();
+    PairItr *itr = q->get(IDX_SPO, -1, -1, -1);
+    while (itr->hasNext()) {
+        itr->next();
+        filter->add(itr->getKey(), itr->getValue1(), itr->getValue2());
+    }
+    q->releaseItr(itr);
+    delete q;
+    filter->store(path + DIR_SEP + "_filter");
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Membership filters built in " << sec.count() << "s. Size " <<
+        filter->getSize() << " bytes";
+    membershipFilter = std::move(filter);
+}
+
+void KB::addDiffToMembershipFilter(DiffIndex *diff, Querier *q) {
+    if (diff->getType() != DiffIndex::TypeUpdate::ADDITION_df) {
+        return;
+    }
+    if (diff->getClass() == DiffIndex::ClassUpdate::DIFF1) {
+        int64_t nfirstterms = 0;
+        PairItr *itr = diff->getIterator(IDX_SPO, -1, -1, -1, nfirstterms);
+        while (itr->hasNext()) {
+            itr->next();
+            membershipFilter->add(itr->getKey(), itr->getValue1(),
+                    itr->getValue2());
+        }
+        if (itr->getTypeItr() != EMPTY_ITR) {
+            q->releaseItr(itr);
+        }
+    } else {
+        DiffScanItr itr;
+        itr.setQuerier(q);
+        ((DiffIndex3*)diff)->getScan(IDX_SPO, &itr);
+        while (itr.hasNext()) {
+            itr.next();
+            membershipFilter->add(itr.getKey(), itr.getValue1(),
+                    itr.getValue2());
+        }
+        itr.clear();
+    }
+}
+
+void KB::buildCharacteristicSets() {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::unique_ptr<CharacteristicSets> sets(new CharacteristicSets());
+    Querier *q = query();
+    sets->build(q, nindices > IDX_OPS);
+    delete q;
+    sets->store(path + DIR_SEP + "_charsets");
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Characteristic sets built in " << sec.count() << "s. " <<
+        sets->getNSets() << " sets";
+    characteristicSets = std::move(sets);
+}
+
+void KB::getDiffChanges(DiffIndex *diff, Querier *q,
+        std::vector<CharacteristicSets::Change> &changes) {
+    CharacteristicSets::Change c;
+    c.sign = diff->getType() == DiffIndex::TypeUpdate::ADDITION_df ? 1 : -1;
+    if (diff->getClass() == DiffIndex::ClassUpdate::DIFF1) {
+        int64_t nfirstterms = 0;
+        PairItr *itr = diff->getIterator(IDX_SPO, -1, -1, -1, nfirstterms);
+        while (itr->hasNext()) {
+            itr->next();
+            c.s = itr->getKey();
+            c.p = itr->getValue1();
+            c.o = itr->getValue2();
+            changes.push_back(c);
+        }
+        if (itr->getTypeItr() != EMPTY_ITR) {
+            q->releaseItr(itr);
+        }
+    } else {
+        DiffScanItr itr;
+        itr.setQuerier(q);
+        ((DiffIndex3*)diff)->getScan(IDX_SPO, &itr);
+        while (itr.hasNext()) {
+            itr.next();
+            c.s = itr.getKey();
+            c.p = itr.getValue1();
+            c.o = itr.getValue2();
+            changes.push_back(c);
+        }
+        itr.clear();
+    }
+}
+
 Querier *KB::query() {
-    return new Querier(tree, dictManager, files, totalNumberTriples,
+    Querier *q = new Querier(tree, dictManager, files, totalNumberTriples,
             totalNumberTerms, nindices, ntables, nFirstTables,
             sampleKB, diffIndices);
+    q->setMembershipFilter(membershipFilter.get());
+    return q;
 }
 
 Inserter *KB::insert() {
@@ -437,6 +615,43 @@ Stats *KB::getStatsDict() {
     return maindict->stats.get();
 }
 
+KB::CacheCounters KB::getCacheCounters() {
+    CacheCounters c;
+    memset(&c, 0, sizeof(CacheCounters));
+    for (int i = 0; i < nindices; ++i) {
+        if (files[i] != NULL) {
+            const Stats &s = files[i]->getStats();
+            c.fileAccesses += s.getNAccessedFiles();
+            c.fileOpens += s.getNOpenedFiles();
+            c.fileCloses += s.getNClosedFiles();
+        }
+        if (bytesTracker[i] != NULL) {
+            c.memEvictions += bytesTracker[i]->getEvictions();
+            c.memBytes += bytesTracker[i]->getBytes();
+        }
+    }
+    std::vector<Root*> trees;
+    trees.push_back(tree);
+    if (maindict) {
+        const Stats *s = maindict->stats.get();
+        c.dictBlockAccesses = s->getNAccessedIndexBlocks();
+        c.dictBlockReads = s->getNReadIndexBlocks();
+        c.dictBlockEvictions = s->getNEvictedIndexBlocks();
+        c.dictBytesRead = s->getNReadIndexBytes();
+        trees.push_back(maindict->dict.get());
+        trees.push_back(maindict->invdict.get());
+    }
+    for (Root *t : trees) {
+        if (t != NULL) {
+            uint64_t accesses, loads;
+            t->getCacheCounters(accesses, loads);
+            c.nodeAccesses += accesses;
+            c.nodeLoads += loads;
+        }
+    }
+    return c;
+}
+
 void KB::close() {
     if (isClosed)
         return;
@@ -458,6 +673,9 @@ void KB::close() {
         delete tree;
         tree = NULL;
     }
+    searchIndex = std::unique_ptr<SearchIndex>();
+    membershipFilter = std::unique_ptr<MembershipFilter>();
+    characteristicSets = std::unique_ptr<CharacteristicSets>();
     if (dictEnabled) {
         if (dictManager != NULL) {
             dictManager->clean();
@@ -561,7 +779,7 @@ KB::~KB() {
     }
 }
 
-void KB::addDiffIndex(string inputdir, const char **globalbuffers, Querier *q) {
+void KB::addDiffIndex(string inputdir, const char **globalbuffers) {
     DiffIndex::TypeUpdate type;
     if (Utils::exists(inputdir + DIR_SEP + "ADD")) {
         type = DiffIndex::TypeUpdate::ADDITION_df;
@@ -600,10 +818,6 @@ void KB::addDiffIndex(string inputdir, const char **globalbuffers, Querier *q) {
 
         dictUpdates.push_back(ud);
     }
-
-    if (q) {
-        q->initDiffIndex(diffIndices.back().get());
-    }
 }
 
 std::vector<const char*> KB::openAllFiles(int perm) {
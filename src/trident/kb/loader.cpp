@@ -43,6 +43,7 @@
 
 #include <mutex>
 #include <condition_variable>
+#include <exception>
 #include <sstream>
 #include <limits>
 #include <fstream>
@@ -143,43 +144,141 @@ bool _sorter_pso(const Triple &a, const Triple &b) {
     return false;
 }
 
-void __parseLineSnapFile(string &line, string &origline,
-        std::map<int64_t, int64_t> &dictionary, std::vector<Triple> &triples, int64_t &counter) {
-    origline = line;
-    char delim = '\t';
-    if (line[0] != '#') {
-        int64_t s,o;
-        auto pos = line.find(delim);
-        if (pos == string::npos) {
-            if (delim == '\t') {
-                delim = ' ';
-                pos = line.find(delim);
-                if (pos == string::npos) {
+//Parses the number that starts at start and moves start after it
+int64_t __parseSnapNumber(const char *&start, const char *end) {
+    const char *begin = start;
+    int64_t v = 0;
+    while (start < end && *start >= '0' && *start <= '9') {
+        v = v * 10 + (*start - '0');
+        start++;
+    }
+    if (start == begin) {
+        LOG(ERRORL) << "Failed parsing the SNAP file (no number)";
+        throw 10;
+    }
+    return v;
+}
+
+void Loader::parseSnapFile_seq(DiskReader *reader,
+        std::vector<std::pair<int64_t, int64_t>> *edges,
+        std::vector<int64_t> *nodes) {
+    typedef std::istream_iterator<char> isitr;
+    DiskReader::Buffer buffer = reader->getfile();
+    std::vector<char> uncompressedByteArray;
+    while (buffer.b != NULL) {
+        const char *input = NULL;
+        size_t sizeinput = 0;
+        if (buffer.gzipped) {
+            uncompressedByteArray.clear();
+            istringstream raw(string(buffer.b, buffer.size));
+            zstr::istream is(raw);
+            is.unsetf(std::ios_base::skipws);
+            isitr itrstream(is);
+            std::copy(itrstream, isitr(), std::back_inserter(uncompressedByteArray));
+            input = uncompressedByteArray.data();
+            sizeinput = uncompressedByteArray.size();
+        } else {
+            input = buffer.b;
+            sizeinput = buffer.size;
+        }
+
+        //Every line is either a comment or "<source><tab or space><dest>"
+        const char *start = input;
+        const char *end = input + sizeinput;
+        while (start < end) {
+            const char *eol = (const char*) memchr(start, '\n', end - start);
+            if (eol == NULL) {
+                eol = end;
+            }
+            if (start < eol && *start != '#' && *start != '\r') {
+                const int64_t s = __parseSnapNumber(start, eol);
+                if (start == eol || (*start != '\t' && *start != ' ')) {
                     LOG(ERRORL) << "Failed parsing the SNAP file (no delim)";
                     throw 10;
                 }
+                while (start < eol && (*start == '\t' || *start == ' ')) {
+                    start++;
+                }
+                const int64_t o = __parseSnapNumber(start, eol);
+                edges->push_back(std::make_pair(s, o));
             }
+            start = eol + 1;
         }
-        string ss = line.substr(0, pos);
-        s = stol(ss);
-        line = line.substr(pos + 1);
-        o = stol(line);
 
-        if (dictionary.count(s)) {
-            s = dictionary.find(s)->second;
-        } else {
-            dictionary.insert(std::make_pair(s, counter));
-            s = counter++;
+        if (buffer.gzipped) {
+            uncompressedByteArray.clear();
         }
+        reader->releasefile(buffer);
+        buffer = reader->getfile();
+    }
 
-        if (dictionary.count(o)) {
-            o = dictionary.find(o)->second;
-        } else {
-            dictionary.insert(std::make_pair(o, counter));
-            o = counter++;
+    //Collect the nodes of this part of the graph
+    nodes->reserve(edges->size() * 2);
+    for (const auto &e : *edges) {
+        nodes->push_back(e.first);
+        nodes->push_back(e.second);
+    }
+    std::sort(nodes->begin(), nodes->end());
+    nodes->erase(std::unique(nodes->begin(), nodes->end()), nodes->end());
+}
+
+void __writeSnapTriple(LZ4Writer &writer, const int perm, const int64_t s,
+        const int64_t o) {
+    const int64_t p = 0;
+    switch (perm) {
+        case IDX_SPO:
+            writer.writeLong(s);
+            writer.writeLong(p);
+            writer.writeLong(o);
+            break;
+        case IDX_OPS:
+            writer.writeLong(o);
+            writer.writeLong(p);
+            writer.writeLong(s);
+            break;
+        case IDX_SOP:
+            writer.writeLong(s);
+            writer.writeLong(o);
+            writer.writeLong(p);
+            break;
+        case IDX_OSP:
+            writer.writeLong(o);
+            writer.writeLong(s);
+            writer.writeLong(p);
+            break;
+        case IDX_PSO:
+            writer.writeLong(p);
+            writer.writeLong(s);
+            writer.writeLong(o);
+            break;
+        case IDX_POS:
+            writer.writeLong(p);
+            writer.writeLong(o);
+            writer.writeLong(s);
+            break;
+    }
+}
+
+void Loader::writeSnapFile_seq(std::vector<std::pair<int64_t, int64_t>> *edges,
+        const std::vector<int64_t> *nodes,
+        string *permDirs,
+        const int *detailPerms,
+        int nperms,
+        int id) {
+    //The new ID of a node is its position in the sorted list of all nodes
+    for (auto &e : *edges) {
+        e.first = std::lower_bound(nodes->begin(), nodes->end(), e.first)
+            - nodes->begin();
+        e.second = std::lower_bound(nodes->begin(), nodes->end(), e.second)
+            - nodes->begin();
+    }
+    for (int i = 0; i < nperms; ++i) {
+        LZ4Writer writer(permDirs[i] + DIR_SEP + "input-" + to_string(id));
+        for (const auto &e : *edges) {
+            __writeSnapTriple(writer, detailPerms[i], e.first, e.second);
         }
-        triples.push_back(Triple(s, 0, o));
     }
+    std::vector<std::pair<int64_t, int64_t>>().swap(*edges);
 }
 
 int64_t Loader::parseSnapFile(string inputtriples,
@@ -191,82 +290,73 @@ int64_t Loader::parseSnapFile(string inputtriples,
         int maxReadingThreads,
         int parallelProcesses) {
     LOG(DEBUGL) << "Loading input graph from " << inputtriples;
+    const int nthreads = std::max(1, parallelProcesses);
+    const int nreadThreads = std::max(1, std::min(maxReadingThreads, nthreads));
+
+    //Parse the edges in parallel. Every thread keeps its own edges
+    vector<FileInfo> *files = Compressor::splitInputInChunks(
+            Utils::parentDir(inputtriples), nreadThreads,
+            Utils::filename(inputtriples));
+    std::vector<std::thread> threadReaders(nreadThreads);
+    std::vector<std::unique_ptr<DiskReader>> readers(nreadThreads);
+    for (int i = 0; i < nreadThreads; ++i) {
+        readers[i] = std::unique_ptr<DiskReader>(new DiskReader(
+                    max(2, (nthreads / nreadThreads) * 2), &files[i]));
+        threadReaders[i] = std::thread(std::bind(&DiskReader::run,
+                    readers[i].get()));
+    }
+    std::vector<std::vector<std::pair<int64_t, int64_t>>> edges(nthreads);
+    std::vector<std::vector<int64_t>> nodes(nthreads);
+    std::vector<std::thread> threads(nthreads);
+    for (int i = 0; i < nthreads; ++i) {
+        threads[i] = std::thread(std::bind(&Loader::parseSnapFile_seq,
+                    readers[i % nreadThreads].get(), &edges[i], &nodes[i]));
+    }
+    for (int i = 0; i < nthreads; ++i) {
+        threads[i].join();
+    }
+    for (int i = 0; i < nreadThreads; ++i) {
+        threadReaders[i].join();
+    }
+    readers.clear();
+    delete[] files;
 
-    //Create the permutations
-    int64_t counter = 0;
-    std::map<int64_t, int64_t> dictionary;
-    std::vector<Triple> triples;
-    string line, origline;
-    if (Utils::ends_with(inputtriples, ".gz")) {
-        zstr::ifstream inputreader(inputtriples);
-        while(std::getline(inputreader, line)) {
-            __parseLineSnapFile(line, origline, dictionary, triples, counter);
-        }
-    } else {
-        ifstream inputreader(inputtriples);
-        while(std::getline(inputreader, line)) {
-            __parseLineSnapFile(line, origline, dictionary, triples, counter);
-        }
+    //Renumber the nodes by sorting them, so that the IDs are dense
+    std::vector<int64_t> allNodes;
+    for (auto &n : nodes) {
+        allNodes.insert(allNodes.end(), n.begin(), n.end());
+        std::vector<int64_t>().swap(n);
     }
+    ParallelTasks::sort_int(allNodes.begin(), allNodes.end(), nthreads);
+    allNodes.erase(std::unique(allNodes.begin(), allNodes.end()),
+            allNodes.end());
+    LOG(DEBUGL) << "Loaded a vocabulary of " << allNodes.size();
 
-    LOG(DEBUGL) << "Loaded a vocabulary of " << dictionary.size();
+    //Every thread writes its edges in its own files
     int detailPerms[6];
     Compressor::parsePermutationSignature(signaturePerm, detailPerms);
-    for(int i = 0; i < nperms; ++i) {
-        int perm = detailPerms[i];
-        LZ4Writer writer(permDirs[i] + DIR_SEP + "input-00");
-        for (auto t : triples) {
-            switch (perm) {
-                case IDX_SPO:
-                    writer.writeLong(t.s);
-                    writer.writeLong(t.p);
-                    writer.writeLong(t.o);
-                    break;
-                case IDX_OPS:
-                    writer.writeLong(t.o);
-                    writer.writeLong(t.p);
-                    writer.writeLong(t.s);
-                    break;
-                case IDX_SOP:
-                    writer.writeLong(t.s);
-                    writer.writeLong(t.o);
-                    writer.writeLong(t.p);
-                    break;
-                case IDX_OSP:
-                    writer.writeLong(t.o);
-                    writer.writeLong(t.s);
-                    writer.writeLong(t.p);
-                    break;
-                case IDX_PSO:
-                    writer.writeLong(t.p);
-                    writer.writeLong(t.s);
-                    writer.writeLong(t.o);
-                    break;
-                case IDX_POS:
-                    writer.writeLong(t.p);
-                    writer.writeLong(t.o);
-                    writer.writeLong(t.s);
-                    break;
-            }
-        }
+    int64_t ntriples = 0;
+    for (int i = 0; i < nthreads; ++i) {
+        ntriples += edges[i].size();
+        threads[i] = std::thread(std::bind(&Loader::writeSnapFile_seq,
+                    &edges[i], &allNodes, permDirs, detailPerms, nperms, i));
     }
-
-    //Store the dictionary. I must ensure that the data is ordered by key.
-    std::map<int64_t, int64_t> inverseDict;
-    for(const auto &it : dictionary) {
-        inverseDict.insert(std::make_pair(it.second, it.first));
+    for (int i = 0; i < nthreads; ++i) {
+        threads[i].join();
     }
+
+    //Store the dictionary, ordered by key
     LZ4Writer outputDict(fileNameDictionaries);
     char *support = new char[MAX_TERM_SIZE];
-    for(const auto &it : inverseDict) {
-        outputDict.writeLong(it.first);
-        string text = to_string(it.second);
+    for (int64_t i = 0; i < allNodes.size(); ++i) {
+        outputDict.writeLong(i);
+        string text = to_string(allNodes[i]);
         Utils::encode_short(support, text.length());
         memcpy(support + 2, text.c_str(), text.length());
         outputDict.writeString(support, text.length() + 2);
     }
     delete[] support;
-    return triples.size();
+    return ntriples;
 }
 
 void Loader::createPermsAndDictsFromFiles_seq(DiskReader *reader,
@@ -1200,7 +1290,7 @@ void Loader::insert(ParamInsert params) {
     if (printstats) {
         Statistics *stat = ins->getStats(permutation);
         if (stat != NULL) {
-            LOG(DEBUGL) << "Perm " << permutation << ": RowLayout" << stat->nListStrategies << " ClusterLayout " << stat->nGroupStrategies << " ColumnLayout " << stat->nList2Strategies;
+            LOG(DEBUGL) << "Perm " << permutation << ": RowLayout" << stat->nListStrategies << " ClusterLayout " << stat->nGroupStrategies << " ColumnLayout " << stat->nList2Strategies << " FORColumnLayout " << stat->nFORStrategies;
             LOG(DEBUGL) << "Perm " << permutation << ": Exact " << stat->exact << " Approx " << stat->approximate;
             LOG(DEBUGL) << "Perm " << permutation << ": FirstElemCompr1 " << stat->nFirstCompr1 << " FirstElemCompr2 " << stat->nFirstCompr2;
             LOG(DEBUGL) << "Perm " << permutation << ": SecondElemCompr1 " << stat->nSecondCompr1 << " SecondElemCompr2 " << stat->nSecondCompr2;
@@ -1430,6 +1520,11 @@ void Loader::addSchemaTerms(const int dictPartitions, nTerm highestNumber, DictM
 
 void Loader::load(ParamsLoad p) {
     LOG(DEBUGL) << "Params: " << p.tostring();
+    if (p.searchIndex && !p.storeDicts) {
+        LOG(ERRORL) << "The search index is built on the dictionary, which "
+            "is not stored. Remove the option --searchindex or store the dictionary";
+        throw 10;
+    }
     std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
     LOG(DEBUGL) << "Start loading ...";
 
@@ -1602,6 +1697,10 @@ void Loader::load(ParamsLoad p) {
             if (p.dictDir == "" && p.dictDir_rel == "" && p.storeDicts) {
                 LOG(INFOL) << "I force storeDicts to false since no directory for the dictionary was given";
                 p.storeDicts = false;
+                if (p.searchIndex) {
+                    LOG(WARNL) << "The search index is not built since there is no dictionary";
+                    p.searchIndex = false;
+                }
             }
         }
     }
@@ -1630,6 +1729,23 @@ void Loader::load(ParamsLoad p) {
             p.storeDicts,
             p.relsOwnIDs);
 
+    if (p.searchIndex || p.membershipFilter ||
+            p.characteristicSets) {
+        //Close the KB and reopen it to read the terms and the triples
+        kb = std::unique_ptr<KB>();
+        KBConfig readConfig;
+        KB rokb(p.kbDir.c_str(), true, false, p.storeDicts, readConfig);
+        if (p.searchIndex) {
+            rokb.buildSearchIndex();
+        }
+        if (p.membershipFilter) {
+            rokb.buildMembershipFilter();
+        }
+        if (p.characteristicSets) {
+            rokb.buildCharacteristicSets();
+        }
+    }
+
     /*** CLEANUP ***/
     delete[] permDirs;
     delete[] fileNameDictionaries;
@@ -1713,7 +1829,8 @@ void Loader::loadKB_handleGraphTransformations(KB &kb,
         Inserter *ins,
         bool relsOwnIDs,
         string kbDir,
-        bool storeDicts) {
+        bool storeDicts,
+        int parallelProcesses) {
 
     if (graphTransformation == "unlabeled") {
         kb.setGraphType(GraphType::DIRECTED);
@@ -1724,22 +1841,34 @@ void Loader::loadKB_handleGraphTransformations(KB &kb,
         string output = input + "_tmp";
         Utils::create_directories(output);
         std::vector<string> files = Utils::getFiles(input);
-        for(auto file : files) {
-            LOG(DEBUGL) << "Transforming file " << file;
-            LZ4Reader reader(file);
-            string fileout = output + DIR_SEP + Utils::filename(file);
-            LZ4Writer writer(fileout);
-            while (!reader.isEof()) {
-                L_Triple t;
-                t.readFrom(&reader);
-                //Write both versions.
-                t.writeTo(&writer);
-                //swap them
-                int64_t box = t.first;
-                t.first = t.third;
-                t.third = box;
-                t.writeTo(&writer);
-            }
+        //Every file is transformed by one thread
+        const int nthreads = std::max(1, std::min(parallelProcesses,
+                    (int) files.size()));
+        std::vector<std::thread> threads(nthreads);
+        for (int i = 0; i < nthreads; ++i) {
+            threads[i] = std::thread([&files, &output, i, nthreads]() {
+                for (size_t j = i; j < files.size(); j += nthreads) {
+                    const string &file = files[j];
+                    LOG(DEBUGL) << "Transforming file " << file;
+                    LZ4Reader reader(file);
+                    string fileout = output + DIR_SEP + Utils::filename(file);
+                    LZ4Writer writer(fileout);
+                    while (!reader.isEof()) {
+                        L_Triple t;
+                        t.readFrom(&reader);
+                        //Write both versions.
+                        t.writeTo(&writer);
+                        //swap them
+                        int64_t box = t.first;
+                        t.first = t.third;
+                        t.third = box;
+                        t.writeTo(&writer);
+                    }
+                }
+            });
+        }
+        for (int i = 0; i < nthreads; ++i) {
+            threads[i].join();
         }
         Utils::remove_all(input);
         Utils::rename(output, input);
@@ -1970,6 +2099,9 @@ void Loader::loadKB(KB &kb,
 
     //Create n threads where the triples are sorted and inserted in the knowledge base
     Inserter *ins = kb.insert();
+    if (p.forColumns) {
+        ins->enableFORColumnStorage();
+    }
     LOG(DEBUGL) << "Start sortAndInsert";
 
     if (nindices != 6) {
@@ -1983,7 +2115,7 @@ void Loader::loadKB(KB &kb,
     }
 
     loadKB_handleGraphTransformations(kb, graphTransformation, permDirs,
-            nindices, ins, relsOwnIDs, kbDir, storeDicts);
+            nindices, ins, relsOwnIDs, kbDir, storeDicts, parallelProcesses);
 
     createIndices(parallelProcesses, maxReadingThreads,
             ins, createIndicesInBlocks,
@@ -1993,7 +2125,8 @@ void Loader::loadKB(KB &kb,
             remoteLocation,
             limitSpace,
             totalCount,
-            nindices);
+            nindices,
+            p.concurrentIndices);
 
     if (nindices != 6)
         nindices = 6; //restore
@@ -2451,7 +2584,17 @@ void Loader::createIndices(
         string remotePath,
         int64_t limitSpace,
         int64_t estimatedSize,
-        int nindices) {
+        int nindices,
+        int concurrentIndices) {
+
+    if (!createIndicesInBlocks && concurrentIndices > 1) {
+        createIndices_concurrent(parallelProcesses, maxReadingThreads, ins,
+                aggrIndices, canSkipTables, storePlainList, permDirs,
+                outputDirs, aggr1Dir, aggr2Dir, treeWriters, sampleWriter,
+                sampleRate, remotePath, limitSpace, estimatedSize,
+                concurrentIndices);
+        return;
+    }
 
     LOG(DEBUGL) << "start createIndices";
     std::vector<std::pair<string, char>> permutations;
@@ -2731,6 +2874,207 @@ void Loader::createIndices(
     }
 }
 
+//Buffers of a parallel insert (3 x 128MB) plus the readers of the merge
+static const int64_t MEMORY_INSERT = 512 * 1024 * 1024l;
+
+void Loader::runIndexTasks(std::vector<IndexTask> &tasks,
+        int maxConcurrent,
+        int64_t memoryBudget) {
+    std::mutex mutex;
+    std::condition_variable cond;
+    //0=waiting, 1=running, 2=finished
+    std::vector<char> status(tasks.size(), 0);
+    size_t finished = 0;
+    int running = 0;
+    int64_t usedMemory = 0;
+    std::vector<std::thread> threads;
+    //The first error of a task. No new task starts after it
+    std::exception_ptr error;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (error ? running > 0 : finished < tasks.size()) {
+        bool started = false;
+        for (size_t i = 0; i < tasks.size() && !error; ++i) {
+            if (status[i] != 0 || running >= maxConcurrent) {
+                continue;
+            }
+            const int dep = tasks[i].dependsOn;
+            if (dep != -1 && status[dep] != 2) {
+                continue;
+            }
+            //A task larger than the budget runs alone
+            if (running > 0 && usedMemory + tasks[i].memory > memoryBudget) {
+                continue;
+            }
+            status[i] = 1;
+            running++;
+            usedMemory += tasks[i].memory;
+            started = true;
+            threads.push_back(std::thread([&, i]() {
+                        std::exception_ptr e;
+                        try {
+                            tasks[i].run();
+                        } catch (...) {
+                            e = std::current_exception();
+                        }
+                        std::lock_guard<std::mutex> l(mutex);
+                        if (e && !error) {
+                            error = e;
+                        }
+                        status[i] = 2;
+                        finished++;
+                        running--;
+                        usedMemory -= tasks[i].memory;
+                        cond.notify_one();
+                        }));
+        }
+        if (!started) {
+            cond.wait(lock);
+        }
+    }
+    lock.unlock();
+    for (auto &t : threads) {
+        t.join();
+    }
+    if (error) {
+        LOG(ERRORL) << "The construction of an index failed";
+        std::rethrow_exception(error);
+    }
+}
+
+void Loader::createIndices_concurrent(
+        int parallelProcesses,
+        int maxReadingThreads,
+        Inserter *ins,
+        const bool aggrIndices,
+        const bool canSkipTables,
+        const bool storePlainList,
+        string *permDirs,
+        string *outputDirs,
+        string aggr1Dir,
+        string aggr2Dir,
+        TreeWriter **treeWriters,
+        SimpleTripleWriter *sampleWriter,
+        double sampleRate,
+        string remotePath,
+        int64_t limitSpace,
+        int64_t estimatedSize,
+        int concurrentIndices) {
+    LOG(DEBUGL) << "start createIndices_concurrent (" << concurrentIndices
+        << " permutations at the time)";
+
+    //All the permutations are created from a single read of the input
+    std::vector<std::pair<string, char>> permutations;
+    if (!aggrIndices) {
+        permutations.push_back(std::make_pair(permDirs[0], IDX_SPO));
+        permutations.push_back(std::make_pair(permDirs[3], IDX_SOP));
+        permutations.push_back(std::make_pair(permDirs[4], IDX_OSP));
+        permutations.push_back(std::make_pair(permDirs[1], IDX_OPS));
+        permutations.push_back(std::make_pair(permDirs[2], IDX_POS));
+        permutations.push_back(std::make_pair(permDirs[5], IDX_PSO));
+    } else {
+        permutations.push_back(std::make_pair(permDirs[0], IDX_SPO));
+        permutations.push_back(std::make_pair(permDirs[2], IDX_SOP));
+        permutations.push_back(std::make_pair(permDirs[3], IDX_OSP));
+        permutations.push_back(std::make_pair(permDirs[1], IDX_OPS));
+    }
+    PermSorter::sortChunks2(permutations, maxReadingThreads,
+            parallelProcesses,
+            estimatedSize,
+            false);
+
+    //The sorting array is released, so its memory can be used by the
+    //concurrent inserts
+    const int64_t memoryBudget = Utils::getSystemMemory() * 0.6;
+
+    //The threads are shared by the tasks that run together. The aggregated
+    //indices run alone and use all of them
+    const int threadsPerTask = std::max(1, parallelProcesses / concurrentIndices);
+
+    ParamInsert defaultParams;
+    defaultParams.parallelProcesses = threadsPerTask;
+    defaultParams.ins = ins;
+    defaultParams.POSoutputDir = NULL;
+    defaultParams.aggregated = false;
+    defaultParams.canSkipTables = false;
+    defaultParams.storeRaw = false;
+    defaultParams.sampleWriter = NULL;
+    defaultParams.sampleRate = 0.0;
+    defaultParams.printstats = printStats;
+    defaultParams.removeInput = false;
+    defaultParams.deletePreviousExt = false;
+
+    //Every permutation is merged and inserted by one task, so that the
+    //merge of one permutation overlaps with the insert of another
+    std::vector<IndexTask> tasks;
+    auto addTask = [&](int perm, string inputDir, bool canSkip,
+            bool stopInserts, int dependsOn) {
+        ParamInsert params = defaultParams;
+        params.permutation = perm;
+        params.inputDir = inputDir;
+        params.treeWriter = treeWriters[perm];
+        params.canSkipTables = canSkip;
+        if (perm == 0) {
+            params.storeRaw = storePlainList;
+            params.sampleWriter = sampleWriter;
+            params.sampleRate = sampleRate;
+            params.POSoutputDir = aggrIndices ? &aggr2Dir : NULL;
+        } else if (perm == 1) {
+            params.POSoutputDir = aggrIndices ? &aggr1Dir : NULL;
+        }
+        string outputDir = outputDirs[perm];
+        tasks.push_back(IndexTask([=]() {
+                    mergeDiskFragments(ParamsMergeDiskFragments(inputDir));
+                    insert(params);
+                    Utils::remove_all(inputDir);
+                    if (stopInserts) {
+                        ins->stopInserts(perm);
+                        moveData(remotePath, outputDir, limitSpace);
+                    }
+                    LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+                    }, MEMORY_INSERT, dependsOn));
+        return (int)tasks.size() - 1;
+    };
+
+    const int task0 = addTask(0, permDirs[0], false, true, -1);
+    const int task1 = addTask(1, permDirs[1], false, true, -1);
+    addTask(3, aggrIndices ? permDirs[2] : permDirs[3], canSkipTables, true, -1);
+    addTask(4, aggrIndices ? permDirs[3] : permDirs[4], canSkipTables, true, -1);
+    if (!aggrIndices) {
+        addTask(2, permDirs[2], false, false, -1);
+        addTask(5, permDirs[5], canSkipTables, false, -1);
+    } else {
+        //The aggregated indices read the lists written by OPS and SPO.
+        //Their sort takes the whole budget
+        auto addAggrTask = [&](int perm, string inputDir, int idx,
+                bool canSkip, int dependsOn) {
+            ParamInsert params = defaultParams;
+            params.permutation = perm;
+            params.inputDir = inputDir;
+            params.treeWriter = treeWriters[perm];
+            params.parallelProcesses = parallelProcesses;
+            params.aggregated = true;
+            params.canSkipTables = canSkip;
+            params.removeInput = true;
+            tasks.push_back(IndexTask([=]() {
+                        PermSorter::sortChunks2(inputDir,
+                                idx, maxReadingThreads,
+                                parallelProcesses,
+                                estimatedSize,
+                                true);
+                        mergeDiskFragments(ParamsMergeDiskFragments(inputDir));
+                        insert(params);
+                        LOG(DEBUGL) << "Memory used so far: " << Utils::getUsedMemory();
+                        }, memoryBudget, dependsOn));
+        };
+        addAggrTask(2, aggr1Dir, IDX_POS, false, task1);
+        addAggrTask(5, aggr2Dir, IDX_PSO, canSkipTables, task0);
+    }
+
+    runIndexTasks(tasks, concurrentIndices, memoryBudget);
+    LOG(DEBUGL) << "stop createIndices_concurrent";
+}
+
 void Loader::createPermutations(string inputDir, int nperms, int signaturePerms,
         string *outputPermFiles, int parallelProcesses, int maxReadingThreads) {
     MultiDiskLZ4Writer ***permWriters = new MultiDiskLZ4Writer**[nperms];
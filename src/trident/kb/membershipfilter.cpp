@@ -0,0 +1,82 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+#include <trident/kb/membershipfilter.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <algorithm>
+
+MembershipFilter::MembershipFilter(const int64_t nkeys[NFILTERS]) {
+    for (int f = 0; f < NFILTERS; ++f) {
+        const uint64_t nbits = std::max((int64_t) 1, nkeys[f]) * BITSPERKEY;
+        nblocks[f] = (nbits + WORDSPERBLOCK * 64 - 1) / (WORDSPERBLOCK * 64);
+        words[f].resize(nblocks[f] * WORDSPERBLOCK, 0);
+    }
+}
+
+MembershipFilter::MembershipFilter(std::string file) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.good()) {
+        LOG(ERRORL) << "Cannot open the membership filters in " << file;
+        throw 10;
+    }
+    for (int f = 0; f < NFILTERS; ++f) {
+        in.read((char*) &nblocks[f], sizeof(uint64_t));
+        if (!in.good() || nblocks[f] == 0) {
+            LOG(ERRORL) << "The membership filters in " << file << " are corrupted";
+            throw 10;
+        }
+        words[f].resize(nblocks[f] * WORDSPERBLOCK);
+        in.read((char*) words[f].data(), words[f].size() * sizeof(uint64_t));
+        if (!in.good()) {
+            LOG(ERRORL) << "The membership filters in " << file << " are corrupted";
+            throw 10;
+        }
+    }
+}
+
+bool MembershipFilter::exists(std::string file) {
+    return Utils::exists(file);
+}
+
+void MembershipFilter::store(std::string file) const {
+    std::ofstream out(file, std::ios::binary);
+    for (int f = 0; f < NFILTERS; ++f) {
+        out.write((const char*) &nblocks[f], sizeof(uint64_t));
+        out.write((const char*) words[f].data(),
+                words[f].size() * sizeof(uint64_t));
+    }
+    if (!out.good()) {
+        LOG(ERRORL) << "Error while writing the membership filters in " << file;
+        throw 10;
+    }
+}
+
+uint64_t MembershipFilter::getSize() const {
+    uint64_t size = 0;
+    for (int f = 0; f < NFILTERS; ++f) {
+        size += words[f].size() * sizeof(uint64_t);
+    }
+    return size;
+}
@@ -22,6 +22,7 @@
 
 #include <trident/kb/permsorter.h>
 #include <trident/utils/parallel.h>
+#include <trident/utils/radixsort.h>
 #include <kognac/utils.h>
 #include <kognac/compressor.h>
 
@@ -29,30 +30,15 @@
 #include <functional>
 #include <array>
 
-typedef std::array<unsigned char, 15> __PermSorter_triple;
-typedef std::array<unsigned char, 23> __PermSorter_tripleCount;
-
-bool __PermSorter_triple_sorter(const __PermSorter_triple &a,
-        const __PermSorter_triple &b) {
-    return a < b;
-}
-
-bool __PermSorter_tripleCount_sorter(const __PermSorter_tripleCount &a,
-        const __PermSorter_tripleCount &b) {
-    return a < b;
-}
-
 void PermSorter::sortPermutation(char *start, char *end, int nthreads,
         bool includeCount) {
     std::chrono::system_clock::time_point starttime = std::chrono::system_clock::now();
+    //The records are big-endian, so a radix sort on the bytes gives the
+    //same order as comparing them lexicographically
     if (includeCount) {
-        __PermSorter_tripleCount *sstart = (__PermSorter_tripleCount*) start;
-        __PermSorter_tripleCount *send = (__PermSorter_tripleCount*) end;
-        ParallelTasks::sort_int(sstart, send, &__PermSorter_tripleCount_sorter, nthreads);
+        RadixSort<23>::sort(start, end, nthreads);
     } else {
-        __PermSorter_triple *sstart = (__PermSorter_triple*) start;
-        __PermSorter_triple *send = (__PermSorter_triple*) end;
-        ParallelTasks::sort_int(sstart, send, &__PermSorter_triple_sorter, nthreads);
+        RadixSort<15>::sort(start, end, nthreads);
     }
     std::chrono::duration<double> duration = std::chrono::system_clock::now() - starttime;
     LOG(DEBUGL) << "Time sorting: " << duration.count() << "s.";
@@ -62,10 +62,11 @@ Querier::Querier(Root* tree, DictMgmt *dict, TableStorage** files,
         this->tree = tree;
         this->dict = dict;
         this->files = files;
+        filter = NULL;
         lastKeyFound = false;
         lastKeyQueried = -1;
         strat.init(/*&listFactory, &comprFactory, &list2Factory,*/ &ncFactory, &nrFactory, &ncluFactory,
-                NULL, NULL, NULL, NULL, NULL, NULL);
+                &forFactory, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
         aggrIndices = notAggrIndices = cacheIndices = 0;
         spo = sop = pos = pso = ops = osp = 0;
 
@@ -496,6 +497,9 @@ int64_t Querier::getCard(const int64_t s, const int64_t p, const int64_t o) {
 
 //Check whether a triple exists
 bool Querier::exists(const int64_t s, const int64_t p, const int64_t o) {
+    if (!mayExist(s, p, o)) {
+        return false;
+    }
     //Use the POS index
     PairItr *itr = get(IDX_POS, s, p, o);
     if (itr->getTypeItr() != EMPTY_ITR) {
@@ -524,6 +528,9 @@ bool Querier::isEmpty(const int64_t s, const int64_t p, const int64_t o) {
         return true;
     }
 
+    if (!mayExist(s, p, o)) {
+        return true;
+    }
     int idx = getIndex(s, p, o);
     PairItr *itr = get(idx, s, p, o);
     if (itr->getTypeItr() != EMPTY_ITR) {
@@ -611,10 +618,15 @@ void Querier::initNewIterator(TableStorage *storage,
         int64_t v1,
         int64_t v2,
         const bool setConstraints) {
-    std::pair<const char*, const char*> coord = storage->getTable(file, mark);
+    unpinTable((AbsNewTable*) t);
+    int pin;
+    std::pair<const char*, const char*> coord = storage->getTable(file, mark,
+            pin);
+    ((AbsNewTable*) t)->setPin(storage, pin);
 
     assert(t->getTypeItr() == NEWROW_ITR || t->getTypeItr() == NEWCLUSTER_ITR
-            || t->getTypeItr() == NEWCOLUMN_ITR);
+            || t->getTypeItr() == NEWCOLUMN_ITR
+            || t->getTypeItr() == FORCOLUMN_ITR);
     if (v1 != -1) {
         if (setConstraints) {
             if (v2 == -1) {
@@ -862,11 +874,24 @@ PairItr *Querier::get(const int idx, TermCoordinates &value,
 
 const char *Querier::getTable(const int perm,
         const short fileIdx,
-        const int64_t mark) {
-    std::pair<const char*, const char*> coord = files[perm]->getTable(fileIdx, mark);
+        const int64_t mark,
+        int &pin) {
+    std::pair<const char*, const char*> coord = files[perm]->getTable(fileIdx,
+            mark, pin);
     return coord.first;
 }
 
+void Querier::releaseTable(const int perm, const int pin) {
+    files[perm]->releaseTable(pin);
+}
+
+void Querier::unpinTable(AbsNewTable *t) {
+    if (t->getPinStorage() != NULL) {
+        t->getPinStorage()->releaseTable(t->getPin());
+        t->setPin(NULL, -1);
+    }
+}
+
 PairItr *Querier::get(const int perm,
         const int64_t key,
         const short fileIdx,
@@ -1135,12 +1160,19 @@ void Querier::releaseItr(PairItr * itr) {
     AggrItr *citr;
     switch (itr->getTypeItr()) {
         case NEWCOLUMN_ITR:
+            unpinTable((AbsNewTable *) itr);
             ncFactory.release((NewColumnTable *) itr);
             break;
+        case FORCOLUMN_ITR:
+            unpinTable((AbsNewTable *) itr);
+            forFactory.release((FORColumnTable *) itr);
+            break;
         case NEWROW_ITR:
+            unpinTable((AbsNewTable *) itr);
             nrFactory.release((AbsNewTable *) itr);
             break;
         case NEWCLUSTER_ITR:
+            unpinTable((AbsNewTable *) itr);
             ncluFactory.release((AbsNewTable *) itr);
             break;
         case ARRAY_ITR:
@@ -0,0 +1,555 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#include <trident/kb/searchindex.h>
+#include <trident/kb/dictmgmt.h>
+#include <trident/kb/consts.h>
+#include <trident/tree/treeitr.h>
+#include <trident/tree/stringbuffer.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <algorithm>
+#include <queue>
+#include <iterator>
+#include <chrono>
+#include <cstring>
+
+static uint32_t getGramAt(const char *text) {
+    return ((uint32_t) (uint8_t) text[0] << 16) |
+        ((uint32_t) (uint8_t) text[1] << 8) |
+        (uint32_t) (uint8_t) text[2];
+}
+
+static void getGrams(const char *text, const int size,
+        std::vector<uint32_t> &out) {
+    out.clear();
+    for (int i = 0; i + 3 <= size; ++i) {
+        out.push_back(getGramAt(text + i));
+    }
+    std::sort(out.begin(), out.end());
+    out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+static void writeVLong(std::ofstream &out, uint64_t v) {
+    while (v >= 128) {
+        out.put((char) ((v & 127) | 128));
+        v >>= 7;
+    }
+    out.put((char) v);
+}
+
+static uint64_t readVLong(const char *&p) {
+    uint64_t v = 0;
+    int shift = 0;
+    while (*p & 128) {
+        v |= (uint64_t) (*p & 127) << shift;
+        shift += 7;
+        p++;
+    }
+    v |= (uint64_t) (*p) << shift;
+    p++;
+    return v;
+}
+
+static int cmpText(const char *text, const int size, const std::string &s) {
+    const int minSize = std::min((size_t) size, s.size());
+    const int r = memcmp(text, s.c_str(), minSize);
+    if (r != 0) {
+        return r;
+    }
+    return size - (int) s.size();
+}
+
+static std::string getRunFile(std::string dir, std::string prefix, int run) {
+    return dir + DIR_SEP + prefix + "-" + std::to_string(run);
+}
+
+//Sorts the terms and the trigrams collected so far and stores them in a run
+static void writeRun(std::string dir, const int run,
+        std::vector<std::pair<std::string, int64_t>> &terms,
+        std::vector<std::pair<uint32_t, int64_t>> &gramsRun) {
+    std::sort(terms.begin(), terms.end());
+    std::ofstream outTerms(getRunFile(dir, "terms", run), std::ios_base::binary);
+    for (const auto &t : terms) {
+        const int32_t size = t.first.size();
+        outTerms.write((const char*) &t.second, 8);
+        outTerms.write((const char*) &size, 4);
+        outTerms.write(t.first.c_str(), size);
+    }
+    outTerms.close();
+    terms.clear();
+
+    std::sort(gramsRun.begin(), gramsRun.end());
+    std::ofstream outGrams(getRunFile(dir, "grams", run), std::ios_base::binary);
+    for (const auto &g : gramsRun) {
+        outGrams.write((const char*) &g.first, 4);
+        outGrams.write((const char*) &g.second, 8);
+    }
+    outGrams.close();
+    gramsRun.clear();
+}
+
+struct TermRunReader {
+    std::ifstream in;
+    std::string text;
+    int64_t id;
+    int run;
+
+    TermRunReader(std::string file, int run) : in(file, std::ios_base::binary),
+        id(0), run(run) {
+    }
+
+    bool next() {
+        int32_t size;
+        if (!in.read((char*) &id, 8) || !in.read((char*) &size, 4)) {
+            return false;
+        }
+        text.resize(size);
+        in.read(&text[0], size);
+        return true;
+    }
+};
+
+struct GramRunReader {
+    std::ifstream in;
+    uint32_t gram;
+    int64_t id;
+    int run;
+
+    GramRunReader(std::string file, int run) : in(file, std::ios_base::binary),
+        gram(0), id(0), run(run) {
+    }
+
+    bool next() {
+        return in.read((char*) &gram, 4) && in.read((char*) &id, 8);
+    }
+};
+
+static void mergeTermRuns(std::string dir, const int nruns) {
+    std::vector<std::unique_ptr<TermRunReader>> readers;
+    auto cmp = [&readers](int r1, int r2) {
+        if (readers[r1]->text != readers[r2]->text) {
+            return readers[r1]->text > readers[r2]->text;
+        }
+        return readers[r1]->id > readers[r2]->id;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(cmp)> queue(cmp);
+    for (int i = 0; i < nruns; ++i) {
+        readers.push_back(std::unique_ptr<TermRunReader>(
+                    new TermRunReader(getRunFile(dir, "terms", i), i)));
+        if (readers.back()->next()) {
+            queue.push(i);
+        }
+    }
+
+    std::ofstream outTerms(dir + DIR_SEP + "prefix.terms", std::ios_base::binary);
+    std::ofstream outOffsets(dir + DIR_SEP + "prefix.offsets", std::ios_base::binary);
+    int64_t offset = 0;
+    while (!queue.empty()) {
+        const int r = queue.top();
+        queue.pop();
+        TermRunReader &reader = *readers[r];
+        const int32_t size = reader.text.size();
+        outOffsets.write((const char*) &offset, 8);
+        outTerms.write((const char*) &reader.id, 8);
+        outTerms.write((const char*) &size, 4);
+        outTerms.write(reader.text.c_str(), size);
+        offset += 12 + size;
+        if (reader.next()) {
+            queue.push(r);
+        }
+    }
+}
+
+static void mergeGramRuns(std::string dir, const int nruns) {
+    std::vector<std::unique_ptr<GramRunReader>> readers;
+    auto cmp = [&readers](int r1, int r2) {
+        if (readers[r1]->gram != readers[r2]->gram) {
+            return readers[r1]->gram > readers[r2]->gram;
+        }
+        return readers[r1]->id > readers[r2]->id;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(cmp)> queue(cmp);
+    for (int i = 0; i < nruns; ++i) {
+        readers.push_back(std::unique_ptr<GramRunReader>(
+                    new GramRunReader(getRunFile(dir, "grams", i), i)));
+        if (readers.back()->next()) {
+            queue.push(i);
+        }
+    }
+
+    std::ofstream outGrams(dir + DIR_SEP + "grams", std::ios_base::binary);
+    std::ofstream outPostings(dir + DIR_SEP + "postings", std::ios_base::binary);
+    SearchIndex::GramEntry entry;
+    entry.gram = 0;
+    entry.padding = 0;
+    entry.offset = entry.count = 0;
+    int64_t prevId = 0;
+    while (!queue.empty()) {
+        const int r = queue.top();
+        queue.pop();
+        GramRunReader &reader = *readers[r];
+        if (entry.count == 0 || reader.gram != entry.gram) {
+            if (entry.count > 0) {
+                outGrams.write((const char*) &entry, sizeof(entry));
+            }
+            entry.gram = reader.gram;
+            entry.offset = outPostings.tellp();
+            entry.count = 0;
+            prevId = 0;
+        }
+        //The IDs of a gram are increasing, so only the deltas are stored
+        writeVLong(outPostings, reader.id - prevId);
+        prevId = reader.id;
+        entry.count++;
+        if (reader.next()) {
+            queue.push(r);
+        }
+    }
+    if (entry.count > 0) {
+        outGrams.write((const char*) &entry, sizeof(entry));
+    }
+}
+
+void SearchIndex::build(DictMgmt *dict, std::string dir, int64_t termsPerRun) {
+    LOG(INFOL) << "Building the search index in " << dir;
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    if (Utils::exists(dir)) {
+        Utils::remove_all(dir);
+    }
+    Utils::create_directories(dir);
+
+    TreeItr *itr = dict->getInvDictIterator();
+    StringBuffer *sb = dict->getStringBuffer();
+    std::unique_ptr<char[]> buffer(new char[MAX_TERM_SIZE]);
+    std::vector<std::pair<std::string, int64_t>> terms;
+    std::vector<std::pair<uint32_t, int64_t>> gramsRun;
+    std::vector<uint32_t> termGrams;
+    const size_t maxGramsPerRun = termsPerRun * 16;
+    int nruns = 0;
+    int64_t nterms = 0;
+    while (itr->hasNext()) {
+        int64_t coordinates;
+        const int64_t id = itr->next(coordinates);
+        int size = 0;
+        sb->get(coordinates, buffer.get(), size);
+        terms.push_back(std::make_pair(std::string(buffer.get(), size), id));
+        getGrams(buffer.get(), size, termGrams);
+        for (auto g : termGrams) {
+            gramsRun.push_back(std::make_pair(g, id));
+        }
+        nterms++;
+        if (terms.size() >= termsPerRun || gramsRun.size() >= maxGramsPerRun) {
+            writeRun(dir, nruns++, terms, gramsRun);
+            LOG(DEBUGL) << "Processed " << nterms << " terms";
+        }
+    }
+    delete itr;
+    if (!terms.empty() || nruns == 0) {
+        writeRun(dir, nruns++, terms, gramsRun);
+    }
+
+    mergeTermRuns(dir, nruns);
+    mergeGramRuns(dir, nruns);
+    for (int i = 0; i < nruns; ++i) {
+        Utils::remove(getRunFile(dir, "terms", i));
+        Utils::remove(getRunFile(dir, "grams", i));
+    }
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Search index with " << nterms << " terms built in " <<
+        sec.count() * 1000 << " ms";
+}
+
+bool SearchIndex::exists(std::string dir) {
+    return Utils::exists(dir + DIR_SEP + "grams");
+}
+
+std::unique_ptr<MemoryMappedFile> SearchIndex::open(std::string file) {
+    if (Utils::fileSize(file) == 0) {
+        //Empty files cannot be mapped
+        return std::unique_ptr<MemoryMappedFile>();
+    }
+    return std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(file));
+}
+
+SearchIndex::SearchIndex(std::string dir) {
+    if (!exists(dir)) {
+        LOG(ERRORL) << "The search index in " << dir << " does not exist";
+        throw 10;
+    }
+    prefixTerms = open(dir + DIR_SEP + "prefix.terms");
+    prefixOffsets = open(dir + DIR_SEP + "prefix.offsets");
+    grams = open(dir + DIR_SEP + "grams");
+    postings = open(dir + DIR_SEP + "postings");
+    nTerms = prefixOffsets ? prefixOffsets->getLength() / 8 : 0;
+    nGrams = grams ? grams->getLength() / sizeof(GramEntry) : 0;
+}
+
+void SearchIndex::getTerm(const int64_t idx, int64_t &id, const char *&text,
+        int &size) const {
+    int64_t offset;
+    memcpy(&offset, prefixOffsets->getData() + idx * 8, 8);
+    const char *record = prefixTerms->getData() + offset;
+    int32_t s;
+    memcpy(&id, record, 8);
+    memcpy(&s, record + 8, 4);
+    size = s;
+    text = record + 12;
+}
+
+const SearchIndex::GramEntry *SearchIndex::getGram(const uint32_t gram) const {
+    if (nGrams == 0) {
+        return NULL;
+    }
+    const GramEntry *begin = (const GramEntry*) grams->getData();
+    const GramEntry *end = begin + nGrams;
+    const GramEntry *it = std::lower_bound(begin, end, gram,
+            [](const GramEntry &e, const uint32_t g) {
+            return e.gram < g;
+            });
+    if (it != end && it->gram == gram) {
+        return it;
+    }
+    return NULL;
+}
+
+void SearchIndex::readPostings(const GramEntry *entry, const int64_t limit,
+        std::vector<int64_t> &ids) const {
+    const char *p = postings->getData() + entry->offset;
+    const int64_t n = std::min(entry->count, limit);
+    ids.resize(n);
+    int64_t id = 0;
+    for (int64_t i = 0; i < n; ++i) {
+        id += readVLong(p);
+        ids[i] = id;
+    }
+}
+
+//Reads the IDs of a posting list one at a time
+struct PostingCursor {
+    const char *p;
+    int64_t left;
+    int64_t id;
+
+    PostingCursor(const char *p, const int64_t count) : p(p), left(count),
+        id(0) {
+    }
+
+    bool next() {
+        if (left == 0) {
+            return false;
+        }
+        id += readVLong(p);
+        left--;
+        return true;
+    }
+
+    //Moves to the first ID >= target
+    bool advance(const int64_t target) {
+        while (id < target) {
+            if (!next()) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+//Decodes the candidates in batches and adds the ones that contain the text
+static void addMatches(const std::string &text, const bool verify,
+        const int64_t limit, DictMgmt *dict,
+        const std::vector<int64_t> &candidates,
+        std::vector<SearchIndex::Match> &out) {
+    const size_t batchSize = 4096;
+    std::vector<nTerm> batch;
+    std::vector<std::string> texts;
+    std::vector<bool> found;
+    for (size_t i = 0; i < candidates.size() && out.size() < limit;
+            i += batchSize) {
+        const size_t end = std::min(candidates.size(), i + batchSize);
+        batch.assign(candidates.begin() + i, candidates.begin() + end);
+        dict->getTexts(batch, texts, found);
+        for (size_t j = 0; j < batch.size() && out.size() < limit; ++j) {
+            if (found[j] && (!verify || texts[j].find(text) != std::string::npos)) {
+                out.push_back(std::make_pair(batch[j], texts[j]));
+            }
+        }
+    }
+}
+
+int64_t SearchIndex::lowerBound(const std::string &text) const {
+    int64_t s = 0;
+    int64_t e = nTerms;
+    int64_t id;
+    const char *t;
+    int size;
+    while (s < e) {
+        const int64_t m = s + (e - s) / 2;
+        getTerm(m, id, t, size);
+        if (cmpText(t, size, text) < 0) {
+            s = m + 1;
+        } else {
+            e = m;
+        }
+    }
+    return s;
+}
+
+bool SearchIndex::findExact(const std::string &text, int64_t &id) const {
+    const int64_t idx = lowerBound(text);
+    if (idx == nTerms) {
+        return false;
+    }
+    const char *t;
+    int size;
+    getTerm(idx, id, t, size);
+    return cmpText(t, size, text) == 0;
+}
+
+void SearchIndex::searchPrefix(const std::string &prefix, const int64_t limit,
+        std::vector<Match> &out) const {
+    int64_t id;
+    const char *text;
+    int size;
+    for (int64_t i = lowerBound(prefix); i < nTerms && out.size() < limit; ++i) {
+        getTerm(i, id, text, size);
+        if (size < prefix.size() ||
+                memcmp(text, prefix.c_str(), prefix.size()) != 0) {
+            break;
+        }
+        out.push_back(std::make_pair(id, std::string(text, size)));
+    }
+}
+
+void SearchIndex::searchSubstring(const std::string &text, const int64_t limit,
+        DictMgmt *dict, std::vector<Match> &out) const {
+    if (text.empty() || limit <= 0) {
+        return;
+    }
+    std::vector<int64_t> candidates;
+    if (text.size() < 3) {
+        //The terms shorter than three bytes that contain the text
+        std::vector<std::string> shortTerms;
+        shortTerms.push_back(text);
+        if (text.size() == 1) {
+            for (int c = 0; c < 256; ++c) {
+                shortTerms.push_back(std::string(1, (char) c) + text);
+                if (c != (uint8_t) text[0]) {
+                    shortTerms.push_back(text + std::string(1, (char) c));
+                }
+            }
+        }
+        for (const auto &t : shortTerms) {
+            int64_t id;
+            if (findExact(t, id)) {
+                candidates.push_back(id);
+            }
+        }
+        //Every other term with a trigram that contains the text is a match
+        const GramEntry *begin = nGrams > 0 ?
+            (const GramEntry*) grams->getData() : NULL;
+        std::vector<int64_t> ids;
+        for (int64_t i = 0; i < nGrams && candidates.size() < limit; ++i) {
+            char g[3];
+            g[0] = (char) (begin[i].gram >> 16);
+            g[1] = (char) (begin[i].gram >> 8);
+            g[2] = (char) begin[i].gram;
+            if (std::string(g, 3).find(text) != std::string::npos) {
+                readPostings(begin + i, limit - candidates.size(), ids);
+                candidates.insert(candidates.end(), ids.begin(), ids.end());
+                if (candidates.size() >= limit) {
+                    //A term can contain several of these trigrams
+                    std::sort(candidates.begin(), candidates.end());
+                    candidates.erase(std::unique(candidates.begin(),
+                                candidates.end()), candidates.end());
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()),
+                candidates.end());
+        addMatches(text, false, limit, dict, candidates, out);
+        return;
+    }
+
+    std::vector<uint32_t> queryGrams;
+    getGrams(text.c_str(), text.size(), queryGrams);
+    std::vector<const GramEntry*> entries;
+    for (auto g : queryGrams) {
+        const GramEntry *entry = getGram(g);
+        if (entry == NULL) {
+            return;
+        }
+        entries.push_back(entry);
+    }
+    //Start from the rarest trigrams
+    std::sort(entries.begin(), entries.end(),
+            [](const GramEntry *e1, const GramEntry *e2) {
+            return e1->count < e2->count;
+            });
+    if (entries[0]->count <= VERIFY_THRESHOLD) {
+        entries.resize(1);
+    }
+    std::vector<PostingCursor> cursors;
+    for (auto entry : entries) {
+        cursors.push_back(PostingCursor(postings->getData() + entry->offset,
+                    entry->count));
+    }
+    //A single trigram matches exactly
+    const bool verify = text.size() > 3;
+
+    //Intersect the lists a batch of candidates at a time, and check them
+    //before reading further
+    const size_t batchSize = 4096;
+    PostingCursor &first = cursors[0];
+    bool more = first.next();
+    while (more && out.size() < limit) {
+        candidates.clear();
+        while (more && candidates.size() < batchSize) {
+            bool match = true;
+            for (size_t i = 1; i < cursors.size(); ++i) {
+                if (!cursors[i].advance(first.id)) {
+                    more = false;
+                    break;
+                }
+                if (cursors[i].id > first.id) {
+                    //Skip to the next candidate of this list
+                    more = first.advance(cursors[i].id);
+                    match = false;
+                    break;
+                }
+            }
+            if (!more) {
+                break;
+            }
+            if (match) {
+                candidates.push_back(first.id);
+                more = first.next();
+            }
+        }
+        addMatches(text, verify, limit, dict, candidates, out);
+    }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017 Jacopo Urbani
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+**/
+
+
+
+#include <trident/kb/termcache.h>
+
+#include <cstring>
+
+bool TermCache::get(const uint64_t key, std::string &value) {
+    Shard &shard = getShard(key);
+#ifdef MT
+    std::lock_guard<std::mutex> lock(shard.mutex);
+#endif
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    value = it->second->second;
+    return true;
+}
+
+bool TermCache::get(const uint64_t key, char *value, int &size) {
+    Shard &shard = getShard(key);
+#ifdef MT
+    std::lock_guard<std::mutex> lock(shard.mutex);
+#endif
+    auto it = shard.index.find(key);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    const std::string &text = it->second->second;
+    size = text.size();
+    memcpy(value, text.c_str(), size);
+    return true;
+}
+
+void TermCache::put(const uint64_t key, const char *value, const int size) {
+    Shard &shard = getShard(key);
+#ifdef MT
+    std::lock_guard<std::mutex> lock(shard.mutex);
+#endif
+    if (shard.index.count(key)) {
+        return;
+    }
+    shard.lru.emplace_front(key, std::string(value, size));
+    shard.index.insert(std::make_pair(key, shard.lru.begin()));
+    shard.bytes += entrySize(shard.lru.front().second);
+    //Evict the least recently used terms
+    while (shard.bytes > maxBytesPerShard && !shard.lru.empty()) {
+        auto &last = shard.lru.back();
+        shard.bytes -= entrySize(last.second);
+        shard.index.erase(last.first);
+        shard.lru.pop_back();
+    }
+}
+
+int64_t TermCache::getSizeBytes() {
+    int64_t size = 0;
+    for (int i = 0; i < NSHARDS; ++i) {
+#ifdef MT
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+#endif
+        size += shards[i].bytes;
+    }
+    return size;
+}
+
+void TermCache::clear() {
+    for (int i = 0; i < NSHARDS; ++i) {
+#ifdef MT
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+#endif
+        shards[i].lru.clear();
+        shards[i].index.clear();
+        shards[i].bytes = 0;
+    }
+}
@@ -25,61 +25,215 @@
 #include <trident/kb/kb.h>
 #include <trident/kb/querier.h>
 #include <trident/kb/dictmgmt.h>
+#include <trident/kb/compactor.h>
 #include <trident/tree/stringbuffer.h>
 #include <trident/tree/root.h>
 
 #include <kognac/filereader.h>
+#include <kognac/lz4io.h>
 
 #include <string>
+#include <mutex>
+#include <atomic>
+#include <thread>
+
+//Chunks smaller than this are not split further
+#define UPDATE_MIN_CHUNK (16 * 1024 * 1024)
+//Number of shards of the map of the new terms
+#define UPDATE_NEWTERMS_SHARDS 64
+//Max number of terms cached by every parsing thread
+#define UPDATE_MAX_CACHED_TERMS 4000000
+
+struct Updater::ParseContext {
+    //Terms that are not in the dictionary. They are split in shards so that
+    //the threads seldom wait on each other
+    struct NewTerms {
+        std::mutex mutex;
+        StringCollection support;
+        ByteArrayToNumberMap map;
+
+        NewTerms() : support(1024 * 1024) {
+            map.set_empty_key(EMPTY_KEY);
+            map.set_deleted_key(DELETED_KEY);
+        }
+    };
+
+    DiffIndex::TypeUpdate type;
+    DictMgmt *dict;
+    std::vector<FileInfo> chunks;
+    std::atomic<size_t> nextChunk;
+    std::atomic<uint64_t> nextID;
+    NewTerms newTerms[UPDATE_NEWTERMS_SHARDS];
+
+    //The parsed triples are sorted and written in runs in this directory
+    string tmpdir;
+    size_t maxTriplesInMemory;
+    std::mutex runsMutex;
+    std::vector<string> runs;
+
+    std::atomic<int64_t> validTriples;
+    std::atomic<int64_t> invalidTriples;
+
+    ParseContext() : nextChunk(0), nextID(0), maxTriplesInMemory(0),
+    validTriples(0), invalidTriples(0) {}
+};
 
-void Updater::parseUpdate(std::string update,
-                          StringCollection &support,
-                          std::vector<TextualTriple> &output) {
+std::vector<FileInfo> Updater::splitUpdate(std::string update, int nthreads) {
     std::vector<std::string> filesToParse;
     if (Utils::isDirectory(update)) {
         //Read files. Ignore hidden ones.
         filesToParse = Utils::getFiles(update);
-        //J: The old code had a bug, I think 
     } else {
         filesToParse.push_back(update);
     }
 
-    //Parse all files. Populate the output of arrays
-    int64_t invalidtriples = 0;
-    int64_t validtriples = 0;
+    int64_t totalSize = 0;
+    for (auto file : filesToParse) {
+        totalSize += Utils::fileSize(file);
+    }
+    //A few chunks per thread, so that the threads finish at the same time
+    const int64_t chunkSize = std::max((int64_t) UPDATE_MIN_CHUNK,
+            totalSize / (nthreads * 4));
+
+    std::vector<FileInfo> chunks;
     for (auto file : filesToParse) {
         FileInfo filei;
         filei.path = file;
         filei.start = 0;
         filei.size = Utils::fileSize(file);
-        //Check whether the file terminates in *.gz
+        //Compressed files cannot be split
         if (Utils::ends_with(file, ".gz")) {
             filei.splittable = false;
+            chunks.push_back(filei);
+            continue;
+        }
+        filei.splittable = true;
+        const int64_t fileSize = filei.size;
+        for (int64_t start = 0; start < fileSize; start += chunkSize) {
+            filei.start = start;
+            filei.size = std::min(chunkSize, fileSize - start);
+            chunks.push_back(filei);
+        }
+    }
+    return chunks;
+}
+
+uint64_t Updater::encodeTerm(ParseContext *ctx,
+        std::unordered_map<std::string, uint64_t> &cache,
+        const char *term, int len) {
+    std::string key(term, len);
+    auto itr = cache.find(key);
+    if (itr != cache.end()) {
+        return itr->second;
+    }
+    if (cache.size() >= UPDATE_MAX_CACHED_TERMS) {
+        cache.clear();
+    }
+
+    nTerm id;
+    uint64_t value;
+    if (ctx->dict->getNumber(term, len, &id)) {
+        value = id;
+    } else if (ctx->type == DiffIndex::TypeUpdate::ADDITION_df) {
+        //Look in (or add to) the map of the new terms
+        char supportbuffer[MAX_TERM_SIZE + 2];
+        Utils::encode_short(supportbuffer, len);
+        memcpy(supportbuffer + 2, term, len);
+        ParseContext::NewTerms &shard = ctx->newTerms[
+            std::hash<std::string>()(key) % UPDATE_NEWTERMS_SHARDS];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto itr2 = shard.map.find(supportbuffer);
+        if (itr2 != shard.map.end()) {
+            value = itr2->second;
         } else {
-            filei.splittable = true;
+            value = ctx->nextID++;
+            const char *newentry = shard.support.addNew(supportbuffer,
+                    len + 2);
+            shard.map.insert(std::make_pair(newentry, value));
         }
-        FileReader reader(filei);
+    } else {
+        //Triples with unknown terms cannot be removed
+        value = UINT64_MAX;
+    }
+    cache.insert(std::make_pair(key, value));
+    return value;
+}
+
+static bool _Updater_lessTriple(const Triple &t1, const Triple &t2) {
+    if (t1.s != t2.s) {
+        return t1.s < t2.s;
+    } else if (t1.p != t2.p) {
+        return t1.p < t2.p;
+    }
+    return t1.o < t2.o;
+}
+
+static bool _Updater_equalTriple(const Triple &t1, const Triple &t2) {
+    return t1.s == t2.s && t1.p == t2.p && t1.o == t2.o;
+}
+
+void Updater::dumpRun(ParseContext *ctx, std::vector<Triple> &triples) {
+    if (triples.empty()) {
+        return;
+    }
+    std::sort(triples.begin(), triples.end(), _Updater_lessTriple);
+    auto newend = std::unique(triples.begin(), triples.end(),
+            _Updater_equalTriple);
+    triples.resize(std::distance(triples.begin(), newend));
+
+    string file;
+    {
+        std::lock_guard<std::mutex> lock(ctx->runsMutex);
+        file = ctx->tmpdir + DIR_SEP + "run-" + to_string(ctx->runs.size());
+        ctx->runs.push_back(file);
+    }
+    {
+        LZ4Writer writer(file);
+        for (auto &t : triples) {
+            t.writeTo(&writer);
+        }
+    }
+    LOG(DEBUGL) << "Written " << triples.size() << " triples in " << file;
+    triples.clear();
+}
+
+void Updater::parseUpdate(ParseContext *ctx) {
+    std::unordered_map<std::string, uint64_t> cache;
+    std::vector<Triple> triples;
+    int64_t validtriples = 0;
+    int64_t invalidtriples = 0;
+    size_t idxChunk;
+    while ((idxChunk = ctx->nextChunk++) < ctx->chunks.size()) {
+        FileReader reader(ctx->chunks[idxChunk]);
         while (reader.parseTriple()) {
             if (reader.isTripleValid()) {
-                TextualTriple t;
                 int length;
                 const char *s = reader.getCurrentS(length);
-                t.s = support.addNew(s, length);
-                t.lens = length;
+                const uint64_t nums = encodeTerm(ctx, cache, s, length);
                 const char *p = reader.getCurrentP(length);
-                t.p = support.addNew(p, length);
-                t.lenp = length;
+                const uint64_t nump = encodeTerm(ctx, cache, p, length);
                 const char *o = reader.getCurrentO(length);
-                t.o = support.addNew(o, length);
-                t.leno = length;
-                output.push_back(t);
+                const uint64_t numo = encodeTerm(ctx, cache, o, length);
                 validtriples++;
+                if (~nums && ~nump && ~numo) {
+                    Triple t;
+                    t.s = nums;
+                    t.p = nump;
+                    t.o = numo;
+                    t.count = 0;
+                    triples.push_back(t);
+                    if (triples.size() >= ctx->maxTriplesInMemory) {
+                        dumpRun(ctx, triples);
+                    }
+                }
             } else {
                 invalidtriples++;
             }
         }
     }
-    LOG(DEBUGL) << "Parsed " << validtriples << " invalid " << invalidtriples;
+    dumpRun(ctx, triples);
+    ctx->validTriples += validtriples;
+    ctx->invalidTriples += invalidtriples;
 }
 
 void Updater::writeDict(DictMgmt *dictmgmt,
@@ -153,170 +307,68 @@ void Updater::compressUpdate(DiffIndex::TypeUpdate type,
                              KB *kb,
                              Querier *q,
                              ByteArrayToNumberMap &tmpdict,
-                             StringCollection &tmpdictsupport) {
-    std::unique_ptr<char[]> supportbuffer(new char[MAX_TERM_SIZE + 2]);
-    Utils::encode_short(supportbuffer.get(), 0);
-    int64_t supportlen = 0;
-
+                             StringCollection &tmpdictsupport,
+                             int nthreads) {
+#ifndef MT
+    nthreads = 1;
+#endif
+    nthreads = std::max(1, nthreads);
     std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-    std::vector<Triple> parsedtriples;
-    {
-        //Read the update and parse the strings
-        std::vector<TextualTriple> triples;
-        StringCollection col(64 * 1024 * 1024);
-        parseUpdate(updatedir, col, triples);
-
-        //Load the existing dictionary
-        DictMgmt *dict = kb->getDictMgmt();
-        int64_t nextID = kb->getNextID();
-        int64_t previd = -1;
-
-        //Sort the update by s
-        std::sort(triples.begin(), triples.end(), sortByS);
-
-        //Convert all s into numbers
-        for (auto itr = triples.begin(); itr != triples.end(); ++itr) {
-            if (supportlen == itr->lens &&
-                    memcmp(itr->s, supportbuffer.get() + 2, supportlen) == 0) {
-                itr->nums = previd;
-            } else {
-                memcpy(supportbuffer.get() + 2, itr->s, itr->lens);
-                Utils::encode_short(supportbuffer.get(), itr->lens);
-                supportlen = itr->lens;
-
-                nTerm id;
-                bool resp = dict->getNumber(itr->s, itr->lens, &id);
-                if (resp) {
-                    itr->nums = id;
-                } else {
-                    if (type == DiffIndex::TypeUpdate::ADDITION_df) {
-                        //Add a new entry in the temporary dictionary
-                        itr->nums = nextID;
-                        const char *newentry = tmpdictsupport.addNew(supportbuffer.get(),
-                                               itr->lens + 2);
-                        tmpdict.insert(std::make_pair(newentry, nextID));
-                        nextID++;
-                    } else {
-                        itr->nums = UINT64_MAX;
-                        continue;
-                    }
-                }
-                previd = itr->nums;
-            }
-        }
 
-        //Sort the update by p
-        std::sort(triples.begin(), triples.end(), sortByP);
-        supportlen = 0;
-        Utils::encode_short(supportbuffer.get(), 0);
-
-        //Convert all p into numbers
-        for (auto itr = triples.begin(); itr != triples.end(); ++itr) {
-            if (supportlen == itr->lenp &&
-                    memcmp(itr->p, supportbuffer.get() + 2, supportlen) == 0) {
-                itr->nump = previd;
-            } else {
-                memcpy(supportbuffer.get() + 2, itr->p, itr->lenp);
-                Utils::encode_short(supportbuffer.get(), itr->lenp);
-                supportlen = itr->lenp;
-
-                nTerm id;
-                bool resp = dict->getNumber(itr->p, itr->lenp, &id);
-                if (resp) {
-                    itr->nump = id;
-                } else {
-                    if (type == DiffIndex::TypeUpdate::ADDITION_df) {
-                        //Is it existing in the tmp dict already?
-                        if (tmpdict.count(supportbuffer.get())) {
-                            auto itr2 = tmpdict.find(supportbuffer.get());
-                            itr->nump = itr2->second;
-                        } else {
-                            //Add a new entry in the temporary dictionary
-                            itr->nump = nextID;
-                            const char *newentry = tmpdictsupport.addNew(supportbuffer.get(),
-                                                   itr->lenp + 2);
-                            tmpdict.insert(std::make_pair(newentry, nextID));
-                            nextID++;
-                        }
-                    } else {
-                        itr->nump = UINT64_MAX;
-                        continue;
-                    }
-                }
-                previd = itr->nump;
-            }
-        }
-
-        //Sort the update by o
-        std::sort(triples.begin(), triples.end(), sortByO);
-        supportlen = 0;
-        Utils::encode_short(supportbuffer.get(), 0);
-
-        //Convert all o into numbers
-        for (auto itr = triples.begin(); itr != triples.end(); ++itr) {
-            if (supportlen == itr->leno &&
-                    memcmp(itr->o, supportbuffer.get() + 2, supportlen) == 0) {
-                itr->numo = previd;
-            } else {
-                memcpy(supportbuffer.get() + 2, itr->o, itr->leno);
-                Utils::encode_short(supportbuffer.get(), itr->leno);
-                supportlen = itr->leno;
-
-                nTerm id;
-                bool resp = dict->getNumber(itr->o, itr->leno, &id);
-                if (resp) {
-                    itr->numo = id;
-                } else {
-                    if (type == DiffIndex::TypeUpdate::ADDITION_df) {
-                        //Is it existing in the tmp dict already?
-                        if (tmpdict.count(supportbuffer.get())) {
-                            auto itr2 = tmpdict.find(supportbuffer.get());
-                            itr->numo = itr2->second;
-                        } else {
-                            //Add a new entry in the temporary dictionary
-                            itr->numo = nextID;
-                            const char *newentry = tmpdictsupport.addNew(supportbuffer.get(),
-                                                   itr->leno + 2);
-                            tmpdict.insert(std::make_pair(newentry, nextID));
-                            nextID++;
-                        }
-                    } else {
-                        itr->numo = UINT64_MAX;
-                        continue;
-                    }
-                }
-                previd = itr->numo;
-            }
-        }
-
-        for (auto itr = triples.begin(); itr != triples.end(); ++itr) {
-            if (~itr->nums && ~itr->nump && ~itr->numo) {
-                Triple t;
-                t.s = itr->nums;
-                t.p = itr->nump;
-                t.o = itr->numo;
-                parsedtriples.push_back(t);
-            }
+    //Parse and encode the chunks of the update in parallel. Every thread
+    //writes sorted runs of encoded triples on disk
+    ParseContext ctx;
+    ctx.type = type;
+    ctx.dict = kb->getDictMgmt();
+    ctx.chunks = splitUpdate(updatedir, nthreads);
+    ctx.nextID = kb->getNextID();
+    ctx.tmpdir = kb->getPath() + DIR_SEP + "_updatetmp";
+    ctx.maxTriplesInMemory = std::max((size_t) 1000000,
+            (size_t) (Utils::getSystemMemory() * 0.3 / (nthreads * sizeof(Triple))));
+    if (Utils::exists(ctx.tmpdir)) {
+        Utils::remove_all(ctx.tmpdir);
+    }
+    Utils::create_directories(ctx.tmpdir);
+    LOG(DEBUGL) << "Parsing " << ctx.chunks.size() << " chunks with "
+        << nthreads << " threads";
+
+#ifdef MT
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nthreads; ++i) {
+        threads.push_back(std::thread(&Updater::parseUpdate, &ctx));
+    }
+#endif
+    parseUpdate(&ctx);
+#ifdef MT
+    for (auto &t : threads) {
+        t.join();
+    }
+#endif
+    LOG(DEBUGL) << "Parsed " << ctx.validTriples << " invalid " << ctx.invalidTriples;
+
+    //Copy the new terms in the temporary dictionary
+    for (int i = 0; i < UPDATE_NEWTERMS_SHARDS; ++i) {
+        for (auto itr = ctx.newTerms[i].map.begin();
+                itr != ctx.newTerms[i].map.end(); ++itr) {
+            const char *newentry = tmpdictsupport.addNew(itr->first,
+                    Utils::decode_short(itr->first) + 2);
+            tmpdict.insert(std::make_pair(newentry, itr->second));
         }
     }
 
-    //Re-sort the numeric triples.
-    std::sort(parsedtriples.begin(), parsedtriples.end(), Triple::sorter);
-
-    //Remove duplicates...
-    auto newend = std::unique(parsedtriples.begin(), parsedtriples.end(),
-                              Triple::equal);
-    parsedtriples.resize(std::distance(parsedtriples.begin(), newend));
-
-    //Add triples that are either not existing (ADD) or existing (REMOVE) ...
-    match(type, all_s, all_p, all_o, q, parsedtriples);
+    //Merge the runs and add triples that are either not existing (ADD) or
+    //existing (REMOVE) ...
+    if (!ctx.runs.empty()) {
+        FileMerger<Triple> merger(ctx.runs, true, false);
+        match(type, all_s, all_p, all_o, q, merger);
+    }
+    Utils::remove_all(ctx.tmpdir);
     std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
     LOG(DEBUGL) << "Runtime compressing and filtering the update = " << sec.count() * 1000;
-
 }
 
 void Updater::creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir,
-                               std::string updatedir) {
+                               std::string updatedir, int nthreads) {
     std::chrono::system_clock::time_point startdiff = std::chrono::system_clock::now();
     std::vector<uint64_t> all_s;
     std::vector<uint64_t> all_p;
@@ -328,20 +380,24 @@ void Updater::creatediffupdate(DiffIndex::TypeUpdate type, std::string kbdir,
     tmpdict.set_empty_key(EMPTY_KEY);
     tmpdict.set_deleted_key(DELETED_KEY);
 
+    //A compaction cannot commit a new generation while the update is written
+    //in the current one
+    Compactor::UpdateLock lock(kbdir);
     KBConfig config;
     KB kb(kbdir.c_str(), true, false, true, config);
     Querier *q = kb.query();
 
     compressUpdate(type, updatedir, all_s, all_p, all_o, &kb, q,
-                   tmpdict, tmpdictsupport);
+                   tmpdict, tmpdictsupport, nthreads);
 
     if (!all_s.empty()) {
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         //Get the location to store the update
-        string locationupdate = getPathForUpdate(kbdir);
+        //The updates go to the generation that was opened
+        string locationupdate = getPathForUpdate(kb.getPath());
 
         //Launch the procedure that is creating the index
-        DiffIndex3::createDiffIndex(type, locationupdate, kbdir + "/_diff", all_s, all_p, all_o,
+        DiffIndex3::createDiffIndex(type, locationupdate, kb.getPath() + "/_diff", all_s, all_p, all_o,
                                     true, q, true);
 
         //Write the type of file
@@ -389,7 +445,7 @@ void Updater::match(DiffIndex::TypeUpdate type,
                     std::vector<uint64_t> &outputp,
                     std::vector<uint64_t> &outputo,
                     Querier *q,
-                    std::vector<Triple> &input) {
+                    FileMerger<Triple> &input) {
 
     PairItr *kbitr = q->get(IDX_SPO, -1, -1, -1);
     if (kbitr->hasNext()) {
@@ -399,10 +455,19 @@ void Updater::match(DiffIndex::TypeUpdate type,
         kbitr = NULL;
     }
 
-    auto itr = input.begin();
-    while (itr != input.end()) {
+    bool first = true;
+    Triple prev;
+    while (!input.isEmpty()) {
+        Triple t = input.get();
+        //The same triple can appear in the runs of several threads
+        if (!first && _Updater_equalTriple(prev, t)) {
+            continue;
+        }
+        first = false;
+        prev = t;
+
         //move kbitr to the good position
-        while (kbitr && cmp(kbitr, *itr) < 0) {
+        while (kbitr && cmp(kbitr, t) < 0) {
             if (kbitr->hasNext()) {
                 kbitr->next();
             } else {
@@ -412,43 +477,38 @@ void Updater::match(DiffIndex::TypeUpdate type,
         }
         if (kbitr) {
             //do the check
-            int res = cmp(kbitr, *itr);
+            int res = cmp(kbitr, t);
             if (type == DiffIndex::TypeUpdate::ADDITION_df) {
                 if (res != 0) {
-                    outputs.push_back(itr->s);
-                    outputp.push_back(itr->p);
-                    outputo.push_back(itr->o);
+                    outputs.push_back(t.s);
+                    outputp.push_back(t.p);
+                    outputo.push_back(t.o);
                 }
             } else {
                 if (res == 0) {
-                    outputs.push_back(itr->s);
-                    outputp.push_back(itr->p);
-                    outputo.push_back(itr->o);
+                    outputs.push_back(t.s);
+                    outputp.push_back(t.p);
+                    outputo.push_back(t.o);
                     //Must move also the original iterator
                     if (kbitr->hasNext()) {
                         kbitr->next();
                     } else {
-                        break;
+                        q->releaseItr(kbitr);
+                        kbitr = NULL;
                     }
                 }
             }
-            itr++;
+        } else if (type == DiffIndex::TypeUpdate::ADDITION_df) {
+            //Copy all remaining tuples
+            outputs.push_back(t.s);
+            outputp.push_back(t.p);
+            outputo.push_back(t.o);
         } else {
             break;
         }
     }
     if (kbitr)
         q->releaseItr(kbitr);
-
-    //Copy all remaining tuples
-    if (type == DiffIndex::TypeUpdate::ADDITION_df) {
-        while (itr != input.end()) {
-            outputs.push_back(itr->s);
-            outputp.push_back(itr->p);
-            outputo.push_back(itr->o);
-            itr++;
-        }
-    }
 }
 
 int Updater::cmp(PairItr *itr, const Triple &t) {
@@ -1,6 +1,7 @@
 #include <trident/ml/batch.h>
 #include <trident/kb/kb.h>
 #include <trident/kb/querier.h>
+#include <trident/binarytables/forcolumntable.h>
 
 #include <fstream>
 #include <algorithm>
@@ -319,6 +320,9 @@ void BatchCreator::KBBatch::populateCoordinates() {
             const char nbytes1 = (currentStrat >> 3) & 3;
             const char nbytes2 = (currentStrat >> 1) & 3;
             FactoryNewRowTable::get12Reader(nbytes1, nbytes2, &info.reader);
+        } else if (storageType == FORCOLUMN_STORAGE) {
+            //The reader decodes the header of the table by itself
+            info.reader = &FORColumnTable::s_getValue12AtRow;
         } else {
             LOG(ERRORL) << "Not supported";
             throw 10;
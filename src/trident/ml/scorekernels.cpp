@@ -0,0 +1,154 @@
+#include <trident/ml/scorekernels.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCOREKERNELS_X86
+#include <immintrin.h>
+#endif
+
+//The scalar kernels use four independent sums so that the additions of
+//consecutive dimensions do not wait on each other
+void ScoreKernels::l1_scalar(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    for (uint64_t r = 0; r < n; ++r) {
+        const double *e = entities + r * dim;
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        uint16_t i = 0;
+        for (; i + 4 <= dim; i += 4) {
+            s0 += std::fabs(query[i] - e[i]);
+            s1 += std::fabs(query[i + 1] - e[i + 1]);
+            s2 += std::fabs(query[i + 2] - e[i + 2]);
+            s3 += std::fabs(query[i + 3] - e[i + 3]);
+        }
+        for (; i < dim; ++i) {
+            s0 += std::fabs(query[i] - e[i]);
+        }
+        out[r] = (s0 + s1) + (s2 + s3);
+    }
+}
+
+void ScoreKernels::negDot_scalar(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    for (uint64_t r = 0; r < n; ++r) {
+        const double *e = entities + r * dim;
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        uint16_t i = 0;
+        for (; i + 4 <= dim; i += 4) {
+            s0 += query[i] * e[i];
+            s1 += query[i + 1] * e[i + 1];
+            s2 += query[i + 2] * e[i + 2];
+            s3 += query[i + 3] * e[i + 3];
+        }
+        for (; i < dim; ++i) {
+            s0 += query[i] * e[i];
+        }
+        out[r] = -((s0 + s1) + (s2 + s3));
+    }
+}
+
+#ifdef SCOREKERNELS_X86
+__attribute__((target("avx2")))
+static inline double _hsum(const __m256d v) {
+    const __m128d lo = _mm256_castpd256_pd128(v);
+    const __m128d hi = _mm256_extractf128_pd(v, 1);
+    const __m128d s = _mm_add_pd(lo, hi);
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2")))
+void ScoreKernels::l1_avx2(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    const __m256d signmask = _mm256_set1_pd(-0.0);
+    for (uint64_t r = 0; r < n; ++r) {
+        const double *e = entities + r * dim;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        uint16_t i = 0;
+        for (; i + 8 <= dim; i += 8) {
+            const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(query + i),
+                    _mm256_loadu_pd(e + i));
+            const __m256d d1 = _mm256_sub_pd(_mm256_loadu_pd(query + i + 4),
+                    _mm256_loadu_pd(e + i + 4));
+            acc0 = _mm256_add_pd(acc0, _mm256_andnot_pd(signmask, d0));
+            acc1 = _mm256_add_pd(acc1, _mm256_andnot_pd(signmask, d1));
+        }
+        if (i + 4 <= dim) {
+            const __m256d d0 = _mm256_sub_pd(_mm256_loadu_pd(query + i),
+                    _mm256_loadu_pd(e + i));
+            acc0 = _mm256_add_pd(acc0, _mm256_andnot_pd(signmask, d0));
+            i += 4;
+        }
+        double res = _hsum(_mm256_add_pd(acc0, acc1));
+        for (; i < dim; ++i) {
+            res += std::fabs(query[i] - e[i]);
+        }
+        out[r] = res;
+    }
+}
+
+__attribute__((target("avx2")))
+void ScoreKernels::negDot_avx2(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    for (uint64_t r = 0; r < n; ++r) {
+        const double *e = entities + r * dim;
+        __m256d acc0 = _mm256_setzero_pd();
+        __m256d acc1 = _mm256_setzero_pd();
+        uint16_t i = 0;
+        for (; i + 8 <= dim; i += 8) {
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(
+                        _mm256_loadu_pd(query + i), _mm256_loadu_pd(e + i)));
+            acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(
+                        _mm256_loadu_pd(query + i + 4),
+                        _mm256_loadu_pd(e + i + 4)));
+        }
+        if (i + 4 <= dim) {
+            acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(
+                        _mm256_loadu_pd(query + i), _mm256_loadu_pd(e + i)));
+            i += 4;
+        }
+        double res = _hsum(_mm256_add_pd(acc0, acc1));
+        for (; i < dim; ++i) {
+            res += query[i] * e[i];
+        }
+        out[r] = -res;
+    }
+}
+
+bool ScoreKernels::isAVX2Supported() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+#else
+void ScoreKernels::l1_avx2(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    l1_scalar(query, entities, n, dim, out);
+}
+
+void ScoreKernels::negDot_avx2(const double *query, const double *entities,
+        const uint64_t n, const uint16_t dim, double *out) {
+    negDot_scalar(query, entities, n, dim, out);
+}
+
+bool ScoreKernels::isAVX2Supported() {
+    return false;
+}
+#endif
+
+//Set by select() the first time that a kernel is used
+ScoreKernels::Kernel ScoreKernels::l1Kernel = NULL;
+ScoreKernels::Kernel ScoreKernels::negDotKernel = NULL;
+std::once_flag ScoreKernels::selected;
+
+void ScoreKernels::select() {
+    if (isAVX2Supported()) {
+        l1Kernel = &ScoreKernels::l1_avx2;
+        negDotKernel = &ScoreKernels::negDot_avx2;
+    } else {
+        l1Kernel = &ScoreKernels::l1_scalar;
+        negDotKernel = &ScoreKernels::negDot_scalar;
+    }
+}
+
+const char *ScoreKernels::getKernelName() {
+    init();
+    return l1Kernel == &ScoreKernels::l1_avx2 ? "avx2" : "scalar";
+}
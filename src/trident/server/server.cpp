@@ -20,13 +20,62 @@
 #include <chrono>
 #include <thread>
 #include <regex>
+#include <algorithm>
+#include <cstring>
 
 TridentServer::TridentServer(KB &kb, string htmlfiles, int nthreads) :
-    kb(kb),
     dirhtmlfiles(htmlfiles),
-    isActive(false), nthreads(nthreads) {
+    activeRequests(0), nthreads(nthreads) {
+        compactor = NULL;
+        //The KB is owned by the caller
+        init(std::shared_ptr<KB>(&kb, [](KB*) {}));
+    }
+
+TridentServer::TridentServer(Compactor &compactor, string htmlfiles,
+        int nthreads) :
+    dirhtmlfiles(htmlfiles),
+    activeRequests(0), nthreads(nthreads) {
+        this->compactor = &compactor;
+        init(compactor.getKB());
+    }
 
+void TridentServer::init(std::shared_ptr<KB> kb) {
+    nQueries = 0;
+    memset(&querierCounters, 0, sizeof(Querier::Counters));
+#ifndef MT
+    if (nthreads > 1) {
+        LOG(WARNL) << "Trident is compiled without multithreading support"
+            " (-DMT=1). Queries from different web threads may interfere";
+    }
+#endif
+    //Each worker gets its own layer, so that queries can run concurrently
+    for (int i = 0; i < std::max(1, nthreads); ++i) {
+        std::unique_ptr<Worker> w(new Worker());
+        w->kb = kb;
+        w->layer = std::unique_ptr<TridentLayer>(new TridentLayer(*kb));
+        freeWorkers.push(w.get());
+        workers.push_back(std::move(w));
     }
+}
+
+TridentServer::Worker *TridentServer::acquireWorker() {
+    Worker *w;
+    freeWorkers.pop_wait(w);
+    if (compactor != NULL) {
+        std::shared_ptr<KB> kb = compactor->getKB();
+        if (kb != w->kb) {
+            //The layer must go before the KB of the old generation
+            w->layer.reset();
+            w->kb = kb;
+            w->layer = std::unique_ptr<TridentLayer>(new TridentLayer(*kb));
+        }
+    }
+    return w;
+}
+
+void TridentServer::releaseWorker(Worker *w) {
+    freeWorkers.push(w);
+}
 
 void TridentServer::startThread(int port) {
     this->webport = port;
@@ -44,7 +93,7 @@ void TridentServer::start(int port) {
 
 void TridentServer::stop() {
     LOG(INFOL) << "Stopping server ...";
-    while (isActive) {
+    while (activeRequests > 0) {
         std::this_thread::sleep_for(chrono::milliseconds(100));
     }
     server->stop();
@@ -66,6 +115,33 @@ string _getValueParam(string req, string param) {
     }
 }
 
+//Bind parameters are sent as bind_<name>=<term>
+std::map<string, string> _getBindParams(string req) {
+    std::map<string, string> params;
+    size_t pos = 0;
+    while ((pos = req.find("bind_", pos)) != string::npos) {
+        //Only at the beginning of a field
+        if (pos > 0 && req[pos - 1] != '&' && req[pos - 1] != '\n') {
+            pos++;
+            continue;
+        }
+        size_t posvalue = req.find("=", pos);
+        if (posvalue == string::npos) {
+            break;
+        }
+        size_t posend = req.find("&", posvalue);
+        if (posend == string::npos) {
+            posend = req.size();
+        }
+        string name = req.substr(pos + 5, posvalue - pos - 5);
+        string value = req.substr(posvalue + 1, posend - posvalue - 1);
+        std::replace(value.begin(), value.end(), '+', ' ');
+        params[name] = HttpClient::unescape(value);
+        pos = posend;
+    }
+    return params;
+}
+
 string TridentServer::lookup(string sId, TridentLayer &db) {
     const char *start;
     const char *end;
@@ -77,7 +153,122 @@ string TridentServer::lookup(string sId, TridentLayer &db) {
 }
 
 void TridentServer::processRequest(std::string req, std::string &res) {
-    setActive();
+    Worker *w = acquireWorker();
+    try {
+        handleRequest(req, res, *w->layer);
+    } catch (...) {
+        collectCounters(*w->layer);
+        releaseWorker(w);
+        throw;
+    }
+    collectCounters(*w->layer);
+    releaseWorker(w);
+}
+
+void TridentServer::collectCounters(TridentLayer &db) {
+    Querier *q = db.getQuerier();
+    Querier::Counters c = q->getCounters();
+    q->resetCounters();
+    std::lock_guard<std::mutex> lock(countersMutex);
+    querierCounters.statsRow += c.statsRow;
+    querierCounters.statsColumn += c.statsColumn;
+    querierCounters.statsCluster += c.statsCluster;
+    querierCounters.aggrIndices += c.aggrIndices;
+    querierCounters.notAggrIndices += c.notAggrIndices;
+    querierCounters.cacheIndices += c.cacheIndices;
+    querierCounters.spo += c.spo;
+    querierCounters.ops += c.ops;
+    querierCounters.pos += c.pos;
+    querierCounters.sop += c.sop;
+    querierCounters.osp += c.osp;
+    querierCounters.pso += c.pso;
+}
+
+static double _hitRate(uint64_t accesses, uint64_t misses) {
+    if (accesses == 0 || misses > accesses) {
+        return 0;
+    }
+    return 1.0 - (double)misses / accesses;
+}
+
+string TridentServer::getMetrics(TridentLayer &db) {
+    JSON pt;
+    pt.put("queries", (unsigned long)nQueries.load());
+
+    JSON latency;
+    JSON lparse, lplan, lexecute, ldecode, ltotal;
+    latencyParse.toJSON(lparse);
+    latencyPlan.toJSON(lplan);
+    latencyExecute.toJSON(lexecute);
+    latencyDecode.toJSON(ldecode);
+    latencyTotal.toJSON(ltotal);
+    latency.add_child("parse", lparse);
+    latency.add_child("plan", lplan);
+    latency.add_child("execute", lexecute);
+    latency.add_child("decode", ldecode);
+    latency.add_child("total", ltotal);
+    pt.add_child("latency", latency);
+
+    JSON querier;
+    {
+        std::lock_guard<std::mutex> lock(countersMutex);
+        const Querier::Counters &c = querierCounters;
+        querier.put("rowLayouts", (long)c.statsRow);
+        querier.put("columnLayouts", (long)c.statsColumn);
+        querier.put("clusterLayouts", (long)c.statsCluster);
+        querier.put("aggrIndices", (long)c.aggrIndices);
+        querier.put("notAggrIndices", (long)c.notAggrIndices);
+        querier.put("cacheIndices", (long)c.cacheIndices);
+        querier.put("spo", (long)c.spo);
+        querier.put("ops", (long)c.ops);
+        querier.put("pos", (long)c.pos);
+        querier.put("sop", (long)c.sop);
+        querier.put("osp", (long)c.osp);
+        querier.put("pso", (long)c.pso);
+    }
+    pt.add_child("querier", querier);
+
+    //The caches belong to the KB served by this worker
+    KB::CacheCounters c = db.getKB()->getCacheCounters();
+    JSON caches;
+    JSON files;
+    files.put("accesses", (unsigned long)c.fileAccesses);
+    files.put("opens", (unsigned long)c.fileOpens);
+    files.put("closes", (unsigned long)c.fileCloses);
+    files.put("hitrate", _hitRate(c.fileAccesses, c.fileOpens));
+    caches.add_child("files", files);
+    JSON memory;
+    memory.put("bytes", (unsigned long)c.memBytes);
+    memory.put("evictions", (unsigned long)c.memEvictions);
+    caches.add_child("memory", memory);
+    JSON dict;
+    dict.put("accesses", (unsigned long)c.dictBlockAccesses);
+    dict.put("reads", (unsigned long)c.dictBlockReads);
+    dict.put("bytesRead", (unsigned long)c.dictBytesRead);
+    dict.put("evictions", (unsigned long)c.dictBlockEvictions);
+    dict.put("hitrate", _hitRate(c.dictBlockAccesses, c.dictBlockReads));
+    caches.add_child("dictblocks", dict);
+    JSON nodes;
+    nodes.put("accesses", (unsigned long)c.nodeAccesses);
+    nodes.put("loads", (unsigned long)c.nodeLoads);
+    nodes.put("hitrate", _hitRate(c.nodeAccesses, c.nodeLoads));
+    caches.add_child("treenodes", nodes);
+    pt.add_child("caches", caches);
+
+    JSON plans;
+    plans.put("size", (unsigned long)plancache.size());
+    plans.put("hits", (unsigned long)plancache.getHits());
+    plans.put("misses", (unsigned long)plancache.getMisses());
+    pt.add_child("plancache", plans);
+
+    std::ostringstream buf;
+    JSON::write(buf, pt);
+    return buf.str();
+}
+
+void TridentServer::handleRequest(std::string req, std::string &res,
+        TridentLayer &db) {
+    ActiveRequest active(*this);
     //Get the page
     string page;
     string message = "";
@@ -110,15 +301,26 @@ void TridentServer::processRequest(std::string req, std::string &res) {
             JSON bindings;
             JSON stats;
             bool jsonoutput = printresults != string("false");
+            std::map<string, string> params = _getBindParams(form);
+            SPARQLUtils::Timings timings;
+            std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
             SPARQLUtils::execSPARQLQuery(sparqlquery,
-                    false,
-                    kb.getNTerms(),
-                    kb,
+                    params,
+                    plancache,
+                    db,
                     false,
                     jsonoutput,
                     &vars,
                     &bindings,
-                    &stats);
+                    &stats,
+                    &timings);
+            std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
+            nQueries++;
+            latencyParse.add(timings.parse);
+            latencyPlan.add(timings.plan);
+            latencyExecute.add(timings.execute);
+            latencyDecode.add(timings.decode);
+            latencyTotal.add(duration.count());
             JSON head;
             head.add_child("vars", vars);
             pt.add_child("head", head);
@@ -135,13 +337,45 @@ void TridentServer::processRequest(std::string req, std::string &res) {
             string form = req.substr(req.find("application/x-www-form-urlencoded"));
             string id = _getValueParam(form, "id");
             //Lookup the value
-            string value = lookup(id, kb);
+            string value = lookup(id, db);
             JSON pt;
             pt.put("value", value);
             std::ostringstream buf;
             JSON::write(buf, pt);
             page = buf.str();
             isjson = true;
+        } else if (path == "/search") {
+            string form = req.substr(req.find("application/x-www-form-urlencoded"));
+            string text = HttpClient::unescape(_getValueParam(form, "text"));
+            string mode = _getValueParam(form, "mode");
+            string sLimit = _getValueParam(form, "limit");
+            int64_t limit = sLimit == "" ? 100 : stol(sLimit);
+            JSON pt;
+            KB &kb = *db.getKB();
+            SearchIndex *index = kb.getSearchIndex();
+            if (index == NULL) {
+                pt.put("error", string("The search index was not built or the KB must be compacted"));
+            } else {
+                std::vector<SearchIndex::Match> matches;
+                if (mode == "prefix") {
+                    index->searchPrefix(text, limit, matches);
+                } else {
+                    index->searchSubstring(text, limit, kb.getDictMgmt(),
+                            matches);
+                }
+                JSON results;
+                for (const auto &m : matches) {
+                    JSON match;
+                    match.put("id", (long)m.first);
+                    match.put("value", m.second);
+                    results.push_back(match);
+                }
+                pt.add_child("results", results);
+            }
+            std::ostringstream buf;
+            JSON::write(buf, pt);
+            page = buf.str();
+            isjson = true;
         } else {
             page = "Error!";
         }
@@ -149,7 +383,10 @@ void TridentServer::processRequest(std::string req, std::string &res) {
         //Get the page
         int pos = req.find("HTTP");
         string path = req.substr(4, pos - 5);
-        if (path.size() > 1) {
+        if (path == "/metrics") {
+            page = getMetrics(db);
+            isjson = true;
+        } else if (path.size() > 1) {
             page = getPage(path);
         }
     }
@@ -172,8 +409,6 @@ void TridentServer::processRequest(std::string req, std::string &res) {
       shared_from_this(),
       boost::asio::placeholders::error,
       boost::asio::placeholders::bytes_transferred));*/
-
-    setInactive();
 }
 
 /*void TridentServer::Server::writeHandler(const boost::system::error_code &err,
@@ -187,6 +422,7 @@ string TridentServer::getDefaultPage() {
 }
 
 string TridentServer::getPage(string f) {
+    std::lock_guard<std::mutex> lock(cachehtmlMutex);
     if (cachehtml.count(f)) {
         return cachehtml.find(f)->second;
     }
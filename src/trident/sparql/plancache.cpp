@@ -0,0 +1,106 @@
+#include <trident/sparql/plancache.h>
+
+#include <layers/TridentLayer.hpp>
+
+#include <kognac/logs.h>
+
+SPARQLPlanCache::SPARQLPlanCache(size_t capacity) : capacity(capacity),
+    hits(0), misses(0) {
+}
+
+std::string SPARQLPlanCache::getKey(const std::string &query,
+        const std::map<std::string, std::string> &params) {
+    //Two queries that differ only in the spacing or comments have the same
+    //sequence of tokens
+    std::string key;
+    SPARQLLexer lexer(query);
+    while (true) {
+        SPARQLLexer::Token token = lexer.getNext();
+        if (token == SPARQLLexer::Eof || token == SPARQLLexer::Error) {
+            break;
+        }
+        key += (char)('A' + token);
+        key += lexer.getTokenValue();
+        key += '\0';
+    }
+    //The values of the parameters are not part of the key
+    for (const auto &p : params) {
+        key += '\1';
+        key += p.first;
+    }
+    return key;
+}
+
+std::string SPARQLPlanCache::getKBVersion(TridentLayer &db) {
+    //Every generation of the KB is stored in a different directory
+    KB *kb = db.getKB();
+    return kb->getPath() + "#" + std::to_string(kb->getNTerms());
+}
+
+void SPARQLPlanCache::checkVersion(TridentLayer &db) {
+    std::string version = getKBVersion(db);
+    if (version != kbversion) {
+        if (!entries.empty()) {
+            LOG(DEBUGL) << "The KB has changed. Dropping "
+                << entries.size() << " cached plans";
+        }
+        entries.clear();
+        lru.clear();
+        kbversion = version;
+    }
+}
+
+std::shared_ptr<SPARQLPlanCache::Entry> SPARQLPlanCache::get(
+        const std::string &key, TridentLayer &db) {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkVersion(db);
+    auto itr = entries.find(key);
+    if (itr == entries.end()) {
+        misses++;
+        return std::shared_ptr<Entry>();
+    }
+    hits++;
+    lru.splice(lru.begin(), lru, itr->second.second);
+    return itr->second.first;
+}
+
+void SPARQLPlanCache::put(const std::string &key, TridentLayer &db,
+        std::shared_ptr<Entry> entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkVersion(db);
+    auto itr = entries.find(key);
+    if (itr != entries.end()) {
+        //Another thread was faster
+        return;
+    }
+    if (capacity == 0) {
+        return;
+    }
+    while (entries.size() >= capacity) {
+        entries.erase(lru.back());
+        lru.pop_back();
+    }
+    lru.push_front(key);
+    entries.insert(std::make_pair(key, std::make_pair(entry, lru.begin())));
+}
+
+void SPARQLPlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    lru.clear();
+}
+
+size_t SPARQLPlanCache::size() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+uint64_t SPARQLPlanCache::getHits() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hits;
+}
+
+uint64_t SPARQLPlanCache::getMisses() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return misses;
+}
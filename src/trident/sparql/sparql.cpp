@@ -23,6 +23,14 @@ void SPARQLUtils::parseQuery(bool &success,
         success = false;
         return;
     }
+    analyseQuery(success, parser, queryGraph, queryDict, db);
+}
+
+void SPARQLUtils::analyseQuery(bool &success,
+        SPARQLParser &parser,
+        std::unique_ptr<QueryGraph> &queryGraph,
+        QueryDict &queryDict,
+        TridentLayer &db) {
     queryGraph = std::unique_ptr<QueryGraph>(
             new QueryGraph(parser.getVarCount()));
     // And perform the semantic anaylsis
@@ -111,33 +119,238 @@ void SPARQLUtils::execSPARQLQuery(string sparqlquery,
         DebugPlanPrinter out(runtime, false);
         operatorTree->print(out);
 #endif
-        //set up output options for the last operators
-        ResultsPrinter *p = (ResultsPrinter*) operatorTree;
-        p->setSilent(!printstdout);
-        if (jsonoutput) {
-            p->setJSONOutput(jsonresults, jsonnamevars);
-        }
+        runQuery(operatorTree, start, printstdout, jsonoutput, jsonnamevars,
+                jsonresults, jsonstats, NULL);
+    }
+    delete plangen;
+}
+
+void SPARQLUtils::runQuery(Operator *operatorTree,
+        std::chrono::system_clock::time_point start,
+        bool printstdout,
+        bool jsonoutput,
+        std::vector<string> &jsonnamevars,
+        JSON *jsonresults,
+        JSON *jsonstats,
+        Timings *timings) {
+    //set up output options for the last operators
+    ResultsPrinter *p = (ResultsPrinter*) operatorTree;
+    p->setSilent(!printstdout);
+    if (jsonoutput) {
+        p->setJSONOutput(jsonresults, jsonnamevars);
+    }
+
+    std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
+    if (operatorTree->first()) {
+        while (operatorTree->next());
+    }
+    std::chrono::duration<double> durationQ = std::chrono::system_clock::now() - startQ;
+    std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Runtime query: " << durationQ.count() * 1000 << "ms.";
+    LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
+    if (timings) {
+        timings->execute = durationQ.count();
+        timings->decode = p->getDecodeTime();
+    }
+    if (jsonstats) {
+        jsonstats->put("runtime", to_string(durationQ.count()));
+        jsonstats->put("nresults", to_string(p->getPrintedRows()));
+
+    }
+    if (printstdout) {
+        uint64_t nElements = p->getPrintedRows();
+        LOG(INFOL) << "# rows = " << nElements;
+    }
+    delete operatorTree;
+}
+
+std::shared_ptr<SPARQLPlanCache::Entry> SPARQLUtils::prepareQuery(
+        string sparqlquery,
+        const std::map<string, string> &params,
+        TridentLayer &db,
+        bool optimize,
+        Timings *timings) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::shared_ptr<SPARQLPlanCache::Entry> entry(
+            new SPARQLPlanCache::Entry());
+    entry->queryDict = std::unique_ptr<QueryDict>(
+            new QueryDict(db.getNTerms()));
+    entry->lexer = std::unique_ptr<SPARQLLexer>(new SPARQLLexer(sparqlquery));
+    entry->parser = std::unique_ptr<SPARQLParser>(
+            new SPARQLParser(*entry->lexer.get()));
+    try {
+        entry->parser->parse(false, true);
+    } catch (const SPARQLParser::ParserException& e) {
+        cerr << "parse error: " << e.message << endl;
+        return std::shared_ptr<SPARQLPlanCache::Entry>();
+    }
 
-        std::chrono::system_clock::time_point startQ = std::chrono::system_clock::now();
-        if (operatorTree->first()) {
-            while (operatorTree->next());
+    //Replace the parameters with their values
+    for (const auto &p : params) {
+        entry->slots.push_back(std::vector<unsigned>());
+        entry->valueSlots.push_back(-1);
+        if (!entry->parser->bindVariable(p.first, p.second,
+                    entry->slots.back(), entry->valueSlots.back())) {
+            LOG(WARNL) << "The parameter " << p.first << " does not appear"
+                " in the query";
         }
-        std::chrono::duration<double> durationQ = std::chrono::system_clock::now() - startQ;
-        std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
-        LOG(INFOL) << "Runtime query: " << durationQ.count() * 1000 << "ms.";
-        LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
-        if (jsonstats) {
-            jsonstats->put("runtime", to_string(durationQ.count()));
-            jsonstats->put("nresults", to_string(p->getPrintedRows()));
+    }
+    for (SPARQLParser::projection_iterator itr = entry->parser->projectionBegin();
+            itr != entry->parser->projectionEnd(); ++itr) {
+        entry->vars.push_back(entry->parser->getVariableName(*itr));
+    }
+    if (!optimize) {
+        return entry;
+    }
+
+    bool parsingOk;
+    analyseQuery(parsingOk, *entry->parser.get(), entry->queryGraph,
+            *entry->queryDict.get(), db);
+    if (!parsingOk) {
+        return std::shared_ptr<SPARQLPlanCache::Entry>();
+    }
 
+    std::chrono::system_clock::time_point startPlan = std::chrono::system_clock::now();
+    if (timings) {
+        std::chrono::duration<double> duration = startPlan - start;
+        timings->parse = duration.count();
+    }
+
+    // Run the optimizer. The plans are owned by the plan generator
+    entry->plangen = std::unique_ptr<PlanGen>(new PlanGen());
+    entry->plan = entry->plangen->translate(db, *entry->queryGraph.get(),
+            false);
+    if (!entry->plan) {
+        cerr << "internal error plan generation failed" << endl;
+        return std::shared_ptr<SPARQLPlanCache::Entry>();
+    }
+    if (timings) {
+        std::chrono::duration<double> duration = std::chrono::system_clock::now() - startPlan;
+        timings->plan = duration.count();
+    }
+    return entry;
+}
+
+static void _emptyResult(JSON *jsonstats) {
+    LOG(INFOL) << "Runtime query: 0ms.";
+    LOG(INFOL) << "# rows = 0";
+    if (jsonstats) {
+        jsonstats->put("runtime", "0");
+        jsonstats->put("nresults", "0");
+    }
+}
+
+void SPARQLUtils::execSPARQLQuery(string sparqlquery,
+        const std::map<string, string> &params,
+        SPARQLPlanCache &cache,
+        TridentLayer &db,
+        bool printstdout,
+        bool jsonoutput,
+        JSON *jsonvars,
+        JSON *jsonresults,
+        JSON *jsonstats,
+        Timings *timings) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    const string key = SPARQLPlanCache::getKey(sparqlquery, params);
+    std::shared_ptr<SPARQLPlanCache::Entry> entry = cache.get(key, db);
+    const bool cached = entry != NULL;
+
+    //Terms that are not in the dictionary cannot match anything
+    std::vector<uint64_t> ids;
+    for (const auto &p : params) {
+        uint64_t id;
+        if (!db.lookup(p.second, ::Type::Literal, 0, id)) {
+            break;
         }
-        if (printstdout) {
-            uint64_t nElements = p->getPrintedRows();
-            LOG(INFOL) << "# rows = " << nElements;
+        ids.push_back(id);
+    }
+    const bool known = ids.size() == params.size();
+
+    if (!cached) {
+        //Without the values, the optimizer cannot estimate the plan. The
+        //entry is then stored without it, and the plan is built by the
+        //first execution with known values
+        entry = prepareQuery(sparqlquery, params, db, known, timings);
+        if (entry == NULL) {
+            std::chrono::duration<double> duration = std::chrono::system_clock::now() - start;
+            LOG(INFOL) << "Runtime query: 0ms.";
+            LOG(INFOL) << "Runtime total: " << duration.count() * 1000 << "ms.";
+            LOG(INFOL) << "# rows = 0";
+            return;
         }
-        delete operatorTree;
+        cache.put(key, db, entry);
     }
-    delete plangen;
-}
 
+    std::vector<string> jsonnamevars;
+    if (jsonvars) {
+        for (const auto &namevar : entry->vars) {
+            jsonvars->push_back(namevar);
+            jsonnamevars.push_back(namevar);
+        }
+    }
+    if (jsonstats) {
+        jsonstats->put("cachedplan", cached ? "true" : "false");
+    }
+    if (!known) {
+        _emptyResult(jsonstats);
+        return;
+    }
 
+    // Build a physical plan
+    std::unique_ptr<Runtime> runtime;
+    Operator* operatorTree;
+    std::chrono::system_clock::time_point startCodegen = std::chrono::system_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(entry->mutex);
+        bool patch = cached;
+        if (entry->plan == NULL) {
+            //The entry was stored by an execution with unknown values
+            std::shared_ptr<SPARQLPlanCache::Entry> planned = prepareQuery(
+                    sparqlquery, params, db, true, timings);
+            if (planned == NULL) {
+                _emptyResult(jsonstats);
+                return;
+            }
+            entry->queryGraph = std::move(planned->queryGraph);
+            entry->plangen = std::move(planned->plangen);
+            entry->queryDict = std::move(planned->queryDict);
+            entry->parser = std::move(planned->parser);
+            entry->lexer = std::move(planned->lexer);
+            entry->slots = planned->slots;
+            entry->valueSlots = planned->valueSlots;
+            entry->plan = planned->plan;
+            patch = false;
+        }
+        if (patch) {
+            //Copy the values of the parameters in the query graph
+            QueryGraph::SubQuery &query = entry->queryGraph->getQuery();
+            for (size_t i = 0; i < ids.size(); ++i) {
+                const uint64_t id = ids[i];
+                if (entry->valueSlots[i] >= 0) {
+                    query.valueNodes[entry->valueSlots[i]].values[0] = id;
+                }
+                for (unsigned slot : entry->slots[i]) {
+                    QueryGraph::Node &node = query.nodes[slot / 3];
+                    if (slot % 3 == 0) {
+                        node.subject = id;
+                    } else if (slot % 3 == 1) {
+                        node.predicate = id;
+                    } else {
+                        node.object = id;
+                    }
+                }
+            }
+        }
+        runtime = std::unique_ptr<Runtime>(new Runtime(db, NULL,
+                    entry->queryDict.get()));
+        operatorTree = CodeGen().translate(*runtime.get(),
+                *entry->queryGraph.get(), entry->plan, false);
+    }
+    if (timings) {
+        //The physical plan is built for every execution
+        std::chrono::duration<double> duration = std::chrono::system_clock::now() - startCodegen;
+        timings->plan += duration.count();
+    }
+    runQuery(operatorTree, start, printstdout, jsonoutput, jsonnamevars,
+            jsonresults, jsonstats, timings);
+}
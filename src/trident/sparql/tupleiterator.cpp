@@ -98,6 +98,18 @@ void TupleKBItr::init(Querier *querier, const Tuple *t,
     //If some variables have the same name, then we must change it
     equalFields = t->getRepeatedVars();
     physIterator = querier->get(idx, s, p, o);
+
+    useBlocks = equalFields.empty();
+    blockKey = -1;
+    blockSize = blockPos = 0;
+}
+
+bool TupleKBItr::fillBlock() {
+    blockSize = (int64_t) physIterator->nextBlock(block1, block2,
+            TUPLEKB_BLOCK_SIZE);
+    blockKey = physIterator->getKey();
+    blockPos = 0;
+    return blockSize > 0;
 }
 
 bool TupleKBItr::checkFields() {
@@ -114,6 +126,23 @@ bool TupleKBItr::checkFields() {
 }
 
 bool TupleKBItr::hasNext() {
+    if (useBlocks) {
+        //The current position is moved only by next()
+        if (!nextProcessed) {
+            if (blockPos + 1 < blockSize) {
+                nextOutcome = true;
+            } else {
+                nextOutcome = fillBlock();
+                //fillBlock() already points to the first element
+                if (nextOutcome) {
+                    blockPos = -1;
+                }
+            }
+            nextProcessed = true;
+        }
+        return nextOutcome;
+    }
+
     if (!nextProcessed) {
         if (physIterator->hasNext()) {
             physIterator->next();
@@ -137,6 +166,18 @@ bool TupleKBItr::hasNext() {
 }
 
 void TupleKBItr::next() {
+    if (useBlocks) {
+        if (nextProcessed) {
+            nextProcessed = false;
+            blockPos++;
+        } else if (blockPos + 1 < blockSize) {
+            blockPos++;
+        } else {
+            fillBlock();
+        }
+        return;
+    }
+
     if (nextProcessed) {
         nextProcessed = false;
     } else {
@@ -151,6 +192,17 @@ size_t TupleKBItr::getTupleSize() {
 uint64_t TupleKBItr::getElementAt(const int p) {
     const uint8_t pos = onlyVars ? varsPos[p] : (uint8_t) invPerm[p];
 
+    if (useBlocks) {
+        switch (pos) {
+        case 0:
+            return blockKey;
+        case 1:
+            return block1[blockPos];
+        case 2:
+            return block2[blockPos];
+        }
+    }
+
     switch (pos) {
     case 0:
         return physIterator->getKey();
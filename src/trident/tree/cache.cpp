@@ -46,8 +46,10 @@ void Cache::init(TreeContext *context, std::string path, int fileMaxSize,
 }
 
 Node *Cache::getNodeFromCache(int64_t id) {
+    nodeLoads.fetch_add(1, std::memory_order_relaxed);
     CachedNode *cachedVersion = manager->getCachedNode(id);
-    char* b = manager->get(cachedVersion);
+    int pin;
+    char* b = manager->get(cachedVersion, pin);
 
     Node *n = NULL;
     if (cachedVersion->children) {
@@ -61,11 +63,14 @@ Node *Cache::getNodeFromCache(int64_t id) {
         LZ4_decompress_safe(b, supportBuffer, cachedVersion->nodeSize,
                 SIZE_SUPPORT_BUFFER);
 
+        manager->release(pin);
+
         // Unserialize buffer
         n->unserialize(supportBuffer, 0);
 
     } else { // Unserialize buffer
         n->unserialize(b, 0);
+        n->setPin(pin);
     }
     return n;
 }
@@ -97,6 +102,8 @@ void Cache::flushNode(Node *node, const bool registerNode) {
     if (node->getParent() != NULL && registerNode)
         node->getParent()->cacheChild(node);
 
+    releasePin(node);
+
     if (!node->canHaveChildren()) {
         //It's a leaf
         factory->release((Leaf *) node);
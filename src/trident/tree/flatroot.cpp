@@ -2,6 +2,8 @@
 #include <trident/tree/flattreeitr.h>
 #include <trident/binarytables/storagestrat.h>
 
+#include <cstring>
+
 FlatRoot::FlatRoot(string path, bool unlabeled, bool undirected) :
     unlabeled(unlabeled), undirected(undirected) {
         file = std::unique_ptr<MemoryMappedFile>(new MemoryMappedFile(path, true));
@@ -18,18 +20,26 @@ FlatRoot::FlatRoot(string path, bool unlabeled, bool undirected) :
     }
 
 void FlatRoot::__set(int permid, char *block, TermCoordinates *value) {
-    const int64_t nels = *((int64_t*)(block)) & INT64_C(0XFFFFFFFFFF);
+    //Read only the five bytes of the fields, the last one ends the record
+    int64_t nels = 0;
+    memcpy(&nels, block, 5);
     if (nels > 0) {
-        const short file = *((short*)(block + 6));
-        const int64_t pos = *((int64_t*)(block + 8)) & INT64_C(0XFFFFFFFFFF);
+        short file;
+        memcpy(&file, block + 6, 2);
+        int64_t pos = 0;
+        memcpy(&pos, block + 8, 5);
         const char strat = *(block + 5);
         value->set(permid, file, pos, nels, strat);
     }
 }
 
 bool FlatRoot::get(nTerm key, TermCoordinates *value) {
-    char *start = raw + key * sizeblock;
     value->clear();
+    //The terms added by the updates are not in the file
+    if (key < 0 || (size_t) key >= len / sizeblock) {
+        return false;
+    }
+    char *start = raw + key * sizeblock;
     __set(IDX_SOP, start + 5, value);
     if (!unlabeled || !undirected) {
         __set(IDX_OSP, start + 18, value);
@@ -40,7 +50,12 @@ bool FlatRoot::get(nTerm key, TermCoordinates *value) {
         __set(IDX_POS, start + 57, value);
         __set(IDX_PSO, start + 70, value);
     }
-    return true;
+    for (int i = 0; i < N_PARTITIONS; ++i) {
+        if (value->exists(i)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 TreeItr *FlatRoot::itr() {
@@ -307,6 +322,44 @@ void FlatRoot::writeFirstPerm(string sop, Root *root, bool unlabeled,
     delete itr;
 }
 
+void FlatRoot::writeAllPerms(Root *root, string output) {
+    int64_t keyToAdd = -1;
+    TermCoordinates coord;
+    std::unique_ptr<TreeItr> itr(root->itr());
+    FlatTreeWriter ftw(output, false, false);
+    int64_t nels[N_PARTITIONS];
+    char strats[N_PARTITIONS];
+    short files[N_PARTITIONS];
+    int64_t marks[N_PARTITIONS];
+    while (itr->hasNext()) {
+        const int64_t treeKey = itr->next(&coord);
+        //The IDs are dense, but some terms might not appear in any triple
+        while (++keyToAdd < treeKey) {
+            ftw.writeOnlyKey(keyToAdd);
+        }
+        for (int i = 0; i < N_PARTITIONS; ++i) {
+            if (coord.exists(i)) {
+                nels[i] = coord.getNElements(i);
+                strats[i] = coord.getStrategy(i);
+                files[i] = coord.getFileIdx(i);
+                marks[i] = coord.getMark(i);
+            } else {
+                nels[i] = marks[i] = 0;
+                strats[i] = 0;
+                files[i] = 0;
+            }
+        }
+        ftw.write(treeKey,
+                nels[IDX_SOP], strats[IDX_SOP], files[IDX_SOP], marks[IDX_SOP],
+                nels[IDX_OSP], strats[IDX_OSP], files[IDX_OSP], marks[IDX_OSP],
+                nels[IDX_SPO], strats[IDX_SPO], files[IDX_SPO], marks[IDX_SPO],
+                nels[IDX_OPS], strats[IDX_OPS], files[IDX_OPS], marks[IDX_OPS],
+                nels[IDX_POS], strats[IDX_POS], files[IDX_POS], marks[IDX_POS],
+                nels[IDX_PSO], strats[IDX_PSO], files[IDX_PSO], marks[IDX_PSO]);
+    }
+    ftw.done();
+}
+
 void FlatRoot::writeOtherPerm(string otherperm, string output,
         int offset,
         int blocksize,
@@ -397,21 +450,19 @@ void FlatRoot::loadFlatTree(string sop,
         bool unlabeled,
         bool undirected) {
 
+    if (!unlabeled) {
+        //The coordinates in the tree are already the ones of the records
+        writeAllPerms(root, flatfile);
+        return;
+    }
+
     writeFirstPerm(sop, root, unlabeled, undirected, flatfile);
 
     //OSP
-    if (unlabeled) {
-        if (!undirected) {
-            writeOtherPerm(osp, flatfile, 23, 31, unlabeled);
-        }
-        //if undirected do nothing nothing
-    } else {
-        writeOtherPerm(osp, flatfile, 23, 83, unlabeled);
-        writeOtherPerm(spo, flatfile, 36, 83, unlabeled);
-        writeOtherPerm(ops, flatfile, 49, 83, unlabeled);
-        writeOtherPerm(pos, flatfile, 62, 83, unlabeled);
-        writeOtherPerm(pso, flatfile, 75, 83, unlabeled);
+    if (!undirected) {
+        writeOtherPerm(osp, flatfile, 23, 31, unlabeled);
     }
+    //if undirected do nothing nothing
 }
 
 
@@ -40,7 +40,8 @@ IntermediateNode::IntermediateNode(TreeContext *context, Node *child1,
 
         if (context->textKeys()) {
             int size = 0;
-            tTerm *key = child1->largestTextualKey(&size);
+            tTerm key[MAX_TERM_SIZE];
+            child1->largestTextualKey(key, &size);
             putkeyAt(key, size, 0);
         } else {
             int64_t key1 = child1->largestNumericKey();
@@ -113,7 +114,8 @@ int IntermediateNode::getPosChild(Node *child) {
         p = pos(child->smallestNumericKey());
     } else {
         int size = 0;
-        tTerm *t = child->smallestTextualKey(&size);
+        tTerm t[MAX_TERM_SIZE];
+        child->smallestTextualKey(t, &size);
         p = pos(t, size);
     }
     if (p < 0) {
@@ -136,14 +138,14 @@ int64_t IntermediateNode::largestNumericKey() {
     return children[getCurrentSize()]->largestNumericKey();
 }
 
-tTerm *IntermediateNode::smallestTextualKey(int *size) {
+tTerm *IntermediateNode::smallestTextualKey(tTerm *key, int *size) {
     ensureChildIsLoaded(0);
-    return children[0]->smallestTextualKey(size);
+    return children[0]->smallestTextualKey(key, size);
 }
 
-tTerm *IntermediateNode::largestTextualKey(int *size) {
+tTerm *IntermediateNode::largestTextualKey(tTerm *key, int *size) {
     ensureChildIsLoaded(getCurrentSize());
-    return children[getCurrentSize()]->largestTextualKey(size);
+    return children[getCurrentSize()]->largestTextualKey(key, size);
 }
 
 void IntermediateNode::cacheChild(Node *child) {
@@ -200,7 +202,8 @@ void numAvg(Node *parent, int p, Node *child1, Node *child2) {
 
 void textAvg(Node *parent, int p, Node *child1, Node *child2) {
     int size = 0;
-    tTerm *key = child1->largestTextualKey(&size);
+    tTerm key[MAX_TERM_SIZE];
+    child1->largestTextualKey(key, &size);
     parent->putkeyAt(key, size, p);
 }
 
@@ -392,6 +395,7 @@ Node *IntermediateNode::putOrGet(tTerm *key, int sizeKey, nTerm &value,
 }
 
 void IntermediateNode::ensureChildIsLoaded(int p) {
+    getContext()->getCache()->incrNodeAccesses();
     if (children[p] == NULL) {
 #ifdef MT
         std::recursive_mutex &mutex = getContext()->getMutex();
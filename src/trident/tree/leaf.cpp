@@ -716,12 +716,12 @@ int64_t Leaf::largestNumericKey() {
     return localLargestNumericKey();
 }
 
-tTerm *Leaf::smallestTextualKey(int *size) {
-    return localSmallestTextualKey(size);
+tTerm *Leaf::smallestTextualKey(tTerm *key, int *size) {
+    return localSmallestTextualKey(key, size);
 }
 
-tTerm *Leaf::largestTextualKey(int *size) {
-    return localLargestTextualKey(size);
+tTerm *Leaf::largestTextualKey(tTerm *key, int *size) {
+    return localLargestTextualKey(key, size);
 }
 
 void Leaf::getValueAtPos(int pos, TermCoordinates * value) {
@@ -189,14 +189,16 @@ int64_t Node::keyAt(int pos) {
     }
 }
 
-tTerm *Node::localSmallestTextualKey(int *size) {
+tTerm *Node::localSmallestTextualKey(tTerm *key, int *size) {
     int64_t coordinates = keyAt(0);
-    return (tTerm*) getContext()->getStringBuffer()->get(coordinates, *size);
+    getContext()->getStringBuffer()->get(coordinates, (char*) key, *size);
+    return key;
 }
 
-tTerm *Node::localLargestTextualKey(int *size) {
+tTerm *Node::localLargestTextualKey(tTerm *key, int *size) {
     int64_t coordinates = keyAt(getCurrentSize() - 1);
-    return (tTerm*) getContext()->getStringBuffer()->get(coordinates, *size);
+    getContext()->getStringBuffer()->get(coordinates, (char*) key, *size);
+    return key;
 }
 
 int Node::pos(tTerm *key, int size) {
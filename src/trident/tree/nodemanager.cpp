@@ -21,6 +21,7 @@
 
 
 #include <trident/tree/nodemanager.h>
+#include <trident/utils/accesslog.h>
 
 #include <iostream>
 #include <fstream>
@@ -33,6 +34,7 @@ NodeManager::NodeManager(TreeContext *context, int nodeMinBytes,
         int fileMaxSize, int maxNFiles, int64_t cacheMaxSize, std::string path) :
     readOnly(context->isReadOnly()), path(path), nodeMinSize(nodeMinBytes) {
         lastNodeInserted = NULL;
+        accessLogDir = AccessLog::registerDir(path);
 
         //Init filemanager
         //Calculate the highest file
@@ -122,9 +124,14 @@ int NodeManager::serializeTo(CachedNode *node, char *buffer) {
     return pos;
 }
 
-char* NodeManager::get(CachedNode *node) {
+char* NodeManager::get(CachedNode *node, int &pin) {
     uint64_t len = node->nodeSize;
-    return manager->getBuffer(node->fileIndex, node->posIndex, &len);
+    AccessLog::record(accessLogDir, node->fileIndex, node->posIndex, len);
+    return manager->pinBuffer(node->fileIndex, node->posIndex, &len, pin);
+}
+
+void NodeManager::release(int pin) {
+    manager->unpin(pin);
 }
 
 CachedNode *NodeManager::getCachedNode(int64_t id) {
@@ -166,8 +173,10 @@ void NodeManager::put(Node *node, char *buffer, int sizeBuffer) {
 
         //Replace the content and update the nodeSize
         uint64_t len = sizeBuffer;
-        char *b = manager->getBuffer(cn->fileIndex, cn->posIndex, &len);
+        int pin;
+        char *b = manager->pinBuffer(cn->fileIndex, cn->posIndex, &len, pin);
         memcpy(b, buffer, sizeBuffer);
+        manager->unpin(pin);
         cn->nodeSize = sizeBuffer;
     } else {
         CachedNode *c = new CachedNode;
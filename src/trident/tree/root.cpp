@@ -104,6 +104,9 @@ Root::Root(string path, StringBuffer *buffer, bool readOnly, PropertyMap &conf)
     }
 
 bool Root::get(nTerm key, TermCoordinates *value) {
+#ifdef MT
+    std::lock_guard<std::recursive_mutex> lock(context->getMutex());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key);
@@ -113,6 +116,9 @@ bool Root::get(nTerm key, TermCoordinates *value) {
 }
 
 bool Root::get(nTerm key, int64_t &coordinates) {
+#ifdef MT
+    std::lock_guard<std::recursive_mutex> lock(context->getMutex());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key);
@@ -120,7 +126,19 @@ bool Root::get(nTerm key, int64_t &coordinates) {
     return node->get(key, coordinates);
 }
 
+void Root::getCacheCounters(uint64_t &nodeAccesses, uint64_t &nodeLoads) {
+    if (cache != NULL) {
+        nodeAccesses = cache->getNodeAccesses();
+        nodeLoads = cache->getNodeLoads();
+    } else {
+        nodeAccesses = nodeLoads = 0;
+    }
+}
+
 bool Root::get(tTerm *key, const int sizeKey, nTerm *value) {
+#ifdef MT
+    std::lock_guard<std::recursive_mutex> lock(context->getMutex());
+#endif
     Node *node = rootNode;
     while (node->canHaveChildren()) {
         node = node->getChildForKey(key, sizeKey);
@@ -130,6 +130,7 @@ void StringBuffer::addCache(int idx) {
         }
 
         elementsInCache--;
+        stats->incrNEvictedIndexBlocks();
         factory.release(blocks[idxToRemove]);
         blocks[idxToRemove] = NULL;
     }
@@ -437,6 +438,9 @@ int StringBuffer::getVInt(int &blockId, char *&block, int &offset) {
 }
 
 void StringBuffer::get(int64_t pos, char* outputBuffer, int &size) {
+#ifdef MT
+    std::lock_guard<std::mutex> lock(cacheLock);
+#endif
     int idxBlock = pos / SB_BLOCK_SIZE;
     int initialIdx = idxBlock;
 
@@ -482,14 +486,9 @@ void StringBuffer::get(int64_t pos, char* outputBuffer, int &size) {
     }
 }
 
-char* StringBuffer::get(int64_t pos, int &size) {
-    get(pos, termSupportBuffer, size);
-    termSupportBuffer[size] = '\0';
-    return termSupportBuffer;
-}
-
 char *StringBuffer::getBlock(int idxBlock) {
     assert(idxBlock >= 0);
+    stats->incrNAccessedIndexBlocks();
     char *block = blocks[idxBlock];
     if (block == NULL) {
         addCache(idxBlock);
@@ -521,6 +520,9 @@ char *StringBuffer::getBlock(int idxBlock) {
 }
 
 int StringBuffer::cmp(int64_t pos, char *string, int sizeString) {
+#ifdef MT
+    std::lock_guard<std::mutex> lock(cacheLock);
+#endif
     int startBlock = pos / SB_BLOCK_SIZE;
     const int initialBlock = startBlock;
     char *block = getBlock(startBlock);
@@ -0,0 +1,309 @@
+#include <trident/utils/accesslog.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> AccessLog::enabled(false);
+std::mutex AccessLog::mutex;
+std::vector<std::string> AccessLog::dirs;
+AccessLog::Shard AccessLog::shards[AccessLog::NSHARDS];
+std::atomic<uint32_t> AccessLog::nextShard(0);
+std::string AccessLog::logFile;
+uint32_t AccessLog::intervalSec = 0;
+std::thread AccessLog::worker;
+std::mutex AccessLog::stopMutex;
+std::condition_variable AccessLog::stopCond;
+bool AccessLog::stopped = true;
+
+//The key packs the directory (8 bits), the file (16 bits) and the offset
+//(40 bits, like the positions in the idx files)
+#define ACCESSLOG_OFFSETMASK ((UINT64_C(1) << 40) - 1)
+
+int AccessLog::registerDir(std::string dir) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < dirs.size(); ++i) {
+        if (dirs[i] == dir) {
+            return i;
+        }
+    }
+    if (dirs.size() >= MAXDIRS) {
+        return -1;
+    }
+    dirs.push_back(dir);
+    return dirs.size() - 1;
+}
+
+void AccessLog::recordAccess(int dir, short file, uint64_t offset,
+        uint64_t len) {
+    const uint64_t key = ((uint64_t) dir << 56) |
+        ((uint64_t) (uint16_t) file << 40) | (offset & ACCESSLOG_OFFSETMASK);
+    //The shard of the thread is picked once, in turns
+    static thread_local const uint32_t idShard = nextShard++ % NSHARDS;
+    Shard &shard = shards[idShard];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    uint64_t &l = shard.accesses[key];
+    if (l < len) {
+        l = len;
+    }
+}
+
+bool AccessLog::load(std::string file, std::vector<std::string> &logDirs,
+        std::vector<Entry> &entries) {
+    std::ifstream ifs(file, std::ios::binary);
+    if (!ifs.good()) {
+        return false;
+    }
+    uint32_t ndirs = 0;
+    ifs.read((char*) &ndirs, sizeof(uint32_t));
+    for (uint32_t i = 0; i < ndirs && ifs.good(); ++i) {
+        uint32_t len = 0;
+        ifs.read((char*) &len, sizeof(uint32_t));
+        std::string dir(len, ' ');
+        ifs.read(&dir[0], len);
+        logDirs.push_back(dir);
+    }
+    uint64_t nentries = 0;
+    ifs.read((char*) &nentries, sizeof(uint64_t));
+    for (uint64_t i = 0; i < nentries && ifs.good(); ++i) {
+        Entry e;
+        ifs.read((char*) &e.dir, sizeof(uint32_t));
+        ifs.read((char*) &e.file, sizeof(short));
+        ifs.read((char*) &e.offset, sizeof(uint64_t));
+        ifs.read((char*) &e.len, sizeof(uint64_t));
+        if (ifs.good() && e.dir < logDirs.size()) {
+            entries.push_back(e);
+        }
+    }
+    if (!ifs.good()) {
+        LOG(WARNL) << "The access log " << file << " is truncated";
+    }
+    return true;
+}
+
+void AccessLog::store() {
+    std::vector<std::string> copyDirs;
+    std::string file;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copyDirs = dirs;
+        file = logFile;
+    }
+    //The same range can be in several shards. Keep the longest length
+    std::unordered_map<uint64_t, uint64_t> merged;
+    for (int i = 0; i < NSHARDS; ++i) {
+        std::lock_guard<std::mutex> lock(shards[i].mutex);
+        for (auto &a : shards[i].accesses) {
+            uint64_t &l = merged[a.first];
+            if (l < a.second) {
+                l = a.second;
+            }
+        }
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> copyAccesses(merged.begin(),
+            merged.end());
+    merged.clear();
+
+    //Write a new file and then replace the old one, so that a crash
+    //leaves the previous log
+    std::string tmpFile = file + ".tmp";
+    {
+        std::ofstream ofs(tmpFile, std::ios::binary);
+        const uint32_t ndirs = copyDirs.size();
+        ofs.write((const char*) &ndirs, sizeof(uint32_t));
+        for (auto &dir : copyDirs) {
+            const uint32_t len = dir.size();
+            ofs.write((const char*) &len, sizeof(uint32_t));
+            ofs.write(dir.c_str(), len);
+        }
+        const uint64_t nentries = copyAccesses.size();
+        ofs.write((const char*) &nentries, sizeof(uint64_t));
+        for (auto &a : copyAccesses) {
+            const uint32_t dir = a.first >> 56;
+            const short f = (short) ((a.first >> 40) & 0xFFFF);
+            const uint64_t offset = a.first & ACCESSLOG_OFFSETMASK;
+            ofs.write((const char*) &dir, sizeof(uint32_t));
+            ofs.write((const char*) &f, sizeof(short));
+            ofs.write((const char*) &offset, sizeof(uint64_t));
+            ofs.write((const char*) &a.second, sizeof(uint64_t));
+        }
+        if (!ofs.good()) {
+            LOG(ERRORL) << "Error while writing the access log " << tmpFile;
+            return;
+        }
+    }
+    if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+        LOG(ERRORL) << "Cannot replace the access log " << file;
+    }
+}
+
+void AccessLog::run() {
+    std::unique_lock<std::mutex> lock(stopMutex);
+    while (!stopped) {
+        stopCond.wait_for(lock, std::chrono::seconds(intervalSec));
+        if (stopped) {
+            break;
+        }
+        lock.unlock();
+        store();
+        lock.lock();
+    }
+}
+
+void AccessLog::startRecording(std::string file, uint32_t intervalSec) {
+    if (enabled) {
+        LOG(WARNL) << "The accesses are already recorded";
+        return;
+    }
+
+    //Keep the ranges of the previous runs, unless their files are gone
+    std::vector<std::string> logDirs;
+    std::vector<Entry> entries;
+    load(file, logDirs, entries);
+    std::vector<int> ids;
+    for (auto &dir : logDirs) {
+        ids.push_back(Utils::exists(dir) ? registerDir(dir) : -1);
+    }
+    for (auto &e : entries) {
+        if (ids[e.dir] >= 0) {
+            recordAccess(ids[e.dir], e.file, e.offset, e.len);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        logFile = file;
+    }
+    AccessLog::intervalSec = std::max(intervalSec, (uint32_t) 1);
+    stopped = false;
+    enabled = true;
+    worker = std::thread(&AccessLog::run);
+    LOG(INFOL) << "Recording the accesses in " << file;
+}
+
+void AccessLog::stopRecording() {
+    if (!enabled) {
+        return;
+    }
+    enabled = false;
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopped = true;
+    }
+    stopCond.notify_all();
+    if (worker.joinable()) {
+        worker.join();
+    }
+    store();
+}
+
+uint64_t AccessLog::prefetch(const std::vector<Range> &ranges,
+        size_t begin, size_t end) {
+    const std::string &path = ranges[begin].path;
+    if (!Utils::exists(path)) {
+        //For instance, a generation removed by the compaction
+        return 0;
+    }
+    uint64_t bytes = 0;
+#if defined(__linux__)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        LOG(WARNL) << "Cannot open " << path;
+        return 0;
+    }
+    for (size_t i = begin; i < end; ++i) {
+        const uint64_t len = ranges[i].end - ranges[i].begin;
+        posix_fadvise(fd, ranges[i].begin, len, POSIX_FADV_WILLNEED);
+        bytes += len;
+    }
+    ::close(fd);
+#else
+    //Read the ranges, the pages stay in the OS cache
+    std::ifstream ifs(path, std::ios::binary);
+    std::vector<char> buffer(MERGEGAP);
+    for (size_t i = begin; i < end && ifs.good(); ++i) {
+        ifs.seekg(ranges[i].begin);
+        uint64_t remaining = ranges[i].end - ranges[i].begin;
+        while (remaining > 0 && ifs.good()) {
+            const uint64_t n = std::min(remaining, (uint64_t) buffer.size());
+            ifs.read(buffer.data(), n);
+            remaining -= n;
+            bytes += n;
+        }
+    }
+#endif
+    return bytes;
+}
+
+uint64_t AccessLog::replay(std::string file, int nthreads) {
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    std::vector<std::string> logDirs;
+    std::vector<Entry> entries;
+    if (!load(file, logDirs, entries)) {
+        LOG(WARNL) << "The access log " << file << " does not exist";
+        return 0;
+    }
+
+    std::vector<Range> ranges;
+    for (auto &e : entries) {
+        Range r;
+        r.path = logDirs[e.dir] + DIR_SEP + std::to_string(e.file);
+        r.begin = e.offset;
+        r.end = e.offset + e.len;
+        ranges.push_back(r);
+    }
+    entries.clear();
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) {
+            return a.path < b.path || (a.path == b.path && a.begin < b.begin);
+            });
+
+    //Merge the ranges that are close, and split them per file
+    std::vector<Range> merged;
+    std::vector<size_t> fileStarts;
+    for (auto &r : ranges) {
+        if (!merged.empty() && merged.back().path == r.path &&
+                r.begin <= merged.back().end + MERGEGAP) {
+            merged.back().end = std::max(merged.back().end, r.end);
+        } else {
+            if (merged.empty() || merged.back().path != r.path) {
+                fileStarts.push_back(merged.size());
+            }
+            merged.push_back(r);
+        }
+    }
+    ranges.clear();
+    fileStarts.push_back(merged.size());
+
+    //Every thread loads whole files, starting from the next one in the list
+    std::atomic<size_t> nextFile(0);
+    std::atomic<uint64_t> bytes(0);
+    const size_t nfiles = fileStarts.size() - 1;
+    auto task = [&]() {
+        size_t f;
+        while ((f = nextFile++) < nfiles) {
+            bytes += prefetch(merged, fileStarts[f], fileStarts[f + 1]);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min((size_t) nthreads, nfiles); ++i) {
+        threads.push_back(std::thread(task));
+    }
+    task();
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Warmup: requested " << bytes.load() << " bytes of " <<
+        nfiles << " files in " << sec.count() << "s.";
+    return bytes;
+}
@@ -0,0 +1,72 @@
+#ifndef _TEST_SPARQLKB_H
+#define _TEST_SPARQLKB_H
+
+//Creates small KBs from N-Triples and runs SPARQL queries on them. Used by
+//the tests of the SPARQL operators
+
+#include <trident/loader.h>
+#include <trident/kb/kb.h>
+#include <trident/kb/kbconfig.h>
+#include <trident/sparql/sparql.h>
+#include <trident/utils/json.h>
+#include <layers/TridentLayer.hpp>
+
+#include <kognac/utils.h>
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+//Every triple is a line of N-Triples without the final dot. Returns the
+//directory of the KB
+static std::string _createKB(std::string dir,
+        const std::vector<std::string> &triples,
+        ParamsLoad p = ParamsLoad()) {
+    if (Utils::exists(dir)) {
+        Utils::remove_all(dir);
+    }
+    std::string input = dir + DIR_SEP + "input";
+    Utils::create_directories(input);
+    std::ofstream out(input + DIR_SEP + "data.nt");
+    for (const auto &t : triples) {
+        out << t << " ." << std::endl;
+    }
+    out.close();
+
+    p.triplesInputDir = input;
+    p.kbDir = dir + DIR_SEP + "kb";
+    p.tmpDir = p.kbDir;
+    p.parallelThreads = 2;
+    p.maxReadingThreads = 1;
+    Loader loader;
+    loader.load(p);
+    return p.kbDir;
+}
+
+//Returns the values of the variables in every row, separated by spaces
+static std::vector<std::string> _runQuery(TridentLayer &db,
+        std::string query, const std::vector<std::string> &vars) {
+    JSON jsonvars, jsonresults;
+    SPARQLUtils::execSPARQLQuery(query, false, db.getNTerms(), db, false,
+            true, &jsonvars, &jsonresults, NULL);
+    std::vector<std::string> rows;
+    for (JSON row : jsonresults.getListChildren()) {
+        std::string r;
+        for (const auto &var : vars) {
+            if (!r.empty()) {
+                r += " ";
+            }
+            r += row.getChild(var).get("value");
+        }
+        rows.push_back(r);
+    }
+    return rows;
+}
+
+static std::vector<std::string> _sorted(std::vector<std::string> rows) {
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "sparqlkb.h"
+
+#include <iostream>
+#include <random>
+#include <set>
+
+using namespace std;
+
+//A hint that never moves the scan, like the one of an unbound IndexScan
+class NoSkipHint : public DBLayer::Hint {
+    public:
+        bool canSkip() {
+            return false;
+        }
+};
+
+static std::vector<std::vector<uint64_t>> readScan(DBLayer::Scan &scan,
+        size_t limit) {
+    std::vector<std::vector<uint64_t>> out;
+    if (!scan.first()) {
+        return out;
+    }
+    do {
+        out.push_back({scan.getValue1(), scan.getValue2(), scan.getValue3()});
+    } while (out.size() < limit && scan.next());
+    return out;
+}
+
+//Checks that the scans that read the pairs in blocks return all triples,
+//also when they are opened again
+int main(int argc, const char** args) {
+    std::mt19937 e2(42);
+    std::uniform_int_distribution<int> dist(0, 300);
+    std::set<std::string> expected;
+    std::vector<std::string> triples;
+    while (expected.size() < 5000) {
+        string s = "http://e/" + to_string(dist(e2));
+        string p = "http://p/" + to_string(dist(e2) % 4);
+        string o = "http://e/" + to_string(dist(e2));
+        if (expected.insert(s + " " + p + " " + o).second) {
+            triples.push_back("<" + s + "> <" + p + "> <" + o + ">");
+        }
+    }
+    string kbdir = _createKB("testblockscan", triples);
+
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    TridentLayer db(kb);
+
+    //Full scan
+    std::vector<std::string> rows = _sorted(_runQuery(db,
+                "SELECT ?s ?p ?o WHERE { ?s ?p ?o . }", {"s", "p", "o"}));
+    if (rows != std::vector<std::string>(expected.begin(), expected.end())) {
+        cout << "Full scan: wrong results (" << rows.size() << " rows)" << endl;
+        return 1;
+    }
+
+    //Scan of one predicate
+    rows = _sorted(_runQuery(db,
+                "SELECT ?s ?o WHERE { ?s <http://p/1> ?o . }", {"s", "o"}));
+    std::vector<std::string> expectedP;
+    for (const auto &t : expected) {
+        size_t pos = t.find(" http://p/1 ");
+        if (pos != string::npos) {
+            expectedP.push_back(t.substr(0, pos) + " " + t.substr(pos + 12));
+        }
+    }
+    if (rows != expectedP) {
+        cout << "Predicate scan: wrong results (" << rows.size() << " rows)" << endl;
+        return 1;
+    }
+
+    //Scans opened again, after reading them until the end or partially
+    NoSkipHint hint;
+    std::unique_ptr<DBLayer::Scan> scan = db.getScan(
+            DBLayer::Order_Subject_Predicate_Object, DBLayer::AGGR_NO, &hint);
+    auto all = readScan(*scan, SIZE_MAX);
+    if (all.size() != expected.size()) {
+        cout << "Scan: " << all.size() << " triples instead of " <<
+            expected.size() << endl;
+        return 1;
+    }
+    auto part = readScan(*scan, 300);
+    auto again = readScan(*scan, SIZE_MAX);
+    if (again != all || part != std::vector<std::vector<uint64_t>>(
+                all.begin(), all.begin() + 300)) {
+        cout << "Scan opened again: wrong results" << endl;
+        return 1;
+    }
+
+    cout << "Block scans are correct" << endl;
+    return 0;
+}
@@ -0,0 +1,154 @@
+#include "sparqlkb.h"
+
+#include <trident/kb/charsets.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+
+using namespace std;
+
+static bool same(double v1, double v2) {
+    return fabs(v1 - v2) <= 1e-6 * max(1.0, fabs(v2));
+}
+
+static uint64_t getId(KB &kb, string term) {
+    nTerm id;
+    if (!kb.getDictMgmt()->getNumber(term.c_str(), term.size(), &id)) {
+        cout << "The term " << term << " is not in the dictionary" << endl;
+        exit(1);
+    }
+    return id;
+}
+
+//Checks the estimates of the stars and of the chains of two predicates. The
+//subjects of a characteristic set have the same number of triples of every
+//predicate, so the estimates must be exact
+int main(int argc, const char** args) {
+    const int NSUBJECTS = 300;
+    const int NPREDICATES = 3;
+    //Number of triples of every predicate of a subject
+    const int counts[NPREDICATES] = { 2, 3, 1 };
+    //The predicates of the subjects, depending on the subject modulo 4
+    const std::vector<std::vector<int>> predicateSets = {
+        { 0 }, { 0, 1 }, { 0, 1, 2 }, { 1, 2 } };
+
+    std::mt19937 e2(9);
+    std::uniform_int_distribution<int> dist(0, NSUBJECTS - 1);
+    //Objects of every subject and predicate
+    std::map<std::pair<int, int>, std::set<int>> objects;
+    std::vector<std::string> triples;
+    for (int s = 0; s < NSUBJECTS; ++s) {
+        for (int p : predicateSets[s % 4]) {
+            std::set<int> &o = objects[make_pair(s, p)];
+            while (o.size() < (size_t) counts[p]) {
+                o.insert(dist(e2));
+            }
+            for (int v : o) {
+                triples.push_back("<http://e/" + to_string(s) + "> <http://p/" +
+                        to_string(p) + "> <http://e/" + to_string(v) + ">");
+            }
+        }
+    }
+    ParamsLoad params;
+    params.characteristicSets = true;
+    string kbdir = _createKB("testcharsets", triples, params);
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    const CharacteristicSets *sets = kb.getCharacteristicSets();
+    if (sets == NULL || !sets->hasChains()) {
+        cout << "The characteristic sets were not loaded" << endl;
+        return 1;
+    }
+    if (sets->getNSets() != predicateSets.size()) {
+        cout << sets->getNSets() << " characteristic sets instead of " <<
+            predicateSets.size() << endl;
+        return 1;
+    }
+    int64_t ids[NPREDICATES];
+    for (int p = 0; p < NPREDICATES; ++p) {
+        ids[p] = getId(kb, "<http://p/" + to_string(p) + ">");
+    }
+    TridentLayer db(kb);
+
+    //Stars of every combination of predicates
+    for (int mask = 1; mask < (1 << NPREDICATES); ++mask) {
+        std::vector<int64_t> predicates;
+        for (int p = 0; p < NPREDICATES; ++p) {
+            if (mask & (1 << p)) {
+                predicates.push_back(ids[p]);
+            }
+        }
+        double expected = 0;
+        for (int s = 0; s < NSUBJECTS; ++s) {
+            double n = 1;
+            for (int p = 0; p < NPREDICATES; ++p) {
+                if (mask & (1 << p)) {
+                    n *= objects.count(make_pair(s, p)) ?
+                        objects[make_pair(s, p)].size() : 0;
+                }
+            }
+            expected += n;
+        }
+        const double estimate = sets->estimateStar(predicates);
+        if (!same(estimate, expected)) {
+            cout << "Star " << mask << ": estimated " << estimate <<
+                " instead of " << expected << endl;
+            return 1;
+        }
+    }
+
+    //Chains of every pair of predicates, the object of p1 is the subject of p2
+    for (int p1 = 0; p1 < NPREDICATES; ++p1) {
+        for (int p2 = 0; p2 < NPREDICATES; ++p2) {
+            int64_t expected = 0;
+            for (const auto &o : objects) {
+                if (o.first.second != p1) {
+                    continue;
+                }
+                for (int v : o.second) {
+                    auto next = objects.find(make_pair(v, p2));
+                    if (next != objects.end()) {
+                        expected += next->second.size();
+                    }
+                }
+            }
+            if (sets->getChainCount(ids[p1], ids[p2]) != expected) {
+                cout << "Chain " << p1 << "," << p2 << ": counted " <<
+                    sets->getChainCount(ids[p1], ids[p2]) << " instead of "
+                    << expected << endl;
+                return 1;
+            }
+
+            //The layer returns the same estimates to the optimizer. The
+            //variables are 1000 (joined), 1001 and 1002
+            const double card1 = db.getCardinality(UINT64_MAX, ids[p1],
+                    UINT64_MAX);
+            const double card2 = db.getCardinality(UINT64_MAX, ids[p2],
+                    UINT64_MAX);
+            double sel = db.getJoinSelectivity(false, 1001, true, ids[p1],
+                    false, 1000, false, 1000, true, ids[p2], false, 1002);
+            if (!same(sel * card1 * card2, expected)) {
+                cout << "Chain " << p1 << "," << p2 << ": the layer estimates "
+                    << sel * card1 * card2 << " instead of " << expected << endl;
+                return 1;
+            }
+            if (p1 != p2) {
+                std::vector<int64_t> star = { ids[p1], ids[p2] };
+                sel = db.getJoinSelectivity(false, 1000, true, ids[p1],
+                        false, 1001, false, 1000, true, ids[p2], false, 1002);
+                if (!same(sel * card1 * card2, sets->estimateStar(star))) {
+                    cout << "Star " << p1 << "," << p2 << ": the layer "
+                        "estimates " << sel * card1 * card2 << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    cout << "The characteristic sets are correct (" << sets->getNSets() <<
+        " sets)" << endl;
+    return 0;
+}
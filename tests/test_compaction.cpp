@@ -0,0 +1,126 @@
+#include "sparqlkb.h"
+
+#include <trident/kb/compactor.h>
+#include <trident/kb/updater.h>
+#include <trident/kb/querier.h>
+#include <trident/iterators/pairitr.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+static string triple(int i) {
+    return "<http://e/" + to_string(i) + "> <http://p/" + to_string(i % 3) +
+        "> <http://e/" + to_string(i + 1) + ">";
+}
+
+static void addUpdate(string kbdir, string file, int first, int n) {
+    {
+        std::ofstream out(file);
+        for (int i = first; i < first + n; ++i) {
+            out << triple(i) << " ." << std::endl;
+        }
+    }
+    Updater up;
+    up.creatediffupdate(DiffIndex::TypeUpdate::ADDITION_df, kbdir, file);
+}
+
+static uint64_t countTriples(string kbdir) {
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    Querier *q = kb.query();
+    PairItr *itr = q->get(IDX_SPO, -1, -1, -1);
+    uint64_t count = 0;
+    while (itr->hasNext()) {
+        itr->next();
+        count++;
+    }
+    q->releaseItr(itr);
+    delete q;
+    return count;
+}
+
+//Adds updates while the KB is compacted, and checks that no update is lost
+int main(int argc, const char** args) {
+    const int NBASE = 1000;
+    const int NUPDATES = 8;
+    const int UPDATESIZE = 100;
+    std::vector<string> triples;
+    for (int i = 0; i < NBASE; ++i) {
+        triples.push_back(triple(i));
+    }
+    string kbdir = _createKB("testcompaction", triples);
+    string updatefile = string("testcompaction") + DIR_SEP + "update.nt";
+    addUpdate(kbdir, updatefile, NBASE, UPDATESIZE);
+
+    KBConfig config;
+    Compactor compactor(kbdir, config, 1, 3600, 2);
+    std::atomic<bool> updating(true);
+    std::thread updater([&]() {
+            for (int i = 1; i < NUPDATES; ++i) {
+                addUpdate(kbdir, updatefile, NBASE + i * UPDATESIZE,
+                    UPDATESIZE);
+            }
+            updating = false;
+            });
+    int ncompactions = 0;
+    while (updating) {
+        ncompactions += compactor.compactNow();
+    }
+    updater.join();
+    //The last updates
+    ncompactions += compactor.compactNow();
+    if (ncompactions == 0) {
+        cout << "No compaction was committed" << endl;
+        return 1;
+    }
+    if (Compactor::countDiffs(Compactor::getGenerationPath(kbdir)) != 0) {
+        cout << "Some updates were not compacted" << endl;
+        return 1;
+    }
+
+    const uint64_t expected = NBASE + NUPDATES * UPDATESIZE;
+    const uint64_t count = countTriples(kbdir);
+    if (count != expected) {
+        cout << "The KB contains " << count << " triples instead of " <<
+            expected << endl;
+        return 1;
+    }
+
+    //No compaction starts while another one is running
+    addUpdate(kbdir, updatefile, expected, UPDATESIZE);
+    {
+        Compactor::FileLock lock(kbdir + DIR_SEP + "_compact", true, true);
+        if (compactor.compactNow()) {
+            cout << "Two compactions ran at the same time" << endl;
+            return 1;
+        }
+    }
+
+    //The old generation is kept until its last reader closes it
+    const string oldstats = Compactor::getGenerationPath(kbdir) + DIR_SEP +
+        "kbstats";
+    std::unique_ptr<KB> reader(new KB(kbdir.c_str(), true, false, true,
+                config));
+    if (!compactor.compactNow()) {
+        cout << "The last update was not compacted" << endl;
+        return 1;
+    }
+    if (!Utils::exists(oldstats)) {
+        cout << "The old generation was removed while it was read" << endl;
+        return 1;
+    }
+    reader.reset();
+    if (Utils::exists(oldstats)) {
+        cout << "The old generation was not removed by its last reader" << endl;
+        return 1;
+    }
+    if (countTriples(kbdir) != expected + UPDATESIZE) {
+        cout << "The last update was lost" << endl;
+        return 1;
+    }
+    cout << "No update was lost in " << ncompactions << " compactions" << endl;
+    return 0;
+}
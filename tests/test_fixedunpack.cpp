@@ -0,0 +1,68 @@
+#include <trident/binarytables/fixedunpack.h>
+
+#include <kognac/utils.h>
+
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+using namespace std;
+
+//Checks that every kernel decodes the same values as the scalar decoder
+int main(int argc, const char** args) {
+    std::mt19937 e2(42);
+    cout << "Selected kernel: " << FixedUnpack::getKernelName() << endl;
+
+    for (uint8_t nbytes = 1; nbytes <= 8; ++nbytes) {
+        for (uint8_t stride = nbytes; stride <= 16; ++stride) {
+            for (size_t n = 0; n < 70; ++n) {
+                std::vector<char> input(n * stride + 1);
+                std::vector<int64_t> expected(n);
+                for (size_t i = 0; i < n; ++i) {
+                    int64_t v = e2();
+                    if (nbytes < 8) {
+                        v &= (((int64_t) 1) << (8 * nbytes)) - 1;
+                    } else {
+                        v &= INT64_MAX;
+                    }
+                    Utils::encode_longNBytes(&input[i * stride], nbytes, v);
+                    expected[i] = v;
+                }
+                std::vector<int64_t> out1(n), out2(n), out3(n);
+                FixedUnpack::unpack_scalar(input.data(), nbytes, stride, n, out1.data());
+                FixedUnpack::unpack(input.data(), nbytes, stride, n, out2.data());
+                if (FixedUnpack::isSSE4Supported()) {
+                    FixedUnpack::unpack_sse4(input.data(), nbytes, stride, n, out3.data());
+                } else {
+                    out3 = expected;
+                }
+                if (out1 != expected || out2 != expected || out3 != expected) {
+                    cout << "Wrong decoding nbytes=" << (int) nbytes << " stride=" <<
+                        (int) stride << " n=" << n << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    cout << "All kernels are consistent" << endl;
+
+    //Throughput on a large column
+    const size_t n = 10000000;
+    const uint8_t nbytes = 3;
+    std::vector<char> input(n * nbytes);
+    for (size_t i = 0; i < n; ++i) {
+        Utils::encode_longNBytes(&input[i * nbytes], nbytes, i);
+    }
+    std::vector<int64_t> out(n);
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    FixedUnpack::unpack_scalar(input.data(), nbytes, nbytes, n, out.data());
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    cout << "Scalar " << sec.count() * 1000 << " ms" << endl;
+    start = std::chrono::system_clock::now();
+    FixedUnpack::unpack(input.data(), nbytes, n, out.data());
+    sec = std::chrono::system_clock::now() - start;
+    cout << FixedUnpack::getKernelName() << " " << sec.count() * 1000 << " ms" << endl;
+    return 0;
+}
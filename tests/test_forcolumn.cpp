@@ -0,0 +1,226 @@
+#include <trident/binarytables/forcolumntable.h>
+#include <trident/binarytables/forcolumntableinserter.h>
+
+#include <kognac/utils.h>
+
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static void appendLong(std::vector<char> &out, const uint8_t nbytes,
+        const int64_t v) {
+    const size_t pos = out.size();
+    out.resize(pos + nbytes);
+    Utils::encode_longNBytes(&out[pos], nbytes, v);
+}
+
+//Writes the pairs with the same layout as FORColumnTableInserter::stopAppend
+static std::vector<char> createTable(
+        const std::vector<std::pair<int64_t, int64_t>> &pairs) {
+    std::vector<std::pair<int64_t, int64_t>> first;
+    int64_t largestGroup = 0, largest1 = 0, largest2 = 0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (first.empty() || first.back().first != pairs[i].first) {
+            first.push_back(make_pair(pairs[i].first, (int64_t) i));
+        }
+        largestGroup = max(largestGroup, (int64_t) i - first.back().second + 1);
+        largest1 = max(largest1, pairs[i].first);
+        largest2 = max(largest2, pairs[i].second);
+    }
+    std::vector<int64_t> bases, offsets;
+    std::vector<uint8_t> bits;
+    std::vector<char> packed;
+    for (size_t b = 0; b < pairs.size(); b += FORColumnTable::BLOCKSIZE) {
+        std::vector<int64_t> block;
+        for (size_t i = b; i < pairs.size() &&
+                i < b + FORColumnTable::BLOCKSIZE; ++i) {
+            block.push_back(pairs[i].second);
+        }
+        const int64_t base = *min_element(block.begin(), block.end());
+        const int64_t max = *max_element(block.begin(), block.end());
+        bases.push_back(base);
+        bits.push_back(FORColumnTableInserter::numBits(max - base));
+        offsets.push_back(packed.size());
+        FORColumnTableInserter::pack(block.data(), block.size(), base,
+                bits.back(), packed);
+    }
+
+    const uint8_t bFirst = Utils::numBytesFixedLength(largest1);
+    const uint8_t bBase = Utils::numBytesFixedLength(largest2);
+    const uint8_t bCount = Utils::numBytesFixedLength(largestGroup);
+    const uint8_t bStart = Utils::numBytesFixedLength(pairs.size());
+    const uint8_t bOffset = Utils::numBytesFixedLength(packed.size());
+    std::vector<char> out(3 + 20);
+    out[0] = (bFirst << 3) + bBase;
+    out[1] = (bCount << 3) + bStart;
+    out[2] = bOffset;
+    int pos = Utils::encode_vlong2(&out[0], 3, first.size());
+    pos = Utils::encode_vlong2(&out[0], pos, pairs.size());
+    out.resize(pos);
+    for (size_t i = 0; i < first.size(); ++i) {
+        const int64_t next = i < first.size() - 1 ? first[i + 1].second :
+            pairs.size();
+        appendLong(out, bFirst, first[i].first);
+        appendLong(out, bCount, next - first[i].second);
+        appendLong(out, bStart, first[i].second);
+    }
+    for (size_t i = 0; i < bases.size(); ++i) {
+        appendLong(out, bBase, bases[i]);
+        out.push_back(bits[i]);
+        appendLong(out, bOffset, offsets[i]);
+    }
+    out.insert(out.end(), packed.begin(), packed.end());
+    out.resize(out.size() + FORColumnTable::PADDING, 0);
+    return out;
+}
+
+//Sorted pairs with groups of random sizes. The second values of a group
+//are close or far apart, so that the blocks use different widths
+static std::vector<std::pair<int64_t, int64_t>> createPairs(std::mt19937 &e2,
+        const size_t n) {
+    std::vector<std::pair<int64_t, int64_t>> pairs;
+    int64_t v1 = e2() % 10;
+    while (pairs.size() < n) {
+        const size_t groupSize = e2() % 3 == 0 ? 1 + e2() % 400 : 1 + e2() % 5;
+        const int64_t gap = e2() % 4 == 0 ? 0 : (1 << (e2() % 30));
+        int64_t v2 = e2() % 100;
+        for (size_t i = 0; i < groupSize && pairs.size() < n; ++i) {
+            pairs.push_back(make_pair(v1, v2));
+            v2 += 1 + (gap == 0 ? 0 : e2() % gap);
+        }
+        v1 += 1 + e2() % 1000;
+    }
+    return pairs;
+}
+
+static bool checkTable(std::mt19937 &e2,
+        const std::vector<std::pair<int64_t, int64_t>> &pairs) {
+    std::vector<char> bytes = createTable(pairs);
+    const char *start = bytes.data();
+    const char *end = bytes.data() + bytes.size();
+
+    //Full scan
+    FORColumnTable table;
+    table.setup(start, end);
+    size_t i = 0;
+    while (table.hasNext()) {
+        table.next();
+        if (i >= pairs.size() || table.getValue1() != pairs[i].first ||
+                table.getValue2() != pairs[i].second) {
+            cout << "next(): wrong pair at row " << i << endl;
+            return false;
+        }
+        i++;
+    }
+    if (i != pairs.size()) {
+        cout << "next(): " << i << " rows instead of " << pairs.size() << endl;
+        return false;
+    }
+
+    //Scan in blocks
+    table.setup(start, end);
+    std::vector<int64_t> v1(100), v2(100);
+    i = 0;
+    size_t n;
+    while ((n = table.nextBlock(v1.data(), v2.data(), v1.size())) > 0) {
+        for (size_t j = 0; j < n; ++j, ++i) {
+            if (i >= pairs.size() || v1[j] != pairs[i].first ||
+                    v2[j] != pairs[i].second) {
+                cout << "nextBlock(): wrong pair at row " << i << endl;
+                return false;
+            }
+        }
+    }
+    if (i != pairs.size()) {
+        cout << "nextBlock(): " << i << " rows instead of " << pairs.size()
+            << endl;
+        return false;
+    }
+
+    //Direct reads of every row
+    for (i = 0; i < pairs.size(); ++i) {
+        uint64_t r1, r2;
+        FORColumnTable::s_getValue12AtRow(0, 0, start, i, r1, r2);
+        if ((int64_t) r1 != pairs[i].first || (int64_t) r2 != pairs[i].second) {
+            cout << "s_getValue12AtRow(): wrong pair at row " << i << endl;
+            return false;
+        }
+    }
+
+    //Increasing sequences of moveto to existing and missing pairs
+    for (int round = 0; round < 20; ++round) {
+        table.setup(start, end);
+        //moveto() never goes back, so the targets follow the last pair
+        std::pair<int64_t, int64_t> last = make_pair(0, 0);
+        while (true) {
+            std::pair<int64_t, int64_t> target = pairs[e2() % pairs.size()];
+            if (e2() % 2 == 0) {
+                target.second += 1;
+            }
+            if (e2() % 5 == 0) {
+                target.second = 0;
+            }
+            if (target < last) {
+                continue;
+            }
+            table.moveto(target.first, target.second);
+            auto exp = lower_bound(pairs.begin(), pairs.end(), target);
+            if (exp == pairs.end()) {
+                break;
+            }
+            if (!table.hasNext()) {
+                cout << "moveto(): the table ended too early" << endl;
+                return false;
+            }
+            table.next();
+            if (table.getValue1() != exp->first ||
+                    table.getValue2() != exp->second) {
+                cout << "moveto(" << target.first << "," << target.second <<
+                    "): wrong pair" << endl;
+                return false;
+            }
+            //getValue2AtRow counts the rows from the start of the group
+            const int64_t groupStart = lower_bound(pairs.begin(), pairs.end(),
+                    make_pair(exp->first, (int64_t) INT64_MIN)) - pairs.begin();
+            const int64_t row = exp - pairs.begin() - groupStart;
+            if (table.getValue2AtRow(row) != exp->second) {
+                cout << "getValue2AtRow(): wrong value" << endl;
+                return false;
+            }
+            last = *exp;
+            if (exp + 1 == pairs.end()) {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+//Checks that the FOR tables return the pairs that were written, and that
+//moveto finds the same pairs as a binary search
+int main(int argc, const char** args) {
+    std::mt19937 e2(42);
+    for (size_t n : { 1, 2, 127, 128, 129, 1000, 20000 }) {
+        for (int t = 0; t < 5; ++t) {
+            auto pairs = createPairs(e2, n);
+            if (!checkTable(e2, pairs)) {
+                cout << "Failed with " << n << " pairs" << endl;
+                return 1;
+            }
+        }
+    }
+    //Blocks where all values are equal (zero bits)
+    std::vector<std::pair<int64_t, int64_t>> pairs;
+    for (int i = 0; i < 500; ++i) {
+        pairs.push_back(make_pair(i, 7));
+    }
+    if (!checkTable(e2, pairs)) {
+        cout << "Failed with constant values" << endl;
+        return 1;
+    }
+    cout << "FOR tables are correct" << endl;
+    return 0;
+}
@@ -0,0 +1,192 @@
+#include "sparqlkb.h"
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+//Forwards the moves of the hint of an index scan, but never returns the
+//keys of a hash join, so the scan reads all tuples
+class NoKeysHint : public DBLayer::Hint {
+    private:
+        DBLayer::Hint *hint;
+
+    public:
+        NoKeysHint(DBLayer::Hint *hint) : hint(hint) {
+        }
+
+        bool canSkip() {
+            return hint->canSkip();
+        }
+
+        void next(uint64_t& value1, uint64_t& value2, uint64_t& value3) {
+            hint->next(value1, value2, value3);
+        }
+
+        void next(uint64_t& value1, uint64_t& value2) {
+            hint->next(value1, value2);
+        }
+
+        void next(uint64_t& value1) {
+            hint->next(value1);
+        }
+};
+
+//Records whether the hash join passed its keys to the scan when it was opened
+class CheckedScan : public DBLayer::Scan {
+    private:
+        std::unique_ptr<DBLayer::Scan> scan;
+        std::unique_ptr<NoKeysHint> noKeys;
+        DBLayer::Hint *hint;
+        bool &usedKeys;
+
+        void check() {
+            if (hint != NULL && hint->getKeys(NULL) != NULL) {
+                usedKeys = true;
+            }
+        }
+
+    public:
+        CheckedScan(std::unique_ptr<DBLayer::Scan> scan,
+                std::unique_ptr<NoKeysHint> noKeys, DBLayer::Hint *hint,
+                bool &usedKeys) : scan(std::move(scan)),
+        noKeys(std::move(noKeys)), hint(hint), usedKeys(usedKeys) {
+        }
+
+        uint64_t getValue1() {
+            return scan->getValue1();
+        }
+
+        uint64_t getValue2() {
+            return scan->getValue2();
+        }
+
+        uint64_t getValue3() {
+            return scan->getValue3();
+        }
+
+        uint64_t getCount() {
+            return scan->getCount();
+        }
+
+        bool next() {
+            return scan->next();
+        }
+
+        bool first() {
+            check();
+            return scan->first();
+        }
+
+        bool first(uint64_t v1, bool c1) {
+            check();
+            return scan->first(v1, c1);
+        }
+
+        bool first(uint64_t v1, bool c1, uint64_t v2, bool c2) {
+            check();
+            return scan->first(v1, c1, v2, c2);
+        }
+
+        bool first(uint64_t v1, bool c1, uint64_t v2, bool c2, uint64_t v3,
+                bool c3) {
+            check();
+            return scan->first(v1, c1, v2, c2, v3, c3);
+        }
+};
+
+//Opens the scans with or without the keys of the hash joins
+class HashKeysLayer : public TridentLayer {
+    private:
+        const bool skip;
+
+    public:
+        bool usedKeys;
+
+        HashKeysLayer(KB &kb, bool skip) : TridentLayer(kb), skip(skip),
+        usedKeys(false) {
+        }
+
+        std::unique_ptr<DBLayer::Scan> getScan(const DBLayer::DataOrder order,
+                const DBLayer::Aggr_t a, DBLayer::Hint *hint) {
+            std::unique_ptr<NoKeysHint> noKeys;
+            if (!skip && hint != NULL) {
+                noKeys = std::unique_ptr<NoKeysHint>(new NoKeysHint(hint));
+            }
+            std::unique_ptr<DBLayer::Scan> scan = TridentLayer::getScan(order,
+                    a, noKeys ? noKeys.get() : hint);
+            return std::unique_ptr<DBLayer::Scan>(new CheckedScan(
+                        std::move(scan), std::move(noKeys), hint, usedKeys));
+        }
+};
+
+//Checks that the scans that skip the tuples missing the keys of a hash join
+//return the same results as the scans that read all tuples
+int main(int argc, const char** args) {
+    std::mt19937 e2(5);
+    std::uniform_int_distribution<int> dist(0, 200);
+    std::vector<std::string> triples;
+    for (int i = 0; i < 3000; ++i) {
+        triples.push_back("<http://e/" + to_string(dist(e2)) + "> <http://p/" +
+                to_string(i % 3) + "> <http://e/" + to_string(dist(e2)) + ">");
+    }
+    //Few subjects in common with the other predicates
+    for (int i = 0; i < 500; ++i) {
+        triples.push_back("<http://e/" + to_string(dist(e2) % 7 * 30) +
+                "> <http://p/sparse> <http://e/" + to_string(dist(e2)) + ">");
+    }
+    //No subject in common with the other predicates
+    for (int i = 0; i < 500; ++i) {
+        triples.push_back("<http://x/" + to_string(dist(e2)) +
+                "> <http://p/none> <http://e/" + to_string(dist(e2)) + ">");
+    }
+    string kbdir = _createKB("testhashkeys", triples);
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    HashKeysLayer skipdb(kb, true);
+    HashKeysLayer noskipdb(kb, false);
+
+    struct TestQuery {
+        string name;
+        string query;
+        std::vector<string> vars;
+        bool empty;
+    };
+    std::vector<TestQuery> queries = {
+        { "chain", "SELECT ?a ?d WHERE { ?a <http://p/0> ?b . ?b <http://p/1> ?c . "
+            "?c <http://p/2> ?d . }", { "a", "d" }, false },
+        { "few matching keys", "SELECT ?a ?d WHERE { ?a <http://p/0> ?b . "
+            "?b <http://p/1> ?c . ?c <http://p/sparse> ?d . }", { "a", "d" }, false },
+        { "no matching keys", "SELECT ?a ?d WHERE { ?a <http://p/0> ?b . "
+            "?b <http://p/1> ?c . ?c <http://p/none> ?d . }", { "a", "d" }, true },
+        { "star and chain", "SELECT ?a ?c ?d WHERE { ?a <http://p/0> ?b . "
+            "?a <http://p/2> ?c . ?c <http://p/1> ?d . ?d <http://p/sparse> ?e . }",
+            { "a", "c", "d" }, false },
+    };
+    for (const auto &q : queries) {
+        std::vector<string> rows = _sorted(_runQuery(skipdb, q.query, q.vars));
+        std::vector<string> expected = _sorted(_runQuery(noskipdb, q.query,
+                    q.vars));
+        if (rows != expected) {
+            cout << q.name << ": " << rows.size() << " rows with the skip and "
+                << expected.size() << " without" << endl;
+            return 1;
+        }
+        if (expected.empty() != q.empty) {
+            cout << q.name << ": unexpected number of results (" <<
+                expected.size() << ")" << endl;
+            return 1;
+        }
+    }
+    if (!skipdb.usedKeys) {
+        cout << "No hash join passed its keys to the scans" << endl;
+        return 1;
+    }
+    if (!noskipdb.usedKeys) {
+        cout << "The plans without the skip have no hash join" << endl;
+        return 1;
+    }
+    cout << "The scans return the same results with and without the skip"
+        << endl;
+    return 0;
+}
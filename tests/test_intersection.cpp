@@ -0,0 +1,87 @@
+#include <trident/binarytables/intersection.h>
+
+#include <kognac/utils.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <set>
+#include <chrono>
+
+using namespace std;
+
+static std::vector<char> pack(const std::set<int64_t> &values,
+        const uint8_t nbytes, const uint8_t stride) {
+    std::vector<char> out(values.size() * stride + 1);
+    size_t i = 0;
+    for (auto v : values) {
+        Utils::encode_longNBytes(&out[i * stride], nbytes, v);
+        i++;
+    }
+    return out;
+}
+
+//Checks that all intersection strategies return the same counts
+int main(int argc, const char** args) {
+    std::mt19937 e2(42);
+    const size_t sizes[] = {0, 1, 3, 17, 100, 1000, 50000};
+    for (auto size1 : sizes) {
+        for (auto size2 : sizes) {
+            for (uint8_t nbytes = 1; nbytes <= 5; ++nbytes) {
+                const int64_t maxValue = nbytes < 3 ? (1 << (8 * nbytes)) : 200000;
+                std::uniform_int_distribution<int64_t> dist(0, maxValue - 1);
+                std::set<int64_t> s1, s2;
+                while (s1.size() < std::min((int64_t) size1, maxValue / 2)) {
+                    s1.insert(dist(e2));
+                }
+                while (s2.size() < std::min((int64_t) size2, maxValue / 2)) {
+                    s2.insert(dist(e2));
+                }
+                int64_t expected = 0;
+                for (auto v : s1) {
+                    expected += s2.count(v);
+                }
+                auto p1 = pack(s1, nbytes, nbytes + 1);
+                auto p2 = pack(s2, nbytes, nbytes);
+                Intersection::PackedList l1(p1.data(), s1.size(), nbytes, nbytes + 1);
+                Intersection::PackedList l2(p2.data(), s2.size(), nbytes, nbytes);
+                const int64_t c1 = Intersection::count(l1, l2);
+                const int64_t c2 = Intersection::count_merge(l1, l2);
+                const int64_t c3 = Intersection::count_simd(l1, l2);
+                const int64_t c4 = Intersection::count_gallop(l1, l2);
+                const int64_t c5 = Intersection::count_gallop(l2, l1);
+                if (c1 != expected || c2 != expected || c3 != expected ||
+                        c4 != expected || c5 != expected) {
+                    cout << "Wrong count size1=" << s1.size() << " size2=" <<
+                        s2.size() << " nbytes=" << (int) nbytes << " expected=" <<
+                        expected << " " << c1 << " " << c2 << " " << c3 << " " <<
+                        c4 << " " << c5 << endl;
+                    return 1;
+                }
+            }
+        }
+    }
+    cout << "All strategies are consistent" << endl;
+
+    //Skewed lists: a hub with many neighbours and a node with a few
+    std::set<int64_t> hub, small;
+    for (int64_t i = 0; i < 5000000; ++i) {
+        hub.insert(i * 3);
+    }
+    for (int64_t i = 0; i < 100; ++i) {
+        small.insert(i * 100000);
+    }
+    auto ph = pack(hub, 4, 4);
+    auto ps = pack(small, 4, 4);
+    Intersection::PackedList lh(ph.data(), hub.size(), 4, 4);
+    Intersection::PackedList ls(ps.data(), small.size(), 4, 4);
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    int64_t c = Intersection::count_merge(ls, lh);
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    cout << "Merge " << c << " " << sec.count() * 1000 << " ms" << endl;
+    start = std::chrono::system_clock::now();
+    c = Intersection::count(ls, lh);
+    sec = std::chrono::system_clock::now() - start;
+    cout << "Adaptive " << c << " " << sec.count() * 1000 << " ms" << endl;
+    return 0;
+}
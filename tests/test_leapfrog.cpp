@@ -0,0 +1,145 @@
+#include "sparqlkb.h"
+
+#include <iostream>
+#include <random>
+#include <set>
+
+using namespace std;
+
+//Without value scans the patterns cannot be read by the Leapfrog join, so
+//only binary plans are built
+class BinaryPlansLayer : public TridentLayer {
+    public:
+        BinaryPlansLayer(KB &kb) : TridentLayer(kb) {
+        }
+
+        bool hasValueScans(const DBLayer::DataOrder order) {
+            return false;
+        }
+};
+
+//The index scans look so expensive that the Leapfrog join is always cheaper
+class LeapfrogLayer : public TridentLayer {
+    public:
+        LeapfrogLayer(KB &kb) : TridentLayer(kb) {
+        }
+
+        double getScanCost(DBLayer::DataOrder order, uint64_t value1,
+                uint64_t value1C, uint64_t value2, uint64_t value2C,
+                uint64_t value3, uint64_t value3C) {
+            return 1e12 + TridentLayer::getScanCost(order, value1, value1C,
+                    value2, value2C, value3, value3C);
+        }
+
+        double getScanCost(DBLayer::DataOrder order, uint64_t value1,
+                uint64_t value1C, uint64_t value2, uint64_t value2C) {
+            return 1e12 + TridentLayer::getScanCost(order, value1, value1C,
+                    value2, value2C);
+        }
+
+        double getScanCost(DBLayer::DataOrder order, uint64_t value1,
+                uint64_t value1C) {
+            return 1e12 + TridentLayer::getScanCost(order, value1, value1C);
+        }
+};
+
+static string node(int i) {
+    return "http://e/" + to_string(i);
+}
+
+//Checks that the Leapfrog join returns the same results as the binary plans
+//on triangles and 4-cycles
+int main(int argc, const char** args) {
+    const int NNODES = 60;
+    std::mt19937 e2(11);
+    std::uniform_int_distribution<int> dist(0, NNODES - 1);
+    std::set<std::pair<int, int>> edges[2];
+    std::vector<std::string> triples;
+    while (edges[0].size() + edges[1].size() < 700) {
+        const int s = dist(e2), o = dist(e2), p = dist(e2) % 2;
+        if (s != o && edges[p].insert(make_pair(s, o)).second) {
+            triples.push_back("<" + node(s) + "> <http://p/" + to_string(p) +
+                    "> <" + node(o) + ">");
+        }
+    }
+    string kbdir = _createKB("testleapfrog", triples);
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    TridentLayer db(kb);
+    BinaryPlansLayer binarydb(kb);
+    LeapfrogLayer leapfrogdb(kb);
+
+    //Expected results
+    std::vector<string> triangles, mixedTriangles, cycles;
+    for (int a = 0; a < NNODES; ++a) {
+        for (int b = 0; b < NNODES; ++b) {
+            for (int c = 0; c < NNODES; ++c) {
+                if (edges[0].count(make_pair(a, b)) &&
+                        edges[0].count(make_pair(b, c)) &&
+                        edges[0].count(make_pair(c, a))) {
+                    triangles.push_back(node(a) + " " + node(b) + " " + node(c));
+                }
+                if (edges[0].count(make_pair(a, b)) &&
+                        edges[1].count(make_pair(b, c)) &&
+                        edges[0].count(make_pair(a, c))) {
+                    mixedTriangles.push_back(node(a) + " " + node(b) + " " +
+                            node(c));
+                }
+                for (int d = 0; d < NNODES; ++d) {
+                    if (edges[0].count(make_pair(a, b)) &&
+                            edges[0].count(make_pair(b, c)) &&
+                            edges[0].count(make_pair(c, d)) &&
+                            edges[0].count(make_pair(d, a))) {
+                        cycles.push_back(node(a) + " " + node(b) + " " +
+                                node(c) + " " + node(d));
+                    }
+                }
+            }
+        }
+    }
+
+    struct TestQuery {
+        string name;
+        string query;
+        std::vector<string> vars;
+        std::vector<string> expected;
+    };
+    std::vector<TestQuery> queries = {
+        { "triangle", "SELECT ?a ?b ?c WHERE { ?a <http://p/0> ?b . "
+            "?b <http://p/0> ?c . ?c <http://p/0> ?a . }",
+            { "a", "b", "c" }, _sorted(triangles) },
+        { "triangle with two predicates", "SELECT ?a ?b ?c WHERE { "
+            "?a <http://p/0> ?b . ?b <http://p/1> ?c . ?a <http://p/0> ?c . }",
+            { "a", "b", "c" }, _sorted(mixedTriangles) },
+        { "4-cycle", "SELECT ?a ?b ?c ?d WHERE { ?a <http://p/0> ?b . "
+            "?b <http://p/0> ?c . ?c <http://p/0> ?d . ?d <http://p/0> ?a . }",
+            { "a", "b", "c", "d" }, _sorted(cycles) },
+    };
+    for (const auto &q : queries) {
+        if (q.expected.empty()) {
+            cout << q.name << ": the data has no results" << endl;
+            return 1;
+        }
+        std::vector<string> binary = _sorted(_runQuery(binarydb, q.query, q.vars));
+        std::vector<string> leapfrog = _sorted(_runQuery(leapfrogdb, q.query,
+                    q.vars));
+        std::vector<string> chosen = _sorted(_runQuery(db, q.query, q.vars));
+        if (binary != q.expected) {
+            cout << q.name << ": the binary plans return " << binary.size() <<
+                " rows instead of " << q.expected.size() << endl;
+            return 1;
+        }
+        if (leapfrog != q.expected) {
+            cout << q.name << ": the Leapfrog join returns " << leapfrog.size()
+                << " rows instead of " << q.expected.size() << endl;
+            return 1;
+        }
+        if (chosen != q.expected) {
+            cout << q.name << ": the cheaper plan returns " << chosen.size() <<
+                " rows instead of " << q.expected.size() << endl;
+            return 1;
+        }
+    }
+    cout << "The Leapfrog join and the binary plans agree" << endl;
+    return 0;
+}
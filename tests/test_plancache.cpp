@@ -0,0 +1,130 @@
+#include "sparqlkb.h"
+
+#include <trident/sparql/plancache.h>
+
+#include <iostream>
+#include <random>
+
+using namespace std;
+
+static std::vector<std::string> runCached(TridentLayer &db,
+        SPARQLPlanCache &cache, std::string query,
+        const std::map<string, string> &params,
+        const std::vector<std::string> &vars, bool &cached) {
+    JSON jsonvars, jsonresults, jsonstats;
+    SPARQLUtils::execSPARQLQuery(query, params, cache, db, false, true,
+            &jsonvars, &jsonresults, &jsonstats);
+    cached = jsonstats.get("cachedplan") == "true";
+    std::vector<std::string> rows;
+    for (JSON row : jsonresults.getListChildren()) {
+        std::string r;
+        for (const auto &var : vars) {
+            if (!r.empty()) {
+                r += " ";
+            }
+            r += row.getChild(var).get("value");
+        }
+        rows.push_back(r);
+    }
+    return _sorted(rows);
+}
+
+static string replaceAll(string query, const string &var, const string &term) {
+    size_t pos;
+    while ((pos = query.find(var)) != string::npos) {
+        query.replace(pos, var.size(), term);
+    }
+    return query;
+}
+
+struct TestQuery {
+    string name;
+    //Query with the parameter ?x
+    string query;
+    std::vector<string> vars;
+    //Same query, where ?x is replaced by its value before the optimization.
+    //If ?x is returned, freshvars does not contain it
+    string fresh;
+    std::vector<string> freshvars;
+};
+
+//Checks that the plans in the cache return the same results as the plans
+//optimized for every value of the parameters
+int main(int argc, const char** args) {
+    std::mt19937 e2(7);
+    std::uniform_int_distribution<int> dist(0, 40);
+    std::vector<std::string> triples;
+    for (int i = 0; i < 2000; ++i) {
+        triples.push_back("<http://e/" + to_string(dist(e2)) +
+                "> <http://p/" + to_string(dist(e2) % 3) + "> <http://e/" +
+                to_string(dist(e2)) + ">");
+    }
+    string kbdir = _createKB("testplancache", triples);
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    TridentLayer db(kb);
+
+    std::vector<TestQuery> queries = {
+        //Only in the triple patterns
+        { "patterns", "SELECT ?o ?z WHERE { ?x <http://p/1> ?o . ?o <http://p/2> ?z . }",
+            { "o", "z" }, "SELECT ?o ?z WHERE { ?x <http://p/1> ?o . ?o <http://p/2> ?z . }",
+            { "o", "z" } },
+        //In a filter
+        { "filter", "SELECT ?s ?o WHERE { ?s <http://p/1> ?o . FILTER (?o = ?x) }",
+            { "s", "o" }, "SELECT ?s ?o WHERE { ?s <http://p/1> ?o . FILTER (?o = ?x) }",
+            { "s", "o" } },
+        //In an optional part
+        { "optional", "SELECT ?s ?y WHERE { ?s <http://p/0> ?y . OPTIONAL { ?s <http://p/1> ?x } }",
+            { "s", "y" }, "SELECT ?s ?y WHERE { ?s <http://p/0> ?y . OPTIONAL { ?s <http://p/1> ?x } }",
+            { "s", "y" } },
+        //In a union
+        { "union", "SELECT ?s WHERE { { ?s <http://p/0> ?x } UNION { ?s <http://p/2> ?x } }",
+            { "s" }, "SELECT ?s WHERE { { ?s <http://p/0> ?x } UNION { ?s <http://p/2> ?x } }",
+            { "s" } },
+        //In the projection and in the ordering
+        { "projection", "SELECT ?x ?o WHERE { ?x <http://p/1> ?o . } ORDER BY ?x",
+            { "x", "o" }, "SELECT ?o WHERE { ?x <http://p/1> ?o . }", { "o" } },
+    };
+
+    SPARQLPlanCache cache;
+    for (const auto &q : queries) {
+        //The first value is not in the dictionary
+        std::vector<string> values = { "http://e/unknown" };
+        for (int i = 0; i < 10; ++i) {
+            values.push_back("http://e/" + to_string(dist(e2)));
+        }
+        bool first = true;
+        for (const auto &v : values) {
+            std::map<string, string> params;
+            params["x"] = "<" + v + ">";
+            bool cached;
+            std::vector<string> rows = runCached(db, cache, q.query, params,
+                    q.vars, cached);
+            if (cached == first) {
+                cout << q.name << ": the plan was " << (cached ? "" : "not ")
+                    << "in the cache" << endl;
+                return 1;
+            }
+            first = false;
+
+            std::vector<string> expected = _sorted(_runQuery(db,
+                        replaceAll(q.fresh, "?x", params["x"]), q.freshvars));
+            if (q.vars.size() > q.freshvars.size()) {
+                //The parameter is returned as a constant column
+                for (auto &row : expected) {
+                    row = v + " " + row;
+                }
+                expected = _sorted(expected);
+            }
+            if (rows != expected) {
+                cout << q.name << ": the cached plan returns " << rows.size()
+                    << " rows instead of " << expected.size() << " for " << v
+                    << endl;
+                return 1;
+            }
+        }
+    }
+    cout << "The cached plans are correct (" << cache.getHits() << " hits)"
+        << endl;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <chrono>
+#include <array>
+
+#include <trident/utils/parallel.h>
+#include <trident/utils/radixsort.h>
+
+using namespace std;
+
+//Compares the radix sort used by the PermSorter with the parallel merge sort
+//used before. Usage: testRadixSort [ntriples] [nthreads] [maxid]
+
+typedef std::array<unsigned char, 15> __PermSorter_triple;
+
+bool __PermSorter_triple_sorter(const __PermSorter_triple &a,
+        const __PermSorter_triple &b) {
+    return a < b;
+}
+
+void writeTermInBuffer(unsigned char *buffer, const int64_t n) {
+    buffer[0] = (n >> 32) & 0xFF;
+    buffer[1] = (n >> 24) & 0xFF;
+    buffer[2] = (n >> 16) & 0xFF;
+    buffer[3] = (n >> 8) & 0xFF;
+    buffer[4] = n & 0xFF;
+}
+
+int main(int argc, const char** argv) {
+    int64_t size = argc > 1 ? atol(argv[1]) : 100000000l;
+    int nthreads = argc > 2 ? atoi(argv[2]) : 8;
+    int64_t maxid = argc > 3 ? atol(argv[3]) : 100000000l;
+
+    std::cout << "Generating " << size << " triples ..." << std::endl;
+    std::vector<__PermSorter_triple> triples1(size);
+    std::mt19937_64 gen(42);
+    //Skewed predicates, like in real KBs
+    std::uniform_int_distribution<int64_t> dis(0, maxid);
+    std::uniform_int_distribution<int64_t> dispred(0, 1000);
+    for(int64_t i = 0; i < size; ++i) {
+        writeTermInBuffer(triples1[i].data(), dis(gen));
+        writeTermInBuffer(triples1[i].data() + 5, dispred(gen) % (1 + dispred(gen)));
+        writeTermInBuffer(triples1[i].data() + 10, dis(gen));
+    }
+    std::vector<__PermSorter_triple> triples2 = triples1;
+
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+    ParallelTasks::sort_int(triples1.begin(), triples1.end(),
+            &__PermSorter_triple_sorter, nthreads);
+    std::chrono::duration<double> durMerge = std::chrono::system_clock::now() - start;
+    std::cout << "Merge sort: " << durMerge.count() << "s." << std::endl;
+
+    start = std::chrono::system_clock::now();
+    RadixSort<15>::sort(triples2.data(), triples2.data() + size, nthreads);
+    std::chrono::duration<double> durRadix = std::chrono::system_clock::now() - start;
+    std::cout << "Radix sort: " << durRadix.count() << "s." << std::endl;
+
+    if (triples1 != triples2) {
+        std::cerr << "Error: the two sorts give different results" << std::endl;
+        return 1;
+    }
+    std::cout << "Speedup: " << durMerge.count() / durRadix.count() << std::endl;
+    return 0;
+}
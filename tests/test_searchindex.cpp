@@ -0,0 +1,192 @@
+#include "sparqlkb.h"
+
+#include <trident/kb/searchindex.h>
+#include <trident/kb/compactor.h>
+#include <trident/kb/updater.h>
+#include <trident/tree/treeitr.h>
+#include <trident/tree/stringbuffer.h>
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+
+using namespace std;
+
+static string word(std::mt19937 &e2) {
+    const string letters = "abcde";
+    string w;
+    const int size = 1 + e2() % 8;
+    for (int i = 0; i < size; ++i) {
+        w += letters[e2() % letters.size()];
+    }
+    return w;
+}
+
+//All the terms of the dictionary, sorted by text
+static std::map<string, int64_t> getAllTerms(KB &kb) {
+    DictMgmt *dict = kb.getDictMgmt();
+    TreeItr *itr = dict->getInvDictIterator();
+    StringBuffer *sb = dict->getStringBuffer();
+    std::unique_ptr<char[]> text(new char[MAX_TERM_SIZE]);
+    std::map<string, int64_t> terms;
+    while (itr->hasNext()) {
+        int64_t coordinates;
+        const int64_t id = itr->next(coordinates);
+        int size;
+        sb->get(coordinates, text.get(), size);
+        terms[string(text.get(), size)] = id;
+    }
+    delete itr;
+    return terms;
+}
+
+static bool checkPrefix(SearchIndex &index,
+        const std::map<string, int64_t> &terms, const string &prefix,
+        const int64_t limit) {
+    std::vector<SearchIndex::Match> expected;
+    for (auto it = terms.lower_bound(prefix); it != terms.end() &&
+            it->first.compare(0, prefix.size(), prefix) == 0 &&
+            (int64_t) expected.size() < limit; ++it) {
+        expected.push_back(make_pair(it->second, it->first));
+    }
+    std::vector<SearchIndex::Match> matches;
+    index.searchPrefix(prefix, limit, matches);
+    if (matches != expected) {
+        cout << "Prefix '" << prefix << "' (limit " << limit << "): " <<
+            matches.size() << " matches instead of " << expected.size() << endl;
+        return false;
+    }
+    return true;
+}
+
+static bool checkSubstring(SearchIndex &index, KB &kb,
+        const std::map<string, int64_t> &terms, const string &text,
+        const int64_t limit) {
+    std::set<SearchIndex::Match> expected;
+    for (const auto &t : terms) {
+        if (t.first.find(text) != string::npos) {
+            expected.insert(make_pair(t.second, t.first));
+        }
+    }
+    std::vector<SearchIndex::Match> matches;
+    index.searchSubstring(text, limit, kb.getDictMgmt(), matches);
+    std::set<SearchIndex::Match> found(matches.begin(), matches.end());
+    if (found.size() != matches.size()) {
+        cout << "Substring '" << text << "': duplicate matches" << endl;
+        return false;
+    }
+    if (matches.size() != std::min((size_t) limit, expected.size())) {
+        cout << "Substring '" << text << "' (limit " << limit << "): " <<
+            matches.size() << " matches instead of " <<
+            std::min((size_t) limit, expected.size()) << endl;
+        return false;
+    }
+    for (const auto &m : matches) {
+        if (!expected.count(m)) {
+            cout << "Substring '" << text << "': wrong match " << m.second <<
+                endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+//Checks the prefix and substring searches against a scan of the dictionary,
+//and that the index is not used once the updates add new terms
+int main(int argc, const char** args) {
+    std::mt19937 e2(13);
+    std::vector<string> triples;
+    for (int i = 0; i < 3000; ++i) {
+        triples.push_back("<http://e/" + word(e2) + "> <http://p/" +
+                to_string(i % 3) + "> \"" + word(e2) + " " + word(e2) + "\"");
+    }
+    ParamsLoad params;
+    params.searchIndex = true;
+    string kbdir = _createKB("testsearchindex", triples, params);
+
+    {
+        KBConfig config;
+        KB kb(kbdir.c_str(), true, false, true, config);
+        SearchIndex *index = kb.getSearchIndex();
+        if (index == NULL) {
+            cout << "The search index was not built" << endl;
+            return 1;
+        }
+        const std::map<string, int64_t> terms = getAllTerms(kb);
+        if (index->getNTerms() != terms.size()) {
+            cout << "The index contains " << index->getNTerms() <<
+                " terms instead of " << terms.size() << endl;
+            return 1;
+        }
+
+        const std::vector<int64_t> prefixLimits = { 1, 5, 100, INT64_MAX };
+        for (const string prefix : { "<http://e/a", "<http://e/abc",
+                "\"b", "<http://p/", "<", "zzz" }) {
+            for (int64_t limit : prefixLimits) {
+                if (!checkPrefix(*index, terms, prefix, limit)) {
+                    return 1;
+                }
+            }
+        }
+
+        //Short queries (no trigram), one trigram and several ones
+        std::vector<string> queries = { "a", "e", "\"", "ab", "a ", "e/",
+            "abc", "cab", "e/abc", "p/1", "bad cab", "xyz", "aaaaaaaa" };
+        for (int i = 0; i < 20; ++i) {
+            queries.push_back(word(e2));
+        }
+        const std::vector<int64_t> limits = { 1, 10, 5000, INT64_MAX };
+        for (const auto &q : queries) {
+            for (int64_t limit : limits) {
+                if (!checkSubstring(*index, kb, terms, q, limit)) {
+                    return 1;
+                }
+            }
+        }
+    }
+
+    //The terms of an update are not in the index until the KB is compacted
+    {
+        string updatefile = string("testsearchindex") + DIR_SEP + "update.nt";
+        std::ofstream out(updatefile);
+        out << "<http://e/newterm> <http://p/0> \"fresh\" ." << std::endl;
+        out.close();
+        Updater up;
+        up.creatediffupdate(DiffIndex::TypeUpdate::ADDITION_df, kbdir,
+                updatefile);
+    }
+    {
+        KBConfig config;
+        KB kb(kbdir.c_str(), true, false, true, config);
+        if (kb.getSearchIndex() != NULL) {
+            cout << "The index is used although it misses the new terms" << endl;
+            return 1;
+        }
+        if (Compactor::compact(kb, kbdir, 2) == "") {
+            cout << "The update was not compacted" << endl;
+            return 1;
+        }
+    }
+    {
+        KBConfig config;
+        KB kb(kbdir.c_str(), true, false, true, config);
+        SearchIndex *index = kb.getSearchIndex();
+        if (index == NULL) {
+            cout << "The compacted KB has no search index" << endl;
+            return 1;
+        }
+        const std::map<string, int64_t> terms = getAllTerms(kb);
+        for (const string q : { "newterm", "fresh", "e/n", "w" }) {
+            if (!checkSubstring(*index, kb, terms, q, INT64_MAX)) {
+                return 1;
+            }
+        }
+        if (!checkPrefix(*index, terms, "<http://e/new", INT64_MAX)) {
+            return 1;
+        }
+    }
+    cout << "The search index is correct" << endl;
+    return 0;
+}
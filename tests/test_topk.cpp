@@ -0,0 +1,101 @@
+#include "sparqlkb.h"
+
+#include <iostream>
+#include <random>
+#include <set>
+
+using namespace std;
+
+static std::vector<std::string> column(const std::vector<std::string> &rows,
+        int idx) {
+    std::vector<std::string> out;
+    for (const auto &row : rows) {
+        const size_t pos = row.find(' ');
+        out.push_back(idx == 0 ? row.substr(0, pos) : row.substr(pos + 1));
+    }
+    return out;
+}
+
+//Checks that the queries with ORDER BY and LIMIT, which keep only the first
+//tuples in a heap, return the same tuples as a full sort
+int main(int argc, const char** args) {
+    std::mt19937 e2(3);
+    //Few distinct objects, so that many tuples have the same key
+    std::uniform_int_distribution<int> dist(0, 50);
+    const int N = 2000;
+    std::vector<std::string> triples;
+    std::set<std::string> inputRows;
+    std::vector<std::string> objects;
+    for (int i = 0; i < N; ++i) {
+        const string s = "http://e/" + to_string(i);
+        const string o = "http://o/" + to_string(dist(e2));
+        triples.push_back("<" + s + "> <http://p/0> <" + o + ">");
+        inputRows.insert(s + " " + o);
+        objects.push_back(o);
+    }
+    std::sort(objects.begin(), objects.end());
+    string kbdir = _createKB("testtopk", triples);
+    KBConfig config;
+    KB kb(kbdir.c_str(), true, false, true, config);
+    TridentLayer db(kb);
+
+    const string where = "SELECT ?s ?o WHERE { ?s <http://p/0> ?o . } ";
+    const std::vector<string> vars = { "s", "o" };
+    std::vector<string> full = _runQuery(db, where + "ORDER BY ?o ?s", vars);
+    std::vector<string> fullDesc = _runQuery(db, where + "ORDER BY DESC(?o) ?s",
+            vars);
+    if (full.size() != N || column(full, 1) != objects) {
+        cout << "The full sort is wrong" << endl;
+        return 1;
+    }
+
+    for (size_t k : { 1, 7, 100, 1999, 2000, 2001, 5000 }) {
+        const size_t expectedSize = std::min(k, (size_t) N);
+        //Ties: only the order of the keys is defined
+        std::vector<string> rows = _runQuery(db, where + "ORDER BY ?o LIMIT " +
+                to_string(k), vars);
+        std::vector<string> rowsObjects = column(rows, 1);
+        if (rows.size() != expectedSize || rowsObjects !=
+                std::vector<string>(objects.begin(), objects.begin() + expectedSize)) {
+            cout << "ORDER BY ?o LIMIT " << k << ": wrong keys" << endl;
+            return 1;
+        }
+        if (std::set<string>(rows.begin(), rows.end()).size() != rows.size()) {
+            cout << "ORDER BY ?o LIMIT " << k << ": duplicate rows" << endl;
+            return 1;
+        }
+        for (const auto &row : rows) {
+            if (!inputRows.count(row)) {
+                cout << "ORDER BY ?o LIMIT " << k << ": unknown row " << row
+                    << endl;
+                return 1;
+            }
+        }
+
+        //Without ties the rows must be the first ones of the full sort
+        rows = _runQuery(db, where + "ORDER BY ?o ?s LIMIT " + to_string(k),
+                vars);
+        if (rows != std::vector<string>(full.begin(),
+                    full.begin() + expectedSize)) {
+            cout << "ORDER BY ?o ?s LIMIT " << k << ": wrong rows" << endl;
+            return 1;
+        }
+        rows = _runQuery(db, where + "ORDER BY DESC(?o) ?s LIMIT " +
+                to_string(k), vars);
+        if (rows != std::vector<string>(fullDesc.begin(),
+                    fullDesc.begin() + expectedSize)) {
+            cout << "ORDER BY DESC(?o) ?s LIMIT " << k << ": wrong rows" << endl;
+            return 1;
+        }
+    }
+
+    //The offset is also kept in the heap
+    std::vector<string> rows = _runQuery(db, where +
+            "ORDER BY ?o ?s LIMIT 10 OFFSET 25", vars);
+    if (rows != std::vector<string>(full.begin() + 25, full.begin() + 35)) {
+        cout << "ORDER BY ?o ?s LIMIT 10 OFFSET 25: wrong rows" << endl;
+        return 1;
+    }
+    cout << "The top-K sorts are correct" << endl;
+    return 0;
+}